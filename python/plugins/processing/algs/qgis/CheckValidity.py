@@ -29,6 +29,7 @@ from qgis.PyQt.QtCore import QVariant
 from qgis.core import (QgsApplication,
                        QgsSettings,
                        QgsGeometry,
+                       QgsGeometryValidator,
                        QgsFeature,
                        QgsField,
                        QgsFeatureRequest,
@@ -46,6 +47,9 @@ from qgis.core import (QgsApplication,
 from processing.algs.qgis.QgisAlgorithm import QgisAlgorithm
 
 settings_method_key = "/qgis/digitizing/validate_geometries"
+
+# number of features read and validated together, the geometries of each chunk are validated in parallel
+VALIDATION_CHUNK_SIZE = 1000
 pluginPath = os.path.split(os.path.split(os.path.dirname(__file__))[0])[0]
 
 
@@ -148,33 +152,80 @@ class CheckValidity(QgisAlgorithm):
 
         features = source.getFeatures(QgsFeatureRequest(), QgsProcessingFeatureSource.FlagSkipGeometryValidityChecks)
         total = 100.0 / source.featureCount() if source.featureCount() else 0
-        for current, inFeat in enumerate(features):
+        current = 0
+        chunk = []
+        for inFeat in features:
             if feedback.isCanceled():
                 break
+            chunk.append(inFeat)
+            if len(chunk) < VALIDATION_CHUNK_SIZE:
+                continue
+
+            counts = self.checkChunk(chunk, method, flags, valid_output_sink, invalid_output_sink, error_output_sink, feedback)
+            valid_count += counts[0]
+            invalid_count += counts[1]
+            error_count += counts[2]
+            current += len(chunk)
+            chunk = []
+            feedback.setProgress(int(current * total))
+
+        if chunk and not feedback.isCanceled():
+            counts = self.checkChunk(chunk, method, flags, valid_output_sink, invalid_output_sink, error_output_sink, feedback)
+            valid_count += counts[0]
+            invalid_count += counts[1]
+            error_count += counts[2]
+
+        results = {
+            self.VALID_COUNT: valid_count,
+            self.INVALID_COUNT: invalid_count,
+            self.ERROR_COUNT: error_count
+        }
+        if valid_output_sink:
+            results[self.VALID_OUTPUT] = valid_output_dest_id
+        if invalid_output_sink:
+            results[self.INVALID_OUTPUT] = invalid_output_dest_id
+        if error_output_sink:
+            results[self.ERROR_OUTPUT] = error_output_dest_id
+        return results
+
+    def checkChunk(self, features, method, flags, valid_output_sink, invalid_output_sink, error_output_sink, feedback):
+        """
+        Validates the geometries of a chunk of features in parallel and writes the features
+        and errors in input order. Returns the valid, invalid and error counts.
+        """
+        valid_count = 0
+        invalid_count = 0
+        error_count = 0
+
+        # null and empty geometries are not validated
+        geometries = [f.geometry() if not f.geometry().isNull() and not f.geometry().isEmpty() else QgsGeometry() for f in features]
+        chunk_errors = QgsGeometryValidator.validateGeometries(geometries, method, flags, feedback)
+        if feedback.isCanceled():
+            return valid_count, invalid_count, error_count
+
+        for inFeat, errors in zip(features, chunk_errors):
             geom = inFeat.geometry()
             attrs = inFeat.attributes()
 
             valid = True
-            if not geom.isNull() and not geom.isEmpty():
-                errors = list(geom.validateGeometry(method, flags))
-                if errors:
-                    valid = False
-                    reasons = []
-                    for error in errors:
-                        errFeat = QgsFeature()
-                        error_geom = QgsGeometry.fromPointXY(error.where())
-                        errFeat.setGeometry(error_geom)
-                        errFeat.setAttributes([error.what()])
-                        if error_output_sink:
-                            error_output_sink.addFeature(errFeat, QgsFeatureSink.FastInsert)
-                        error_count += 1
-
-                        reasons.append(error.what())
-
-                    reason = "\n".join(reasons)
-                    if len(reason) > 255:
-                        reason = reason[:252] + '…'
-                    attrs.append(reason)
+            if errors:
+                valid = False
+                reasons = []
+                for error in errors:
+                    errFeat = QgsFeature()
+                    error_geom = QgsGeometry.fromPointXY(error.where())
+                    errFeat.setGeometry(error_geom)
+                    errFeat.setAttributes([error.what()])
+                    if error_output_sink:
+                        error_output_sink.addFeature(errFeat, QgsFeatureSink.FastInsert)
+                    error_count += 1
+
+                    reasons.append(error.what())
+
+                reason = "\n".join(reasons)
+                if len(reason) > 255:
+                    reason = reason[:252] + '…'
+                attrs.append(reason)
 
             outFeat = QgsFeature()
             outFeat.setGeometry(geom)
@@ -190,17 +241,4 @@ class CheckValidity(QgisAlgorithm):
                     invalid_output_sink.addFeature(outFeat, QgsFeatureSink.FastInsert)
                 invalid_count += 1
 
-            feedback.setProgress(int(current * total))
-
-        results = {
-            self.VALID_COUNT: valid_count,
-            self.INVALID_COUNT: invalid_count,
-            self.ERROR_COUNT: error_count
-        }
-        if valid_output_sink:
-            results[self.VALID_OUTPUT] = valid_output_dest_id
-        if invalid_output_sink:
-            results[self.INVALID_OUTPUT] = invalid_output_dest_id
-        if error_output_sink:
-            results[self.ERROR_OUTPUT] = error_output_dest_id
-        return results
+        return valid_count, invalid_count, error_count
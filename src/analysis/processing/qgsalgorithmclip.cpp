@@ -140,7 +140,8 @@ QVariantMap QgsClipAlgorithm::processAlgorithm( const QVariantMap &parameters, Q
     singleClipFeature = true;
   }
 
-  // use prepared geometries for faster intersection tests
+  // use prepared geometries for faster intersection tests, the engine's GEOS representation
+  // of the clip geometry is also reused when computing the intersections
   std::unique_ptr< QgsGeometryEngine > engine( QgsGeometry::createGeometryEngine( combinedClipGeom.constGet() ) );
   engine->prepareGeometry();
 
@@ -194,7 +195,7 @@ QVariantMap QgsClipAlgorithm::processAlgorithm( const QVariantMap &parameters, Q
       if ( !engine->contains( inputFeature.geometry().constGet() ) )
       {
         QgsGeometry currentGeometry = inputFeature.geometry();
-        newGeometry = combinedClipGeom.intersection( currentGeometry );
+        newGeometry = QgsGeometry( engine->intersection( currentGeometry.constGet() ) );
         if ( newGeometry.wkbType() == QgsWkbTypes::Unknown || QgsWkbTypes::flatType( newGeometry.wkbType() ) == QgsWkbTypes::GeometryCollection )
         {
           QgsGeometry intCom = inputFeature.geometry().combine( newGeometry );
@@ -17,6 +17,9 @@
 
 #include "qgsalgorithmdissolve.h"
 
+#include <QtConcurrentMap>
+#include <algorithm>
+
 ///@cond PRIVATE
 
 //
@@ -212,34 +215,162 @@ QgsDissolveAlgorithm *QgsDissolveAlgorithm::createInstance() const
   return new QgsDissolveAlgorithm();
 }
 
-QVariantMap QgsDissolveAlgorithm::processAlgorithm( const QVariantMap &parameters, QgsProcessingContext &context, QgsProcessingFeedback *feedback )
+//! Number of parts unioned together by a single GEOS call at the bottom of the union tree
+static const int DISSOLVE_BLOCK_SIZE = 256;
+
+//! Number of results unioned together at each upper level of the union tree
+static const int DISSOLVE_FAN_IN = 8;
+
+//! A node of the union tree, unioned on a worker thread
+struct QgsDissolveBlock
 {
-  return processCollection( parameters, context, feedback, [ & ]( const QVector< QgsGeometry > &parts )->QgsGeometry
+  QVector< QgsGeometry > parts;
+  QgsGeometry result;
+  bool usedSlowRoute = false;
+};
+
+static void unionBlock( QgsDissolveBlock &block, QgsProcessingFeedback *feedback )
+{
+  block.result = QgsGeometry::unaryUnion( block.parts );
+  // Geos may fail in some cases, let's try a slower but safer approach
+  // See: https://github.com/qgis/QGIS/issues/28411 - Dissolve tool failing to produce outputs
+  if ( ! block.result.lastError().isEmpty() && block.parts.count() > 2 && !feedback->isCanceled() )
   {
-    QgsGeometry result( QgsGeometry::unaryUnion( parts ) );
-    if ( QgsWkbTypes::geometryType( result.wkbType() ) == QgsWkbTypes::LineGeometry )
-      result = result.mergeLines();
-    // Geos may fail in some cases, let's try a slower but safer approach
-    // See: https://github.com/qgis/QGIS/issues/28411 - Dissolve tool failing to produce outputs
-    if ( ! result.lastError().isEmpty() && parts.count() >  2 )
+    block.usedSlowRoute = true;
+    block.result = QgsGeometry();
+    for ( const QgsGeometry &p : qgis::as_const( block.parts ) )
     {
+      block.result = QgsGeometry::unaryUnion( QVector< QgsGeometry >() << block.result << p );
+      if ( QgsWkbTypes::geometryType( block.result.wkbType() ) == QgsWkbTypes::LineGeometry )
+        block.result = block.result.mergeLines();
       if ( feedback->isCanceled() )
-        return result;
+        break;
+    }
+  }
+  block.parts.clear();
+}
 
-      feedback->pushDebugInfo( QObject::tr( "GEOS exception: taking the slower route ..." ) );
-      result = QgsGeometry();
-      for ( const auto &p : parts )
-      {
-        result = QgsGeometry::unaryUnion( QVector< QgsGeometry >() << result << p );
-        if ( QgsWkbTypes::geometryType( result.wkbType() ) == QgsWkbTypes::LineGeometry )
-          result = result.mergeLines();
-        if ( feedback->isCanceled() )
-          return result;
-      }
+//! Interleaves the bits of \a x and \a y, giving the position of a cell along a Z-order curve
+static quint64 zOrderKey( quint32 x, quint32 y )
+{
+  auto spread = []( quint64 v ) -> quint64
+  {
+    v = ( v | ( v << 16 ) ) & 0x0000FFFF0000FFFFULL;
+    v = ( v | ( v << 8 ) ) & 0x00FF00FF00FF00FFULL;
+    v = ( v | ( v << 4 ) ) & 0x0F0F0F0F0F0F0F0FULL;
+    v = ( v | ( v << 2 ) ) & 0x3333333333333333ULL;
+    v = ( v | ( v << 1 ) ) & 0x5555555555555555ULL;
+    return v;
+  };
+  return spread( x ) | ( spread( y ) << 1 );
+}
+
+/**
+ * Unions \a parts with a balanced tree of unions: the parts are sorted along a space filling curve,
+ * unioned in blocks of neighboring parts, then the block results are unioned in small groups
+ * until a single geometry remains. Each level of the tree is processed on the global thread pool.
+ *
+ * This avoids repeatedly unioning new parts into an ever growing result, and keeps each union
+ * call local and small. The first GEOS error encountered in the tree is stored in \a error.
+ */
+static QgsGeometry cascadedUnion( const QVector< QgsGeometry > &parts, QgsProcessingFeedback *feedback, bool &usedSlowRoute, QString &error )
+{
+  QgsRectangle extent;
+  bool first = true;
+  for ( const QgsGeometry &part : parts )
+  {
+    const QgsRectangle box = part.boundingBox();
+    if ( first )
+    {
+      extent = box;
+      first = false;
+    }
+    else
+    {
+      extent.setXMinimum( std::min( extent.xMinimum(), box.xMinimum() ) );
+      extent.setYMinimum( std::min( extent.yMinimum(), box.yMinimum() ) );
+      extent.setXMaximum( std::max( extent.xMaximum(), box.xMaximum() ) );
+      extent.setYMaximum( std::max( extent.yMaximum(), box.yMaximum() ) );
     }
-    if ( ! result.lastError().isEmpty() )
+  }
+
+  QVector< QPair< quint64, int > > order;
+  order.reserve( parts.size() );
+  const double cellWidth = extent.width() > 0 ? extent.width() / 0xFFFF : 1;
+  const double cellHeight = extent.height() > 0 ? extent.height() / 0xFFFF : 1;
+  // cells are clamped to the grid before being converted to unsigned values, in case of
+  // non finite coordinates
+  auto gridCell = []( double offset, double cellSize ) -> quint32
+  {
+    const double cell = offset / cellSize;
+    if ( !( cell > 0 ) )
+      return 0;
+    return static_cast< quint32 >( std::min( cell, static_cast< double >( 0xFFFF ) ) );
+  };
+  for ( int i = 0; i < parts.size(); ++i )
+  {
+    const QgsPointXY center = parts.at( i ).boundingBox().center();
+    const quint32 x = gridCell( center.x() - extent.xMinimum(), cellWidth );
+    const quint32 y = gridCell( center.y() - extent.yMinimum(), cellHeight );
+    order << qMakePair( zOrderKey( x, y ), i );
+  }
+  std::sort( order.begin(), order.end() );
+
+  QVector< QgsGeometry > current;
+  current.reserve( parts.size() );
+  for ( const auto &item : qgis::as_const( order ) )
+    current << parts.at( item.second );
+
+  int blockSize = DISSOLVE_BLOCK_SIZE;
+  while ( !current.isEmpty() )
+  {
+    QVector< QgsDissolveBlock > blocks;
+    for ( int i = 0; i < current.size(); i += blockSize )
+    {
+      QgsDissolveBlock block;
+      block.parts = current.mid( i, blockSize );
+      blocks << block;
+    }
+    current.clear();
+
+    QtConcurrent::blockingMap( blocks, [feedback]( QgsDissolveBlock & block ) { unionBlock( block, feedback ); } );
+
+    for ( const QgsDissolveBlock &block : qgis::as_const( blocks ) )
+    {
+      current << block.result;
+      usedSlowRoute |= block.usedSlowRoute;
+      if ( error.isEmpty() )
+        error = block.result.lastError();
+    }
+
+    if ( current.size() == 1 || feedback->isCanceled() )
+      break;
+
+    blockSize = DISSOLVE_FAN_IN;
+  }
+
+  return current.value( 0 );
+}
+
+QVariantMap QgsDissolveAlgorithm::processAlgorithm( const QVariantMap &parameters, QgsProcessingContext &context, QgsProcessingFeedback *feedback )
+{
+  return processCollection( parameters, context, feedback, [ & ]( const QVector< QgsGeometry > &parts )->QgsGeometry
+  {
+    bool usedSlowRoute = false;
+    QString error;
+    QgsGeometry result = cascadedUnion( parts, feedback, usedSlowRoute, error );
+    if ( usedSlowRoute )
+      feedback->pushDebugInfo( QObject::tr( "GEOS exception: taking the slower route ..." ) );
+    if ( feedback->isCanceled() )
+      return result;
+
+    if ( QgsWkbTypes::geometryType( result.wkbType() ) == QgsWkbTypes::LineGeometry )
+      result = result.mergeLines();
+    if ( error.isEmpty() )
+      error = result.lastError();
+    if ( ! error.isEmpty() )
     {
-      feedback->reportError( result.lastError(), true );
+      feedback->reportError( error, true );
       if ( result.isEmpty() )
         throw QgsProcessingException( QObject::tr( "The algorithm returned no output." ) );
     }
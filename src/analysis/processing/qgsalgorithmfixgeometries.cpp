@@ -18,8 +18,13 @@
 #include "qgsalgorithmfixgeometries.h"
 #include "qgsvectorlayer.h"
 
+#include <QtConcurrentMap>
+
 ///@cond PRIVATE
 
+// number of features read from the source before their geometries are fixed in parallel
+static const int FIX_CHUNK_SIZE = 1000;
+
 QString QgsFixGeometriesAlgorithm::name() const
 {
   return QStringLiteral( "fixgeometries" );
@@ -85,19 +90,19 @@ bool QgsFixGeometriesAlgorithm::supportInPlaceEdit( const QgsMapLayer *l ) const
   return ! QgsWkbTypes::hasM( layer->wkbType() );
 }
 
-QgsFeatureList QgsFixGeometriesAlgorithm::processFeature( const QgsFeature &feature, QgsProcessingContext &, QgsProcessingFeedback *feedback )
+QgsFeature QgsFixGeometriesAlgorithm::fixFeature( const QgsFeature &feature, QString &message )
 {
   if ( !feature.hasGeometry() )
-    return QgsFeatureList() << feature;
+    return feature;
 
   QgsFeature outputFeature = feature;
 
   QgsGeometry outputGeometry = outputFeature.geometry().makeValid();
   if ( outputGeometry.isNull() )
   {
-    feedback->pushInfo( QObject::tr( "makeValid failed for feature %1 " ).arg( feature.id() ) );
+    message = QObject::tr( "makeValid failed for feature %1 " ).arg( feature.id() );
     outputFeature.clearGeometry();
-    return QgsFeatureList() << outputFeature;
+    return outputFeature;
   }
 
   if ( outputGeometry.wkbType() == QgsWkbTypes::Unknown ||
@@ -121,14 +126,92 @@ QgsFeatureList QgsFixGeometriesAlgorithm::processFeature( const QgsFeature &feat
   if ( QgsWkbTypes::geometryType( outputGeometry.wkbType() ) != QgsWkbTypes::geometryType( feature.geometry().wkbType() ) )
   {
     // don't keep geometries which have different types - e.g. lines converted to points
-    feedback->pushInfo( QObject::tr( "Fixing geometry for feature %1 resulted in %2, geometry has been dropped." ).arg( feature.id() ).arg( QgsWkbTypes::displayString( outputGeometry.wkbType() ) ) );
+    message = QObject::tr( "Fixing geometry for feature %1 resulted in %2, geometry has been dropped." ).arg( feature.id() ).arg( QgsWkbTypes::displayString( outputGeometry.wkbType() ) );
     outputFeature.clearGeometry();
   }
   else
   {
     outputFeature.setGeometry( outputGeometry );
   }
+  return outputFeature;
+}
+
+QgsFeatureList QgsFixGeometriesAlgorithm::processFeature( const QgsFeature &feature, QgsProcessingContext &, QgsProcessingFeedback *feedback )
+{
+  QString message;
+  const QgsFeature outputFeature = fixFeature( feature, message );
+  if ( !message.isEmpty() )
+    feedback->pushInfo( message );
   return QgsFeatureList() << outputFeature;
 }
 
+QVariantMap QgsFixGeometriesAlgorithm::processAlgorithm( const QVariantMap &parameters, QgsProcessingContext &context, QgsProcessingFeedback *feedback )
+{
+  std::unique_ptr< QgsProcessingFeatureSource > source( parameterAsSource( parameters, inputParameterName(), context ) );
+  if ( !source )
+    throw QgsProcessingException( invalidSourceError( parameters, inputParameterName() ) );
+
+  QString dest;
+  std::unique_ptr< QgsFeatureSink > sink( parameterAsSink( parameters, QStringLiteral( "OUTPUT" ), context, dest,
+                                          outputFields( source->fields() ),
+                                          outputWkbType( source->wkbType() ),
+                                          outputCrs( source->sourceCrs() ),
+                                          sinkFlags() ) );
+  if ( !sink )
+    throw QgsProcessingException( invalidSinkError( parameters, QStringLiteral( "OUTPUT" ) ) );
+
+  struct FixedFeature
+  {
+    QgsFeature feature;
+    QString message;
+  };
+
+  const long count = source->featureCount();
+  const double step = count > 0 ? 100.0 / count : 1;
+  long current = 0;
+
+  // features are read and written on this thread in chunks, while the geometries of
+  // each chunk are fixed in parallel. Output features keep the order of the input.
+  QgsFeatureIterator it = source->getFeatures( request(), sourceFlags() );
+  QVector< FixedFeature > chunk;
+  chunk.reserve( FIX_CHUNK_SIZE );
+  QgsFeature f;
+  bool atEnd = false;
+  while ( !atEnd )
+  {
+    if ( feedback->isCanceled() )
+      break;
+
+    chunk.clear();
+    while ( chunk.size() < FIX_CHUNK_SIZE )
+    {
+      if ( !it.nextFeature( f ) )
+      {
+        atEnd = true;
+        break;
+      }
+      chunk.append( FixedFeature{ f, QString() } );
+    }
+
+    QtConcurrent::blockingMap( chunk, []( FixedFeature & fixed )
+    {
+      fixed.feature = fixFeature( fixed.feature, fixed.message );
+    } );
+
+    for ( FixedFeature &fixed : chunk )
+    {
+      if ( !fixed.message.isEmpty() )
+        feedback->pushInfo( fixed.message );
+      sink->addFeature( fixed.feature, QgsFeatureSink::FastInsert );
+    }
+
+    current += chunk.size();
+    feedback->setProgress( current * step );
+  }
+
+  QVariantMap outputs;
+  outputs.insert( QStringLiteral( "OUTPUT" ), dest );
+  return outputs;
+}
+
 ///@endcond
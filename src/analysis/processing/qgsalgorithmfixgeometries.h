@@ -48,6 +48,17 @@ class QgsFixGeometriesAlgorithm : public QgsProcessingFeatureBasedAlgorithm
     QString outputName() const override;
     QgsWkbTypes::Type outputWkbType( QgsWkbTypes::Type type ) const override;
     QgsFeatureList processFeature( const QgsFeature &feature,  QgsProcessingContext &context, QgsProcessingFeedback *feedback ) override;
+    QVariantMap processAlgorithm( const QVariantMap &parameters, QgsProcessingContext &context, QgsProcessingFeedback *feedback ) override;
+
+  private:
+
+    /**
+     * Returns a copy of \a feature with a fixed geometry. If the geometry could not be fixed, the
+     * returned feature has no geometry and \a message is set to the reason.
+     *
+     * This method is safe to call from any thread.
+     */
+    static QgsFeature fixFeature( const QgsFeature &feature, QString &message );
 
 };
 
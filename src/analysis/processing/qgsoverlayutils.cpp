@@ -18,6 +18,10 @@
 #include "qgsgeometryengine.h"
 #include "qgsprocessingalgorithm.h"
 
+#include <QThread>
+#include <QtConcurrentMap>
+#include <limits>
+
 ///@cond PRIVATE
 
 bool QgsOverlayUtils::sanitizeIntersectionResult( QgsGeometry &geom, QgsWkbTypes::GeometryType geometryType )
@@ -82,8 +86,445 @@ static bool sanitizeDifferenceResult( QgsGeometry &geom, QgsWkbTypes::GeometryTy
 }
 
 
+//! Inputs with fewer features are processed serially, splitting them would not pay off
+static const long PARALLEL_OVERLAY_MIN_FEATURES = 10000;
+
+//! Average number of features of the first input in each tile
+static const long TILED_OVERLAY_FEATURES_PER_TILE = 1000;
+
+//! Number of features of the first input read at once per thread by the parallel difference
+static const int PARALLEL_DIFFERENCE_FEATURES_PER_THREAD = 1000;
+
+/**
+ * Regular grid partitioning the extent of the first overlay input in tiles, which are
+ * processed independently.
+ *
+ * A feature (or pair of features) may intersect several tiles, but it is owned by the
+ * single tile containing a reference point: the corner of its bounding box (or of the
+ * intersection of the bounding boxes of the pair) with the minimum coordinates. Only
+ * the owning tile writes it out, so every output feature is created exactly once and
+ * the results do not depend on the processing order.
+ */
+class QgsOverlayTileGrid
+{
+  public:
+
+    QgsOverlayTileGrid( const QgsRectangle &extent, long featureCount )
+      : mExtent( extent )
+    {
+      const int tilesPerSide = std::max( 1, static_cast< int >( std::ceil( std::sqrt( static_cast< double >( featureCount ) / TILED_OVERLAY_FEATURES_PER_TILE ) ) ) );
+      mColumns = mExtent.width() > 0 ? tilesPerSide : 1;
+      mRows = mExtent.height() > 0 ? tilesPerSide : 1;
+      mTileWidth = mExtent.width() / mColumns;
+      mTileHeight = mExtent.height() / mRows;
+    }
+
+    int tileCount() const { return mColumns * mRows; }
+
+    //! Returns the tile owning the reference point \a x, \a y
+    int tileForPoint( double x, double y ) const
+    {
+      return cell( y, mExtent.yMinimum(), mTileHeight, mRows ) * mColumns + cell( x, mExtent.xMinimum(), mTileWidth, mColumns );
+    }
+
+    /**
+     * Returns the rectangle to read the features of a \a tile from. It is slightly larger than
+     * the tile, and tiles on the border of the grid are unbounded on their outer sides, so that
+     * features outside of a stale or estimated source extent are still read by the tile owning them.
+     */
+    QgsRectangle readRect( int tile ) const
+    {
+      const int column = tile % mColumns;
+      const int row = tile / mColumns;
+      const double marginX = std::max( mTileWidth * 1e-6, 1e-9 );
+      const double marginY = std::max( mTileHeight * 1e-6, 1e-9 );
+      const double unbounded = std::numeric_limits< double >::max();
+
+      const double xMin = column == 0 ? -unbounded : mExtent.xMinimum() + column * mTileWidth - marginX;
+      const double xMax = column == mColumns - 1 ? unbounded : mExtent.xMinimum() + ( column + 1 ) * mTileWidth + marginX;
+      const double yMin = row == 0 ? -unbounded : mExtent.yMinimum() + row * mTileHeight - marginY;
+      const double yMax = row == mRows - 1 ? unbounded : mExtent.yMinimum() + ( row + 1 ) * mTileHeight + marginY;
+      return QgsRectangle( xMin, yMin, xMax, yMax );
+    }
+
+  private:
+
+    static int cell( double value, double origin, double size, int count )
+    {
+      if ( size <= 0 || count == 1 || !std::isfinite( value ) )
+        return 0;
+      const double position = std::floor( ( value - origin ) / size );
+      if ( position < 0 )
+        return 0;
+      if ( position >= count - 1 )
+        return count - 1;
+      return static_cast< int >( position );
+    }
+
+    QgsRectangle mExtent;
+    int mColumns = 1;
+    int mRows = 1;
+    double mTileWidth = 0;
+    double mTileHeight = 0;
+};
+
+//! Input and results of the overlay of a single tile
+struct QgsOverlayTile
+{
+  int index = 0;
+  QgsFeatureList featuresA;
+  QgsFeatureList featuresB;
+  QgsFeatureList output;
+  int processed = 0;
+  QString error;
+};
+
+//! Returns TRUE if the tiled parallel overlay should be used for the first input \a sourceA
+static bool useTiledOverlay( const QgsFeatureSource &sourceA )
+{
+  return sourceA.featureCount() >= PARALLEL_OVERLAY_MIN_FEATURES && !sourceA.sourceExtent().isEmpty();
+}
+
+/**
+ * Runs the overlay tile by tile. Tiles are processed in groups: the features of a group are read
+ * on the calling thread (feature sources cannot be used from several threads), the group is
+ * processed on the global thread pool, and its results are written to the \a sink in tile order.
+ */
+static void processOverlayTiles( const QgsOverlayTileGrid &grid, const std::function< void( QgsOverlayTile & ) > &load, const std::function< void( QgsOverlayTile & ) > &process,
+                                 QgsFeatureSink &sink, QgsProcessingFeedback *feedback, int &count, int totalCount )
+{
+  const int groupSize = 2 * std::max( 1, QThread::idealThreadCount() );
+  for ( int first = 0; first < grid.tileCount(); first += groupSize )
+  {
+    if ( feedback->isCanceled() )
+      return;
+
+    QVector< QgsOverlayTile > tiles;
+    for ( int tile = first; tile < std::min( first + groupSize, grid.tileCount() ); ++tile )
+    {
+      QgsOverlayTile overlayTile;
+      overlayTile.index = tile;
+      load( overlayTile );
+      tiles << overlayTile;
+    }
+
+    QtConcurrent::blockingMap( tiles, [&process]( QgsOverlayTile & tile )
+    {
+      // exceptions cannot cross the thread pool, they are rethrown from the calling thread
+      try
+      {
+        process( tile );
+      }
+      catch ( QgsProcessingException &e )
+      {
+        tile.error = e.what();
+      }
+      tile.featuresA.clear();
+      tile.featuresB.clear();
+    } );
+
+    for ( QgsOverlayTile &tile : tiles )
+    {
+      if ( !tile.error.isEmpty() )
+        throw QgsProcessingException( tile.error );
+
+      sink.addFeatures( tile.output, QgsFeatureSink::FastInsert );
+      count += tile.processed;
+    }
+    feedback->setProgress( count / ( double ) totalCount * 100. );
+  }
+}
+
+//! Parallel version of QgsOverlayUtils::difference(), writing the output in the order of the features of \a sourceA
+static void parallelDifference( const QgsFeatureSource &sourceA, const QgsFeatureSource &sourceB, QgsFeatureSink &sink, QgsProcessingContext &context, QgsProcessingFeedback *feedback, int &count, int totalCount, QgsOverlayUtils::DifferenceOutput outputAttrs )
+{
+  QgsWkbTypes::GeometryType geometryType = QgsWkbTypes::geometryType( QgsWkbTypes::multiType( sourceA.wkbType() ) );
+  QgsFeatureRequest requestB;
+  requestB.setNoAttributes();
+  if ( outputAttrs != QgsOverlayUtils::OutputBA )
+    requestB.setDestinationCrs( sourceA.sourceCrs(), context.transformContext() );
+  QgsSpatialIndex indexB( sourceB.getFeatures( requestB ), feedback );
+
+  const int fieldsCountA = sourceA.fields().count();
+  const int fieldsCountB = sourceB.fields().count();
+  const int attrCount = outputAttrs == QgsOverlayUtils::OutputA ? fieldsCountA : ( fieldsCountA + fieldsCountB );
+
+  QgsFeatureRequest requestA;
+  requestA.setInvalidGeometryCheck( context.invalidGeometryCheck() );
+  if ( outputAttrs == QgsOverlayUtils::OutputBA )
+    requestA.setDestinationCrs( sourceB.sourceCrs(), context.transformContext() );
+  QgsFeatureIterator fitA = sourceA.getFeatures( requestA );
+
+  struct Item
+  {
+    QgsFeature feature;
+    QList< QgsFeatureId > intersects;
+    QgsFeature output;
+    bool hasOutput = false;
+    QString error;
+  };
+
+  // the features of the first source are read in chunks, the differences of a chunk are
+  // computed in parallel and written in the original order
+  const int chunkSize = PARALLEL_DIFFERENCE_FEATURES_PER_THREAD * std::max( 1, QThread::idealThreadCount() );
+  bool atEnd = false;
+  while ( !atEnd && !feedback->isCanceled() )
+  {
+    QVector< Item > items;
+    items.reserve( chunkSize );
+    QgsFeatureIds idsB;
+    QgsFeature featA;
+    while ( items.size() < chunkSize )
+    {
+      if ( !fitA.nextFeature( featA ) )
+      {
+        atEnd = true;
+        break;
+      }
+
+      Item item;
+      item.feature = featA;
+      if ( featA.hasGeometry() )
+      {
+        item.intersects = indexB.intersects( featA.geometry().boundingBox() );
+        std::sort( item.intersects.begin(), item.intersects.end() );
+        for ( QgsFeatureId id : qgis::as_const( item.intersects ) )
+          idsB.insert( id );
+      }
+      items << item;
+    }
+
+    // feature sources cannot be used from several threads, so the candidate geometries
+    // of the second source are read for the whole chunk first
+    QHash< QgsFeatureId, QgsGeometry > geometriesB;
+    if ( !idsB.isEmpty() )
+    {
+      QgsFeatureRequest request( requestB );
+      request.setFilterFids( idsB );
+      QgsFeatureIterator fitB = sourceB.getFeatures( request );
+      QgsFeature featB;
+      while ( fitB.nextFeature( featB ) )
+        geometriesB.insert( featB.id(), featB.geometry() );
+    }
+
+    QtConcurrent::blockingMap( items, [&]( Item & item )
+    {
+      if ( !item.feature.hasGeometry() )
+      {
+        // as in the serial code path, features without geometry are written unchanged
+        item.output = item.feature;
+        item.hasOutput = true;
+        return;
+      }
+
+      if ( feedback->isCanceled() )
+        return;
+
+      QgsGeometry geom( item.feature.geometry() );
+      QVector<QgsGeometry> intersectingB;
+      if ( !item.intersects.isEmpty() )
+      {
+        // use prepared geometries for faster intersection tests
+        std::unique_ptr< QgsGeometryEngine > engine( QgsGeometry::createGeometryEngine( geom.constGet() ) );
+        engine->prepareGeometry();
+        for ( QgsFeatureId id : qgis::as_const( item.intersects ) )
+        {
+          const QgsGeometry geometryB = geometriesB.value( id );
+          if ( !geometryB.isNull() && engine->intersects( geometryB.constGet() ) )
+            intersectingB << geometryB;
+        }
+      }
+
+      // exceptions cannot cross the thread pool, they are rethrown from the calling thread
+      try
+      {
+        if ( !intersectingB.isEmpty() )
+        {
+          QgsGeometry geomB = QgsGeometry::unaryUnion( intersectingB );
+          if ( !geomB.lastError().isEmpty() )
+          {
+            throw QgsProcessingException( QStringLiteral( "%1\n\n%2" ).arg( QObject::tr( "GEOS geoprocessing error: unary union failed." ), geomB.lastError() ) );
+          }
+          geom = geom.difference( geomB );
+        }
+
+        if ( !sanitizeDifferenceResult( geom, geometryType ) )
+          return;
+      }
+      catch ( QgsProcessingException &e )
+      {
+        item.error = e.what();
+        return;
+      }
+
+      QgsAttributes attrs( attrCount );
+      const QgsAttributes attrsA( item.feature.attributes() );
+      switch ( outputAttrs )
+      {
+        case QgsOverlayUtils::OutputA:
+          attrs = attrsA;
+          break;
+        case QgsOverlayUtils::OutputAB:
+          for ( int i = 0; i < fieldsCountA; ++i )
+            attrs[i] = attrsA[i];
+          break;
+        case QgsOverlayUtils::OutputBA:
+          for ( int i = 0; i < fieldsCountA; ++i )
+            attrs[i + fieldsCountB] = attrsA[i];
+          break;
+      }
+
+      item.output.setGeometry( geom );
+      item.output.setAttributes( attrs );
+      item.hasOutput = true;
+    } );
+
+    for ( const Item &item : qgis::as_const( items ) )
+    {
+      if ( !item.error.isEmpty() )
+        throw QgsProcessingException( item.error );
+
+      if ( item.hasOutput )
+        sink.addFeature( item.output, QgsFeatureSink::FastInsert );
+      ++count;
+    }
+    feedback->setProgress( count / ( double ) totalCount * 100. );
+  }
+}
+
+/**
+ * Tiled and parallel version of QgsOverlayUtils::intersection(). The output is written
+ * tile by tile, so its order differs from the one of the serial code path.
+ */
+static void tiledIntersection( const QgsFeatureSource &sourceA, const QgsFeatureSource &sourceB, QgsFeatureSink &sink, QgsProcessingContext &context, QgsProcessingFeedback *feedback, int &count, int totalCount, const QList<int> &fieldIndicesA, const QList<int> &fieldIndicesB )
+{
+  QgsWkbTypes::GeometryType geometryType = QgsWkbTypes::geometryType( QgsWkbTypes::multiType( sourceA.wkbType() ) );
+  const int attrCount = fieldIndicesA.count() + fieldIndicesB.count();
+
+  const QgsOverlayTileGrid grid( sourceA.sourceExtent(), sourceA.featureCount() );
+
+  auto load = [&]( QgsOverlayTile & tile )
+  {
+    const QgsRectangle rect = grid.readRect( tile.index );
+    QgsFeatureIterator fitA = sourceA.getFeatures( QgsFeatureRequest().setSubsetOfAttributes( fieldIndicesA ).setFilterRect( rect ) );
+    QgsFeature f;
+    QgsRectangle extentA;
+    while ( fitA.nextFeature( f ) )
+    {
+      if ( f.hasGeometry() )
+      {
+        tile.featuresA << f;
+        extentA.combineExtentWith( f.geometry().boundingBox() );
+      }
+    }
+
+    if ( tile.featuresA.isEmpty() )
+      return;
+
+    // only features intersecting those of the first input matter. Unlike the tile rectangle, their
+    // extent is always bounded, so it can be transformed to the CRS of the second input
+    QgsFeatureRequest requestB;
+    requestB.setDestinationCrs( sourceA.sourceCrs(), context.transformContext() );
+    requestB.setSubsetOfAttributes( fieldIndicesB );
+    requestB.setFilterRect( extentA );
+    QgsFeatureIterator fitB = sourceB.getFeatures( requestB );
+    while ( fitB.nextFeature( f ) )
+    {
+      if ( f.hasGeometry() )
+        tile.featuresB << f;
+    }
+  };
+
+  auto process = [&]( QgsOverlayTile & tile )
+  {
+    QgsSpatialIndex indexB;
+    QHash< QgsFeatureId, int > positionsB;
+    for ( int i = 0; i < tile.featuresB.count(); ++i )
+    {
+      indexB.addFeature( tile.featuresB[i] );
+      positionsB.insert( tile.featuresB.at( i ).id(), i );
+    }
+
+    QgsAttributes outAttributes( attrCount );
+    for ( const QgsFeature &featA : qgis::as_const( tile.featuresA ) )
+    {
+      if ( feedback->isCanceled() )
+        return;
+
+      QgsGeometry geom( featA.geometry() );
+      const QgsRectangle boxA = geom.boundingBox();
+      if ( grid.tileForPoint( boxA.xMinimum(), boxA.yMinimum() ) == tile.index )
+        tile.processed++;
+
+      QList< QgsFeatureId > intersects = indexB.intersects( boxA );
+      if ( intersects.isEmpty() )
+        continue;
+      std::sort( intersects.begin(), intersects.end() );
+
+      // use prepared geometries for faster intersection tests, the engine's GEOS
+      // representation of geom is also reused when computing the intersections
+      std::unique_ptr< QgsGeometryEngine > engine( QgsGeometry::createGeometryEngine( geom.constGet() ) );
+      engine->prepareGeometry();
+
+      const QgsAttributes attrsA( featA.attributes() );
+      for ( int i = 0; i < fieldIndicesA.count(); ++i )
+        outAttributes[i] = attrsA[fieldIndicesA[i]];
+
+      for ( QgsFeatureId id : qgis::as_const( intersects ) )
+      {
+        const QgsFeature &featB = tile.featuresB.at( positionsB.value( id ) );
+        const QgsGeometry tmpGeom( featB.geometry() );
+
+        // a pair of features is handled by the tile owning the corner of their common bounding box
+        const QgsRectangle boxB = tmpGeom.boundingBox();
+        if ( grid.tileForPoint( std::max( boxA.xMinimum(), boxB.xMinimum() ), std::max( boxA.yMinimum(), boxB.yMinimum() ) ) != tile.index )
+          continue;
+
+        if ( !engine->intersects( tmpGeom.constGet() ) )
+          continue;
+
+        QgsGeometry intGeom( engine->intersection( tmpGeom.constGet() ) );
+        if ( !QgsOverlayUtils::sanitizeIntersectionResult( intGeom, geometryType ) )
+          continue;
+
+        const QgsAttributes attrsB( featB.attributes() );
+        for ( int i = 0; i < fieldIndicesB.count(); ++i )
+          outAttributes[fieldIndicesA.count() + i] = attrsB[fieldIndicesB[i]];
+
+        QgsFeature outFeat;
+        outFeat.setGeometry( intGeom );
+        outFeat.setAttributes( outAttributes );
+        tile.output << outFeat;
+      }
+    }
+  };
+
+  const int countBefore = count;
+  processOverlayTiles( grid, load, process, sink, feedback, count, totalCount );
+  if ( feedback->isCanceled() )
+    return;
+
+  // features without geometry are never returned for the tiles' rectangles, they have
+  // nothing to intersect but still count as processed
+  const long withoutGeometry = sourceA.featureCount() - ( count - countBefore );
+  if ( withoutGeometry > 0 )
+  {
+    count += static_cast< int >( withoutGeometry );
+    feedback->setProgress( count / ( double ) totalCount * 100. );
+  }
+}
+
 void QgsOverlayUtils::difference( const QgsFeatureSource &sourceA, const QgsFeatureSource &sourceB, QgsFeatureSink &sink, QgsProcessingContext &context, QgsProcessingFeedback *feedback, int &count, int totalCount, QgsOverlayUtils::DifferenceOutput outputAttrs )
 {
+  if ( totalCount == 0 )
+    totalCount = 1;  // avoid division by zero
+
+  if ( sourceA.featureCount() >= PARALLEL_OVERLAY_MIN_FEATURES )
+  {
+    parallelDifference( sourceA, sourceB, sink, context, feedback, count, totalCount, outputAttrs );
+    return;
+  }
+
   QgsWkbTypes::GeometryType geometryType = QgsWkbTypes::geometryType( QgsWkbTypes::multiType( sourceA.wkbType() ) );
   QgsFeatureRequest requestB;
   requestB.setNoAttributes();
@@ -96,9 +537,6 @@ void QgsOverlayUtils::difference( const QgsFeatureSource &sourceA, const QgsFeat
   QgsAttributes attrs;
   attrs.resize( outputAttrs == OutputA ? fieldsCountA : ( fieldsCountA + fieldsCountB ) );
 
-  if ( totalCount == 0 )
-    totalCount = 1;  // avoid division by zero
-
   QgsFeature featA;
   QgsFeatureRequest requestA;
   requestA.setInvalidGeometryCheck( context.invalidGeometryCheck() );
@@ -194,6 +632,15 @@ void QgsOverlayUtils::difference( const QgsFeatureSource &sourceA, const QgsFeat
 
 void QgsOverlayUtils::intersection( const QgsFeatureSource &sourceA, const QgsFeatureSource &sourceB, QgsFeatureSink &sink, QgsProcessingContext &context, QgsProcessingFeedback *feedback, int &count, int totalCount, const QList<int> &fieldIndicesA, const QList<int> &fieldIndicesB )
 {
+  if ( totalCount == 0 )
+    totalCount = 1;  // avoid division by zero
+
+  if ( useTiledOverlay( sourceA ) )
+  {
+    tiledIntersection( sourceA, sourceB, sink, context, feedback, count, totalCount, fieldIndicesA, fieldIndicesB );
+    return;
+  }
+
   QgsWkbTypes::GeometryType geometryType = QgsWkbTypes::geometryType( QgsWkbTypes::multiType( sourceA.wkbType() ) );
   int attrCount = fieldIndicesA.count() + fieldIndicesB.count();
 
@@ -204,9 +651,6 @@ void QgsOverlayUtils::intersection( const QgsFeatureSource &sourceA, const QgsFe
   QgsFeature outFeat;
   QgsSpatialIndex indexB( sourceB.getFeatures( request ), feedback );
 
-  if ( totalCount == 0 )
-    totalCount = 1;  // avoid division by zero
-
   QgsFeature featA;
   QgsFeatureIterator fitA = sourceA.getFeatures( QgsFeatureRequest().setSubsetOfAttributes( fieldIndicesA ) );
   while ( fitA.nextFeature( featA ) )
@@ -228,7 +672,8 @@ void QgsOverlayUtils::intersection( const QgsFeatureSource &sourceA, const QgsFe
     std::unique_ptr< QgsGeometryEngine > engine;
     if ( !intersects.isEmpty() )
     {
-      // use prepared geometries for faster intersection tests
+      // use prepared geometries for faster intersection tests, the engine's GEOS
+      // representation of geom is also reused when computing the intersections
       engine.reset( QgsGeometry::createGeometryEngine( geom.constGet() ) );
       engine->prepareGeometry();
     }
@@ -249,7 +694,7 @@ void QgsOverlayUtils::intersection( const QgsFeatureSource &sourceA, const QgsFe
       if ( !engine->intersects( tmpGeom.constGet() ) )
         continue;
 
-      QgsGeometry intGeom = geom.intersection( tmpGeom );
+      QgsGeometry intGeom( engine->intersection( tmpGeom.constGet() ) );
       if ( !sanitizeIntersectionResult( intGeom, geometryType ) )
         continue;
 
@@ -59,6 +59,8 @@
 #include "pal/labelposition.h"
 
 #include <QIODevice>
+#include <QThreadPool>
+#include <QtConcurrentRun>
 
 QgsDxfExport::QgsDxfExport() = default;
 
@@ -633,14 +635,42 @@ void QgsDxfExport::writeEntities()
 
   mBlockHandle = QString::number( mBlockHandles[ QStringLiteral( "*Model_Space" )], 16 );
 
-  // iterate through the maplayers
+  auto usesSymbolLevels = [this]( const DxfLayerJob * job )
+  {
+    return mSymbologyExport == QgsDxfExport::SymbolLayerSymbology &&
+           ( job->renderer->capabilities() & QgsFeatureRenderer::SymbolLevels ) &&
+           job->renderer->usingSymbolLevels();
+  };
+
+  // fetch the features of all layers in the background, while the entities are written
+  // in layer order on this thread. A dedicated pool is used, so that fetching cannot be
+  // starved by other tasks (e.g. if this export itself runs in the global pool).
+  QThreadPool fetchPool;
+  std::vector< std::unique_ptr< DxfFeatureFetcher > > fetchers;
+  fetchers.reserve( mJobs.size() );
   for ( DxfLayerJob *job : qgis::as_const( mJobs ) )
   {
+    if ( usesSymbolLevels( job ) )
+    {
+      fetchers.emplace_back( nullptr );
+      continue;
+    }
+
+    QgsCoordinateTransform ct( mMapSettings.destinationCrs(), job->crs, mMapSettings.transformContext() );
+
+    QgsFeatureRequest request = QgsFeatureRequest().setSubsetOfAttributes( job->attributes, job->fields ).setExpressionContext( job->renderContext.expressionContext() );
+    request.setFilterRect( ct.transform( mExtent ) );
+
+    fetchers.emplace_back( qgis::make_unique< DxfFeatureFetcher >( job, request, &fetchPool ) );
+  }
+
+  // iterate through the maplayers
+  for ( int i = 0; i < mJobs.size(); ++i )
+  {
+    DxfLayerJob *job = mJobs.at( i );
     QgsSymbolRenderContext sctx( mRenderContext, QgsUnitTypes::RenderMillimeters, 1.0, false, QgsSymbol::RenderHints(), nullptr );
 
-    if ( mSymbologyExport == QgsDxfExport::SymbolLayerSymbology &&
-         ( job->renderer->capabilities() & QgsFeatureRenderer::SymbolLevels ) &&
-         job->renderer->usingSymbolLevels() )
+    if ( usesSymbolLevels( job ) )
     {
       writeEntitiesSymbolLevels( job );
 
@@ -649,13 +679,10 @@ void QgsDxfExport::writeEntities()
 
     QgsCoordinateTransform ct( mMapSettings.destinationCrs(), job->crs, mMapSettings.transformContext() );
 
-    QgsFeatureRequest request = QgsFeatureRequest().setSubsetOfAttributes( job->attributes, job->fields ).setExpressionContext( job->renderContext.expressionContext() );
-    request.setFilterRect( ct.transform( mExtent ) );
-
-    QgsFeatureIterator featureIt = job->featureSource.getFeatures( request );
+    DxfFeatureFetcher *fetcher = fetchers[ i ].get();
 
     QgsFeature fet;
-    while ( featureIt.nextFeature( fet ) )
+    while ( fetcher->nextFeature( fet ) )
     {
       mRenderContext.expressionContext().setFeature( fet );
       QString lName( dxfLayerName( job->splitLayerAttribute.isNull() ? job->layerTitle : fet.attribute( job->splitLayerAttribute ).toString() ) );
@@ -733,6 +760,9 @@ void QgsDxfExport::writeEntities()
     }
   }
 
+  // the features of all layers have been written, release the memory of the fetchers
+  fetchers.clear();
+
   QImage image( 10, 10, QImage::Format_ARGB32_Premultiplied );
   image.setDotsPerMeterX( 96 / 25.4 * 1000 );
   image.setDotsPerMeterY( 96 / 25.4 * 1000 );
@@ -744,6 +774,92 @@ void QgsDxfExport::writeEntities()
   endSection();
 }
 
+DxfFeatureFetcher::DxfFeatureFetcher( DxfLayerJob *job, const QgsFeatureRequest &request, QThreadPool *pool )
+  : mJob( job )
+  , mRequest( request )
+{
+  mFuture = QtConcurrent::run( pool, this, &DxfFeatureFetcher::run );
+}
+
+DxfFeatureFetcher::~DxfFeatureFetcher()
+{
+  {
+    QMutexLocker locker( &mMutex );
+    mCanceled = true;
+    mCondition.wakeAll();
+  }
+  mFuture.waitForFinished();
+}
+
+bool DxfFeatureFetcher::nextFeature( QgsFeature &feature )
+{
+  if ( mCurrentIndex >= mCurrentBatch.size() )
+  {
+    QMutexLocker locker( &mMutex );
+    while ( mBatches.isEmpty() && !mFinished )
+      mCondition.wait( &mMutex );
+
+    if ( mBatches.isEmpty() )
+      return false;
+
+    mCurrentBatch = mBatches.dequeue();
+    mCurrentIndex = 0;
+    // there is room for another batch now
+    mCondition.wakeAll();
+  }
+
+  feature = mCurrentBatch.at( mCurrentIndex++ );
+  return true;
+}
+
+void DxfFeatureFetcher::run()
+{
+  {
+    QMutexLocker locker( &mMutex );
+    if ( mCanceled )
+      return;
+  }
+
+  QgsFeatureIterator featureIt = mJob->featureSource.getFeatures( mRequest );
+
+  QVector< QgsFeature > batch;
+  batch.reserve( BATCH_SIZE );
+  QgsFeature fet;
+  while ( featureIt.nextFeature( fet ) )
+  {
+    batch << fet;
+    if ( batch.size() == BATCH_SIZE )
+    {
+      if ( !enqueueBatch( batch ) )
+        return;
+
+      batch.clear();
+      batch.reserve( BATCH_SIZE );
+    }
+  }
+
+  if ( !batch.isEmpty() && !enqueueBatch( batch ) )
+    return;
+
+  QMutexLocker locker( &mMutex );
+  mFinished = true;
+  mCondition.wakeAll();
+}
+
+bool DxfFeatureFetcher::enqueueBatch( const QVector< QgsFeature > &batch )
+{
+  QMutexLocker locker( &mMutex );
+  while ( mBatches.size() >= MAX_QUEUED_BATCHES && !mCanceled )
+    mCondition.wait( &mMutex );
+
+  if ( mCanceled )
+    return false;
+
+  mBatches.enqueue( batch );
+  mCondition.wakeAll();
+  return true;
+}
+
 void QgsDxfExport::prepareRenderers()
 {
   Q_ASSERT( mJobs.empty() ); // If this fails, stopRenderers() was not called after the last job
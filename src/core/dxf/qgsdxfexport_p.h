@@ -24,6 +24,13 @@
 #include "qgsvectorlayerlabeling.h"
 #include "qgslabelsink.h"
 
+#include <QFuture>
+#include <QMutex>
+#include <QQueue>
+#include <QWaitCondition>
+
+class QThreadPool;
+
 /**
  * Holds information about each layer in a DXF job.
  * This can be used for multithreading.
@@ -109,6 +116,60 @@ struct DxfLayerJob
     DxfLayerJob &operator=( const DxfLayerJob & ) = delete;
 };
 
+/**
+ * Fetches the features of a DXF layer job on a worker thread, so that reading
+ * from the data provider overlaps with writing the entities of the preceding layers.
+ *
+ * Features are handed over in batches through a bounded queue. Symbol evaluation and
+ * writing stay on the thread calling nextFeature(), which must be the thread writing
+ * the DXF file.
+ */
+class DxfFeatureFetcher
+{
+  public:
+
+    /**
+     * Starts fetching the features of \a job matching \a request on a thread of \a pool.
+     */
+    DxfFeatureFetcher( DxfLayerJob *job, const QgsFeatureRequest &request, QThreadPool *pool );
+
+    /**
+     * Cancels fetching and waits for the worker thread to stop.
+     */
+    ~DxfFeatureFetcher();
+
+    /**
+     * Fetches the next feature, blocking until it is available.
+     * Returns FALSE when all features have been fetched.
+     */
+    bool nextFeature( QgsFeature &feature );
+
+  private:
+    DxfFeatureFetcher( const DxfFeatureFetcher & ) = delete;
+    DxfFeatureFetcher &operator=( const DxfFeatureFetcher & ) = delete;
+
+    void run();
+    bool enqueueBatch( const QVector< QgsFeature > &batch );
+
+    //! Number of features handed over at once
+    static const int BATCH_SIZE = 1000;
+    //! Maximum number of batches waiting to be written
+    static const int MAX_QUEUED_BATCHES = 8;
+
+    DxfLayerJob *mJob = nullptr;
+    QgsFeatureRequest mRequest;
+
+    QMutex mMutex;
+    QWaitCondition mCondition;
+    QQueue< QVector< QgsFeature > > mBatches;
+    bool mFinished = false;
+    bool mCanceled = false;
+    QFuture< void > mFuture;
+
+    QVector< QgsFeature > mCurrentBatch;
+    int mCurrentIndex = 0;
+};
+
 // dxf color palette
 static const int sDxfColors[][3] =
 {
@@ -1047,6 +1047,7 @@ class CORE_EXPORT QgsAbstractGeometry
     virtual void clearCache() const;
 
     friend class TestQgsGeometry;
+    friend class QgsGeometryTransformBatch;
 };
 
 
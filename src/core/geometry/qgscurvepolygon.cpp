@@ -20,6 +20,7 @@
 #include "qgscircularstring.h"
 #include "qgscompoundcurve.h"
 #include "qgsgeometryutils.h"
+#include "qgsgeometrytransformbatch.h"
 #include "qgslinestring.h"
 #include "qgspolygon.h"
 #include "qgswkbptr.h"
@@ -817,15 +818,15 @@ void QgsCurvePolygon::draw( QPainter &p ) const
 
 void QgsCurvePolygon::transform( const QgsCoordinateTransform &ct, QgsCoordinateTransform::TransformDirection d, bool transformZ )
 {
-  if ( mExteriorRing )
-  {
-    mExteriorRing->transform( ct, d, transformZ );
-  }
+  // transform the vertices of all rings at once
+  QgsGeometryTransformBatch batch( ct, d, transformZ );
+  batch.addGeometry( mExteriorRing.get() );
 
   for ( QgsCurve *curve : qgis::as_const( mInteriorRings ) )
   {
-    curve->transform( ct, d, transformZ );
+    batch.addGeometry( curve );
   }
+  batch.transform();
   clearCache();
 }
 
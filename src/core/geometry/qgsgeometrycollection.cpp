@@ -17,6 +17,7 @@ email                : marco.hugentobler at sourcepole dot com
 #include "qgsapplication.h"
 #include "qgsgeometryfactory.h"
 #include "qgsgeometryutils.h"
+#include "qgsgeometrytransformbatch.h"
 #include "qgscircularstring.h"
 #include "qgscompoundcurve.h"
 #include "qgslinestring.h"
@@ -283,10 +284,13 @@ QString QgsGeometryCollection::geometryType() const
 
 void QgsGeometryCollection::transform( const QgsCoordinateTransform &ct, QgsCoordinateTransform::TransformDirection d, bool transformZ )
 {
+  // transform the vertices of all parts at once
+  QgsGeometryTransformBatch batch( ct, d, transformZ );
   for ( QgsAbstractGeometry *g : qgis::as_const( mGeometries ) )
   {
-    g->transform( ct, d, transformZ );
+    batch.addGeometry( g );
   }
+  batch.transform();
   clearCache(); //set bounding box invalid
 }
 
@@ -0,0 +1,156 @@
+/***************************************************************************
+                        qgsgeometrytransformbatch.cpp
+  -------------------------------------------------------------------
+Date                 : November 2020
+Copyright            : (C) 2020 by the QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsgeometrytransformbatch.h"
+#include "qgscurvepolygon.h"
+#include "qgsgeometrycollection.h"
+#include "qgslinestring.h"
+#include "qgspoint.h"
+
+#include <algorithm>
+#include <cmath>
+
+QgsGeometryTransformBatch::QgsGeometryTransformBatch( const QgsCoordinateTransform &ct, QgsCoordinateTransform::TransformDirection direction, bool transformZ )
+  : mTransform( ct )
+  , mDirection( direction )
+  , mTransformZ( transformZ )
+{
+}
+
+void QgsGeometryTransformBatch::addGeometry( QgsAbstractGeometry *geometry )
+{
+  if ( !geometry )
+    return;
+
+  if ( QgsPoint *point = qgsgeometry_cast< QgsPoint * >( geometry ) )
+  {
+    // like QgsPoint::transform(), z values are handed to the transform even for 2D points
+    mParts << Part{ point, vertexCount(), 1, mTransformZ };
+    mX.push_back( point->x() );
+    mY.push_back( point->y() );
+    mZ.push_back( mTransformZ ? point->z() : 0.0 );
+  }
+  else if ( QgsLineString *line = qgsgeometry_cast< QgsLineString * >( geometry ) )
+  {
+    const bool transformZ = mTransformZ && line->is3D();
+    const int count = line->numPoints();
+    mParts << Part{ line, vertexCount(), count, transformZ };
+    mX.insert( mX.end(), line->mX.constBegin(), line->mX.constEnd() );
+    mY.insert( mY.end(), line->mY.constBegin(), line->mY.constEnd() );
+    if ( transformZ )
+      mZ.insert( mZ.end(), line->mZ.constBegin(), line->mZ.constEnd() );
+    else
+      mZ.resize( mZ.size() + count, 0.0 );
+  }
+  else if ( QgsCurvePolygon *polygon = qgsgeometry_cast< QgsCurvePolygon * >( geometry ) )
+  {
+    // the rings are owned by the polygon, which we are allowed to modify
+    addGeometry( const_cast< QgsCurve * >( polygon->exteriorRing() ) );
+    for ( int i = 0; i < polygon->numInteriorRings(); ++i )
+      addGeometry( const_cast< QgsCurve * >( polygon->interiorRing( i ) ) );
+    mContainers << polygon;
+  }
+  else if ( QgsGeometryCollection *collection = qgsgeometry_cast< QgsGeometryCollection * >( geometry ) )
+  {
+    for ( int i = 0; i < collection->numGeometries(); ++i )
+      addGeometry( collection->geometryN( i ) );
+    mContainers << collection;
+  }
+  else
+  {
+    mOtherGeometries << geometry;
+  }
+}
+
+void QgsGeometryTransformBatch::transform()
+{
+  // empty the batch first, so that it is also empty if the transform throws
+  const QVector< Part > parts = std::move( mParts );
+  const QVector< QgsAbstractGeometry * > otherGeometries = std::move( mOtherGeometries );
+  const QVector< QgsAbstractGeometry * > containers = std::move( mContainers );
+  const std::vector< double > sourceX = std::move( mX );
+  const std::vector< double > sourceY = std::move( mY );
+  const std::vector< double > sourceZ = std::move( mZ );
+  mParts.clear();
+  mOtherGeometries.clear();
+  mContainers.clear();
+  mX.clear();
+  mY.clear();
+  mZ.clear();
+
+  std::vector< double > x( sourceX );
+  std::vector< double > y( sourceY );
+  std::vector< double > z( sourceZ );
+  if ( !x.empty() )
+  {
+    mTransform.transformCoords( static_cast< int >( x.size() ), x.data(), y.data(), z.data(), mDirection );
+
+    // when some vertices fail with the preferred operation, the whole buffer is transformed again with a
+    // fallback operation. Only the parts which failed should use it, so every part is then transformed again
+    // on its own, as if it had not been batched
+    const bool fallbackOccurred = mTransform.fallbackOperationOccurred();
+    for ( const Part &part : parts )
+    {
+      const auto partFailed = [&]
+      {
+        for ( int i = part.offset; i < part.offset + part.count; ++i )
+        {
+          if ( !std::isfinite( x[i] ) || !std::isfinite( y[i] ) )
+            return true;
+        }
+        return false;
+      };
+      if ( !fallbackOccurred && !partFailed() )
+        continue;
+
+      // like QgsPoint::transform() and QgsLineString::transform(), this raises an exception for
+      // single points which cannot be transformed
+      std::copy( sourceX.begin() + part.offset, sourceX.begin() + part.offset + part.count, x.begin() + part.offset );
+      std::copy( sourceY.begin() + part.offset, sourceY.begin() + part.offset + part.count, y.begin() + part.offset );
+      std::copy( sourceZ.begin() + part.offset, sourceZ.begin() + part.offset + part.count, z.begin() + part.offset );
+      mTransform.transformCoords( part.count, x.data() + part.offset, y.data() + part.offset, z.data() + part.offset, mDirection );
+    }
+  }
+
+  for ( QgsAbstractGeometry *geometry : otherGeometries )
+  {
+    geometry->transform( mTransform, mDirection, mTransformZ );
+  }
+
+  // all vertices were transformed, they can now be written to the geometries
+  for ( const Part &part : parts )
+  {
+    if ( QgsPoint *point = qgsgeometry_cast< QgsPoint * >( part.geometry ) )
+    {
+      point->setX( x[part.offset] );
+      point->setY( y[part.offset] );
+      if ( part.transformZ )
+        point->setZ( z[part.offset] );
+    }
+    else
+    {
+      QgsLineString *line = static_cast< QgsLineString * >( part.geometry );
+      std::copy( x.begin() + part.offset, x.begin() + part.offset + part.count, line->mX.begin() );
+      std::copy( y.begin() + part.offset, y.begin() + part.offset + part.count, line->mY.begin() );
+      if ( part.transformZ )
+        std::copy( z.begin() + part.offset, z.begin() + part.offset + part.count, line->mZ.begin() );
+      line->clearCache();
+    }
+  }
+
+  for ( QgsAbstractGeometry *geometry : containers )
+  {
+    geometry->clearCache();
+  }
+}
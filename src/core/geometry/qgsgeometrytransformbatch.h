@@ -0,0 +1,104 @@
+/***************************************************************************
+                        qgsgeometrytransformbatch.h
+  -------------------------------------------------------------------
+Date                 : November 2020
+Copyright            : (C) 2020 by the QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSGEOMETRYTRANSFORMBATCH_H
+#define QGSGEOMETRYTRANSFORMBATCH_H
+
+class QgsAbstractGeometry;
+
+#define SIP_NO_FILE
+
+#include "qgis_core.h"
+#include "qgscoordinatetransform.h"
+#include <QVector>
+#include <vector>
+
+/**
+ * \ingroup core
+ * \class QgsGeometryTransformBatch
+ * \brief Transforms the vertices of many geometries with a single coordinate transform call.
+ *
+ * The vertices of all points and line strings of the added geometries, including the parts of
+ * collections and the rings of polygons, are gathered in one buffer. This avoids the overhead of
+ * transforming each part on its own, e.g. for multi points or polygons with many rings.
+ *
+ * Curved geometries are transformed on their own when transform() is called.
+ *
+ * \note not available in Python bindings
+ * \since QGIS 3.18
+ */
+class CORE_EXPORT QgsGeometryTransformBatch
+{
+  public:
+
+    /**
+     * Constructor for QgsGeometryTransformBatch, transforming with \a ct in the given \a direction.
+     * The z values of the vertices are transformed if \a transformZ is TRUE.
+     */
+    QgsGeometryTransformBatch( const QgsCoordinateTransform &ct,
+                               QgsCoordinateTransform::TransformDirection direction = QgsCoordinateTransform::ForwardTransform,
+                               bool transformZ = false );
+
+    /**
+     * Adds a \a geometry to the batch. The geometry is modified in place by transform(),
+     * so it must be kept alive until then.
+     */
+    void addGeometry( QgsAbstractGeometry *geometry );
+
+    /**
+     * Transforms all added geometries and empties the batch.
+     *
+     * A point or line string which cannot be transformed together with the other vertices, or which
+     * would require a fallback operation, is transformed again on its own. It gets the same result and
+     * raises the same exceptions as when transforming that part directly, while the other parts keep
+     * the preferred operation.
+     *
+     * \throws QgsCsException if the transform fails. The vertices of points and line strings are
+     * only written once all of them have been transformed, so they are left untouched in that case.
+     * Curved geometries may have been transformed already, as they are transformed on their own.
+     */
+    void transform();
+
+    //! Returns the number of vertices currently gathered in the batch.
+    int vertexCount() const { return static_cast< int >( mX.size() ); }
+
+  private:
+
+    //! A point or line string whose vertices are gathered in the buffer
+    struct Part
+    {
+      QgsAbstractGeometry *geometry;
+      int offset;
+      int count;
+      bool transformZ;
+    };
+
+    QgsCoordinateTransform mTransform;
+    QgsCoordinateTransform::TransformDirection mDirection = QgsCoordinateTransform::ForwardTransform;
+    bool mTransformZ = false;
+
+    QVector< Part > mParts;
+
+    //! Curved geometries, transformed on their own
+    QVector< QgsAbstractGeometry * > mOtherGeometries;
+
+    //! Polygons and collections whose cache must be cleared
+    QVector< QgsAbstractGeometry * > mContainers;
+
+    std::vector< double > mX;
+    std::vector< double > mY;
+    std::vector< double > mZ;
+};
+
+#endif // QGSGEOMETRYTRANSFORMBATCH_H
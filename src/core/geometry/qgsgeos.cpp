@@ -25,6 +25,8 @@ email                : marco.hugentobler at sourcepole dot com
 #include "qgslogger.h"
 #include "qgspolygon.h"
 #include "qgsgeometryeditutils.h"
+#include "qgsconfig.h"
+#include <QThreadStorage>
 #include <limits>
 #include <cstdio>
 
@@ -113,7 +115,25 @@ class GEOSInit
     GEOSInit &operator=( const GEOSInit &rh ) = delete;
 };
 
-Q_GLOBAL_STATIC( GEOSInit, geosinit )
+// A GEOS context handle must not be used by several threads at once, so each
+// thread gets its own context. This lets geometry operations run concurrently
+// from worker threads without any locking.
+#ifdef USE_THREAD_LOCAL
+static thread_local GEOSInit sGeosInit;
+#else
+static QThreadStorage< GEOSInit * > sGeosInit;
+#endif
+
+static GEOSInit *geosinit()
+{
+#ifdef USE_THREAD_LOCAL
+  return &sGeosInit;
+#else
+  if ( !sGeosInit.hasLocalData() )
+    sGeosInit.setLocalData( new GEOSInit() );
+  return sGeosInit.localData();
+#endif
+}
 
 void geos::GeosDeleter::operator()( GEOSGeometry *geom )
 {
@@ -356,6 +356,11 @@ class CORE_EXPORT QgsGeos: public QgsGeometryEngine
     static geos::unique_ptr asGeos( const QgsAbstractGeometry *geometry, double precision = 0 );
     static QgsPoint coordSeqPoint( const GEOSCoordSequence *cs, int i, bool hasZ, bool hasM );
 
+    /**
+     * Returns the GEOS context handle for the calling thread.
+     *
+     * Each thread uses its own context, so the returned handle must not be passed to other threads.
+     */
     static GEOSContextHandle_t getGEOSHandler();
 
 
@@ -806,6 +806,7 @@ class CORE_EXPORT QgsLineString: public QgsCurve
 
     friend class QgsPolygon;
     friend class QgsTriangle;
+    friend class QgsGeometryTransformBatch;
 
 };
 
@@ -598,11 +598,27 @@ bool QgsLayoutAtlas::prepareForFeature( const int featureI )
     return false;
   }
 
-  mCurrentFeatureNo = featureI;
-
   // retrieve the next feature, based on its id
-  if ( !mCoverageLayer->getFeatures( QgsFeatureRequest().setFilterFid( mFeatureIds[ featureI ].first ) ).nextFeature( mCurrentFeature ) )
+  QgsFeature feature;
+  if ( !mCoverageLayer->getFeatures( QgsFeatureRequest().setFilterFid( mFeatureIds[ featureI ].first ) ).nextFeature( feature ) )
+  {
+    mCurrentFeatureNo = featureI;
+    mCurrentFeature = feature;
     return false;
+  }
+
+  return prepareForFeature( featureI, feature );
+}
+
+bool QgsLayoutAtlas::prepareForFeature( const int featureI, const QgsFeature &feature )
+{
+  if ( !mCoverageLayer || featureI < 0 || featureI >= mFeatureIds.size() )
+  {
+    return false;
+  }
+
+  mCurrentFeatureNo = featureI;
+  mCurrentFeature = feature;
 
   mLayout->reportContext().blockSignals( true ); // setFeature emits changed, we don't want 2 signals
   mLayout->reportContext().setLayer( mCoverageLayer.get() );
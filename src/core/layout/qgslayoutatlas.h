@@ -361,6 +361,13 @@ class CORE_EXPORT QgsLayoutAtlas : public QObject, public QgsAbstractLayoutItera
      */
     bool prepareForFeature( int i );
 
+    /**
+     * Prepares the atlas for the feature number \a i, using the already fetched \a feature
+     * instead of reading it from the coverage layer.
+     * \returns TRUE if feature was successfully prepared
+     */
+    bool prepareForFeature( int i, const QgsFeature &feature );
+
     QPointer< QgsLayout > mLayout;
 
     bool mEnabled = false;
@@ -395,6 +402,7 @@ class CORE_EXPORT QgsLayoutAtlas : public QObject, public QgsAbstractLayoutItera
 
 
     friend class AtlasFeatureSorter;
+    friend class QgsLayoutExporter;
 };
 
 #endif //QGSLAYOUTATLAS_H
@@ -27,9 +27,22 @@
 #include "qgsfeedback.h"
 #include "qgslayoutgeopdfexporter.h"
 #include "qgslinestring.h"
+#include "qgsprintlayout.h"
+#include "qgslayoutatlas.h"
+#include "qgslayoutitemlabel.h"
+#include "qgslayoutitempicture.h"
+#include "qgslayoutframe.h"
+#include "qgslayoutmultiframe.h"
+#include "qgslayoutitemregistry.h"
+#include "qgsvectorlayer.h"
 #include <QImageWriter>
 #include <QSize>
 #include <QSvgGenerator>
+#include <QMutex>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrentMap>
+#include <numeric>
 
 #include "gdal.h"
 #include "cpl_conv.h"
@@ -460,6 +473,14 @@ QgsLayoutExporter::ExportResult QgsLayoutExporter::exportToImage( QgsAbstractLay
 {
   error.clear();
 
+  auto exportFeature = [&settings]( QgsLayoutExporter & exporter, const QString & filePath )
+  {
+    return exporter.exportToImage( filePath, settings );
+  };
+  ExportResult concurrentResult = Success;
+  if ( settings.maxThreads != 1 && exportAtlasConcurrently( iterator, baseFilePath, extension, settings.maxThreads, exportFeature, concurrentResult, error, feedback ) )
+    return concurrentResult;
+
   if ( !iterator->beginRender() )
     return IteratorError;
 
@@ -790,6 +811,14 @@ QgsLayoutExporter::ExportResult QgsLayoutExporter::exportToPdfs( QgsAbstractLayo
 {
   error.clear();
 
+  auto exportFeature = [&settings]( QgsLayoutExporter & exporter, const QString & filePath )
+  {
+    return exporter.exportToPdf( filePath, settings );
+  };
+  ExportResult concurrentResult = Success;
+  if ( settings.maxThreads != 1 && exportAtlasConcurrently( iterator, baseFilePath, QStringLiteral( "pdf" ), settings.maxThreads, exportFeature, concurrentResult, error, feedback ) )
+    return concurrentResult;
+
   if ( !iterator->beginRender() )
     return IteratorError;
 
@@ -1295,6 +1324,240 @@ void QgsLayoutExporter::updatePrinterPageSize( QgsLayout *layout, QPrinter &prin
   printer.setPageMargins( QMarginsF( 0, 0, 0, 0 ) );
 }
 
+void QgsLayoutExporter::moveLayoutToThread( QgsLayout *layout, QThread *thread )
+{
+  // layout items and multiframes are not children of their layout, move them along with it
+  layout->moveToThread( thread );
+  const QList< QGraphicsItem * > items = layout->items();
+  for ( QGraphicsItem *graphicsItem : items )
+  {
+    if ( QgsLayoutItem *item = dynamic_cast< QgsLayoutItem * >( graphicsItem ) )
+      item->moveToThread( thread );
+  }
+  const QList< QgsLayoutMultiFrame * > multiFrames = layout->multiFrames();
+  for ( QgsLayoutMultiFrame *multiFrame : multiFrames )
+    multiFrame->moveToThread( thread );
+}
+
+bool QgsLayoutExporter::canRenderConcurrently( QgsLayout *layout )
+{
+  // only item types which are known to render without objects tied to the main thread
+  // (web pages, event loops, layer tree models, 3D scenes) or to feature requests of their
+  // own are allowed, anything else (including plugin items) is exported sequentially
+  QList< QgsLayoutItem * > items;
+  layout->layoutItems( items );
+  for ( QgsLayoutItem *item : qgis::as_const( items ) )
+  {
+    switch ( item->type() )
+    {
+      case QgsLayoutItemRegistry::LayoutGroup:
+      case QgsLayoutItemRegistry::LayoutPage:
+      case QgsLayoutItemRegistry::LayoutMap:
+      case QgsLayoutItemRegistry::LayoutShape:
+      case QgsLayoutItemRegistry::LayoutPolygon:
+      case QgsLayoutItemRegistry::LayoutPolyline:
+      case QgsLayoutItemRegistry::LayoutScaleBar:
+      case QgsLayoutItemRegistry::LayoutMarker:
+        break;
+
+      case QgsLayoutItemRegistry::LayoutLabel:
+        // HTML labels are rendered through a web page
+        if ( static_cast< QgsLayoutItemLabel * >( item )->mode() != QgsLayoutItemLabel::ModeFont )
+          return false;
+        break;
+
+      case QgsLayoutItemRegistry::LayoutPicture:
+      {
+        // remote pictures are downloaded in an event loop, and data defined sources may be remote
+        QgsLayoutItemPicture *picture = static_cast< QgsLayoutItemPicture * >( item );
+        if ( picture->dataDefinedProperties().isActive( QgsLayoutObject::PictureSource )
+             || picture->picturePath().startsWith( QLatin1String( "http" ) ) )
+          return false;
+        break;
+      }
+
+      case QgsLayoutItemRegistry::LayoutFrame:
+      {
+        const QgsLayoutMultiFrame *multiFrame = static_cast< QgsLayoutFrame * >( item )->multiFrame();
+        if ( !multiFrame )
+          return false;
+        if ( multiFrame->type() != QgsLayoutItemRegistry::LayoutManualTable && multiFrame->type() != QgsLayoutItemRegistry::LayoutTextTable )
+          return false;
+        break;
+      }
+
+      default:
+        return false;
+    }
+  }
+  return true;
+}
+
+bool QgsLayoutExporter::exportAtlasConcurrently( QgsAbstractLayoutIterator *iterator, const QString &baseFilePath, const QString &extension, int maxThreads,
+    const std::function<ExportResult( QgsLayoutExporter &, const QString & )> &exportFeature,
+    ExportResult &result, QString &error, QgsFeedback *feedback )
+{
+  // only atlases can be recreated from a copy of their layout, other iterators (e.g. reports)
+  // are exported sequentially
+  QgsLayoutAtlas *atlas = dynamic_cast< QgsLayoutAtlas * >( iterator );
+  if ( !atlas )
+    return false;
+
+  QgsPrintLayout *sourceLayout = qobject_cast< QgsPrintLayout * >( atlas->layout() );
+  if ( !sourceLayout )
+    return false;
+
+  int threadCount = maxThreads > 0 ? maxThreads : QThread::idealThreadCount();
+  threadCount = std::min( threadCount, QThreadPool::globalInstance()->maxThreadCount() );
+  if ( threadCount <= 1 )
+    return false;
+
+  if ( !canRenderConcurrently( sourceLayout ) )
+    return false;
+
+  result = Success;
+  if ( !atlas->beginRender() )
+  {
+    result = IteratorError;
+    return true;
+  }
+
+  const int total = atlas->count();
+  const double step = total > 0 ? 100.0 / total : 100.0;
+  threadCount = std::min( threadCount, total );
+
+  // the coverage layer is only read on this thread, the threads are handed the atlas features
+  QgsFeatureIds ids;
+  for ( const QPair< QgsFeatureId, QString > &id : qgis::as_const( atlas->mFeatureIds ) )
+    ids.insert( id.first );
+  QHash< QgsFeatureId, QgsFeature > featuresById;
+  QgsFeatureIterator it = atlas->coverageLayer()->getFeatures( QgsFeatureRequest().setFilterFids( ids ) );
+  QgsFeature f;
+  while ( it.nextFeature( f ) )
+    featuresById.insert( f.id(), f );
+
+  QVector< QgsFeature > features;
+  features.reserve( total );
+  for ( const QPair< QgsFeatureId, QString > &id : qgis::as_const( atlas->mFeatureIds ) )
+  {
+    if ( !featuresById.contains( id.first ) )
+    {
+      result = IteratorError;
+      atlas->endRender();
+      return true;
+    }
+    features << featuresById.value( id.first );
+  }
+  featuresById.clear();
+
+  // each thread renders its own copy of the layout, so that layout items are never shared
+  // between threads. Map layers are shared, and only read while rendering. Layouts can only
+  // be created on this thread, so the copies are detached from it here and picked up by
+  // the thread which renders them.
+  std::vector< std::unique_ptr< QgsPrintLayout > > layouts;
+  layouts.reserve( threadCount );
+  for ( int i = 0; i < threadCount; ++i )
+  {
+    std::unique_ptr< QgsPrintLayout > layout( sourceLayout->clone() );
+    QString filenameError;
+    if ( !layout || !layout->atlas()->coverageLayer() )
+    {
+      result = IteratorError;
+      atlas->endRender();
+      return true;
+    }
+    // the clone shares the atlas features of the source layout, instead of fetching them again
+    layout->atlas()->mFeatureIds = atlas->mFeatureIds;
+    if ( !layout->atlas()->updateFilenameExpression( filenameError ) )
+    {
+      result = IteratorError;
+      error = filenameError;
+      atlas->endRender();
+      return true;
+    }
+    moveLayoutToThread( layout.get(), nullptr );
+    layouts.emplace_back( std::move( layout ) );
+  }
+
+  QMutex mutex;
+  QAtomicInt nextFeature( 0 );
+  int exported = 0;
+  QString failedFilePath;
+
+  auto exportFeatures = [&]( int index )
+  {
+    QgsPrintLayout *layout = layouts[ index ].get();
+    moveLayoutToThread( layout, QThread::currentThread() );
+
+    while ( true )
+    {
+      const int feature = nextFeature.fetchAndAddOrdered( 1 );
+      if ( feature >= total )
+        break;
+
+      {
+        QMutexLocker locker( &mutex );
+        if ( result != Success )
+          break;
+        if ( feedback && feedback->isCanceled() )
+        {
+          result = Canceled;
+          break;
+        }
+      }
+
+      if ( !layout->atlas()->prepareForFeature( feature, features.at( feature ) ) )
+      {
+        QMutexLocker locker( &mutex );
+        if ( result == Success )
+          result = IteratorError;
+        break;
+      }
+
+      const QString filePath = layout->atlas()->filePath( baseFilePath, extension );
+      QgsLayoutExporter exporter( layout );
+      const ExportResult featureResult = exportFeature( exporter, filePath );
+
+      QMutexLocker locker( &mutex );
+      if ( featureResult != Success )
+      {
+        if ( result == Success )
+        {
+          result = featureResult;
+          failedFilePath = filePath;
+        }
+        break;
+      }
+
+      exported++;
+      if ( feedback )
+      {
+        feedback->setProperty( "progress", QObject::tr( "Exporting %1 of %2" ).arg( exported ).arg( total ) );
+        feedback->setProgress( step * exported );
+      }
+    }
+
+    // hand the copy back, it is destroyed by the calling thread
+    moveLayoutToThread( layout, nullptr );
+  };
+
+  QVector< int > threads( threadCount );
+  std::iota( threads.begin(), threads.end(), 0 );
+  QtConcurrent::blockingMap( threads, exportFeatures );
+
+  for ( const std::unique_ptr< QgsPrintLayout > &layout : layouts )
+    moveLayoutToThread( layout.get(), QThread::currentThread() );
+  layouts.clear();
+
+  if ( result == FileError )
+    error = QObject::tr( "Cannot write to %1. This file may be open in another application or may be an invalid path." ).arg( QDir::toNativeSeparators( failedFilePath ) );
+  else if ( result == Success && feedback )
+    feedback->setProgress( 100 );
+
+  atlas->endRender();
+  return true;
+}
+
 QgsLayoutExporter::ExportResult QgsLayoutExporter::renderToLayeredSvg( const SvgExportSettings &settings, double width, double height, int page, const QRectF &bounds, const QString &filename, unsigned int svgLayerId, const QString &layerName, QDomDocument &svg, QDomNode &svgDocRoot, bool includeMetadata ) const
 {
   QBuffer svgBuffer;
@@ -34,6 +34,7 @@ class QPainter;
 class QgsLayoutItemMap;
 class QgsAbstractLayoutIterator;
 class QgsFeedback;
+class QThread;
 
 /**
  * \ingroup core
@@ -217,6 +218,18 @@ class CORE_EXPORT QgsLayoutExporter
        */
       QVector<qreal> predefinedMapScales;
 
+      /**
+       * Maximum number of atlas features to export concurrently when exporting an atlas
+       * to separate images. Each concurrent export renders its own copy of the layout.
+       *
+       * A value of 1 exports features one after another, and a value <= 0 uses one thread
+       * per available CPU core. Other layout iterators, and atlases whose layout contains
+       * HTML frames, legends or attribute tables, are always exported one feature at a time.
+       *
+       * \since QGIS 3.18
+       */
+      int maxThreads = 1;
+
     };
 
     /**
@@ -383,6 +396,20 @@ class CORE_EXPORT QgsLayoutExporter
        */
       QVector<qreal> predefinedMapScales;
 
+      /**
+       * Maximum number of atlas features to export concurrently when exporting an atlas
+       * to separate PDF files with exportToPdfs(). Each concurrent export renders its own
+       * copy of the layout.
+       *
+       * A value of 1 exports features one after another, and a value <= 0 uses one thread
+       * per available CPU core. Other layout iterators, atlases whose layout contains
+       * HTML frames, legends or attribute tables, and atlases exported to a single PDF file,
+       * are always exported one feature at a time.
+       *
+       * \since QGIS 3.18
+       */
+      int maxThreads = 1;
+
     };
 
     /**
@@ -695,6 +722,34 @@ class CORE_EXPORT QgsLayoutExporter
 
     static void updatePrinterPageSize( QgsLayout *layout, QPrinter &printer, int page );
 
+    /**
+     * Exports the features of an atlas \a iterator to separate files concurrently, using up to
+     * \a maxThreads threads. The atlas layout is cloned once per thread on the calling thread,
+     * and each thread exports features from its own clone by calling \a exportFeature with an
+     * exporter for the clone and the file path for the feature. The atlas features are read on
+     * the calling thread and handed to the clones, so the coverage layer is never queried
+     * from the other threads.
+     *
+     * Returns FALSE if the iterator cannot be exported concurrently (e.g. because its layout
+     * contains items which can't be rendered outside of the main thread), in which case nothing
+     * is exported. Otherwise \a result and \a error are set to the export result.
+     */
+    static bool exportAtlasConcurrently( QgsAbstractLayoutIterator *iterator, const QString &baseFilePath, const QString &extension, int maxThreads,
+                                         const std::function< ExportResult( QgsLayoutExporter &exporter, const QString &filePath ) > &exportFeature,
+                                         ExportResult &result, QString &error, QgsFeedback *feedback );
+
+    /**
+     * Moves a \a layout, its items and its multiframes to a \a thread. A NULLPTR \a thread
+     * detaches them from their current thread, so that any thread can pick them up.
+     */
+    static void moveLayoutToThread( QgsLayout *layout, QThread *thread );
+
+    /**
+     * Returns TRUE if all items in \a layout are of types which are known to render safely
+     * outside of the main thread, and the layout can be exported concurrently.
+     */
+    static bool canRenderConcurrently( QgsLayout *layout );
+
     ExportResult renderToLayeredSvg( const SvgExportSettings &settings, double width, double height, int page, const QRectF &bounds,
                                      const QString &filename, unsigned int svgLayerId, const QString &layerName,
                                      QDomDocument &svg, QDomNode &svgDocRoot, bool includeMetadata ) const;
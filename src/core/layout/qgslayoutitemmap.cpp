@@ -34,9 +34,11 @@
 #include "qgsexpressioncontextutils.h"
 #include "qgsstyleentityvisitor.h"
 #include "qgsannotationlayer.h"
+#include "qgsmaprendererparalleljob.h"
 
 #include <QPainter>
 #include <QStyleOptionGraphicsItem>
+#include <QThreadPool>
 
 QgsLayoutItemMap::QgsLayoutItemMap( QgsLayout *layout )
   : QgsLayoutItem( layout )
@@ -1331,6 +1333,18 @@ void QgsLayoutItemMap::drawMap( QPainter *painter, const QgsRectangle &extent, Q
     ms.setLayers( mOverviewStack->modifyMapLayerList( ms.layers() ) );
   }
 
+  if ( canRenderLayersInParallel( painter, ms ) )
+  {
+    // render layers to separate images in parallel, and composite the result onto the raster destination
+    QgsMapRendererParallelJob job( ms );
+    job.start();
+    job.waitForFinished();
+    painter->drawImage( QPointF( 0, 0 ), job.renderedImage() );
+
+    mRenderingErrors = job.errors();
+    return;
+  }
+
   QgsMapRendererCustomPainterJob job( ms, painter );
   // Render the map in this thread. This is done because of problems
   // with printing to printer on Windows (printing to PDF is fine though).
@@ -1340,6 +1354,27 @@ void QgsLayoutItemMap::drawMap( QPainter *painter, const QgsRectangle &extent, Q
   mRenderingErrors = job.errors();
 }
 
+bool QgsLayoutItemMap::canRenderLayersInParallel( const QPainter *painter, const QgsMapSettings &settings )
+{
+  // vector destinations (PDF, SVG, printers) must receive the layers as vectors
+  if ( painter->device()->devType() != QInternal::Image )
+    return false;
+
+  if ( settings.layers().size() < 2 || QThreadPool::globalInstance()->maxThreadCount() < 2 )
+    return false;
+
+  // the composited image must line up exactly with the destination pixels, otherwise
+  // it would be resampled
+  const QTransform transform = painter->deviceTransform();
+  if ( transform.type() > QTransform::TxTranslate
+       || !qgsDoubleNear( transform.dx(), std::round( transform.dx() ) )
+       || !qgsDoubleNear( transform.dy(), std::round( transform.dy() ) ) )
+    return false;
+
+  // layers with blend modes must be blended with the content already drawn by the layout
+  return QgsMapSettingsUtils::containsAdvancedEffects( settings ).isEmpty();
+}
+
 void QgsLayoutItemMap::recreateCachedImageInBackground()
 {
   if ( mPainterJob )
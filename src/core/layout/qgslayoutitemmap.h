@@ -1042,6 +1042,12 @@ class CORE_EXPORT QgsLayoutItemMap : public QgsLayoutItem, public QgsTemporalRan
      */
     void drawMap( QPainter *painter, const QgsRectangle &extent, QSizeF size, double dpi );
 
+    /**
+     * Returns TRUE if the layers of a map rendered with the specified \a settings can be rendered
+     * in parallel and composited onto \a painter, without altering the output.
+     */
+    static bool canRenderLayersInParallel( const QPainter *painter, const QgsMapSettings &settings );
+
     //! Establishes signal/slot connection for update in case of layer change
     void connectUpdateSlot();
 
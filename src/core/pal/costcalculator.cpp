@@ -31,6 +31,11 @@ bool CostCalculator::candidateSortGrow( const std::unique_ptr< LabelPosition > &
 }
 
 void CostCalculator::addObstacleCostPenalty( LabelPosition *lp, FeaturePart *obstacle, Pal *pal )
+{
+  applyObstacleCostPenalty( lp, obstacle, calculateObstaclePenalty( lp, obstacle ), pal );
+}
+
+int CostCalculator::calculateObstaclePenalty( const LabelPosition *lp, FeaturePart *obstacle )
 {
   int n = 0;
   double dist;
@@ -78,9 +83,14 @@ void CostCalculator::addObstacleCostPenalty( LabelPosition *lp, FeaturePart *obs
       break;
   }
 
+  return n;
+}
+
+void CostCalculator::applyObstacleCostPenalty( LabelPosition *lp, FeaturePart *obstacle, int penalty, Pal *pal )
+{
   //scale cost by obstacle's factor
-  double obstacleCost = obstacle->obstacleSettings().factor() * double( n );
-  if ( n > 0 )
+  double obstacleCost = obstacle->obstacleSettings().factor() * double( penalty );
+  if ( penalty > 0 )
     lp->setConflictsWithObstacle( true );
 
   switch ( pal->placementVersion() )
@@ -95,7 +105,7 @@ void CostCalculator::addObstacleCostPenalty( LabelPosition *lp, FeaturePart *obs
       const double obstaclePriority = obstacle->obstacleSettings().factor();
 
       // if feature priority is < obstaclePriorty, there's a hard conflict...
-      if ( n > 0 && ( priority < obstaclePriority && !qgsDoubleNear( priority, obstaclePriority, 0.001 ) ) )
+      if ( penalty > 0 && ( priority < obstaclePriority && !qgsDoubleNear( priority, obstaclePriority, 0.001 ) ) )
       {
         lp->setHasHardObstacleConflict( true );
       }
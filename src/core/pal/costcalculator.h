@@ -40,6 +40,22 @@ namespace pal
       //! Increase candidate's cost according to its collision with passed feature
       static void addObstacleCostPenalty( pal::LabelPosition *lp, pal::FeaturePart *obstacle, Pal *pal );
 
+      /**
+       * Calculates how much a candidate \a lp collides with an \a obstacle, from 0 (no collision) to 12.
+       *
+       * The candidate is not modified, so that penalties for several obstacles can be calculated at
+       * once from different threads, as long as each obstacle is only tested by a single thread.
+       *
+       * \see applyObstacleCostPenalty()
+       */
+      static int calculateObstaclePenalty( const pal::LabelPosition *lp, pal::FeaturePart *obstacle );
+
+      /**
+       * Increase candidate's cost according to the collision \a penalty with an \a obstacle, as
+       * calculated by calculateObstaclePenalty().
+       */
+      static void applyObstacleCostPenalty( pal::LabelPosition *lp, pal::FeaturePart *obstacle, int penalty, Pal *pal );
+
       /**
        * Updates the costs for polygon label candidates by considering the distance between the
        * candidates and the nearest polygon ring (i.e. prefer labels closer to the pole of inaccessibility).
@@ -432,6 +432,22 @@ void LabelPosition::insertIntoIndex( PalRtree<LabelPosition> &index )
   index.insert( this, QgsRectangle( amin[0], amin[1], amax[0], amax[1] ) );
 }
 
+void LabelPosition::createGeosGeometries() const
+{
+  if ( !mGeos )
+    createGeosGeom();
+
+  // GEOS calculates the envelope of a geometry on first use, so force it now
+  // to avoid this happening concurrently later
+  if ( mGeos )
+  {
+    geos::unique_ptr envelope( GEOSEnvelope_r( QgsGeos::getGEOSHandler(), mGeos ) );
+  }
+
+  if ( mNextPart )
+    mNextPart->createGeosGeometries();
+}
+
 double LabelPosition::getDistanceToPoint( double xp, double yp ) const
 {
   //first check if inside, if so then distance is -1
@@ -303,6 +303,14 @@ namespace pal
        */
       void insertIntoIndex( PalRtree<LabelPosition> &index );
 
+      /**
+       * Creates the GEOS geometries of the label position and of all its parts.
+       *
+       * Once created, the geometries are only read, so the label position can be tested
+       * against obstacles from several threads at once.
+       */
+      void createGeosGeometries() const;
+
     protected:
 
       int id;
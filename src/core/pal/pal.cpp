@@ -44,6 +44,17 @@
 #include "qgssettings.h"
 #include <cfloat>
 #include <list>
+#include <numeric>
+
+#include <QThread>
+#include <QtConcurrentMap>
+
+// minimum number of feature parts for which candidates are generated in parallel
+static const std::size_t PARALLEL_CANDIDATES_MIN_PARTS = 500;
+
+// number of candidate generation tasks created per thread, more tasks than threads keep all
+// threads busy when some features are much more expensive to label than others
+static const int CANDIDATE_TASKS_PER_THREAD = 4;
 
 using namespace pal;
 
@@ -96,8 +107,6 @@ std::unique_ptr<Problem> Pal::extract( const QgsRectangle &extent, const QgsGeom
   // and the consequence of inserting coordinates outside this extent is worse than the consequence of setting this value too large.)
   const QgsRectangle maxCoordinateExtentForSpatialIndices = extent.buffered( std::max( extent.width(), extent.height() ) * 1000 );
 
-  // to store obstacles
-  PalRtree< FeaturePart > obstacles( maxCoordinateExtentForSpatialIndices );
   PalRtree< LabelPosition > allCandidatesFirstRound( maxCoordinateExtentForSpatialIndices );
   std::vector< FeaturePart * > allObstacleParts;
   std::unique_ptr< Problem > prob = qgis::make_unique< Problem >( maxCoordinateExtentForSpatialIndices );
@@ -116,16 +125,22 @@ std::unique_ptr<Problem> Pal::extract( const QgsRectangle &extent, const QgsGeom
 
   // prepare map boundary
   geos::unique_ptr mapBoundaryGeos( QgsGeos::asGeos( mapBoundary ) );
-  geos::prepared_unique_ptr mapBoundaryPrepared( GEOSPrepare_r( QgsGeos::getGEOSHandler(), mapBoundaryGeos.get() ) );
-
-  int obstacleCount = 0;
 
   // first step : extract features from layers
 
-  std::size_t previousFeatureCount = 0;
-  int previousObstacleCount = 0;
+  // active layers, with the range of their feature parts in allParts
+  struct ExtractedLayer
+  {
+    Layer *layer = nullptr;
+    std::size_t firstPart = 0;
+    std::size_t lastPart = 0;
+    int obstacleCount = 0;
+  };
+  std::vector< ExtractedLayer > extractedLayers;
+  std::vector< FeaturePart * > allParts;
 
-  QStringList layersWithFeaturesInBBox;
+  // layers stay locked until candidates have been generated for all of their parts
+  std::vector< std::unique_ptr< QMutexLocker > > layerLockers;
 
   QMutexLocker palLocker( &mMutex );
   for ( const auto &it : mLayers )
@@ -153,19 +168,18 @@ std::unique_ptr<Problem> Pal::extract( const QgsRectangle &extent, const QgsGeom
     if ( isCanceled() )
       return nullptr;
 
-    QMutexLocker locker( &layer->mMutex );
+    layerLockers.emplace_back( qgis::make_unique< QMutexLocker >( &layer->mMutex ) );
+
+    ExtractedLayer extractedLayer;
+    extractedLayer.layer = layer;
+    extractedLayer.firstPart = allParts.size();
 
-    // generate candidates for all features
     for ( FeaturePart *featurePart : qgis::as_const( layer->mFeatureParts ) )
     {
-      if ( isCanceled() )
-        break;
-
       // Holes of the feature are obstacles
       for ( int i = 0; i < featurePart->getNumSelfObstacles(); i++ )
       {
         FeaturePart *selfObstacle =  featurePart->getSelfObstacle( i );
-        obstacles.insert( selfObstacle, selfObstacle->boundingBox() );
         allObstacleParts.emplace_back( selfObstacle );
 
         if ( !featurePart->getSelfObstacle( i )->getHoleOf() )
@@ -174,96 +188,173 @@ std::unique_ptr<Problem> Pal::extract( const QgsRectangle &extent, const QgsGeom
         }
       }
 
+      allParts.emplace_back( featurePart );
+    }
+    extractedLayer.lastPart = allParts.size();
+
+    // collate all layer obstacles
+    for ( FeaturePart *obstaclePart : qgis::as_const( layer->mObstacleParts ) )
+    {
+      allObstacleParts.emplace_back( obstaclePart );
+      extractedLayer.obstacleCount++;
+    }
+
+    extractedLayers.emplace_back( extractedLayer );
+
+    if ( isCanceled() )
+      return nullptr;
+  }
+
+  // generate candidates for all feature parts. This is spread over the global thread pool, with the
+  // parts of a label feature always handled by the same task as they share its prepared permissible
+  // zone, which can't be used from several threads at once. Each task stores the results of its parts
+  // separately, and these are merged in the original order of the parts afterwards.
+  struct PartCandidates
+  {
+    std::unique_ptr< Feats > feats;
+    std::unique_ptr< LabelPosition > unplacedPosition;
+  };
+  std::vector< PartCandidates > partCandidates( allParts.size() );
+
+  std::vector< std::vector< std::size_t > > tasks;
+  {
+    std::vector< std::vector< std::size_t > > labelFeatureParts;
+    QHash< QgsLabelFeature *, std::size_t > labelFeatureIndex;
+    for ( std::size_t i = 0; i < allParts.size(); ++i )
+    {
+      QgsLabelFeature *labelFeature = allParts[i]->feature();
+      auto labelFeatureIt = labelFeatureIndex.constFind( labelFeature );
+      if ( labelFeatureIt == labelFeatureIndex.constEnd() )
+      {
+        labelFeatureIndex.insert( labelFeature, labelFeatureParts.size() );
+        labelFeatureParts.emplace_back( std::vector< std::size_t >() );
+        labelFeatureParts.back().emplace_back( i );
+      }
+      else
+      {
+        labelFeatureParts[ *labelFeatureIt ].emplace_back( i );
+      }
+    }
+
+    const std::size_t taskCount = allParts.size() < PARALLEL_CANDIDATES_MIN_PARTS ? 1
+                                  : static_cast< std::size_t >( std::max( 1, QThread::idealThreadCount() ) * CANDIDATE_TASKS_PER_THREAD );
+    const std::size_t partsPerTask = std::max( static_cast< std::size_t >( 1 ), allParts.size() / taskCount );
+    std::vector< std::size_t > task;
+    for ( const std::vector< std::size_t > &parts : labelFeatureParts )
+    {
+      task.insert( task.end(), parts.begin(), parts.end() );
+      if ( task.size() >= partsPerTask )
+      {
+        tasks.emplace_back( std::move( task ) );
+        task = std::vector< std::size_t >();
+      }
+    }
+    if ( !task.empty() )
+      tasks.emplace_back( std::move( task ) );
+  }
+
+  const GEOSGeometry *mapBoundaryGeom = mapBoundaryGeos.get();
+  auto generateCandidates = [this, mapBoundaryGeom, &allParts, &partCandidates]( const std::vector< std::size_t > &task )
+  {
+    // each task uses its own prepared map boundary, as prepared geometries aren't thread safe
+    GEOSContextHandle_t geosctxt = QgsGeos::getGEOSHandler();
+    geos::unique_ptr taskMapBoundary( GEOSGeom_clone_r( geosctxt, mapBoundaryGeom ) );
+    geos::prepared_unique_ptr taskMapBoundaryPrepared( GEOSPrepare_r( geosctxt, taskMapBoundary.get() ) );
+
+    for ( std::size_t partIndex : task )
+    {
+      if ( isCanceled() )
+        return;
+
+      FeaturePart *featurePart = allParts[ partIndex ];
+
       // generate candidates for the feature part
       std::vector< std::unique_ptr< LabelPosition > > candidates = featurePart->createCandidates( this );
 
       if ( isCanceled() )
-        break;
+        return;
 
       // purge candidates that are outside the bbox
-      candidates.erase( std::remove_if( candidates.begin(), candidates.end(), [&mapBoundaryPrepared, this]( std::unique_ptr< LabelPosition > &candidate )
+      candidates.erase( std::remove_if( candidates.begin(), candidates.end(), [&taskMapBoundaryPrepared, this]( std::unique_ptr< LabelPosition > &candidate )
       {
         if ( showPartialLabels() )
-          return !candidate->intersects( mapBoundaryPrepared.get() );
+          return !candidate->intersects( taskMapBoundaryPrepared.get() );
         else
-          return !candidate->within( mapBoundaryPrepared.get() );
+          return !candidate->within( taskMapBoundaryPrepared.get() );
       } ), candidates.end() );
 
-      if ( isCanceled() )
-        break;
-
-      if ( !candidates.empty() )
-      {
-        for ( std::unique_ptr< LabelPosition > &candidate : candidates )
-        {
-          candidate->insertIntoIndex( allCandidatesFirstRound );
-        }
-
-        std::sort( candidates.begin(), candidates.end(), CostCalculator::candidateSortGrow );
-
-        // valid features are added to fFeats
-        std::unique_ptr< Feats > ft = qgis::make_unique< Feats >();
-        ft->feature = featurePart;
-        ft->shape = nullptr;
-        ft->candidates = std::move( candidates );
-        ft->priority = featurePart->calculatePriority();
-        features.emplace_back( std::move( ft ) );
-      }
-      else
+      if ( candidates.empty() )
       {
         // no candidates, so generate a default "point on surface" one
         std::unique_ptr< LabelPosition > unplacedPosition = featurePart->createCandidatePointOnSurface( featurePart );
         if ( !unplacedPosition )
           continue;
 
-        if ( layer->displayAll() )
-        {
-          // if we are displaying all labels, we throw the default candidate in too
-          unplacedPosition->insertIntoIndex( allCandidatesFirstRound );
-          candidates.emplace_back( std::move( unplacedPosition ) );
-
-          // valid features are added to fFeats
-          std::unique_ptr< Feats > ft = qgis::make_unique< Feats >();
-          ft->feature = featurePart;
-          ft->shape = nullptr;
-          ft->candidates = std::move( candidates );
-          ft->priority = featurePart->calculatePriority();
-          features.emplace_back( std::move( ft ) );
-        }
-        else
+        if ( !featurePart->layer()->displayAll() )
         {
           // not displaying all labels for this layer, so it goes into the unlabeled feature list
-          prob->positionsWithNoCandidates()->emplace_back( std::move( unplacedPosition ) );
+          partCandidates[ partIndex ].unplacedPosition = std::move( unplacedPosition );
+          continue;
         }
-      }
-    }
-    if ( isCanceled() )
-      return nullptr;
 
-    // collate all layer obstacles
-    for ( FeaturePart *obstaclePart : qgis::as_const( layer->mObstacleParts ) )
-    {
-      if ( isCanceled() )
-        break; // do not continue searching
+        // if we are displaying all labels, we throw the default candidate in too
+        candidates.emplace_back( std::move( unplacedPosition ) );
+      }
+      else
+      {
+        std::sort( candidates.begin(), candidates.end(), CostCalculator::candidateSortGrow );
+      }
 
-      // insert into obstacles
-      obstacles.insert( obstaclePart, obstaclePart->boundingBox() );
-      allObstacleParts.emplace_back( obstaclePart );
-      obstacleCount++;
+      // obstacles are tested against the candidates from several threads
+      for ( std::unique_ptr< LabelPosition > &candidate : candidates )
+        candidate->createGeosGeometries();
+
+      // valid features are added to fFeats
+      std::unique_ptr< Feats > ft = qgis::make_unique< Feats >();
+      ft->feature = featurePart;
+      ft->shape = nullptr;
+      ft->candidates = std::move( candidates );
+      ft->priority = featurePart->calculatePriority();
+      partCandidates[ partIndex ].feats = std::move( ft );
     }
+  };
 
-    if ( isCanceled() )
-      return nullptr;
+  if ( tasks.size() == 1 )
+    generateCandidates( tasks.front() );
+  else if ( !tasks.empty() )
+    QtConcurrent::blockingMap( tasks, generateCandidates );
 
-    locker.unlock();
+  if ( isCanceled() )
+    return nullptr;
+
+  QStringList layersWithFeaturesInBBox;
+  for ( const ExtractedLayer &extractedLayer : extractedLayers )
+  {
+    const std::size_t previousFeatureCount = features.size();
+    for ( std::size_t i = extractedLayer.firstPart; i < extractedLayer.lastPart; ++i )
+    {
+      PartCandidates &candidates = partCandidates[i];
+      if ( candidates.feats )
+      {
+        for ( std::unique_ptr< LabelPosition > &candidate : candidates.feats->candidates )
+        {
+          candidate->insertIntoIndex( allCandidatesFirstRound );
+        }
+        features.emplace_back( std::move( candidates.feats ) );
+      }
+      else if ( candidates.unplacedPosition )
+      {
+        prob->positionsWithNoCandidates()->emplace_back( std::move( candidates.unplacedPosition ) );
+      }
+    }
 
-    if ( features.size() - previousFeatureCount > 0 || obstacleCount > previousObstacleCount )
+    if ( features.size() - previousFeatureCount > 0 || extractedLayer.obstacleCount > 0 )
     {
-      layersWithFeaturesInBBox << layer->name();
+      layersWithFeaturesInBBox << extractedLayer.layer->name();
     }
-    previousFeatureCount = features.size();
-    previousObstacleCount = obstacleCount;
   }
+
+  layerLockers.clear();
   palLocker.unlock();
 
   if ( isCanceled() )
@@ -277,32 +368,81 @@ std::unique_ptr<Problem> Pal::extract( const QgsRectangle &extent, const QgsGeom
   prob->mFeatNbLp.resize( prob->mFeatureCount );
   prob->mFeatStartId.resize( prob->mFeatureCount );
   prob->mInactiveCost.resize( prob->mFeatureCount );
+  prob->mConflictParents.resize( prob->mFeatureCount );
+  std::iota( prob->mConflictParents.begin(), prob->mConflictParents.end(), 0 );
 
   if ( !features.empty() )
   {
     // Filtering label positions against obstacles
-    for ( FeaturePart *obstaclePart : allObstacleParts )
+    auto ignoreObstacle = []( const LabelPosition * candidatePosition, FeaturePart * obstaclePart ) -> bool
+    {
+      // test whether we should ignore this obstacle for the candidate. We do this if:
+      // 1. it's not a hole, and the obstacle belongs to the same label feature as the candidate (e.g.,
+      // features aren't obstacles for their own labels)
+      // 2. it IS a hole, and the hole belongs to a different label feature to the candidate (e.g., holes
+      // are ONLY obstacles for the labels of the feature they belong to)
+      return ( !obstaclePart->getHoleOf() && candidatePosition->getFeaturePart()->hasSameLabelFeatureAs( obstaclePart ) )
+             || ( obstaclePart->getHoleOf() && !candidatePosition->getFeaturePart()->hasSameLabelFeatureAs( dynamic_cast< FeaturePart * >( obstaclePart->getHoleOf() ) ) );
+    };
+
+    // penalties for line and polygon obstacles are calculated in parallel, with each obstacle tested by a
+    // single thread. Point obstacles are cheap to test but rely on the candidates' own prepared geometries,
+    // so they are tested below on this thread.
+    typedef std::vector< std::pair< LabelPosition *, int > > ObstaclePenalties;
+    std::vector< ObstaclePenalties > obstaclePenalties( allObstacleParts.size() );
+    std::vector< std::size_t > parallelObstacles;
+    for ( std::size_t i = 0; i < allObstacleParts.size(); ++i )
+    {
+      if ( allObstacleParts[i]->getGeosType() != GEOS_POINT )
+        parallelObstacles.emplace_back( i );
+    }
+
+    QtConcurrent::blockingMap( parallelObstacles, [this, &allObstacleParts, &allCandidatesFirstRound, &obstaclePenalties, &ignoreObstacle]( std::size_t obstacleIndex )
     {
       if ( isCanceled() )
-        break; // do not continue searching
+        return;
 
-      allCandidatesFirstRound.intersects( obstaclePart->boundingBox(), [obstaclePart, this]( const LabelPosition * candidatePosition ) -> bool
+      FeaturePart *obstaclePart = allObstacleParts[ obstacleIndex ];
+      ObstaclePenalties &penalties = obstaclePenalties[ obstacleIndex ];
+      allCandidatesFirstRound.intersects( obstaclePart->boundingBox(), [obstaclePart, &penalties, &ignoreObstacle]( const LabelPosition * candidatePosition ) -> bool
       {
-        // test whether we should ignore this obstacle for the candidate. We do this if:
-        // 1. it's not a hole, and the obstacle belongs to the same label feature as the candidate (e.g.,
-        // features aren't obstacles for their own labels)
-        // 2. it IS a hole, and the hole belongs to a different label feature to the candidate (e.g., holes
-        // are ONLY obstacles for the labels of the feature they belong to)
-        if ( ( !obstaclePart->getHoleOf() && candidatePosition->getFeaturePart()->hasSameLabelFeatureAs( obstaclePart ) )
-             || ( obstaclePart->getHoleOf() && !candidatePosition->getFeaturePart()->hasSameLabelFeatureAs( dynamic_cast< FeaturePart * >( obstaclePart->getHoleOf() ) ) ) )
-        {
+        if ( ignoreObstacle( candidatePosition, obstaclePart ) )
           return true;
-        }
 
-        CostCalculator::addObstacleCostPenalty( const_cast< LabelPosition * >( candidatePosition ), obstaclePart, this );
+        const int penalty = CostCalculator::calculateObstaclePenalty( candidatePosition, obstaclePart );
+        if ( penalty > 0 )
+          penalties.emplace_back( const_cast< LabelPosition * >( candidatePosition ), penalty );
 
         return true;
       } );
+    } );
+
+    // costs are applied in the order of the obstacles, as they would have been serially
+    for ( std::size_t i = 0; i < allObstacleParts.size(); ++i )
+    {
+      if ( isCanceled() )
+        break; // do not continue searching
+
+      FeaturePart *obstaclePart = allObstacleParts[i];
+      if ( obstaclePart->getGeosType() == GEOS_POINT )
+      {
+        allCandidatesFirstRound.intersects( obstaclePart->boundingBox(), [obstaclePart, &ignoreObstacle, this]( const LabelPosition * candidatePosition ) -> bool
+        {
+          if ( ignoreObstacle( candidatePosition, obstaclePart ) )
+            return true;
+
+          CostCalculator::addObstacleCostPenalty( const_cast< LabelPosition * >( candidatePosition ), obstaclePart, this );
+
+          return true;
+        } );
+      }
+      else
+      {
+        for ( const std::pair< LabelPosition *, int > &penalty : obstaclePenalties[i] )
+        {
+          CostCalculator::applyObstacleCostPenalty( penalty.first, obstaclePart, penalty.second, this );
+        }
+      }
     }
 
     if ( isCanceled() )
@@ -445,11 +585,12 @@ std::unique_ptr<Problem> Pal::extract( const QgsRectangle &extent, const QgsGeom
 
         // lookup for overlapping candidate
         lp->getBoundingBox( amin, amax );
-        prob->allCandidatesIndex().intersects( QgsRectangle( amin[0], amin[1], amax[0], amax[1] ), [&lp]( const LabelPosition * lp2 )->bool
+        prob->allCandidatesIndex().intersects( QgsRectangle( amin[0], amin[1], amax[0], amax[1] ), [&lp, &prob]( const LabelPosition * lp2 )->bool
         {
           if ( lp->isInConflict( lp2 ) )
           {
             lp->incrementNumOverlaps();
+            prob->joinConflictingFeatures( lp->getProblemFeatureId(), lp2->getProblemFeatureId() );
           }
 
           return true;
@@ -488,11 +629,9 @@ QList<LabelPosition *> Pal::solveProblem( Problem *prob, bool displayAll, QList<
   if ( !prob )
     return QList<LabelPosition *>();
 
-  prob->reduce();
-
   try
   {
-    prob->chain_search();
+    prob->solve();
   }
   catch ( InternalException::Empty & )
   {
@@ -42,8 +42,17 @@
 
 #include "qgslabelingengine.h"
 
+#include <QtConcurrentMap>
+
 using namespace pal;
 
+// minimum number of candidates for a problem to be split into sub problems solved in parallel
+static const int PARALLEL_SOLVE_MIN_CANDIDATES = 10000;
+
+// groups of conflicting features are merged into the same sub problem until it holds at least
+// this number of candidates, which keeps the overhead of many tiny sub problems low
+static const int SUB_PROBLEM_MIN_CANDIDATES = 1000;
+
 inline void delete_chain( Chain *chain )
 {
   if ( chain )
@@ -57,6 +66,7 @@ inline void delete_chain( Chain *chain )
 Problem::Problem( const QgsRectangle &extent )
   : mAllCandidatesIndex( extent )
   , mActiveCandidatesIndex( extent )
+  , mExtent( extent )
 {
 
 }
@@ -654,6 +664,181 @@ void Problem::chain_search()
   delete[] ok;
 }
 
+int Problem::conflictRoot( int feature )
+{
+  int root = feature;
+  while ( mConflictParents[root] != root )
+    root = mConflictParents[root];
+
+  // compress the path, so that later lookups are fast
+  while ( mConflictParents[feature] != root )
+  {
+    const int next = mConflictParents[feature];
+    mConflictParents[feature] = root;
+    feature = next;
+  }
+  return root;
+}
+
+void Problem::joinConflictingFeatures( int feature1, int feature2 )
+{
+  const int root1 = conflictRoot( feature1 );
+  const int root2 = conflictRoot( feature2 );
+  if ( root1 < root2 )
+    mConflictParents[root2] = root1;
+  else if ( root2 < root1 )
+    mConflictParents[root1] = root2;
+}
+
+void Problem::solve()
+{
+  if ( mConflictParents.size() != mFeatureCount || mTotalCandidates < PARALLEL_SOLVE_MIN_CANDIDATES )
+  {
+    reduce();
+    chain_search();
+    return;
+  }
+
+  struct SubProblem
+  {
+    //! Features of the sub problem, in increasing order
+    std::vector< int > features;
+    int totalCandidates = 0;
+    double nbOverlap = 0;
+    double totalCost = 0;
+    bool empty = false;
+  };
+
+  // collect the groups of conflicting features, in order of their first feature, and merge
+  // them into sub problems. This only depends on the problem, not on the number of threads.
+  std::vector< SubProblem > subProblems;
+  {
+    std::vector< std::vector< int > > groups;
+    std::vector< int > groupForRoot( mFeatureCount, -1 );
+    for ( int i = 0; i < static_cast< int >( mFeatureCount ); ++i )
+    {
+      const int root = conflictRoot( i );
+      if ( groupForRoot[root] < 0 )
+      {
+        groupForRoot[root] = static_cast< int >( groups.size() );
+        groups.emplace_back( std::vector< int >() );
+      }
+      groups[ groupForRoot[root] ].emplace_back( i );
+    }
+
+    SubProblem subProblem;
+    int candidateCount = 0;
+    for ( const std::vector< int > &group : groups )
+    {
+      subProblem.features.insert( subProblem.features.end(), group.begin(), group.end() );
+      for ( int feature : group )
+        candidateCount += mFeatNbLp[feature];
+
+      if ( candidateCount >= SUB_PROBLEM_MIN_CANDIDATES )
+      {
+        std::sort( subProblem.features.begin(), subProblem.features.end() );
+        subProblems.emplace_back( std::move( subProblem ) );
+        subProblem = SubProblem();
+        candidateCount = 0;
+      }
+    }
+    if ( !subProblem.features.empty() )
+    {
+      std::sort( subProblem.features.begin(), subProblem.features.end() );
+      subProblems.emplace_back( std::move( subProblem ) );
+    }
+  }
+
+  if ( subProblems.size() < 2 )
+  {
+    reduce();
+    chain_search();
+    return;
+  }
+
+  mSol.init( mFeatureCount );
+
+  QtConcurrent::blockingMap( subProblems, [this]( SubProblem & subProblem )
+  {
+    Problem sub( mExtent );
+    sub.pal = pal;
+    sub.mDisplayAll = mDisplayAll;
+    std::copy( mMapExtentBounds, mMapExtentBounds + 4, sub.mMapExtentBounds );
+    sub.mFeatureCount = subProblem.features.size();
+    sub.mFeatStartId.resize( sub.mFeatureCount );
+    sub.mFeatNbLp.resize( sub.mFeatureCount );
+    sub.mInactiveCost.resize( sub.mFeatureCount );
+
+    // candidates are moved to the sub problem and renumbered with its own feature and label ids
+    int localId = 0;
+    int nbOverlaps = 0;
+    for ( std::size_t i = 0; i < sub.mFeatureCount; ++i )
+    {
+      const int feature = subProblem.features[i];
+      sub.mFeatStartId[i] = localId;
+      sub.mFeatNbLp[i] = mFeatNbLp[feature];
+      sub.mInactiveCost[i] = mInactiveCost[feature];
+      for ( int j = 0; j < mFeatNbLp[feature]; ++j )
+      {
+        std::unique_ptr< LabelPosition > lp = std::move( mLabelPositions[ mFeatStartId[feature] + j ] );
+        lp->setProblemIds( static_cast< int >( i ), localId++ );
+        lp->insertIntoIndex( sub.mAllCandidatesIndex );
+        nbOverlaps += lp->getNumOverlaps();
+        sub.mLabelPositions.emplace_back( std::move( lp ) );
+      }
+    }
+    sub.mTotalCandidates = localId;
+    sub.mAllNblp = localId;
+    sub.mNbOverlap = nbOverlaps / 2;
+
+    try
+    {
+      sub.reduce();
+      sub.chain_search();
+    }
+    catch ( InternalException::Empty & )
+    {
+      subProblem.empty = true;
+    }
+
+    // move the candidates back, with their original ids, and translate the solution
+    for ( std::size_t i = 0; i < sub.mFeatureCount; ++i )
+    {
+      const int feature = subProblem.features[i];
+      const int offset = mFeatStartId[feature] - sub.mFeatStartId[i];
+      const int end = i + 1 < sub.mFeatureCount ? sub.mFeatStartId[i + 1] : localId;
+      for ( int label = sub.mFeatStartId[i]; label < end; ++label )
+      {
+        std::unique_ptr< LabelPosition > lp = std::move( sub.mLabelPositions[ label ] );
+        lp->setProblemIds( feature, label + offset );
+        mLabelPositions[ label + offset ] = std::move( lp );
+      }
+
+      const int activeLabel = i < sub.mSol.activeLabelIds.size() ? sub.mSol.activeLabelIds[i] : -1;
+      mSol.activeLabelIds[feature] = activeLabel < 0 ? -1 : activeLabel + offset;
+      mFeatNbLp[feature] = sub.mFeatNbLp[i];
+    }
+
+    subProblem.totalCandidates = sub.mTotalCandidates;
+    subProblem.nbOverlap = sub.mNbOverlap;
+    subProblem.totalCost = sub.mSol.totalCost;
+  } );
+
+  mTotalCandidates = 0;
+  mNbOverlap = 0;
+  bool empty = false;
+  for ( const SubProblem &subProblem : subProblems )
+  {
+    mTotalCandidates += subProblem.totalCandidates;
+    mNbOverlap += subProblem.nbOverlap;
+    mSol.totalCost += subProblem.totalCost;
+    empty |= subProblem.empty;
+  }
+
+  if ( empty )
+    throw InternalException::Empty();
+}
+
 QList<LabelPosition *> Problem::getSolution( bool returnInactive, QList<LabelPosition *> *unlabeled )
 {
   QList<LabelPosition *> finalLabelPlacements;
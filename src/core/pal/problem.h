@@ -117,6 +117,18 @@ namespace pal
        */
       void chain_search();
 
+      /**
+       * Reduces and solves the problem, selecting the best candidates for all features.
+       *
+       * Features are grouped by the connected components of the conflict graph, i.e. candidates of
+       * features from different groups never conflict. For large problems, each group is then solved as
+       * an independent sub problem, on the global thread pool. Groups only depend on the problem itself,
+       * so the solution is deterministic.
+       *
+       * \since QGIS 3.18
+       */
+      void solve();
+
       /**
        * Solves the labeling problem, selecting the best candidate locations for all labels and returns a list of these
        * calculated label positions.
@@ -221,6 +233,23 @@ namespace pal
 
       Chain *chain( int seed );
 
+      /**
+       * Records that candidates of \a feature1 and \a feature2 conflict, so that both features
+       * end up in the same group when the problem is solved.
+       */
+      void joinConflictingFeatures( int feature1, int feature2 );
+
+      //! Returns the feature representing the group of conflicting features containing \a feature
+      int conflictRoot( int feature );
+
+      /**
+       * Parent of each feature in the disjoint sets of conflicting features, or empty
+       * if conflicts have not been recorded.
+       */
+      std::vector< int > mConflictParents;
+
+      QgsRectangle mExtent;
+
       Pal *pal = nullptr;
 
       void solution_cost();
@@ -23,6 +23,7 @@
 #include "qgsproject.h"
 #include "qgsexception.h"
 #include "qgsexpressioncontextutils.h"
+#include "qgsfeaturebatch.h"
 
 ///@cond PRIVATE
 
@@ -103,6 +104,24 @@ bool QgsMemoryFeatureIterator::fetchFeature( QgsFeature &feature )
     return nextFeatureTraverseAll( feature );
 }
 
+int QgsMemoryFeatureIterator::fetchBatch( QgsFeatureBatch &batch, int maxRows )
+{
+  if ( mUsingFeatureIdList || !mFilterRect.isNull() || mSubsetExpression || mTransform.isValid() )
+    return QgsAbstractFeatureIterator::fetchBatch( batch, maxRows );
+
+  if ( mClosed )
+    return 0;
+
+  // plain traversal: append the stored features directly, without copying them first
+  int rows = 0;
+  for ( ; rows < maxRows && mSelectIterator != mSource->mFeatures.constEnd(); ++rows, ++mSelectIterator )
+    batch.appendFeature( mSelectIterator.value() );
+
+  if ( mSelectIterator == mSource->mFeatures.constEnd() )
+    close();
+
+  return rows;
+}
 
 bool QgsMemoryFeatureIterator::nextFeatureUsingList( QgsFeature &feature )
 {
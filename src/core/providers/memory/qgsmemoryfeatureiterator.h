@@ -65,6 +65,7 @@ class QgsMemoryFeatureIterator final: public QgsAbstractFeatureIteratorFromSourc
   protected:
 
     bool fetchFeature( QgsFeature &feature ) override;
+    int fetchBatch( QgsFeatureBatch &batch, int maxRows ) override;
 
   private:
     bool nextFeatureUsingList( QgsFeature &feature );
@@ -26,11 +26,16 @@
 #include "qgsmessagelog.h"
 #include "qgssettings.h"
 #include "qgsexception.h"
+#include "qgsfeaturebatch.h"
 #include "qgswkbtypes.h"
 #include "qgsogrtransaction.h"
 
 #include <QTextCodec>
 #include <QFile>
+#include <QMutex>
+#include <QQueue>
+#include <QThread>
+#include <QWaitCondition>
 
 // using from provider:
 // - setRelevantFields(), mRelevantFieldsForNextFeature
@@ -41,6 +46,101 @@
 
 ///@cond PRIVATE
 
+/**
+ * Thread reading the features of an OGR feature iterator ahead of the consumer.
+ *
+ * The thread owns the OGR layer of the iterator while it is running and
+ * fills a bounded queue with ready to use features, so that disk reads,
+ * GDAL decoding and the QgsFeature conversion overlap with the consumer work.
+ */
+class QgsOgrFeatureReadAheadThread : public QThread
+{
+  public:
+
+    explicit QgsOgrFeatureReadAheadThread( QgsOgrFeatureIterator *iterator )
+      : mIterator( iterator )
+    {}
+
+    ~QgsOgrFeatureReadAheadThread() override
+    {
+      stop();
+    }
+
+    /**
+     * Takes the next prepared feature, waiting for the thread to read it if needed.
+     * Returns FALSE when all the features have been read.
+     */
+    bool nextFeature( QgsFeature &feature )
+    {
+      QMutexLocker locker( &mMutex );
+      while ( mQueue.isEmpty() && !mFinished )
+        mQueueNotEmpty.wait( &mMutex );
+
+      if ( mQueue.isEmpty() )
+        return false;
+
+      feature = mQueue.dequeue();
+      if ( mQueue.size() == QUEUE_SIZE - 1 )
+        mQueueNotFull.wakeOne();
+      return true;
+    }
+
+    //! Asks the thread to stop reading and waits until it is done
+    void stop()
+    {
+      {
+        QMutexLocker locker( &mMutex );
+        mStopRequested = true;
+        mQueueNotFull.wakeOne();
+      }
+      wait();
+    }
+
+  protected:
+
+    void run() override
+    {
+      // the HTTP fetch overrider is per thread
+      QgsCPLHTTPFetchOverrider oCPLHTTPFetcher( mIterator->mAuthCfg, mIterator->mInterruptionChecker );
+      QgsSetCPLHTTPFetchOverriderInitiatorClass( oCPLHTTPFetcher, QStringLiteral( "QgsOgrFeatureIterator" ) );
+
+      QgsFeature feature;
+      for ( ;; )
+      {
+        const bool hasFeature = mIterator->fetchNextFeature( feature );
+
+        QMutexLocker locker( &mMutex );
+        while ( hasFeature && mQueue.size() >= QUEUE_SIZE && !mStopRequested )
+          mQueueNotFull.wait( &mMutex );
+
+        if ( mStopRequested || !hasFeature )
+        {
+          mFinished = true;
+          mQueueNotEmpty.wakeOne();
+          return;
+        }
+
+        mQueue.enqueue( feature );
+        if ( mQueue.size() == 1 )
+          mQueueNotEmpty.wakeOne();
+      }
+    }
+
+  private:
+
+    //! Maximum number of features read ahead of the consumer
+    static const int QUEUE_SIZE = 256;
+
+    QgsOgrFeatureIterator *mIterator = nullptr;
+
+    QMutex mMutex;
+    QWaitCondition mQueueNotEmpty;
+    QWaitCondition mQueueNotFull;
+    QQueue< QgsFeature > mQueue;
+    bool mFinished = false;
+    bool mStopRequested = false;
+};
+
 
 QgsOgrFeatureIterator::QgsOgrFeatureIterator( QgsOgrFeatureSource *source, bool ownSource, const QgsFeatureRequest &request, QgsTransaction *transaction )
   : QgsAbstractFeatureIteratorFromSource<QgsOgrFeatureSource>( source, ownSource, request )
@@ -248,6 +348,14 @@ QgsOgrFeatureIterator::QgsOgrFeatureIterator( QgsOgrFeatureSource *source, bool
     OGR_L_SetAttributeFilter( mOgrLayer, nullptr );
   }
 
+  // the read-ahead thread needs the dataset for itself, which is not possible
+  // when it is shared with a transaction or when the iterator may be nested
+  mUseReadAhead = ( mRequest.flags() & QgsFeatureRequest::ReadAhead )
+                  && mConn
+                  && mAllowResetReading
+                  && mRequest.filterType() != QgsFeatureRequest::FilterFid
+                  && mRequest.filterType() != QgsFeatureRequest::FilterFids;
+
   //start with first feature
   rewind();
 
@@ -376,6 +484,42 @@ bool QgsOgrFeatureIterator::fetchFeature( QgsFeature &feature )
     return false;
   }
 
+  if ( mUseReadAhead )
+  {
+    if ( !mReadAheadThread )
+    {
+      mReadAheadThread = qgis::make_unique< QgsOgrFeatureReadAheadThread >( this );
+      mReadAheadThread->start();
+    }
+
+    if ( mReadAheadThread->nextFeature( feature ) )
+      return true;
+  }
+  else if ( fetchNextFeature( feature ) )
+  {
+    return true;
+  }
+
+  close();
+  return false;
+}
+
+bool QgsOgrFeatureIterator::fetchNextFeature( QgsFeature &feature )
+{
+  gdal::ogr_feature_unique_ptr fet;
+  while ( ( fet = nextOgrFeature() ) )
+  {
+    if ( checkFeature( fet, feature ) )
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+gdal::ogr_feature_unique_ptr QgsOgrFeatureIterator::nextOgrFeature()
+{
   gdal::ogr_feature_unique_ptr fet;
 
   // OSM layers (especially large ones) need the GDALDataset::GetNextFeature() call rather than OGRLayer::GetNextFeature()
@@ -387,27 +531,151 @@ bool QgsOgrFeatureIterator::fetchFeature( QgsFeature &feature )
     OGRLayerH nextFeatureBelongingLayer;
     while ( fet.reset( GDALDatasetGetNextFeature( mConn->ds, &nextFeatureBelongingLayer, nullptr, nullptr, nullptr ) ), fet )
     {
-      if ( nextFeatureBelongingLayer == mOgrLayer && checkFeature( fet, feature ) )
-      {
-        return true;
-      }
+      if ( nextFeatureBelongingLayer == mOgrLayer )
+        break;
     }
   }
   else
 #endif
   {
+    fet.reset( OGR_L_GetNextFeature( mOgrLayer ) );
+  }
+
+  return fet;
+}
+
+int QgsOgrFeatureIterator::fetchBatch( QgsFeatureBatch &batch, int maxRows )
+{
+  // filtering on the geometries, reprojecting and reading ahead need complete features
+  if ( mUseReadAhead || mRequest.filterType() != QgsFeatureRequest::FilterNone || !mRequest.filterRect().isNull()
+       || mSource->mOgrGeometryTypeFilter != wkbUnknown || mTransform.isValid() )
+    return QgsAbstractFeatureIterator::fetchBatch( batch, maxRows );
+
+  QMutexLocker locker( mSharedDS ? &mSharedDS->mutex() : nullptr );
+
+  QgsCPLHTTPFetchOverrider oCPLHTTPFetcher( mAuthCfg, mInterruptionChecker );
+  QgsSetCPLHTTPFetchOverriderInitiatorClass( oCPLHTTPFetcher, QStringLiteral( "QgsOgrFeatureIterator" ) );
+
+  if ( mClosed || !mOgrLayer )
+    return 0;
 
-    while ( fet.reset( OGR_L_GetNextFeature( mOgrLayer ) ), fet )
+  // only the requested attributes are read, the other batch columns stay NULL
+  const QgsAttributeList batchAttributes = batch.attributes();
+  const bool subsetOfAttributes = mRequest.flags() & QgsFeatureRequest::SubsetOfAttributes;
+  const QgsAttributeList requestedAttributes = mRequest.subsetOfAttributes();
+  QVector<int> columns;
+  QVector<QVariant::Type> columnFieldTypes;
+  for ( int column = 0; column < batchAttributes.count(); ++column )
+  {
+    if ( subsetOfAttributes && !requestedAttributes.contains( batchAttributes.at( column ) ) )
+      continue;
+    columns << column;
+    columnFieldTypes << mSource->mFields.at( batchAttributes.at( column ) ).type();
+  }
+
+  const bool fetchGeometry = mFetchGeometry && batch.includesGeometry();
+  const bool forceMulti = QgsWkbTypes::isMultiType( mSource->mWkbType );
+  const bool utf8 = !mSource->mEncoding || mSource->mEncoding->mibEnum() == 106;
+
+  int rows = 0;
+  gdal::ogr_feature_unique_ptr fet;
+  while ( rows < maxRows && ( fet = nextOgrFeature() ) )
+  {
+    OGRFeatureH ogrFet = fet.get();
+    batch.addRow( OGR_F_GetFID( ogrFet ) );
+
+    if ( fetchGeometry )
     {
-      if ( checkFeature( fet, feature ) )
+      OGRGeometryH geom = OGR_F_GetGeometryRef( ogrFet );
+      if ( geom )
       {
-        return true;
+        const OGRwkbGeometryType flatType = wkbFlatten( OGR_G_GetGeometryType( geom ) );
+        if ( flatType >= wkbPoint && flatType <= wkbMultiPolygon && ( !forceMulti || flatType >= wkbMultiPoint ) )
+        {
+          // ISO WKB of the simple types is what QgsGeometry uses, export it in place
+          unsigned char *wkb = reinterpret_cast< unsigned char * >( batch.reserveWkb( OGR_G_WkbSize( geom ) ) );
+          OGR_G_ExportToIsoWkb( geom, wkbNDR, wkb );
+        }
+        else
+        {
+          QgsGeometry g = QgsOgrUtils::ogrGeometryToQgsGeometry( geom );
+
+          // Insure that multipart datasets return multipart geometry
+          if ( forceMulti && !g.isMultipart() )
+          {
+            g.convertToMultiType();
+          }
+          batch.setGeometry( g );
+        }
+      }
+    }
+
+    for ( int i = 0; i < columns.count(); ++i )
+    {
+      const int column = columns.at( i );
+      const int attindex = batchAttributes.at( column );
+      if ( mFirstFieldIsFid && attindex == 0 )
+      {
+        batch.setInt64( column, OGR_F_GetFID( ogrFet ) );
+        continue;
+      }
+
+      const int attindexWithoutFid = ( mFirstFieldIsFid ) ? attindex - 1 : attindex;
+      if ( !OGR_F_IsFieldSetAndNotNull( ogrFet, attindexWithoutFid ) )
+        continue;
+
+      switch ( columnFieldTypes.at( i ) )
+      {
+        case QVariant::Int:
+          batch.setInt64( column, OGR_F_GetFieldAsInteger( ogrFet, attindexWithoutFid ) );
+          break;
+
+        case QVariant::Bool:
+          batch.setInt64( column, OGR_F_GetFieldAsInteger( ogrFet, attindexWithoutFid ) ? 1 : 0 );
+          break;
+
+        case QVariant::LongLong:
+          batch.setInt64( column, OGR_F_GetFieldAsInteger64( ogrFet, attindexWithoutFid ) );
+          break;
+
+        case QVariant::Double:
+          batch.setDouble( column, OGR_F_GetFieldAsDouble( ogrFet, attindexWithoutFid ) );
+          break;
+
+        case QVariant::String:
+        {
+          const char *string = OGR_F_GetFieldAsString( ogrFet, attindexWithoutFid );
+          if ( utf8 )
+            batch.setString( column, string, static_cast< int >( strlen( string ) ) );
+          else
+            batch.setString( column, mSource->mEncoding->toUnicode( string ) );
+          break;
+        }
+
+        default:
+        {
+          bool ok = false;
+          const QVariant value = QgsOgrUtils::getOgrFeatureAttribute( ogrFet, mFieldsWithoutFid, attindexWithoutFid, mSource->mEncoding, &ok );
+          if ( ok )
+            batch.setValue( column, value );
+          break;
+        }
       }
     }
+
+    ++rows;
   }
 
-  close();
-  return false;
+  if ( rows < maxRows )
+    close();
+
+  return rows;
+}
+
+void QgsOgrFeatureIterator::stopReadAhead()
+{
+  // the thread must not touch the layer anymore once this returns
+  mReadAheadThread.reset();
 }
 
 void QgsOgrFeatureIterator::resetReading()
@@ -436,6 +704,7 @@ bool QgsOgrFeatureIterator::rewind()
   if ( mClosed || !mOgrLayer )
     return false;
 
+  stopReadAhead();
   resetReading();
 
   mFilterFidsIt = mFilterFids.begin();
@@ -446,6 +715,8 @@ bool QgsOgrFeatureIterator::rewind()
 
 bool QgsOgrFeatureIterator::close()
 {
+  stopReadAhead();
+
   if ( mSharedDS )
   {
     iteratorClosed();
@@ -29,6 +29,7 @@
 #define SIP_NO_FILE
 
 class QgsOgrFeatureIterator;
+class QgsOgrFeatureReadAheadThread;
 class QgsOgrProvider;
 class QgsOgrDataset;
 using QgsOgrDatasetSharedPtr = std::shared_ptr< QgsOgrDataset>;
@@ -79,11 +80,21 @@ class QgsOgrFeatureIterator final: public QgsAbstractFeatureIteratorFromSource<Q
     bool checkFeature( gdal::ogr_feature_unique_ptr &fet, QgsFeature &feature ) ;
     bool fetchFeature( QgsFeature &feature ) override;
     bool nextFeatureFilterExpression( QgsFeature &f ) override;
+    int fetchBatch( QgsFeatureBatch &batch, int maxRows ) override;
 
   private:
 
     bool readFeature( gdal::ogr_feature_unique_ptr fet, QgsFeature &feature ) const;
 
+    //! Reads the next feature of the layer matching the request, without closing the iterator at the end
+    bool fetchNextFeature( QgsFeature &feature );
+
+    //! Returns the next raw OGR feature of the layer, or NULLPTR at the end of the layer
+    gdal::ogr_feature_unique_ptr nextOgrFeature();
+
+    //! Stops the read-ahead thread, discarding the features it has already prepared
+    void stopReadAhead();
+
     //! Gets an attribute associated with a feature
     void getFeatureAttribute( OGRFeatureH ogrFet, QgsFeature &f, int attindex ) const;
 
@@ -114,9 +125,15 @@ class QgsOgrFeatureIterator final: public QgsAbstractFeatureIteratorFromSource<Q
      * a transaction for SQLITE-based layers */
     bool mAllowResetReading = true;
 
+    //! Sets to true if the features are read by a dedicated thread (QgsFeatureRequest::ReadAhead)
+    bool mUseReadAhead = false;
+    std::unique_ptr< QgsOgrFeatureReadAheadThread > mReadAheadThread;
+
     bool fetchFeatureWithId( QgsFeatureId id, QgsFeature &feature ) const;
 
     void resetReading();
+
+    friend class QgsOgrFeatureReadAheadThread;
 };
 
 ///@endcond
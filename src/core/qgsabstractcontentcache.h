@@ -27,12 +27,14 @@
 
 #include <QObject>
 #include <QMutex>
+#include <QWaitCondition>
 #include <QCache>
 #include <QSet>
 #include <QDateTime>
 #include <QList>
 #include "qgsnetworkcontentfetchertask.h"
 #include <QNetworkReply>
+#include <memory>
 
 /**
  * \class QgsAbstractContentCacheEntry
@@ -217,6 +219,36 @@ class CORE_EXPORT QgsAbstractContentCache : public QgsAbstractContentCacheBase
     ~QgsAbstractContentCache() override
     {
       qDeleteAll( mEntryLookup );
+      qDeleteAll( mRemovedEntriesBeingFilled );
+    }
+
+    /**
+     * Returns the number of requests for content which were answered with content
+     * already present in the cache.
+     *
+     * \see missCount()
+     * \since QGIS 3.18
+     */
+    qint64 hitCount() const
+    {
+      QMutexLocker locker( &mMutex );
+      return mHitCount;
+    }
+
+    /**
+     * Returns the number of requests for content which had to be created because it
+     * was not present in the cache.
+     *
+     * Requests which waited for another thread creating the same content are not
+     * counted as misses.
+     *
+     * \see hitCount()
+     * \since QGIS 3.18
+     */
+    qint64 missCount() const
+    {
+      QMutexLocker locker( &mMutex );
+      return mMissCount;
     }
 
   protected:
@@ -237,6 +269,10 @@ class CORE_EXPORT QgsAbstractContentCache : public QgsAbstractContentCacheBase
         T *bkEntry = entry;
         entry = static_cast< T * >( entry->nextEntry );
 
+        // entries can't be removed while another thread is filling them
+        if ( mEntriesBeingFilled.contains( bkEntry ) )
+          continue;
+
         takeEntryFromList( bkEntry );
         mEntryLookup.remove( bkEntry->path, bkEntry );
         mTotalSize -= bkEntry->dataSize();
@@ -443,7 +479,11 @@ class CORE_EXPORT QgsAbstractContentCache : public QgsAbstractContentCacheBase
           takeEntryFromList( entry );
           mEntryLookup.remove( entry->path, entry );
           mTotalSize -= entry->dataSize();
-          delete entry;
+          // entries which are being filled are deleted by finishFillingEntry() instead
+          if ( mEntriesBeingFilled.contains( entry ) )
+            mRemovedEntriesBeingFilled.insert( entry );
+          else
+            delete entry;
         }
       }
 
@@ -546,6 +586,67 @@ class CORE_EXPORT QgsAbstractContentCache : public QgsAbstractContentCacheBase
       return currentEntry;
     }
 
+    /**
+     * Marks an \a entry without content as being filled by the calling thread, so that the content
+     * can be created without holding the cache lock.
+     *
+     * Must be called with mMutex locked exactly once through \a locker. Returns TRUE if the calling thread
+     * must fill the entry, and then call finishFillingEntry() with mMutex locked again. Until then the entry
+     * is kept alive, and only the calling thread may modify it.
+     *
+     * If another thread is already filling the entry, the lock is released while waiting until that thread
+     * has finished, and FALSE is returned. \a entry may have been deleted meanwhile, so callers must look up
+     * the entry again.
+     *
+     * \since QGIS 3.18
+     */
+    bool startFillingEntry( T *entry, QMutexLocker &locker )
+    {
+      const auto it = mEntriesBeingFilled.constFind( entry );
+      if ( it == mEntriesBeingFilled.constEnd() )
+      {
+        mEntriesBeingFilled.insert( entry, std::make_shared< PendingEntry >() );
+        mMissCount++;
+        return true;
+      }
+
+      const std::shared_ptr< PendingEntry > pending = it.value();
+      locker.unlock();
+      {
+        QMutexLocker pendingLocker( &pending->mutex );
+        while ( !pending->isFilled )
+          pending->filled.wait( &pending->mutex );
+      }
+      locker.relock();
+      return false;
+    }
+
+    /**
+     * Finishes filling an \a entry marked by startFillingEntry(), waking any threads waiting for it.
+     *
+     * Must be called with mMutex locked. Returns FALSE if the entry was removed from the cache while it
+     * was being filled, in which case it has been deleted and its content must not be stored.
+     *
+     * \since QGIS 3.18
+     */
+    bool finishFillingEntry( T *entry )
+    {
+      const std::shared_ptr< PendingEntry > pending = mEntriesBeingFilled.take( entry );
+      if ( pending )
+      {
+        QMutexLocker pendingLocker( &pending->mutex );
+        pending->isFilled = true;
+        pending->filled.wakeAll();
+      }
+
+      if ( mRemovedEntriesBeingFilled.remove( entry ) )
+      {
+        delete entry;
+        return false;
+      }
+      return true;
+    }
+
     mutable QMutex mMutex;
     //! Estimated total size of all cached content
     long mTotalSize = 0;
@@ -553,8 +654,22 @@ class CORE_EXPORT QgsAbstractContentCache : public QgsAbstractContentCacheBase
     //! Maximum cache size
     long mMaxCacheSize = 20000000;
 
+    //! Number of requests answered with cached content
+    qint64 mHitCount = 0;
+
+    //! Number of requests for which content had to be created
+    qint64 mMissCount = 0;
+
   private:
 
+    //! Allows threads to wait for an entry which is being filled by another thread
+    struct PendingEntry
+    {
+      QMutex mutex;
+      QWaitCondition filled;
+      bool isFilled = false;
+    };
+
     /**
      * Inserts a new \a entry into the cache.
      *
@@ -651,6 +766,11 @@ class CORE_EXPORT QgsAbstractContentCache : public QgsAbstractContentCacheBase
     mutable QCache< QString, QByteArray > mRemoteContentCache;
     mutable QSet< QString > mPendingRemoteUrls;
 
+    //! Entries which are being filled by a thread, with the state other threads can wait on
+    QHash< T *, std::shared_ptr< PendingEntry > > mEntriesBeingFilled;
+    //! Entries which were removed from the cache while being filled, deleted once filling has finished
+    QSet< T * > mRemovedEntriesBeingFilled;
+
     QString mTypeString;
 
     friend class TestQgsSvgCache;
@@ -43,6 +43,7 @@
 #include <sqlite3.h>
 #include <qlogging.h>
 #include <vector>
+#include <cmath>
 #include <algorithm>
 
 // if defined shows all information about transform to stdout
@@ -627,6 +628,68 @@ QgsRectangle QgsCoordinateTransform::transformBoundingBox( const QgsRectangle &r
   return bb_rect;
 }
 
+// Radius of the sphere used by the web mercator projection, the semi-major axis of the WGS 84 ellipsoid
+static const double WEB_MERCATOR_RADIUS = 6378137.0;
+
+// Web mercator is only computed directly up to this latitude, the limit of the EPSG:3857 area of use
+static const double WEB_MERCATOR_MAX_LATITUDE = 85.06;
+
+/**
+ * Transforms WGS 84 longitudes and latitudes to web mercator in place, without going through PROJ.
+ * Returns FALSE and leaves the coordinates untouched if any point is outside the area where the
+ * projection is computed directly.
+ */
+static bool geographicToWebMercator( int numPoints, double *x, double *y )
+{
+  for ( int i = 0; i < numPoints; ++i )
+  {
+    // also rejects NaN values
+    if ( !( std::fabs( x[i] ) <= 180.0 ) || !( std::fabs( y[i] ) <= WEB_MERCATOR_MAX_LATITUDE ) )
+      return false;
+  }
+
+  // branch free loops, which the compiler can vectorize
+  const double toRadians = M_PI / 180.0;
+  for ( int i = 0; i < numPoints; ++i )
+  {
+    x[i] *= WEB_MERCATOR_RADIUS * toRadians;
+  }
+  for ( int i = 0; i < numPoints; ++i )
+  {
+    y[i] = WEB_MERCATOR_RADIUS * std::asinh( std::tan( y[i] * toRadians ) );
+  }
+  return true;
+}
+
+/**
+ * Transforms web mercator coordinates to WGS 84 longitudes and latitudes in place, without going through PROJ.
+ * Returns FALSE and leaves the coordinates untouched if any point is outside the area where the
+ * projection is computed directly.
+ */
+static bool webMercatorToGeographic( int numPoints, double *x, double *y )
+{
+  const double maxX = WEB_MERCATOR_RADIUS * M_PI;
+  const double maxY = WEB_MERCATOR_RADIUS * std::asinh( std::tan( WEB_MERCATOR_MAX_LATITUDE * M_PI / 180.0 ) );
+  for ( int i = 0; i < numPoints; ++i )
+  {
+    // also rejects NaN values
+    if ( !( std::fabs( x[i] ) <= maxX ) || !( std::fabs( y[i] ) <= maxY ) )
+      return false;
+  }
+
+  // branch free loops, which the compiler can vectorize
+  const double toDegrees = 180.0 / M_PI;
+  for ( int i = 0; i < numPoints; ++i )
+  {
+    x[i] *= toDegrees / WEB_MERCATOR_RADIUS;
+  }
+  for ( int i = 0; i < numPoints; ++i )
+  {
+    y[i] = toDegrees * std::atan( std::sinh( y[i] / WEB_MERCATOR_RADIUS ) );
+  }
+  return true;
+}
+
 void QgsCoordinateTransform::transformCoords( int numPoints, double *x, double *y, double *z, TransformDirection direction ) const
 {
   if ( !d->mIsValid || d->mShortCircuit )
@@ -646,6 +709,17 @@ void QgsCoordinateTransform::transformCoords( int numPoints, double *x, double *
     return;
   }
 
+  if ( d->mAnalyticOperation != QgsCoordinateTransformPrivate::NoAnalyticOperation )
+  {
+    // points outside the area where the operation is computed directly are all left to PROJ, with its exact results and error handling
+    const bool toWebMercator = ( d->mAnalyticOperation == QgsCoordinateTransformPrivate::GeographicToWebMercator ) == ( direction == ForwardTransform );
+    if ( toWebMercator ? geographicToWebMercator( numPoints, x, y ) : webMercatorToGeographic( numPoints, x, y ) )
+    {
+      mFallbackOperationOccurred = false;
+      return;
+    }
+  }
+
   std::vector< int > zNanPositions;
   for ( int i = 0; i < numPoints; i++ )
   {
@@ -113,6 +113,7 @@ QgsCoordinateTransformPrivate::QgsCoordinateTransformPrivate( const QgsCoordinat
   , mShouldReverseCoordinateOperation( other.mShouldReverseCoordinateOperation )
   , mAllowFallbackTransforms( other.mAllowFallbackTransforms )
   , mIsReversed( other.mIsReversed )
+  , mAnalyticOperation( other.mAnalyticOperation )
   , mProjLock()
   , mProjProjections()
   , mProjFallbackProjections()
@@ -146,6 +147,7 @@ void QgsCoordinateTransformPrivate::invalidate()
 {
   mShortCircuit = true;
   mIsValid = false;
+  mAnalyticOperation = NoAnalyticOperation;
 #if PROJ_VERSION_MAJOR >= 6
   mAvailableOpCount = -1;
 #endif
@@ -260,6 +262,24 @@ bool QgsCoordinateTransformPrivate::initialize()
   // Transform must take place
   mShortCircuit = false;
 
+  // the operation between WGS 84 and web mercator is common enough to be worth computing directly
+#if PROJ_VERSION_MAJOR>=6
+  const bool defaultOperation = mProjCoordinateOperation.isEmpty();
+#else
+  Q_NOWARN_DEPRECATED_PUSH
+  const bool defaultOperation = mSourceDatumTransform == -1 && mDestinationDatumTransform == -1;
+  Q_NOWARN_DEPRECATED_POP
+#endif
+  if ( mIsValid && defaultOperation )
+  {
+    const QString sourceAuthId = mSourceCRS.authid();
+    const QString destAuthId = mDestCRS.authid();
+    if ( sourceAuthId == QLatin1String( "EPSG:4326" ) && destAuthId == QLatin1String( "EPSG:3857" ) )
+      mAnalyticOperation = GeographicToWebMercator;
+    else if ( sourceAuthId == QLatin1String( "EPSG:3857" ) && destAuthId == QLatin1String( "EPSG:4326" ) )
+      mAnalyticOperation = WebMercatorToGeographic;
+  }
+
   return mIsValid;
 }
 
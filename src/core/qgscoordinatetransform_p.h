@@ -140,6 +140,17 @@ class QgsCoordinateTransformPrivate : public QSharedData
     //! True if the proj transform corresponds to the reverse direction, and must be flipped when transforming...
     bool mIsReversed = false;
 
+    //! Coordinate operations which are computed directly instead of through PROJ
+    enum AnalyticOperation
+    {
+      NoAnalyticOperation, //!< All points are transformed by PROJ
+      GeographicToWebMercator, //!< From WGS 84 (EPSG:4326) to WGS 84 / Pseudo-Mercator (EPSG:3857)
+      WebMercatorToGeographic, //!< From WGS 84 / Pseudo-Mercator (EPSG:3857) to WGS 84 (EPSG:4326)
+    };
+
+    //! Operation computed directly for forward transforms, the reverse operation is used for reverse transforms
+    AnalyticOperation mAnalyticOperation = NoAnalyticOperation;
+
 #if PROJ_VERSION_MAJOR<6
 
     /**
@@ -0,0 +1,343 @@
+/***************************************************************************
+                         qgsfeaturebatch.cpp
+                         -------------------
+    begin                : November 2020
+    copyright            : (C) 2020 by the QGIS project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsfeaturebatch.h"
+
+#include <QJsonDocument>
+#include <cstring>
+
+QgsFeatureBatch::QgsFeatureBatch( const QgsFields &fields, bool includeGeometry )
+  : mFields( fields )
+  , mAttributes( fields.allAttributesList() )
+  , mIncludeGeometry( includeGeometry )
+{
+  initColumns();
+}
+
+QgsFeatureBatch::QgsFeatureBatch( const QgsFields &fields, const QgsAttributeList &attributes, bool includeGeometry )
+  : mFields( fields )
+  , mIncludeGeometry( includeGeometry )
+{
+  for ( int attributeIndex : attributes )
+  {
+    if ( attributeIndex >= 0 && attributeIndex < fields.count() && !mAttributes.contains( attributeIndex ) )
+      mAttributes << attributeIndex;
+  }
+  initColumns();
+}
+
+void QgsFeatureBatch::initColumns()
+{
+  mColumns.resize( mAttributes.count() );
+  for ( int column = 0; column < mAttributes.count(); ++column )
+    mColumns[column].type = columnTypeForField( mFields.at( mAttributes.at( column ) ) );
+  clear();
+}
+
+int QgsFeatureBatch::columnForAttribute( int attributeIndex ) const
+{
+  return mAttributes.indexOf( attributeIndex );
+}
+
+QgsFeatureBatch::ColumnType QgsFeatureBatch::columnTypeForField( const QgsField &field )
+{
+  switch ( field.type() )
+  {
+    case QVariant::Int:
+    case QVariant::UInt:
+    case QVariant::LongLong:
+    case QVariant::ULongLong:
+    case QVariant::Bool:
+      return Int64Column;
+
+    case QVariant::Double:
+      return DoubleColumn;
+
+    default:
+      return StringColumn;
+  }
+}
+
+void QgsFeatureBatch::clear()
+{
+  // QVector::clear() keeps the capacity, so a reused batch does not reallocate
+  mIds.clear();
+  mWkb.clear();
+  mWkbOffsets.clear();
+  mWkbOffsets.append( 0 );
+  for ( Column &column : mColumns )
+  {
+    column.int64s.clear();
+    column.doubles.clear();
+    column.chars.clear();
+    column.offsets.clear();
+    column.nulls.clear();
+    if ( column.type == StringColumn )
+      column.offsets.append( 0 );
+  }
+}
+
+void QgsFeatureBatch::reserve( int rows )
+{
+  mIds.reserve( rows );
+  mWkbOffsets.reserve( rows + 1 );
+  for ( Column &column : mColumns )
+  {
+    column.nulls.reserve( rows );
+    switch ( column.type )
+    {
+      case Int64Column:
+        column.int64s.reserve( rows );
+        break;
+      case DoubleColumn:
+        column.doubles.reserve( rows );
+        break;
+      case StringColumn:
+        column.offsets.reserve( rows + 1 );
+        break;
+    }
+  }
+}
+
+QString QgsFeatureBatch::stringValue( int column, int row ) const
+{
+  const Column &c = mColumns.at( column );
+  if ( c.nulls.at( row ) )
+    return QString();
+
+  const int start = c.offsets.at( row );
+  return QString::fromUtf8( c.chars.constData() + start, c.offsets.at( row + 1 ) - start );
+}
+
+QVariant QgsFeatureBatch::value( int column, int row ) const
+{
+  const QgsField field = mFields.at( mAttributes.at( column ) );
+  if ( mColumns.at( column ).nulls.at( row ) )
+    return QVariant( field.type() );
+
+  const Column &c = mColumns.at( column );
+  switch ( c.type )
+  {
+    case Int64Column:
+    {
+      QVariant v( c.int64s.at( row ) );
+      if ( field.type() == QVariant::Bool )
+        return v.toBool();
+      v.convert( field.type() );
+      return v;
+    }
+
+    case DoubleColumn:
+      return c.doubles.at( row );
+
+    case StringColumn:
+    {
+      const int start = c.offsets.at( row );
+      const int length = c.offsets.at( row + 1 ) - start;
+      switch ( field.type() )
+      {
+        case QVariant::ByteArray:
+          return QByteArray( c.chars.constData() + start, length );
+
+        case QVariant::Map:
+        case QVariant::List:
+        case QVariant::StringList:
+        {
+          QVariant v = QJsonDocument::fromJson( QByteArray::fromRawData( c.chars.constData() + start, length ) ).toVariant();
+          if ( field.type() == QVariant::StringList )
+            v.convert( QVariant::StringList );
+          return v;
+        }
+
+        default:
+        {
+          const QVariant string( QString::fromUtf8( c.chars.constData() + start, length ) );
+          QVariant v = string;
+          if ( field.type() != QVariant::String && !v.convert( field.type() ) )
+            return string;
+          return v;
+        }
+      }
+    }
+  }
+  return QVariant();
+}
+
+QByteArray QgsFeatureBatch::wkb( int row ) const
+{
+  const int start = mWkbOffsets.at( row );
+  return QByteArray( mWkb.constData() + start, mWkbOffsets.at( row + 1 ) - start );
+}
+
+QgsGeometry QgsFeatureBatch::geometry( int row ) const
+{
+  if ( !hasGeometry( row ) )
+    return QgsGeometry();
+
+  QgsGeometry geometry;
+  geometry.fromWkb( wkb( row ) );
+  return geometry;
+}
+
+QgsFeature QgsFeatureBatch::feature( int row ) const
+{
+  QgsFeature feature( mFields, mIds.at( row ) );
+  for ( int column = 0; column < mColumns.count(); ++column )
+    feature.setAttribute( mAttributes.at( column ), value( column, row ) );
+  if ( mIncludeGeometry )
+    feature.setGeometry( geometry( row ) );
+  return feature;
+}
+
+void QgsFeatureBatch::appendFeature( const QgsFeature &feature )
+{
+  addRow( feature.id() );
+
+  const QgsAttributes attributes = feature.attributes();
+  for ( int column = 0; column < mColumns.count(); ++column )
+  {
+    const int attributeIndex = mAttributes.at( column );
+    if ( attributeIndex < attributes.count() )
+      setValue( column, attributes.at( attributeIndex ) );
+  }
+
+  if ( mIncludeGeometry && feature.hasGeometry() )
+    setGeometry( feature.geometry() );
+}
+
+void QgsFeatureBatch::addRow( QgsFeatureId id )
+{
+  mIds.append( id );
+  mWkbOffsets.append( mWkb.count() );
+  for ( Column &column : mColumns )
+  {
+    column.nulls.append( 1 );
+    switch ( column.type )
+    {
+      case Int64Column:
+        column.int64s.append( 0 );
+        break;
+      case DoubleColumn:
+        column.doubles.append( 0 );
+        break;
+      case StringColumn:
+        column.offsets.append( column.chars.count() );
+        break;
+    }
+  }
+}
+
+void QgsFeatureBatch::setInt64( int column, qint64 value )
+{
+  Column &c = mColumns[column];
+  c.int64s.last() = value;
+  c.nulls.last() = 0;
+}
+
+void QgsFeatureBatch::setDouble( int column, double value )
+{
+  Column &c = mColumns[column];
+  c.doubles.last() = value;
+  c.nulls.last() = 0;
+}
+
+void QgsFeatureBatch::setString( int column, const QString &value )
+{
+  const QByteArray utf8 = value.toUtf8();
+  setString( column, utf8.constData(), utf8.length() );
+}
+
+void QgsFeatureBatch::setString( int column, const char *data, int length )
+{
+  Column &c = mColumns[column];
+  // the value of the last row always ends the character data
+  const int start = c.offsets.at( c.offsets.count() - 2 );
+  c.chars.resize( start + length );
+  if ( length > 0 )
+    std::memcpy( c.chars.data() + start, data, length );
+  c.offsets.last() = start + length;
+  c.nulls.last() = 0;
+}
+
+void QgsFeatureBatch::setValue( int column, const QVariant &value )
+{
+  if ( !value.isValid() || value.isNull() )
+    return;
+
+  bool ok = true;
+  switch ( mColumns.at( column ).type )
+  {
+    case Int64Column:
+    {
+      const qint64 v = value.toLongLong( &ok );
+      if ( ok )
+        setInt64( column, v );
+      break;
+    }
+
+    case DoubleColumn:
+    {
+      const double v = value.toDouble( &ok );
+      if ( ok )
+        setDouble( column, v );
+      break;
+    }
+
+    case StringColumn:
+    {
+      switch ( value.type() )
+      {
+        case QVariant::ByteArray:
+        {
+          const QByteArray bytes = value.toByteArray();
+          setString( column, bytes.constData(), bytes.length() );
+          break;
+        }
+
+        case QVariant::Map:
+        case QVariant::List:
+        case QVariant::StringList:
+        {
+          const QByteArray json = QJsonDocument::fromVariant( value ).toJson( QJsonDocument::Compact );
+          setString( column, json.constData(), json.length() );
+          break;
+        }
+
+        default:
+          setString( column, value.toString() );
+          break;
+      }
+      break;
+    }
+  }
+}
+
+void QgsFeatureBatch::setGeometry( const QgsGeometry &geometry )
+{
+  if ( !mIncludeGeometry || geometry.isNull() )
+    return;
+
+  const QByteArray wkb = geometry.asWkb();
+  std::memcpy( reserveWkb( wkb.length() ), wkb.constData(), wkb.length() );
+}
+
+char *QgsFeatureBatch::reserveWkb( int size )
+{
+  const int start = mWkbOffsets.at( mWkbOffsets.count() - 2 );
+  mWkb.resize( start + size );
+  mWkbOffsets.last() = start + size;
+  return mWkb.data() + start;
+}
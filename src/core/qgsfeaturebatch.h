@@ -0,0 +1,259 @@
+/***************************************************************************
+                         qgsfeaturebatch.h
+                         -----------------
+    begin                : November 2020
+    copyright            : (C) 2020 by the QGIS project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSFEATUREBATCH_H
+#define QGSFEATUREBATCH_H
+
+#include "qgis_core.h"
+#include "qgis_sip.h"
+#include "qgsfeature.h"
+#include "qgsfields.h"
+
+#include <QVector>
+
+/**
+ * \ingroup core
+ * \class QgsFeatureBatch
+ * A column oriented block of features, filled by QgsFeatureIterator::nextBatch().
+ *
+ * Instead of one QgsFeature (and one QVariant per attribute) for each row, a batch
+ * stores the values of every requested attribute in one contiguous typed array per
+ * column, alongside the feature ids and the geometries as WKB. Consumers which
+ * aggregate or scan large numbers of features can read the arrays directly and
+ * providers which support it fill them without creating any intermediate QgsFeature.
+ *
+ * Integer and boolean fields are stored as 64 bit integers, double fields as doubles
+ * and all other fields as UTF-8 strings (binary fields keep their raw bytes).
+ *
+ * A batch can be reused between calls to QgsFeatureIterator::nextBatch(), in which
+ * case the allocated storage is kept.
+ *
+ * \since QGIS 3.18
+ */
+class CORE_EXPORT QgsFeatureBatch
+{
+  public:
+
+    //! Storage type of a batch column
+    enum ColumnType
+    {
+      Int64Column, //!< 64 bit integer values
+      DoubleColumn, //!< Double values
+      StringColumn //!< UTF-8 encoded strings
+    };
+
+    /**
+     * Constructor for QgsFeatureBatch, with a column for each of the specified \a fields.
+     *
+     * If \a includeGeometry is FALSE the geometries of the features are not stored.
+     */
+    explicit QgsFeatureBatch( const QgsFields &fields = QgsFields(), bool includeGeometry = true );
+
+    /**
+     * Constructor for QgsFeatureBatch, with a column for each of the specified
+     * \a attributes indexes from \a fields.
+     *
+     * If \a includeGeometry is FALSE the geometries of the features are not stored.
+     */
+    QgsFeatureBatch( const QgsFields &fields, const QgsAttributeList &attributes, bool includeGeometry = true );
+
+    //! Returns the fields the batch columns refer to
+    QgsFields fields() const { return mFields; }
+
+    //! Returns the indexes of the attributes stored in the batch columns
+    QgsAttributeList attributes() const { return mAttributes; }
+
+    //! Returns TRUE if the batch stores feature geometries
+    bool includesGeometry() const { return mIncludeGeometry; }
+
+    //! Returns the number of columns in the batch
+    int columnCount() const { return mColumns.count(); }
+
+    //! Returns the number of rows (features) in the batch
+    int rowCount() const { return mIds.count(); }
+
+    /**
+     * Returns the column storing the attribute with the specified field index,
+     * or -1 if the attribute is not part of the batch.
+     */
+    int columnForAttribute( int attributeIndex ) const;
+
+    //! Returns the storage type of a \a column
+    ColumnType columnType( int column ) const { return mColumns.at( column ).type; }
+
+    //! Returns the storage type used for values of a \a field
+    static ColumnType columnTypeForField( const QgsField &field );
+
+    /**
+     * Removes all rows from the batch. The allocated storage is kept, so that the
+     * batch can be refilled without reallocations.
+     */
+    void clear();
+
+    //! Reserves storage for \a rows rows
+    void reserve( int rows );
+
+    //! Returns the feature id of a \a row
+    QgsFeatureId id( int row ) const { return mIds.at( row ); }
+
+    //! Returns TRUE if the value of \a column for \a row is NULL
+    bool isNull( int column, int row ) const { return mColumns.at( column ).nulls.at( row ); }
+
+    /**
+     * Returns the value of an Int64Column \a column for \a row.
+     * Returns 0 for NULL values.
+     */
+    qint64 int64Value( int column, int row ) const { return mColumns.at( column ).int64s.at( row ); }
+
+    /**
+     * Returns the value of a DoubleColumn \a column for \a row.
+     * Returns 0 for NULL values.
+     */
+    double doubleValue( int column, int row ) const { return mColumns.at( column ).doubles.at( row ); }
+
+    //! Returns the value of a StringColumn \a column for \a row as a string
+    QString stringValue( int column, int row ) const;
+
+    /**
+     * Returns the value of \a column for \a row, converted back to the type of the
+     * corresponding field.
+     */
+    QVariant value( int column, int row ) const;
+
+    //! Returns TRUE if the feature at \a row has a geometry
+    bool hasGeometry( int row ) const { return mWkbOffsets.at( row + 1 ) > mWkbOffsets.at( row ); }
+
+    //! Returns the WKB of the geometry of the feature at \a row, or an empty array if it has no geometry
+    QByteArray wkb( int row ) const;
+
+    //! Returns the geometry of the feature at \a row
+    QgsGeometry geometry( int row ) const;
+
+    /**
+     * Returns the feature at \a row. Only the attributes stored in the batch are set,
+     * all others are NULL.
+     */
+    QgsFeature feature( int row ) const;
+
+#ifndef SIP_RUN
+
+    //! Returns the feature ids of all the rows
+    const QgsFeatureId *idData() const { return mIds.constData(); }
+
+    //! Returns the values of an Int64Column \a column, one per row
+    const qint64 *int64Data( int column ) const { return mColumns.at( column ).int64s.constData(); }
+
+    //! Returns the values of a DoubleColumn \a column, one per row
+    const double *doubleData( int column ) const { return mColumns.at( column ).doubles.constData(); }
+
+    /**
+     * Returns the concatenated UTF-8 strings of a StringColumn \a column.
+     * \see stringOffsets()
+     */
+    const char *stringData( int column ) const { return mColumns.at( column ).chars.constData(); }
+
+    /**
+     * Returns the offsets of the strings of a StringColumn \a column in stringData(),
+     * rowCount() + 1 values. The string of a row spans from offsets[row] to offsets[row + 1].
+     */
+    const int *stringOffsets( int column ) const { return mColumns.at( column ).offsets.constData(); }
+
+    //! Returns the NULL flags of a \a column, one non zero byte for each NULL value
+    const char *nullFlags( int column ) const { return mColumns.at( column ).nulls.constData(); }
+
+    /**
+     * Returns the concatenated WKB of the geometries.
+     * \see wkbOffsets()
+     */
+    const char *wkbData() const { return mWkb.constData(); }
+
+    /**
+     * Returns the offsets of the geometries in wkbData(), rowCount() + 1 values.
+     * Rows without a geometry have an empty span.
+     */
+    const int *wkbOffsets() const { return mWkbOffsets.constData(); }
+
+#endif
+
+    /**
+     * Appends a \a feature to the batch, as a new row.
+     */
+    void appendFeature( const QgsFeature &feature );
+
+    /**
+     * Appends a new row for the feature with the given \a id, with NULL values
+     * for all columns and no geometry. The setters can then be used to fill
+     * the values of the new row.
+     */
+    void addRow( QgsFeatureId id );
+
+    //! Sets the value of an Int64Column \a column for the last row
+    void setInt64( int column, qint64 value );
+
+    //! Sets the value of a DoubleColumn \a column for the last row
+    void setDouble( int column, double value );
+
+    //! Sets the value of a StringColumn \a column for the last row
+    void setString( int column, const QString &value );
+
+    /**
+     * Sets the value of a StringColumn \a column for the last row from \a length bytes
+     * of UTF-8 encoded \a data.
+     * \note not available in Python bindings
+     */
+    void setString( int column, const char *data, int length ) SIP_SKIP;
+
+    /**
+     * Sets the value of a \a column for the last row, converting it to the column type.
+     * Invalid, NULL or unconvertible values are stored as NULL.
+     */
+    void setValue( int column, const QVariant &value );
+
+    //! Sets the geometry of the last row
+    void setGeometry( const QgsGeometry &geometry );
+
+    /**
+     * Reserves \a size bytes for the WKB of the geometry of the last row and returns
+     * a pointer to them, which stays valid until the batch is modified again.
+     * \note not available in Python bindings
+     */
+    char *reserveWkb( int size ) SIP_SKIP;
+
+  private:
+
+    struct Column
+    {
+      ColumnType type = StringColumn;
+      QVector<qint64> int64s;
+      QVector<double> doubles;
+      QVector<char> chars;
+      QVector<int> offsets;
+      QVector<char> nulls;
+    };
+
+    QgsFields mFields;
+    QgsAttributeList mAttributes;
+    bool mIncludeGeometry = true;
+
+    QVector<Column> mColumns;
+    QVector<QgsFeatureId> mIds;
+    QVector<char> mWkb;
+    QVector<int> mWkbOffsets;
+
+    void initColumns();
+};
+
+#endif // QGSFEATUREBATCH_H
@@ -0,0 +1,277 @@
+/***************************************************************************
+                             qgsfeatureexternalsorter.cpp
+                             -----------------
+    begin                : November 2020
+    copyright            : (C) 2020 by the QGIS project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsfeatureexternalsorter_p.h"
+#include "qgsgeometry.h"
+#include "qgsmessagelog.h"
+
+#include <QDir>
+
+#include <algorithm>
+
+///@cond PRIVATE
+
+//! Returns the approximate memory used by a \a value
+static qint64 approximateSize( const QVariant &value )
+{
+  switch ( value.type() )
+  {
+    case QVariant::String:
+      return sizeof( QVariant ) + value.toString().size() * static_cast< qint64 >( sizeof( QChar ) );
+    case QVariant::ByteArray:
+      return sizeof( QVariant ) + value.toByteArray().size();
+    default:
+      return sizeof( QVariant );
+  }
+}
+
+//! Returns the approximate memory used by a \a feature and its order by values
+static qint64 approximateSize( const QgsIndexedFeature &feature )
+{
+  qint64 size = sizeof( QgsIndexedFeature );
+  if ( feature.mFeature.hasGeometry() )
+    size += feature.mFeature.geometry().constGet()->wkbSize();
+
+  const QgsAttributes attributes = feature.mFeature.attributes();
+  for ( const QVariant &attribute : attributes )
+    size += approximateSize( attribute );
+
+  for ( const QVariant &index : feature.mIndexes )
+    size += approximateSize( index );
+
+  return size;
+}
+
+//! Returns TRUE if \a value can be written to a run with the QDataStream operators of QVariant
+static bool isStreamable( const QVariant &value )
+{
+  switch ( value.userType() )
+  {
+    case QMetaType::QVariantList:
+    {
+      const QVariantList list = value.toList();
+      return std::all_of( list.constBegin(), list.constEnd(), []( const QVariant & item ) { return isStreamable( item ); } );
+    }
+
+    case QMetaType::QVariantMap:
+    {
+      const QVariantMap map = value.toMap();
+      return std::all_of( map.constBegin(), map.constEnd(), []( const QVariant & item ) { return isStreamable( item ); } );
+    }
+
+    case QMetaType::QVariantHash:
+    {
+      const QVariantHash hash = value.toHash();
+      return std::all_of( hash.constBegin(), hash.constEnd(), []( const QVariant & item ) { return isStreamable( item ); } );
+    }
+
+    case QMetaType::VoidStar:
+    case QMetaType::QObjectStar:
+    case QMetaType::Nullptr:
+      return false;
+
+    default:
+      // user types like QgsGeometry or QgsInterval have no registered stream operators
+      return value.userType() < QMetaType::User;
+  }
+}
+
+//! Returns TRUE if the attributes and order by values of \a feature can be written to a run
+static bool isStreamable( const QgsIndexedFeature &feature )
+{
+  const QgsAttributes attributes = feature.mFeature.attributes();
+  for ( const QVariant &attribute : attributes )
+  {
+    if ( !isStreamable( attribute ) )
+      return false;
+  }
+
+  for ( const QVariant &index : feature.mIndexes )
+  {
+    if ( !isStreamable( index ) )
+      return false;
+  }
+  return true;
+}
+
+QgsFeatureExternalSorter::QgsFeatureExternalSorter( const QList<QgsFeatureRequest::OrderByClause> &preparedOrderBys, qint64 memoryBudget )
+  : mSorter( preparedOrderBys )
+  , mMemoryBudget( memoryBudget )
+{
+}
+
+QgsFeatureExternalSorter::~QgsFeatureExternalSorter() = default;
+
+void QgsFeatureExternalSorter::addFeature( const QgsIndexedFeature &feature )
+{
+  if ( !mHasFields )
+  {
+    // features of one iterator share their fields, they are not written to the runs
+    mFields = feature.mFeature.fields();
+    mHasFields = true;
+  }
+
+  if ( mSpillable && !isStreamable( feature ) )
+  {
+    // the features collected from now on are kept in memory, the runs written so far are still merged
+    mSpillable = false;
+  }
+
+  mFeatures.push_back( feature );
+  mFeaturesSize += approximateSize( feature );
+
+  if ( mFeaturesSize > mMemoryBudget && mSpillable && !mSpillFailed )
+  {
+    if ( !writeRun() )
+    {
+      // keep sorting in memory, as we did before spilling to disk was possible
+      QgsMessageLog::logMessage( QObject::tr( "Could not write sorted features to a temporary file, sorting in memory" ), QObject::tr( "General" ), Qgis::Warning );
+      mSpillFailed = true;
+    }
+  }
+}
+
+void QgsFeatureExternalSorter::sortMemory()
+{
+  mOrder.resize( mFeatures.size() );
+  for ( std::size_t i = 0; i < mFeatures.size(); ++i )
+    mOrder[i] = static_cast< int >( i );
+
+  // sort the compact indices only, the features themselves are not moved around
+  std::sort( mOrder.begin(), mOrder.end(), [this]( int a, int b )
+  {
+    return mSorter( mFeatures[a], mFeatures[b] );
+  } );
+}
+
+bool QgsFeatureExternalSorter::writeRun()
+{
+  std::unique_ptr< Run > run = qgis::make_unique< Run >();
+  run->file = qgis::make_unique< QTemporaryFile >( QDir::tempPath() + QStringLiteral( "/qgis_orderby_XXXXXX" ) );
+  if ( !run->file->open() )
+    return false;
+
+  sortMemory();
+
+  run->stream.setDevice( run->file.get() );
+  for ( int index : mOrder )
+  {
+    const QgsIndexedFeature &feature = mFeatures[index];
+    run->stream << feature.mIndexes << feature.mFeature;
+  }
+  if ( run->stream.status() != QDataStream::Ok || !run->file->flush() || !run->file->seek( 0 ) )
+    return false;
+
+  run->stream.resetStatus();
+  run->count = static_cast< qint64 >( mOrder.size() );
+  mRuns.emplace_back( std::move( run ) );
+
+  mFeatures.clear();
+  mFeatures.shrink_to_fit();
+  mOrder.clear();
+  mFeaturesSize = 0;
+  return true;
+}
+
+void QgsFeatureExternalSorter::finish()
+{
+  sortMemory();
+  mOrderPosition = 0;
+
+  mHeap.clear();
+  const int memorySource = static_cast< int >( mRuns.size() );
+  for ( int source = 0; source <= memorySource; ++source )
+  {
+    if ( source == memorySource ? !mOrder.empty() : advance( source ) )
+      mHeap.push_back( source );
+  }
+  std::make_heap( mHeap.begin(), mHeap.end(), [this]( int a, int b ) { return after( a, b ); } );
+}
+
+bool QgsFeatureExternalSorter::nextFeature( QgsFeature &feature )
+{
+  if ( mHeap.empty() )
+    return false;
+
+  auto sourceAfter = [this]( int a, int b ) { return after( a, b ); };
+
+  std::pop_heap( mHeap.begin(), mHeap.end(), sourceAfter );
+  const int source = mHeap.back();
+  mHeap.pop_back();
+
+  feature = current( source ).mFeature;
+  if ( source < static_cast< int >( mRuns.size() ) )
+    feature.setFields( mFields );
+
+  if ( advance( source ) )
+  {
+    mHeap.push_back( source );
+    std::push_heap( mHeap.begin(), mHeap.end(), sourceAfter );
+  }
+  return true;
+}
+
+bool QgsFeatureExternalSorter::advance( int source )
+{
+  if ( source == static_cast< int >( mRuns.size() ) )
+  {
+    // memory source, finish() leaves it at its first feature
+    return ++mOrderPosition < mOrder.size();
+  }
+
+  Run &run = *mRuns[source];
+  if ( run.read >= run.count )
+  {
+    run.current = QgsIndexedFeature();
+    run.stream.setDevice( nullptr );
+    run.file.reset();
+    return false;
+  }
+
+  run.stream >> run.current.mIndexes >> run.current.mFeature;
+  ++run.read;
+  if ( run.stream.status() != QDataStream::Ok )
+  {
+    QgsMessageLog::logMessage( QObject::tr( "Could not read sorted features from a temporary file" ), QObject::tr( "General" ), Qgis::Critical );
+    run.current = QgsIndexedFeature();
+    run.stream.setDevice( nullptr );
+    run.file.reset();
+    return false;
+  }
+  return true;
+}
+
+const QgsIndexedFeature &QgsFeatureExternalSorter::current( int source ) const
+{
+  if ( source == static_cast< int >( mRuns.size() ) )
+    return mFeatures[mOrder[mOrderPosition]];
+  return mRuns[source]->current;
+}
+
+bool QgsFeatureExternalSorter::after( int a, int b ) const
+{
+  const QgsIndexedFeature &featureA = current( a );
+  const QgsIndexedFeature &featureB = current( b );
+  if ( mSorter( featureB, featureA ) )
+    return true;
+  if ( mSorter( featureA, featureB ) )
+    return false;
+
+  // equal features, take earlier runs first
+  return a > b;
+}
+
+///@endcond
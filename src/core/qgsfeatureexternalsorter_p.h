@@ -0,0 +1,142 @@
+/***************************************************************************
+                             qgsfeatureexternalsorter_p.h
+                             -----------------
+    begin                : November 2020
+    copyright            : (C) 2020 by the QGIS project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSFEATUREEXTERNALSORTER_PRIVATE_H
+#define QGSFEATUREEXTERNALSORTER_PRIVATE_H
+
+#define SIP_NO_FILE
+
+/// @cond PRIVATE
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the QGIS API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+
+#include "qgis_core.h"
+#include "qgsexpressionsorter.h"
+#include "qgsfeaturerequest.h"
+#include "qgsfields.h"
+#include "qgsindexedfeature.h"
+
+#include <QDataStream>
+#include <QTemporaryFile>
+#include <memory>
+#include <vector>
+
+/**
+ * Sorts features by the prepared order by clauses of a feature request, without the need
+ * to keep all of them in memory.
+ *
+ * The features added with addFeature() are collected until their approximate size exceeds
+ * the memory budget. They are then sorted and written as a sorted run to a temporary file.
+ * Once all features are added, finish() sorts the features left in memory and nextFeature()
+ * streams the features in order, merging the runs.
+ *
+ * Sorting is done on compact records referring to the collected features, the order by
+ * values are evaluated only once per feature by the caller.
+ *
+ * Runs are only written as long as all attributes and order by values are of built-in types,
+ * as user types like QgsGeometry or QgsInterval can't be written to a QDataStream.
+ */
+class CORE_EXPORT QgsFeatureExternalSorter
+{
+  public:
+
+    //! Default memory budget for the features collected in memory, in bytes
+    static const qint64 DEFAULT_MEMORY_BUDGET = 256 * 1024 * 1024;
+
+    /**
+     * Constructor for QgsFeatureExternalSorter, sorting by the prepared \a preparedOrderBys.
+     * Sorted runs are written to disk once the features collected in memory exceed \a memoryBudget bytes.
+     */
+    explicit QgsFeatureExternalSorter( const QList<QgsFeatureRequest::OrderByClause> &preparedOrderBys, qint64 memoryBudget = DEFAULT_MEMORY_BUDGET );
+
+    ~QgsFeatureExternalSorter();
+
+    QgsFeatureExternalSorter( const QgsFeatureExternalSorter &other ) = delete;
+    QgsFeatureExternalSorter &operator=( const QgsFeatureExternalSorter &other ) = delete;
+
+    /**
+     * Adds a feature with its order by values in QgsIndexedFeature::mIndexes.
+     * Must not be called after finish().
+     */
+    void addFeature( const QgsIndexedFeature &feature );
+
+    //! Sorts the remaining features and prepares the merge, to be called once all features are added
+    void finish();
+
+    //! Fetches the next \a feature in sort order, returns FALSE once all features are returned
+    bool nextFeature( QgsFeature &feature );
+
+    //! Returns the number of sorted runs written to temporary files
+    int runCount() const { return static_cast< int >( mRuns.size() ); }
+
+  private:
+
+    //! A sorted run written to a temporary file
+    struct Run
+    {
+      std::unique_ptr< QTemporaryFile > file;
+      QDataStream stream;
+      qint64 count = 0;
+      qint64 read = 0;
+      QgsIndexedFeature current;
+    };
+
+    //! Sorts the features collected in memory and writes them to a new run, returns FALSE on failure
+    bool writeRun();
+
+    //! Sorts mOrder by the features collected in memory
+    void sortMemory();
+
+    //! Moves the source with index \a source to its next feature, returns FALSE if it is exhausted
+    bool advance( int source );
+
+    //! Returns the current feature of the source with index \a source, the last source being the memory
+    const QgsIndexedFeature &current( int source ) const;
+
+    //! Returns TRUE if the current feature of source \a a comes after the one of source \a b
+    bool after( int a, int b ) const;
+
+    QgsExpressionSorter mSorter;
+    qint64 mMemoryBudget = DEFAULT_MEMORY_BUDGET;
+
+    QgsFields mFields;
+    bool mHasFields = false;
+
+    std::vector< QgsIndexedFeature > mFeatures;
+    qint64 mFeaturesSize = 0;
+    std::vector< int > mOrder;
+    std::size_t mOrderPosition = 0;
+    bool mSpillFailed = false;
+
+    //! FALSE once a feature with a value which can't be written to a run was added
+    bool mSpillable = true;
+
+    std::vector< std::unique_ptr< Run > > mRuns;
+
+    //! Sources with a current feature, as a heap on their current features
+    std::vector< int > mHeap;
+};
+
+/// @endcond
+
+#endif // QGSFEATUREEXTERNALSORTER_PRIVATE_H
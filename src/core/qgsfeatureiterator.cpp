@@ -13,17 +13,21 @@
  *                                                                         *
  ***************************************************************************/
 #include "qgsfeatureiterator.h"
+#include "qgsfeaturebatch.h"
 #include "qgslogger.h"
 
 #include "qgssimplifymethod.h"
 #include "qgsexception.h"
-#include "qgsexpressionsorter.h"
+#include "qgsgeometrytransformbatch.h"
+#include "qgsfeatureexternalsorter_p.h"
 
 QgsAbstractFeatureIterator::QgsAbstractFeatureIterator( const QgsFeatureRequest &request )
   : mRequest( request )
 {
 }
 
+QgsAbstractFeatureIterator::~QgsAbstractFeatureIterator() = default;
+
 bool QgsAbstractFeatureIterator::nextFeature( QgsFeature &f )
 {
   bool dataOk = false;
@@ -34,16 +38,15 @@ bool QgsAbstractFeatureIterator::nextFeature( QgsFeature &f )
 
   if ( mUseCachedFeatures )
   {
-    if ( mFeatureIterator != mCachedFeatures.constEnd() )
+    if ( mSortedFeatures && mSortedFeatures->nextFeature( f ) )
     {
-      f = mFeatureIterator->mFeature;
-      ++mFeatureIterator;
       dataOk = true;
     }
     else
     {
       dataOk = false;
       // even the zombie dies at this point...
+      mSortedFeatures.reset();
       mZombie = false;
     }
   }
@@ -71,6 +74,47 @@ bool QgsAbstractFeatureIterator::nextFeature( QgsFeature &f )
   return dataOk;
 }
 
+int QgsAbstractFeatureIterator::nextBatch( QgsFeatureBatch &batch, int maxRows )
+{
+  batch.clear();
+
+  if ( mRequest.limit() >= 0 )
+    maxRows = static_cast< int >( std::min( static_cast< long >( maxRows ), mRequest.limit() - mFetchedCount ) );
+  if ( maxRows <= 0 )
+    return 0;
+
+  batch.reserve( maxRows );
+
+  if ( !mUseCachedFeatures && mRequest.filterType() == QgsFeatureRequest::FilterNone )
+  {
+    const int rows = fetchBatch( batch, maxRows );
+    mFetchedCount += rows;
+    return rows;
+  }
+
+  // filtered and sorted requests go through the regular feature by feature path
+  QgsFeature f;
+  int rows = 0;
+  while ( rows < maxRows && nextFeature( f ) )
+  {
+    batch.appendFeature( f );
+    ++rows;
+  }
+  return rows;
+}
+
+int QgsAbstractFeatureIterator::fetchBatch( QgsFeatureBatch &batch, int maxRows )
+{
+  QgsFeature f;
+  int rows = 0;
+  while ( rows < maxRows && fetchFeature( f ) )
+  {
+    batch.appendFeature( f );
+    ++rows;
+  }
+  return rows;
+}
+
 bool QgsAbstractFeatureIterator::nextFeatureFilterExpression( QgsFeature &f )
 {
   while ( fetchFeature( f ) )
@@ -98,8 +142,11 @@ void QgsAbstractFeatureIterator::geometryToDestinationCrs( QgsFeature &feature,
   {
     try
     {
+      // gather the vertices of all parts, so that multi-part geometries are transformed with a single call
       QgsGeometry g = feature.geometry();
-      g.transform( transform );
+      QgsGeometryTransformBatch batch( transform );
+      batch.addGeometry( g.get() );
+      batch.transform();
       feature.setGeometry( g );
     }
     catch ( QgsCsException & )
@@ -176,7 +223,9 @@ void QgsAbstractFeatureIterator::setupOrderBy( const QList<QgsFeatureRequest::Or
     }
     while ( ++orderByIt != preparedOrderBys.end() );
 
-    // Fetch all features
+    // Fetch all features, evaluating the order by values once per feature. Features which
+    // don't fit in memory are written as sorted runs to temporary files and merged later
+    mSortedFeatures = qgis::make_unique< QgsFeatureExternalSorter >( preparedOrderBys );
     QgsIndexedFeature indexedFeature;
     indexedFeature.mIndexes.resize( preparedOrderBys.size() );
 
@@ -184,8 +233,7 @@ void QgsAbstractFeatureIterator::setupOrderBy( const QList<QgsFeatureRequest::Or
     {
       expressionContext->setFeature( indexedFeature.mFeature );
       int i = 0;
-      const auto constPreparedOrderBys = preparedOrderBys;
-      for ( const QgsFeatureRequest::OrderByClause &orderBy : constPreparedOrderBys )
+      for ( const QgsFeatureRequest::OrderByClause &orderBy : qgis::as_const( preparedOrderBys ) )
       {
         indexedFeature.mIndexes.replace( i++, orderBy.expression().evaluate( expressionContext ) );
       }
@@ -193,12 +241,10 @@ void QgsAbstractFeatureIterator::setupOrderBy( const QList<QgsFeatureRequest::Or
       // We need all features, to ignore the limit for this pre-fetch
       // keep the fetched count at 0.
       mFetchedCount = 0;
-      mCachedFeatures.append( indexedFeature );
+      mSortedFeatures->addFeature( indexedFeature );
     }
 
-    std::sort( mCachedFeatures.begin(), mCachedFeatures.end(), QgsExpressionSorter( preparedOrderBys ) );
-
-    mFeatureIterator = mCachedFeatures.constBegin();
+    mSortedFeatures->finish();
     mUseCachedFeatures = true;
     // The real iterator is closed, we are only serving cached features
     mZombie = true;
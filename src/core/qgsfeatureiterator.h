@@ -18,8 +18,11 @@
 #include "qgis_core.h"
 #include "qgsfeaturerequest.h"
 #include "qgsindexedfeature.h"
+#include <memory>
 
 class QgsFeedback;
+class QgsFeatureBatch;
+class QgsFeatureExternalSorter;
 
 /**
  * \ingroup core
@@ -41,11 +44,22 @@ class CORE_EXPORT QgsAbstractFeatureIterator
     QgsAbstractFeatureIterator( const QgsFeatureRequest &request );
 
     //! destructor makes sure that the iterator is closed properly
-    virtual ~QgsAbstractFeatureIterator() = default;
+    virtual ~QgsAbstractFeatureIterator();
 
     //! fetch next feature, return TRUE on success
     virtual bool nextFeature( QgsFeature &f );
 
+    /**
+     * Fetches up to \a maxRows next features into a column oriented \a batch.
+     *
+     * The batch is cleared first. Returns the number of rows added to the batch,
+     * 0 once the iteration is complete.
+     *
+     * \see fetchBatch()
+     * \since QGIS 3.18
+     */
+    int nextBatch( QgsFeatureBatch &batch, int maxRows );
+
     //! reset the iterator to the starting position
     virtual bool rewind() = 0;
     //! end of iterating: free the resources / lock
@@ -102,6 +116,18 @@ class CORE_EXPORT QgsAbstractFeatureIterator
      */
     virtual bool fetchFeature( QgsFeature &f ) = 0;
 
+    /**
+     * Fetches up to \a maxRows features into \a batch and returns the number of
+     * rows added.
+     *
+     * This is only called for requests without filter expression or feature id list.
+     * The default implementation appends the features returned by fetchFeature(), providers
+     * can reimplement it to fill the batch columns directly from their data source.
+     *
+     * \since QGIS 3.18
+     */
+    virtual int fetchBatch( QgsFeatureBatch &batch, int maxRows );
+
     /**
      * By default, the iterator will fetch all features and check if the feature
      * matches the expression.
@@ -199,8 +225,7 @@ class CORE_EXPORT QgsAbstractFeatureIterator
 
   private:
     bool mUseCachedFeatures = false;
-    QList<QgsIndexedFeature> mCachedFeatures;
-    QList<QgsIndexedFeature>::ConstIterator mFeatureIterator;
+    std::unique_ptr< QgsFeatureExternalSorter > mSortedFeatures;
 
     //! returns whether the iterator supports simplify geometries on provider side
     virtual bool providerCanSimplify( QgsSimplifyMethod::MethodType methodType ) const;
@@ -217,7 +242,8 @@ class CORE_EXPORT QgsAbstractFeatureIterator
 
     /**
      * Setup the orderby. Internally calls prepareOrderBy and if FALSE is returned will
-     * cache all features and order them with local expression evaluation.
+     * fetch all features and order them with local expression evaluation. Sorted runs
+     * are written to temporary files when the features do not fit in memory.
      *
      * \since QGIS 2.14
      */
@@ -299,6 +325,21 @@ class CORE_EXPORT QgsFeatureIterator
     QgsFeatureIterator &operator=( const QgsFeatureIterator &other );
 
     bool nextFeature( QgsFeature &f );
+
+    /**
+     * Fetches up to \a maxRows next features into a column oriented \a batch.
+     *
+     * The batch is cleared first, and only the attributes and geometry it was created
+     * for are stored. Returns the number of rows added to the batch, 0 once the
+     * iteration is complete.
+     *
+     * Reading features in batches avoids creating a QgsFeature for each row, and
+     * providers supporting it fill the batch columns directly from their data.
+     *
+     * \since QGIS 3.18
+     */
+    int nextBatch( QgsFeatureBatch &batch, int maxRows = 1000 );
+
     bool rewind();
     bool close();
 
@@ -376,6 +417,11 @@ inline bool QgsFeatureIterator::nextFeature( QgsFeature &f )
   return mIter ? mIter->nextFeature( f ) : false;
 }
 
+inline int QgsFeatureIterator::nextBatch( QgsFeatureBatch &batch, int maxRows )
+{
+  return mIter ? mIter->nextBatch( batch, maxRows ) : 0;
+}
+
 inline bool QgsFeatureIterator::rewind()
 {
   if ( mIter )
@@ -80,7 +80,8 @@ class CORE_EXPORT QgsFeatureRequest
       NoFlags            = 0,
       NoGeometry         = 1,  //!< Geometry is not required. It may still be returned if e.g. required for a filter condition.
       SubsetOfAttributes = 2,  //!< Fetch only a subset of attributes (setSubsetOfAttributes sets this flag)
-      ExactIntersect     = 4   //!< Use exact geometry intersection (slower) instead of bounding boxes
+      ExactIntersect     = 4,  //!< Use exact geometry intersection (slower) instead of bounding boxes
+      ReadAhead          = 8   //!< Allow the provider to read and prepare the next features on a background thread while the current ones are processed. Ignored by providers which do not support it (since QGIS 3.18)
     };
     Q_DECLARE_FLAGS( Flags, Flag )
 
@@ -19,6 +19,7 @@
 #include "qgslogger.h"
 #include "qgssettings.h"
 #include "qgis.h"
+#include "qgstextpathcache_p.h"
 
 #include <QApplication>
 #include <QFile>
@@ -281,6 +282,12 @@ bool QgsFontUtils::loadStandardTestFonts( const QStringList &loadstyles )
     }
   }
 
+#if QT_VERSION < QT_VERSION_CHECK( 5, 11, 0 )
+  // older Qt versions don't signal font database changes, outlines cached with a substituted font are stale now
+  if ( fontsLoaded )
+    QgsTextPathCache::instance()->clear();
+#endif
+
   return fontsLoaded;
 }
 
@@ -20,6 +20,13 @@ email                : jef at norbit dot de
 #include "qgsgeos.h"
 #include "qgsgeometrycollection.h"
 #include "qgspolygon.h"
+#include "qgsfeedback.h"
+
+#include <QtConcurrent>
+
+// number of chunks created per thread when validating lists of geometries, more chunks
+// than threads keep all threads busy when some geometries are much more complex than others
+static const int VALIDATION_CHUNKS_PER_THREAD = 4;
 
 QgsGeometryValidator::QgsGeometryValidator( const QgsGeometry &geometry, QVector<QgsGeometry::Error> *errors, QgsGeometry::ValidationMethod method )
   : mGeometry( geometry )
@@ -388,10 +395,40 @@ void QgsGeometryValidator::addError( const QgsGeometry::Error &e )
 
 void QgsGeometryValidator::validateGeometry( const QgsGeometry &geometry, QVector<QgsGeometry::Error> &errors, QgsGeometry::ValidationMethod method )
 {
-  QgsGeometryValidator *gv = new QgsGeometryValidator( geometry, &errors, method );
-  connect( gv, &QgsGeometryValidator::errorFound, gv, &QgsGeometryValidator::addError );
-  gv->run();
-  gv->wait();
+  QgsGeometryValidator gv( geometry, &errors, method );
+  connect( &gv, &QgsGeometryValidator::errorFound, &gv, &QgsGeometryValidator::addError );
+  gv.run();
+  gv.wait();
+}
+
+QVector< QVector< QgsGeometry::Error > > QgsGeometryValidator::validateGeometries( const QVector< QgsGeometry > &geometries, QgsGeometry::ValidationMethod method, QgsGeometry::ValidityFlags flags, QgsFeedback *feedback )
+{
+  QVector< QVector< QgsGeometry::Error > > errors( geometries.size() );
+  if ( geometries.isEmpty() )
+    return errors;
+
+  const int geometryCount = geometries.size();
+  const int chunkCount = std::min( geometryCount, std::max( 1, QThread::idealThreadCount() ) * VALIDATION_CHUNKS_PER_THREAD );
+  QVector< int > chunks( chunkCount );
+  for ( int i = 0; i < chunkCount; ++i )
+    chunks[i] = i;
+
+  // each geometry writes to its own slot only, so no locking is required
+  QVector< QgsGeometry::Error > *geometryErrors = errors.data();
+  QtConcurrent::blockingMap( chunks, [&geometries, geometryErrors, geometryCount, chunkCount, method, flags, feedback]( int chunk )
+  {
+    const int start = static_cast< int >( static_cast< qint64 >( chunk ) * geometryCount / chunkCount );
+    const int end = static_cast< int >( static_cast< qint64 >( chunk + 1 ) * geometryCount / chunkCount );
+    for ( int i = start; i < end; ++i )
+    {
+      if ( feedback && feedback->isCanceled() )
+        return;
+
+      geometries.at( i ).validateGeometry( geometryErrors[i], method, flags );
+    }
+  } );
+
+  return errors;
 }
 
 //
@@ -21,6 +21,8 @@ email                : jef at norbit dot de
 #include <QThread>
 #include "qgsgeometry.h"
 
+class QgsFeedback;
+
 /**
  * \ingroup core
  * \class QgsGeometryValidator
@@ -46,6 +48,20 @@ class CORE_EXPORT QgsGeometryValidator : public QThread
      */
     static void validateGeometry( const QgsGeometry &geometry, QVector<QgsGeometry::Error> &errors SIP_OUT, QgsGeometry::ValidationMethod method = QgsGeometry::ValidatorQgisInternal );
 
+    /**
+     * Validates a list of \a geometries and returns the errors found for each of them, in the same order
+     * as the input geometries.
+     *
+     * The geometries are split into chunks which are validated in parallel on the global thread pool.
+     * This method blocks until all geometries have been validated. If the optional \a feedback is canceled,
+     * the geometries which have not been validated yet are returned without errors.
+     *
+     * \see QgsGeometry::validateGeometry()
+     * \since QGIS 3.18
+     */
+    static QVector< QVector< QgsGeometry::Error > > validateGeometries( const QVector< QgsGeometry > &geometries, QgsGeometry::ValidationMethod method = QgsGeometry::ValidatorQgisInternal,
+        QgsGeometry::ValidityFlags flags = QgsGeometry::ValidityFlags(), QgsFeedback *feedback = nullptr );
+
   signals:
 
     /**
@@ -30,10 +30,13 @@
 #include <QProgressDialog>
 #include <QSet>
 #include <QSettings>
+#include <QThread>
 #include <QUrl>
+#include <QtConcurrentMap>
 
 #include "ogr_api.h"
 
+#include <algorithm>
 #include <limits>
 
 static const char NS_SEPARATOR = '?';
@@ -178,7 +181,7 @@ int QgsGml::getFeatures( const QByteArray &data, QgsWkbTypes::Type *wkbType, Qgs
   mExtent.setMinimal();
 
   QString errorMsg;
-  if ( !mParser.processData( data, true /* atEnd */, errorMsg ) )
+  if ( !mParser.processDataInParallel( data, QThread::idealThreadCount(), errorMsg ) )
     QgsMessageLog::logMessage( errorMsg, QObject::tr( "WFS" ) );
 
   fillMapsFromParser();
@@ -460,6 +463,200 @@ bool QgsGmlStreamingParser::processData( const QByteArray &data, bool atEnd, QSt
   return true;
 }
 
+static inline bool isXmlSpace( char c )
+{
+  return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+/**
+ * Scans a GML document for the offsets just after the start tag of the root
+ * element (returned) and just after each closing tag of its direct children
+ * (in \a childEnds). Returns -1 if the document cannot be safely split, that
+ * is if it contains comments, CDATA sections or a DTD, or is not encoded in
+ * an ASCII compatible encoding.
+ */
+static int scanTopLevelElements( const QByteArray &data, QByteArray &rootName, QVector<int> &childEnds )
+{
+  const char *begin = data.constData();
+  const int size = data.size();
+  if ( size < 2 || begin[0] == 0 || begin[1] == 0 ||
+       static_cast< unsigned char >( begin[0] ) == 0xFE || static_cast< unsigned char >( begin[0] ) == 0xFF )
+    return -1;
+
+  int rootStartEnd = -1;
+  int depth = 0;
+  int pos = 0;
+  while ( ( pos = data.indexOf( '<', pos ) ) >= 0 )
+  {
+    if ( pos + 1 >= size )
+      return -1;
+
+    const char next = begin[pos + 1];
+    if ( next == '!' )
+      return -1;
+
+    if ( next == '?' )
+    {
+      pos = data.indexOf( "?>", pos );
+      if ( pos < 0 )
+        return -1;
+      pos += 2;
+      continue;
+    }
+
+    // find the end of the tag, skipping quoted attribute values
+    int tagEnd = -1;
+    char quote = 0;
+    for ( int i = pos + 1; i < size; ++i )
+    {
+      const char c = begin[i];
+      if ( quote )
+      {
+        if ( c == quote )
+          quote = 0;
+      }
+      else if ( c == '"' || c == '\'' )
+        quote = c;
+      else if ( c == '>' )
+      {
+        tagEnd = i;
+        break;
+      }
+    }
+    if ( tagEnd < 0 )
+      return -1;
+
+    if ( next == '/' )
+    {
+      depth--;
+      if ( depth == 1 )
+        childEnds << tagEnd + 1;
+    }
+    else if ( begin[tagEnd - 1] != '/' )
+    {
+      if ( depth == 0 )
+      {
+        int nameEnd = pos + 1;
+        while ( nameEnd < tagEnd && !isXmlSpace( begin[nameEnd] ) )
+          nameEnd++;
+        rootName = data.mid( pos + 1, nameEnd - pos - 1 );
+        rootStartEnd = tagEnd + 1;
+      }
+      depth++;
+    }
+    pos = tagEnd + 1;
+  }
+
+  return rootStartEnd;
+}
+
+std::unique_ptr< QgsGmlStreamingParser > QgsGmlStreamingParser::createChunkParser() const
+{
+  std::unique_ptr< QgsGmlStreamingParser > parser = qgis::make_unique< QgsGmlStreamingParser >( mTypeName, mGeometryAttribute, mFields, mAxisOrientationLogic, mInvertAxisOrientationRequest );
+  parser->mThematicAttributes = mThematicAttributes;
+  parser->mGMLNameSpaceURI = mGMLNameSpaceURI;
+  parser->mGMLNameSpaceURIPtr = mGMLNameSpaceURIPtr;
+  parser->mEpsg = mEpsg;
+  parser->mSrsName = mSrsName;
+  parser->mInvertAxisOrientation = mInvertAxisOrientation;
+  return parser;
+}
+
+bool QgsGmlStreamingParser::processDataInParallel( const QByteArray &data, int maxThreads, QString &errorMsg )
+{
+  // below that size, the overhead of splitting the document is not worth it
+  static const int MIN_CHUNK_SIZE = 1024 * 1024;
+
+  QByteArray rootName;
+  QVector<int> childEnds;
+  // join layers are always parsed sequentially
+  const int headerEnd = ( maxThreads > 1 && data.size() >= 2 * MIN_CHUNK_SIZE && mTypeNamePtr && mParseDepth == 0 ) ?
+                        scanTopLevelElements( data, rootName, childEnds ) : -1;
+  if ( headerEnd < 0 || childEnds.size() < 2 )
+    return processData( data, true, errorMsg );
+
+  // parse the first elements until a feature is found, so that the CRS, the axis
+  // order and the GML namespace are known when the chunk parsers are created
+  int parsedUpTo = 0;
+  int nextChild = 0;
+  while ( nextChild < childEnds.size() && mFeatureList.isEmpty() )
+  {
+    if ( !processData( QByteArray::fromRawData( data.constData() + parsedUpTo, childEnds[nextChild] - parsedUpTo ), false, errorMsg ) )
+      return false;
+    parsedUpTo = childEnds[nextChild++];
+  }
+
+  struct Chunk
+  {
+    int start = 0;
+    int end = 0;
+    std::unique_ptr< QgsGmlStreamingParser > parser;
+    bool ok = true;
+    QString errorMsg;
+  };
+
+  const int lastChildEnd = childEnds.constLast();
+  const int chunkCount = std::min( maxThreads, std::max( 1, ( lastChildEnd - parsedUpTo ) / MIN_CHUNK_SIZE ) );
+  std::vector< Chunk > chunks;
+  if ( chunkCount > 1 )
+  {
+    int chunkStart = parsedUpTo;
+    for ( int i = nextChild; i < childEnds.size(); ++i )
+    {
+      const int target = parsedUpTo + static_cast< int >( static_cast< qint64 >( lastChildEnd - parsedUpTo ) * ( chunks.size() + 1 ) / chunkCount );
+      if ( childEnds[i] >= target || i == childEnds.size() - 1 )
+      {
+        Chunk chunk;
+        chunk.start = chunkStart;
+        chunk.end = childEnds[i];
+        chunk.parser = createChunkParser();
+        chunks.emplace_back( std::move( chunk ) );
+        chunkStart = childEnds[i];
+      }
+    }
+  }
+
+  const QByteArray header = QByteArray::fromRawData( data.constData(), headerEnd );
+  const QByteArray footer = "</" + rootName + '>';
+  QtConcurrent::blockingMap( chunks, [&data, &header, &footer]( Chunk & chunk )
+  {
+    chunk.ok = chunk.parser->processData( header, false, chunk.errorMsg ) &&
+               chunk.parser->processData( QByteArray::fromRawData( data.constData() + chunk.start, chunk.end - chunk.start ), false, chunk.errorMsg ) &&
+               chunk.parser->processData( footer, true, chunk.errorMsg );
+  } );
+
+  // merge the chunks in document order
+  for ( Chunk &chunk : chunks )
+  {
+    if ( !chunk.ok )
+    {
+      errorMsg = chunk.errorMsg;
+      return false;
+    }
+
+    const QVector<QgsGmlFeaturePtrGmlIdPair> features = chunk.parser->getAndStealReadyFeatures();
+    for ( const QgsGmlFeaturePtrGmlIdPair &featPair : features )
+    {
+      featPair.first->setId( mFeatureCount++ );
+      mFeatureList.push_back( featPair );
+    }
+
+    if ( chunk.parser->mWkbType != QgsWkbTypes::Unknown &&
+         ( mWkbType == QgsWkbTypes::Unknown || QgsWkbTypes::isMultiType( chunk.parser->mWkbType ) ) )
+      mWkbType = chunk.parser->mWkbType;
+    if ( mEpsg == 0 )
+    {
+      mEpsg = chunk.parser->mEpsg;
+      mSrsName = chunk.parser->mSrsName;
+    }
+    mTruncatedResponse |= chunk.parser->mTruncatedResponse;
+    mFoundUnhandledGeometryElement |= chunk.parser->mFoundUnhandledGeometryElement;
+    parsedUpTo = chunk.end;
+  }
+
+  return processData( QByteArray::fromRawData( data.constData() + parsedUpTo, data.size() - parsedUpTo ), true, errorMsg );
+}
+
 QVector<QgsGmlStreamingParser::QgsGmlFeaturePtrGmlIdPair> QgsGmlStreamingParser::getAndStealReadyFeatures()
 {
   QVector<QgsGmlFeaturePtrGmlIdPair> ret = mFeatureList;
@@ -539,14 +736,14 @@ void QgsGmlStreamingParser::startElement( const XML_Char *el, const XML_Char **a
   {
     mParseModeStack.push( Coordinate );
     mCoorMode = QgsGmlStreamingParser::Coordinate;
-    mStringCash.clear();
-    mCoordinateSeparator = readAttribute( QStringLiteral( "cs" ), attr );
-    if ( mCoordinateSeparator.isEmpty() )
+    mCoordinateCash.clear();
+    mCoordinateSeparator = readAttribute( QStringLiteral( "cs" ), attr ).toUtf8().toStdString();
+    if ( mCoordinateSeparator.empty() )
     {
       mCoordinateSeparator = ',';
     }
-    mTupleSeparator = readAttribute( QStringLiteral( "ts" ), attr );
-    if ( mTupleSeparator.isEmpty() )
+    mTupleSeparator = readAttribute( QStringLiteral( "ts" ), attr ).toUtf8().toStdString();
+    if ( mTupleSeparator.empty() )
     {
       mTupleSeparator = ' ';
     }
@@ -556,7 +753,7 @@ void QgsGmlStreamingParser::startElement( const XML_Char *el, const XML_Char **a
   {
     mParseModeStack.push( QgsGmlStreamingParser::PosList );
     mCoorMode = QgsGmlStreamingParser::PosList;
-    mStringCash.clear();
+    mCoordinateCash.clear();
     if ( elDimension == 0 )
     {
       QString srsDimension = readAttribute( QStringLiteral( "srsDimension" ), attr );
@@ -600,13 +797,13 @@ void QgsGmlStreamingParser::startElement( const XML_Char *el, const XML_Char **a
             isGMLNS && LOCALNAME_EQUALS( "lowerCorner" ) )
   {
     mParseModeStack.push( QgsGmlStreamingParser::LowerCorner );
-    mStringCash.clear();
+    mCoordinateCash.clear();
   }
   else if ( parseMode == Envelope &&
             isGMLNS && LOCALNAME_EQUALS( "upperCorner" ) )
   {
     mParseModeStack.push( QgsGmlStreamingParser::UpperCorner );
-    mStringCash.clear();
+    mCoordinateCash.clear();
   }
   else if ( parseMode == None && !mTypeNamePtr &&
             LOCALNAME_EQUALS( "Tuple" ) )
@@ -927,10 +1124,10 @@ void QgsGmlStreamingParser::endElement( const XML_Char *el )
   }
   else if ( parseMode == BoundingBox && isGMLNS && LOCALNAME_EQUALS( "boundedBy" ) )
   {
-    //create bounding box from mStringCash
+    //create bounding box from mCoordinateCash
     if ( mCurrentExtent.isNull() &&
          !mBoundedByNullFound &&
-         !createBBoxFromCoordinateString( mCurrentExtent, mStringCash ) )
+         !createBBoxFromCoordinateString( mCurrentExtent, mCoordinateCash ) )
     {
       QgsDebugMsg( QStringLiteral( "creation of bounding box failed" ) );
     }
@@ -953,8 +1150,8 @@ void QgsGmlStreamingParser::endElement( const XML_Char *el )
   }
   else if ( parseMode == LowerCorner && isGMLNS && LOCALNAME_EQUALS( "lowerCorner" ) )
   {
-    QList<QgsPointXY> points;
-    pointsFromPosListString( points, mStringCash, 2 );
+    QVector<QgsPointXY> points;
+    pointsFromPosListString( points, mCoordinateCash, 2 );
     if ( points.size() == 1 )
     {
       mCurrentExtent.setXMinimum( points[0].x() );
@@ -964,8 +1161,8 @@ void QgsGmlStreamingParser::endElement( const XML_Char *el )
   }
   else if ( parseMode == UpperCorner && isGMLNS && LOCALNAME_EQUALS( "upperCorner" ) )
   {
-    QList<QgsPointXY> points;
-    pointsFromPosListString( points, mStringCash, 2 );
+    QVector<QgsPointXY> points;
+    pointsFromPosListString( points, mCoordinateCash, 2 );
     if ( points.size() == 1 )
     {
       mCurrentExtent.setXMaximum( points[0].x() );
@@ -1009,8 +1206,8 @@ void QgsGmlStreamingParser::endElement( const XML_Char *el )
   }
   else if ( isGMLNS && LOCALNAME_EQUALS( "Point" ) )
   {
-    QList<QgsPointXY> pointList;
-    if ( pointsFromString( pointList, mStringCash ) != 0 )
+    QVector<QgsPointXY> pointList;
+    if ( pointsFromString( pointList, mCoordinateCash ) != 0 )
     {
       //error
     }
@@ -1053,8 +1250,8 @@ void QgsGmlStreamingParser::endElement( const XML_Char *el )
   {
     //add WKB point to the feature
 
-    QList<QgsPointXY> pointList;
-    if ( pointsFromString( pointList, mStringCash ) != 0 )
+    QVector<QgsPointXY> pointList;
+    if ( pointsFromString( pointList, mCoordinateCash ) != 0 )
     {
       //error
     }
@@ -1091,8 +1288,8 @@ void QgsGmlStreamingParser::endElement( const XML_Char *el )
   else if ( ( parseMode == Geometry || parseMode == MultiPolygon ) &&
             isGMLNS && LOCALNAME_EQUALS( "LinearRing" ) )
   {
-    QList<QgsPointXY> pointList;
-    if ( pointsFromString( pointList, mStringCash ) != 0 )
+    QVector<QgsPointXY> pointList;
+    if ( pointsFromString( pointList, mCoordinateCash ) != 0 )
     {
       //error
     }
@@ -1180,13 +1377,17 @@ void QgsGmlStreamingParser::characters( const XML_Char *chars, int len )
   }
 
   QgsGmlStreamingParser::ParseMode parseMode = mParseModeStack.top();
-  if ( parseMode == QgsGmlStreamingParser::Attribute ||
-       parseMode == QgsGmlStreamingParser::AttributeTuple ||
-       parseMode == QgsGmlStreamingParser::Coordinate ||
+  if ( parseMode == QgsGmlStreamingParser::Coordinate ||
        parseMode == QgsGmlStreamingParser::PosList ||
        parseMode == QgsGmlStreamingParser::LowerCorner ||
-       parseMode == QgsGmlStreamingParser::UpperCorner ||
-       parseMode == QgsGmlStreamingParser::ExceptionText )
+       parseMode == QgsGmlStreamingParser::UpperCorner )
+  {
+    // coordinates are parsed directly from the UTF-8 bytes
+    mCoordinateCash.append( chars, len );
+  }
+  else if ( parseMode == QgsGmlStreamingParser::Attribute ||
+            parseMode == QgsGmlStreamingParser::AttributeTuple ||
+            parseMode == QgsGmlStreamingParser::ExceptionText )
   {
     mStringCash.append( QString::fromUtf8( chars, len ) );
   }
@@ -1297,9 +1498,113 @@ QString QgsGmlStreamingParser::readAttribute( const QString &attributeName, cons
   return QString();
 }
 
-bool QgsGmlStreamingParser::createBBoxFromCoordinateString( QgsRectangle &r, const QString &coordString ) const
+/**
+ * Locale independent conversion of a number from a range of bytes.
+ * Numbers whose decimal mantissa and exponent can be represented exactly
+ * as doubles, which covers nearly all coordinates, are converted without
+ * any allocation. The others are handed to Qt.
+ */
+static bool parseDouble( const char *begin, const char *end, double &value )
 {
-  QList<QgsPointXY> points;
+  static const double POWERS_OF_TEN[] =
+  {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+
+  const char *p = begin;
+  bool negative = false;
+  if ( p < end && ( *p == '-' || *p == '+' ) )
+  {
+    negative = *p == '-';
+    ++p;
+  }
+
+  quint64 mantissa = 0;
+  int significantDigits = 0;
+  int exponent = 0;
+  bool hasDigits = false;
+  bool exact = true;
+  bool afterPoint = false;
+  for ( ; p < end; ++p )
+  {
+    if ( *p == '.' && !afterPoint )
+    {
+      afterPoint = true;
+      continue;
+    }
+    if ( *p < '0' || *p > '9' )
+      break;
+
+    hasDigits = true;
+    if ( significantDigits < 19 )
+    {
+      mantissa = mantissa * 10 + static_cast< quint64 >( *p - '0' );
+      if ( mantissa != 0 )
+        significantDigits++;
+      if ( afterPoint )
+        exponent--;
+    }
+    else
+    {
+      exact = false;
+    }
+  }
+  if ( !hasDigits )
+    exact = false;
+
+  if ( exact && p < end && ( *p == 'e' || *p == 'E' ) )
+  {
+    ++p;
+    bool negativeExponent = false;
+    if ( p < end && ( *p == '-' || *p == '+' ) )
+    {
+      negativeExponent = *p == '-';
+      ++p;
+    }
+    int explicitExponent = 0;
+    const char *exponentStart = p;
+    for ( ; p < end && *p >= '0' && *p <= '9' && explicitExponent < 10000; ++p )
+      explicitExponent = explicitExponent * 10 + ( *p - '0' );
+    if ( p == exponentStart )
+      exact = false;
+    exponent += negativeExponent ? -explicitExponent : explicitExponent;
+  }
+
+  if ( exact && p == end && mantissa <= ( Q_UINT64_C( 1 ) << 53 ) && exponent >= -22 && exponent <= 22 )
+  {
+    // both the mantissa and the power of ten are exact doubles, so a single
+    // multiplication or division gives a correctly rounded result
+    const double v = exponent < 0 ? static_cast< double >( mantissa ) / POWERS_OF_TEN[-exponent]
+                     : static_cast< double >( mantissa ) * POWERS_OF_TEN[exponent];
+    value = negative ? -v : v;
+    return true;
+  }
+
+  bool ok = false;
+  value = QByteArray( begin, static_cast< int >( end - begin ) ).toDouble( &ok );
+  return ok;
+}
+
+//! Converts a range of bytes to a double, ignoring leading and trailing white spaces
+static bool parseCoordinate( const char *begin, const char *end, double &value )
+{
+  while ( begin < end && isXmlSpace( *begin ) )
+    ++begin;
+  while ( end > begin && isXmlSpace( *( end - 1 ) ) )
+    --end;
+  return begin < end && parseDouble( begin, end, value );
+}
+
+//! Returns the position of the next occurrence of \a separator in a range of bytes, or \a end
+static const char *findSeparator( const char *begin, const char *end, const std::string &separator )
+{
+  return std::search( begin, end, separator.begin(), separator.end() );
+}
+
+bool QgsGmlStreamingParser::createBBoxFromCoordinateString( QgsRectangle &r, const std::string &coordString ) const
+{
+  QVector<QgsPointXY> points;
   if ( pointsFromCoordinateString( points, coordString ) != 0 )
   {
     return false;
@@ -1315,79 +1620,81 @@ bool QgsGmlStreamingParser::createBBoxFromCoordinateString( QgsRectangle &r, con
   return true;
 }
 
-int QgsGmlStreamingParser::pointsFromCoordinateString( QList<QgsPointXY> &points, const QString &coordString ) const
+int QgsGmlStreamingParser::pointsFromCoordinateString( QVector<QgsPointXY> &points, const std::string &coordString ) const
 {
   //tuples are separated by space, x/y by ','
-#if QT_VERSION < QT_VERSION_CHECK(5, 15, 0)
-  QStringList tuples = coordString.split( mTupleSeparator, QString::SkipEmptyParts );
-#else
-  QStringList tuples = coordString.split( mTupleSeparator, Qt::SkipEmptyParts );
-#endif
-  QStringList tuples_coordinates;
-  double x, y;
-  bool conversionSuccess;
-
-  QStringList::const_iterator tupleIterator;
-  for ( tupleIterator = tuples.constBegin(); tupleIterator != tuples.constEnd(); ++tupleIterator )
-  {
-#if QT_VERSION < QT_VERSION_CHECK(5, 15, 0)
-    tuples_coordinates = tupleIterator->split( mCoordinateSeparator, QString::SkipEmptyParts );
-#else
-    tuples_coordinates = tupleIterator->split( mCoordinateSeparator, Qt::SkipEmptyParts );
-#endif
-    if ( tuples_coordinates.size() < 2 )
-    {
-      continue;
-    }
-    x = tuples_coordinates.at( 0 ).toDouble( &conversionSuccess );
-    if ( !conversionSuccess )
-    {
-      continue;
-    }
-    y = tuples_coordinates.at( 1 ).toDouble( &conversionSuccess );
-    if ( !conversionSuccess )
+  const char *end = coordString.data() + coordString.size();
+  const char *tupleStart = coordString.data();
+  while ( tupleStart < end )
+  {
+    const char *tupleEnd = findSeparator( tupleStart, end, mTupleSeparator );
+    if ( tupleEnd > tupleStart )
     {
-      continue;
+      double coordinates[2];
+      int coordinateCount = 0;
+      bool conversionSuccess = true;
+      const char *coordinateStart = tupleStart;
+      while ( conversionSuccess && coordinateCount < 2 && coordinateStart < tupleEnd )
+      {
+        const char *coordinateEnd = findSeparator( coordinateStart, tupleEnd, mCoordinateSeparator );
+        if ( coordinateEnd > coordinateStart )
+        {
+          conversionSuccess = parseCoordinate( coordinateStart, coordinateEnd, coordinates[coordinateCount++] );
+        }
+        coordinateStart = coordinateEnd == tupleEnd ? tupleEnd : coordinateEnd + mCoordinateSeparator.size();
+      }
+      if ( conversionSuccess && coordinateCount == 2 )
+      {
+        points.push_back( ( mInvertAxisOrientation ) ? QgsPointXY( coordinates[1], coordinates[0] ) : QgsPointXY( coordinates[0], coordinates[1] ) );
+      }
     }
-    points.push_back( ( mInvertAxisOrientation ) ? QgsPointXY( y, x ) : QgsPointXY( x, y ) );
+    tupleStart = tupleEnd == end ? end : tupleEnd + mTupleSeparator.size();
   }
   return 0;
 }
 
-int QgsGmlStreamingParser::pointsFromPosListString( QList<QgsPointXY> &points, const QString &coordString, int dimension ) const
+int QgsGmlStreamingParser::pointsFromPosListString( QVector<QgsPointXY> &points, const std::string &coordString, int dimension ) const
 {
-  // coordinates separated by spaces
-#if QT_VERSION < QT_VERSION_CHECK(5, 15, 0)
-  QStringList coordinates = coordString.split( ' ', QString::SkipEmptyParts );
-#else
-  QStringList coordinates = coordString.split( ' ', Qt::SkipEmptyParts );
-#endif
+  // coordinates separated by white spaces, as posList is a XML list type
+  dimension = std::max( dimension, 2 );
+  points.reserve( points.size() + static_cast< int >( coordString.size() / ( 8 * dimension ) ) );
+
+  const char *p = coordString.data();
+  const char *end = p + coordString.size();
+  int coordinateIndex = 0;
+  double x = 0;
+  double y = 0;
+  bool conversionSuccess = true;
+  while ( true )
+  {
+    while ( p < end && isXmlSpace( *p ) )
+      ++p;
+    if ( p == end )
+      break;
+    const char *tokenEnd = std::find_if( p, end, isXmlSpace );
 
-  if ( coordinates.size() % dimension != 0 )
-  {
-    QgsDebugMsg( QStringLiteral( "Wrong number of coordinates" ) );
-  }
+    const int component = coordinateIndex % dimension;
+    if ( component == 0 )
+      conversionSuccess = parseDouble( p, tokenEnd, x );
+    else if ( component == 1 )
+      conversionSuccess = conversionSuccess && parseDouble( p, tokenEnd, y );
 
-  int ncoor = coordinates.size() / dimension;
-  for ( int i = 0; i < ncoor; i++ )
-  {
-    bool conversionSuccess;
-    double x = coordinates.value( i * dimension ).toDouble( &conversionSuccess );
-    if ( !conversionSuccess )
+    if ( component == dimension - 1 && conversionSuccess )
     {
-      continue;
+      points.append( ( mInvertAxisOrientation ) ? QgsPointXY( y, x ) : QgsPointXY( x, y ) );
     }
-    double y = coordinates.value( i * dimension + 1 ).toDouble( &conversionSuccess );
-    if ( !conversionSuccess )
-    {
-      continue;
-    }
-    points.append( ( mInvertAxisOrientation ) ? QgsPointXY( y, x ) : QgsPointXY( x, y ) );
+    coordinateIndex++;
+    p = tokenEnd;
+  }
+
+  if ( coordinateIndex % dimension != 0 )
+  {
+    QgsDebugMsg( QStringLiteral( "Wrong number of coordinates" ) );
   }
   return 0;
 }
 
-int QgsGmlStreamingParser::pointsFromString( QList<QgsPointXY> &points, const QString &coordString ) const
+int QgsGmlStreamingParser::pointsFromString( QVector<QgsPointXY> &points, const std::string &coordString ) const
 {
   if ( mCoorMode == QgsGmlStreamingParser::Coordinate )
   {
@@ -1411,7 +1718,7 @@ int QgsGmlStreamingParser::getPointWKB( QgsWkbPtr &wkbPtr, const QgsPointXY &poi
   return 0;
 }
 
-int QgsGmlStreamingParser::getLineWKB( QgsWkbPtr &wkbPtr, const QList<QgsPointXY> &lineCoordinates ) const
+int QgsGmlStreamingParser::getLineWKB( QgsWkbPtr &wkbPtr, const QVector<QgsPointXY> &lineCoordinates ) const
 {
   int wkbSize = 1 + 2 * sizeof( int ) + lineCoordinates.size() * 2 * sizeof( double );
   wkbPtr = QgsWkbPtr( new unsigned char[wkbSize], wkbSize );
@@ -1420,7 +1727,7 @@ int QgsGmlStreamingParser::getLineWKB( QgsWkbPtr &wkbPtr, const QList<QgsPointXY
 
   fillPtr << mEndian << QgsWkbTypes::LineString << lineCoordinates.size();
 
-  QList<QgsPointXY>::const_iterator iter;
+  QVector<QgsPointXY>::const_iterator iter;
   for ( iter = lineCoordinates.constBegin(); iter != lineCoordinates.constEnd(); ++iter )
   {
     fillPtr << iter->x() << iter->y();
@@ -1429,7 +1736,7 @@ int QgsGmlStreamingParser::getLineWKB( QgsWkbPtr &wkbPtr, const QList<QgsPointXY
   return 0;
 }
 
-int QgsGmlStreamingParser::getRingWKB( QgsWkbPtr &wkbPtr, const QList<QgsPointXY> &ringCoordinates ) const
+int QgsGmlStreamingParser::getRingWKB( QgsWkbPtr &wkbPtr, const QVector<QgsPointXY> &ringCoordinates ) const
 {
   int wkbSize = sizeof( int ) + ringCoordinates.size() * 2 * sizeof( double );
   wkbPtr = QgsWkbPtr( new unsigned char[wkbSize], wkbSize );
@@ -1438,7 +1745,7 @@ int QgsGmlStreamingParser::getRingWKB( QgsWkbPtr &wkbPtr, const QList<QgsPointXY
 
   fillPtr << ringCoordinates.size();
 
-  QList<QgsPointXY>::const_iterator iter;
+  QVector<QgsPointXY>::const_iterator iter;
   for ( iter = ringCoordinates.constBegin(); iter != ringCoordinates.constEnd(); ++iter )
   {
     fillPtr << iter->x() << iter->y();
@@ -31,6 +31,7 @@
 #include <QVector>
 
 #include <string>
+#include <memory>
 
 class QgsCoordinateReferenceSystem;
 
@@ -110,6 +111,17 @@ class CORE_EXPORT QgsGmlStreamingParser
     */
     bool processData( const QByteArray &data, bool atEnd );
 
+    /**
+     * Process a complete GML document. Features that are direct children of the
+     * root element are split into chunks at element boundaries, and the chunks
+     * are parsed concurrently on up to \a maxThreads threads. The resulting
+     * features are in document order, exactly as if processData() had been called
+     * with \a data and atEnd set to TRUE, which is also what is done for small
+     * documents or documents that cannot be split safely.
+     * \since QGIS 3.18
+     */
+    bool processDataInParallel( const QByteArray &data, int maxThreads, QString &errorMsg );
+
     /**
      * Returns the list of features that have been completely parsed. This
      * can be called at any point. This will empty the list maintained internally
@@ -208,29 +220,35 @@ class CORE_EXPORT QgsGmlStreamingParser
       */
     QString readAttribute( const QString &attributeName, const XML_Char **attr ) const;
     //! Creates a rectangle from a coordinate string.
-    bool createBBoxFromCoordinateString( QgsRectangle &bb, const QString &coordString ) const;
+    bool createBBoxFromCoordinateString( QgsRectangle &bb, const std::string &coordString ) const;
 
     /**
      * Creates a set of points from a coordinate string.
      * \param points list that will contain the created points
-     * \param coordString the text containing the coordinates
+     * \param coordString the UTF-8 text containing the coordinates
      * \returns 0 in case of success
      */
-    int pointsFromCoordinateString( QList<QgsPointXY> &points, const QString &coordString ) const;
+    int pointsFromCoordinateString( QVector<QgsPointXY> &points, const std::string &coordString ) const;
 
     /**
      * Creates a set of points from a gml:posList or gml:pos coordinate string.
      * \param points list that will contain the created points
-     * \param coordString the text containing the coordinates
+     * \param coordString the UTF-8 text containing the coordinates
      * \param dimension number of dimensions
      * \returns 0 in case of success
       */
-    int pointsFromPosListString( QList<QgsPointXY> &points, const QString &coordString, int dimension ) const;
+    int pointsFromPosListString( QVector<QgsPointXY> &points, const std::string &coordString, int dimension ) const;
 
-    int pointsFromString( QList<QgsPointXY> &points, const QString &coordString ) const;
+    int pointsFromString( QVector<QgsPointXY> &points, const std::string &coordString ) const;
     int getPointWKB( QgsWkbPtr &wkbPtr, const QgsPointXY & ) const;
-    int getLineWKB( QgsWkbPtr &wkbPtr, const QList<QgsPointXY> &lineCoordinates ) const;
-    int getRingWKB( QgsWkbPtr &wkbPtr, const QList<QgsPointXY> &ringCoordinates ) const;
+    int getLineWKB( QgsWkbPtr &wkbPtr, const QVector<QgsPointXY> &lineCoordinates ) const;
+    int getRingWKB( QgsWkbPtr &wkbPtr, const QVector<QgsPointXY> &ringCoordinates ) const;
+
+    /**
+     * Creates a parser with the same settings, and the same state regarding
+     * CRS and axis order, to parse a chunk of the document in processDataInParallel().
+     */
+    std::unique_ptr< QgsGmlStreamingParser > createChunkParser() const;
 
     /**
      * Creates a multiline from the information in mCurrentWKBFragments and
@@ -291,6 +309,8 @@ class CORE_EXPORT QgsGmlStreamingParser
     QStack<ParseMode> mParseModeStack;
     //! This contains the character data if an important element has been encountered
     QString mStringCash;
+    //! This contains the raw UTF-8 character data of coordinates elements
+    std::string mCoordinateCash;
     QgsFeature *mCurrentFeature = nullptr;
     QVector<QVariant> mCurrentAttributes; //attributes of current feature
     QString mCurrentFeatureId;
@@ -310,9 +330,9 @@ class CORE_EXPORT QgsGmlStreamingParser
     QString mAttributeName;
     char mEndian;
     //! Coordinate separator for coordinate strings. Usually ","
-    QString mCoordinateSeparator;
+    std::string mCoordinateSeparator;
     //! Tuple separator for coordinate strings. Usually " "
-    QString mTupleSeparator;
+    std::string mTupleSeparator;
     //! Keep track about number of dimensions in pos or posList
     QStack<int> mDimensionStack;
     //! Number of dimensions in pos or posList for the current geometry
@@ -116,6 +116,12 @@ QImage QgsImageCache::pathAsImage( const QString &f, const QSize size, const boo
 
   QgsImageCacheEntry *currentEntry = findExistingEntry( new QgsImageCacheEntry( file, size, keepAspectRatio, opacity ) );
 
+  // if another thread is already rendering the same image, wait for it and look up the entry again
+  while ( currentEntry->image.isNull() && !startFillingEntry( currentEntry, locker ) )
+  {
+    currentEntry = findExistingEntry( new QgsImageCacheEntry( file, size, keepAspectRatio, opacity ) );
+  }
+
   QImage result;
 
   //if current entry image is null: create the image
@@ -123,29 +129,37 @@ QImage QgsImageCache::pathAsImage( const QString &f, const QSize size, const boo
   //update stats for memory usage
   if ( currentEntry->image.isNull() )
   {
-    long cachedDataSize = 0;
+    // decode and scale the image without holding the lock, so that other threads can use the cache meanwhile
+    locker.unlock();
     bool isBroken = false;
     result = renderImage( file, size, keepAspectRatio, opacity, isBroken, blocking );
+    locker.relock();
+
+    long cachedDataSize = 0;
     cachedDataSize += result.width() * result.height() * 32;
     if ( cachedDataSize > mMaxCacheSize / 2 )
     {
       fitsInCache = false;
-      currentEntry->image = QImage();
-    }
-    else
-    {
-      mTotalSize += ( result.width() * result.height() * 32 );
-      currentEntry->image = result;
     }
 
     if ( isMissing )
       *isMissing = isBroken;
-    currentEntry->isMissingImage = isBroken;
 
-    trimToMaximumSize();
+    if ( finishFillingEntry( currentEntry ) )
+    {
+      if ( fitsInCache )
+      {
+        mTotalSize += cachedDataSize;
+        currentEntry->image = result;
+      }
+      currentEntry->isMissingImage = isBroken;
+
+      trimToMaximumSize();
+    }
   }
   else
   {
+    mHitCount++;
     result = currentEntry->image;
     if ( isMissing )
       *isMissing = currentEntry->isMissingImage;
@@ -29,7 +29,9 @@
 #include "qgspointlocatorinittask.h"
 #include <spatialindex/SpatialIndex.h>
 
+#include <QAtomicInt>
 #include <QLinkedListIterator>
+#include <QThreadPool>
 #include <QtConcurrent>
 
 using namespace SpatialIndex;
@@ -85,6 +87,91 @@ class QgsPointLocator_Stream : public IDataStream
 };
 
 
+// R-tree parameters
+static const double RTREE_FILL_FACTOR = 0.7;
+static const unsigned long RTREE_INDEX_CAPACITY = 10;
+static const unsigned long RTREE_LEAF_CAPACITY = 10;
+static const unsigned long RTREE_DIMENSION = 2;
+static const RTree::RTreeVariant RTREE_VARIANT = RTree::RV_RSTAR;
+
+// Layers with at least this many features are read in parallel parts when building the index
+static const long PARALLEL_INDEX_MIN_FEATURES = 50000;
+
+// Approximate number of features read by each part
+static const long PARALLEL_INDEX_FEATURES_PER_PARTITION = 25000;
+
+
+/**
+ * \ingroup core
+ * Helper class holding what is needed to read one part of the layer when the index is built in parallel.
+ * Each part has its own feature source, renderer and render context so that parts can be read
+ * from different threads.
+ * \note not available in Python bindings
+*/
+class QgsPointLocator_IndexPartition
+{
+  public:
+    std::unique_ptr<QgsVectorLayerFeatureSource> source;
+    std::unique_ptr<QgsFeatureRenderer> renderer;
+    std::unique_ptr<QgsRenderContext> context;
+
+    //! Part of the layer extent read, in layer coordinates
+    QgsRectangle rect;
+
+    /**
+     * TRUE for the part reading the ids of all features, without their geometry, to find
+     * the features outside the extent split among the other parts
+     */
+    bool catchAll = false;
+
+    //! Features to read instead of the ones in rect, if not empty
+    QgsFeatureIds missingIds;
+
+    //! Ids of all the features read, including the ones which are not indexed
+    QgsFeatureIds readIds;
+
+    //! Features read, with their geometry in destination coordinates
+    QVector< QPair< QgsFeatureId, QgsGeometry > > features;
+};
+
+
+/**
+ * Returns the geometry of \a f to index, in destination coordinates. A null geometry is returned
+ * if the feature has no geometry, is not rendered or could not be transformed.
+ */
+static QgsGeometry indexedGeometry( const QgsFeature &f, QgsFeatureRenderer *renderer, QgsRenderContext *ctx, bool filter, const QgsCoordinateTransform &transform )
+{
+  if ( !f.hasGeometry() )
+    return QgsGeometry();
+
+  if ( filter && ctx && renderer )
+  {
+    ctx->expressionContext().setFeature( f );
+    if ( !renderer->willRenderFeature( f, *ctx ) )
+    {
+      return QgsGeometry();
+    }
+  }
+
+  QgsGeometry geometry = f.geometry();
+  if ( transform.isValid() )
+  {
+    try
+    {
+      geometry.transform( transform );
+    }
+    catch ( const QgsException &e )
+    {
+      Q_UNUSED( e )
+      // See https://github.com/qgis/QGIS/issues/20749
+      QgsDebugMsg( QStringLiteral( "could not transform geometry to map, skipping the snap for it (%1)" ).arg( e.what() ) );
+      return QgsGeometry();
+    }
+  }
+  return geometry;
+}
+
+
 ////////////////////////////////////////////////////////////////////////////
 
 
@@ -812,6 +899,7 @@ void QgsPointLocator::onInitTaskFinished()
   mIsIndexing = false;
   mRenderer.reset();
   mSource.reset();
+  mIndexPartitions.clear();
 
   // treat added and deleted feature while indexing
   for ( QgsFeatureId fid : mAddedFeatures )
@@ -845,6 +933,8 @@ bool QgsPointLocator::init( int maxFeaturesToIndex, bool relaxed )
     mContext->expressionContext() << QgsExpressionContextUtils::layerScope( mLayer );
   }
 
+  prepareIndexPartitions();
+
   mIsIndexing = true;
 
   if ( relaxed )
@@ -859,6 +949,7 @@ bool QgsPointLocator::init( int maxFeaturesToIndex, bool relaxed )
   {
     const bool ok = rebuildIndex( maxFeaturesToIndex );
     mIsIndexing = false;
+    mIndexPartitions.clear();
     emit initFinished( ok );
     return ok;
   }
@@ -872,6 +963,40 @@ void QgsPointLocator::waitForIndexingFinished()
     onInitTaskFinished();
 }
 
+void QgsPointLocator::prepareIndexPartitions()
+{
+  mIndexPartitions.clear();
+  mLayerExtent = QgsRectangle();
+
+  // reading parts of the layer only pays off if the provider can use an index to fetch them
+  const long featureCount = mLayer->featureCount();
+  if ( featureCount < PARALLEL_INDEX_MIN_FEATURES
+       || mLayer->dataProvider()->hasSpatialIndex() != QgsFeatureSource::SpatialIndexPresent )
+    return;
+
+  const int partitionCount = std::min( std::max( 1, QThreadPool::globalInstance()->maxThreadCount() ),
+                                       static_cast< int >( std::ceil( static_cast< double >( featureCount ) / PARALLEL_INDEX_FEATURES_PER_PARTITION ) ) );
+  if ( partitionCount < 2 )
+    return;
+
+  // sources and renderers are created here as they can only be copied from the layer in the main thread.
+  // The layer extent may be outdated or estimated, one more part catches the features outside of it
+  mLayerExtent = mLayer->extent();
+  for ( int i = 0; i <= partitionCount; ++i )
+  {
+    std::unique_ptr<QgsPointLocator_IndexPartition> partition = qgis::make_unique<QgsPointLocator_IndexPartition>();
+    partition->source = qgis::make_unique<QgsVectorLayerFeatureSource>( mLayer );
+    if ( mContext )
+    {
+      partition->context = qgis::make_unique<QgsRenderContext>( *mContext );
+      if ( mRenderer )
+        partition->renderer.reset( mRenderer->clone() );
+    }
+    partition->catchAll = i == partitionCount;
+    mIndexPartitions.push_back( std::move( partition ) );
+  }
+}
+
 bool QgsPointLocator::hasIndex() const
 {
   return mIsIndexing || mRTree || mIsEmptyLayer;
@@ -912,6 +1037,7 @@ bool QgsPointLocator::rebuildIndex( int maxFeaturesToIndex )
   QgsFeatureRequest request;
   request.setNoAttributes();
 
+  QgsRectangle partitionsExtent = mLayerExtent;
   if ( mExtent )
   {
     QgsRectangle rect = *mExtent;
@@ -929,82 +1055,169 @@ bool QgsPointLocator::rebuildIndex( int maxFeaturesToIndex )
       }
     }
     request.setFilterRect( rect );
+    partitionsExtent = partitionsExtent.intersect( rect );
   }
 
-  bool filter = false;
-  QgsRenderContext *ctx = nullptr;
-  if ( mContext )
+  int indexedCount = 0;
+  mIndexPartitionsRead = 0;
+
+  if ( !mIndexPartitions.empty() && !partitionsExtent.isEmpty() )
   {
-    ctx = mContext.get();
-    if ( mRenderer )
+    // split the extent in a grid, one cell for each part but the catch all one
+    const int partitionCount = static_cast< int >( mIndexPartitions.size() ) - 1;
+    const int columns = static_cast< int >( std::ceil( std::sqrt( static_cast< double >( partitionCount ) ) ) );
+    const int rows = static_cast< int >( std::ceil( static_cast< double >( partitionCount ) / columns ) );
+    const double cellWidth = partitionsExtent.width() / columns;
+    const double cellHeight = partitionsExtent.height() / rows;
+    for ( int i = 0; i < partitionCount; ++i )
     {
-      // setup scale for scale dependent visibility (rule based)
-      mRenderer->startRender( *ctx, mSource->fields() );
-      filter = mRenderer->capabilities() & QgsFeatureRenderer::Filter;
-      request.setSubsetOfAttributes( mRenderer->usedAttributes( *ctx ), mSource->fields() );
+      const int column = i % columns;
+      const int row = i / columns;
+      // the last cell spans the rest of the last row
+      const double xMax = i == partitionCount - 1 ? partitionsExtent.xMaximum() : partitionsExtent.xMinimum() + ( column + 1 ) * cellWidth;
+      const double yMax = row == rows - 1 ? partitionsExtent.yMaximum() : partitionsExtent.yMinimum() + ( row + 1 ) * cellHeight;
+      mIndexPartitions[i]->rect = QgsRectangle( partitionsExtent.xMinimum() + column * cellWidth, partitionsExtent.yMinimum() + row * cellHeight, xMax, yMax );
     }
-  }
 
-  QgsFeatureIterator fi = mSource->getFeatures( request );
-  int indexedCount = 0;
+    QAtomicInt tooManyFeatures( 0 );
+    const QgsCoordinateTransform transform = mTransform;
+    auto readPartition = [&request, &transform, &tooManyFeatures, maxFeaturesToIndex]( std::unique_ptr<QgsPointLocator_IndexPartition> &partition )
+    {
+      QgsFeatureRequest partitionRequest( request );
+      QgsFeature f;
+      if ( partition->catchAll )
+      {
+        partitionRequest.setFlags( QgsFeatureRequest::NoGeometry );
+        QgsFeatureIterator fi = partition->source->getFeatures( partitionRequest );
+        while ( !tooManyFeatures.loadAcquire() && fi.nextFeature( f ) )
+          partition->readIds << f.id();
+        return;
+      }
 
-  while ( fi.nextFeature( f ) )
-  {
-    if ( !f.hasGeometry() )
-      continue;
+      if ( partition->missingIds.isEmpty() )
+        partitionRequest.setFilterRect( partition->rect );
+      else
+        partitionRequest.setFilterFids( partition->missingIds );
 
-    if ( filter && ctx && mRenderer )
-    {
-      ctx->expressionContext().setFeature( f );
-      if ( !mRenderer->willRenderFeature( f, *ctx ) )
+      bool filter = false;
+      QgsRenderContext *ctx = partition->context.get();
+      QgsFeatureRenderer *renderer = partition->renderer.get();
+      if ( ctx && renderer )
       {
-        continue;
+        renderer->startRender( *ctx, partition->source->fields() );
+        filter = renderer->capabilities() & QgsFeatureRenderer::Filter;
+        partitionRequest.setSubsetOfAttributes( renderer->usedAttributes( *ctx ), partition->source->fields() );
       }
-    }
 
-    if ( mTransform.isValid() )
-    {
-      try
+      QgsFeatureIterator fi = partition->source->getFeatures( partitionRequest );
+      while ( !tooManyFeatures.loadAcquire() && fi.nextFeature( f ) )
       {
-        QgsGeometry transformedGeometry = f.geometry();
-        transformedGeometry.transform( mTransform );
-        f.setGeometry( transformedGeometry );
+        partition->readIds << f.id();
+
+        const QgsGeometry geometry = indexedGeometry( f, renderer, ctx, filter, transform );
+        if ( geometry.isNull() || !geometry.boundingBox().isFinite() )
+          continue;
+
+        partition->features << qMakePair( f.id(), geometry );
+
+        // feature ids are unique within a part, so the whole layer has too many features too
+        if ( maxFeaturesToIndex != -1 && partition->features.count() > maxFeaturesToIndex )
+          tooManyFeatures.storeRelease( 1 );
       }
-      catch ( const QgsException &e )
+
+      if ( ctx && renderer )
       {
-        Q_UNUSED( e )
-        // See https://github.com/qgis/QGIS/issues/20749
-        QgsDebugMsg( QStringLiteral( "could not transform geometry to map, skipping the snap for it (%1)" ).arg( e.what() ) );
-        continue;
+        renderer->stopRender( *ctx );
       }
+    };
+    QtConcurrent::blockingMap( mIndexPartitions, readPartition );
+    mIndexPartitionsRead = partitionCount;
+
+    // the features not read by any part lie outside of the layer extent, or have no geometry
+    std::unique_ptr<QgsPointLocator_IndexPartition> &catchAll = mIndexPartitions.back();
+    QgsFeatureIds missingIds = catchAll->readIds;
+    for ( int i = 0; i < partitionCount; ++i )
+      missingIds.subtract( mIndexPartitions[i]->readIds );
+    if ( !missingIds.isEmpty() && !tooManyFeatures.loadAcquire() )
+    {
+      catchAll->catchAll = false;
+      catchAll->missingIds = missingIds;
+      readPartition( catchAll );
     }
 
-    const QgsRectangle bbox = f.geometry().boundingBox();
-    if ( bbox.isFinite() )
+    for ( const std::unique_ptr<QgsPointLocator_IndexPartition> &partition : mIndexPartitions )
     {
-      SpatialIndex::Region r( rect2region( bbox ) );
-      dataList << new RTree::Data( 0, nullptr, r, f.id() );
+      for ( const QPair< QgsFeatureId, QgsGeometry > &feature : qgis::as_const( partition->features ) )
+      {
+        // features crossing the border of two parts are read by both
+        if ( tooManyFeatures.loadAcquire() || mGeoms.contains( feature.first ) )
+          continue;
 
-      if ( mGeoms.contains( f.id() ) )
-        delete mGeoms.take( f.id() );
-      mGeoms[f.id()] = new QgsGeometry( f.geometry() );
-      ++indexedCount;
+        SpatialIndex::Region r( rect2region( feature.second.boundingBox() ) );
+        dataList << new RTree::Data( 0, nullptr, r, feature.first );
+        mGeoms[feature.first] = new QgsGeometry( feature.second );
+        ++indexedCount;
+      }
+      partition->features.clear();
     }
 
-    if ( maxFeaturesToIndex != -1 && indexedCount > maxFeaturesToIndex )
+    if ( tooManyFeatures.loadAcquire() || ( maxFeaturesToIndex != -1 && indexedCount > maxFeaturesToIndex ) )
     {
       qDeleteAll( dataList );
       destroyIndex();
       return false;
     }
   }
+  else
+  {
+    bool filter = false;
+    QgsRenderContext *ctx = nullptr;
+    if ( mContext )
+    {
+      ctx = mContext.get();
+      if ( mRenderer )
+      {
+        // setup scale for scale dependent visibility (rule based)
+        mRenderer->startRender( *ctx, mSource->fields() );
+        filter = mRenderer->capabilities() & QgsFeatureRenderer::Filter;
+        request.setSubsetOfAttributes( mRenderer->usedAttributes( *ctx ), mSource->fields() );
+      }
+    }
+
+    QgsFeatureIterator fi = mSource->getFeatures( request );
+
+    while ( fi.nextFeature( f ) )
+    {
+      const QgsGeometry geometry = indexedGeometry( f, mRenderer.get(), ctx, filter, mTransform );
+      if ( geometry.isNull() )
+        continue;
+
+      const QgsRectangle bbox = geometry.boundingBox();
+      if ( bbox.isFinite() )
+      {
+        SpatialIndex::Region r( rect2region( bbox ) );
+        dataList << new RTree::Data( 0, nullptr, r, f.id() );
+
+        if ( mGeoms.contains( f.id() ) )
+          delete mGeoms.take( f.id() );
+        mGeoms[f.id()] = new QgsGeometry( geometry );
+        ++indexedCount;
+      }
+
+      if ( maxFeaturesToIndex != -1 && indexedCount > maxFeaturesToIndex )
+      {
+        qDeleteAll( dataList );
+        destroyIndex();
+        return false;
+      }
+    }
+
+    if ( ctx && mRenderer )
+    {
+      mRenderer->stopRender( *ctx );
+    }
+  }
 
-  // R-Tree parameters
-  double fillFactor = 0.7;
-  unsigned long indexCapacity = 10;
-  unsigned long leafCapacity = 10;
-  unsigned long dimension = 2;
-  RTree::RTreeVariant variant = RTree::RV_RSTAR;
   SpatialIndex::id_type indexId;
 
   if ( dataList.isEmpty() )
@@ -1014,13 +1227,8 @@ bool QgsPointLocator::rebuildIndex( int maxFeaturesToIndex )
   }
 
   QgsPointLocator_Stream stream( dataList );
-  mRTree.reset( RTree::createAndBulkLoadNewRTree( RTree::BLM_STR, stream, *mStorage, fillFactor, indexCapacity,
-                leafCapacity, dimension, variant, indexId ) );
-
-  if ( ctx && mRenderer )
-  {
-    mRenderer->stopRender( *ctx );
-  }
+  mRTree.reset( RTree::createAndBulkLoadNewRTree( RTree::BLM_STR, stream, *mStorage, RTREE_FILL_FACTOR, RTREE_INDEX_CAPACITY,
+                RTREE_LEAF_CAPACITY, RTREE_DIMENSION, RTREE_VARIANT, indexId ) );
 
   QgsDebugMsgLevel( QStringLiteral( "RebuildIndex end : %1 ms (%2)" ).arg( t.elapsed() ).arg( mSource->id() ), 2 );
 
@@ -1050,13 +1258,14 @@ void QgsPointLocator::onFeatureAdded( QgsFeatureId fid )
 
   if ( !mRTree )
   {
-    if ( mIsEmptyLayer )
-    {
-      // layer is not empty any more, let's build the index
-      mIsEmptyLayer = false;
-      init();
-    }
-    return; // nothing to do if we are not initialized yet
+    if ( !mIsEmptyLayer )
+      return; // nothing to do if we are not initialized yet
+
+    // layer is not empty any more, start an empty index and add the feature to it
+    mIsEmptyLayer = false;
+    SpatialIndex::id_type indexId;
+    mRTree.reset( RTree::createNewRTree( *mStorage, RTREE_FILL_FACTOR, RTREE_INDEX_CAPACITY,
+                                         RTREE_LEAF_CAPACITY, RTREE_DIMENSION, RTREE_VARIANT, indexId ) );
   }
 
   QgsFeature f;
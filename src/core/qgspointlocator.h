@@ -21,6 +21,7 @@ class QgsFeatureRenderer;
 class QgsRenderContext;
 class QgsRectangle;
 class QgsVectorLayerFeatureSource;
+class QgsPointLocator_IndexPartition;
 
 #include "qgis_core.h"
 #include "qgspointxy.h"
@@ -33,6 +34,7 @@ class QgsVectorLayerFeatureSource;
 #include "qgslinestring.h"
 #include "qgspointlocatorinittask.h"
 #include <memory>
+#include <vector>
 
 /**
  * \ingroup core
@@ -438,6 +440,12 @@ class CORE_EXPORT QgsPointLocator : public QObject
      */
     bool prepare( bool relaxed );
 
+    /**
+     * Prepares the sources used to read the layer in parallel parts when building the index.
+     * Nothing is prepared if the layer is too small or has no spatial index to read parts efficiently.
+     */
+    void prepareIndexPartitions();
+
     //! Storage manager
     std::unique_ptr< SpatialIndex::IStorageManager > mStorage;
 
@@ -456,6 +464,10 @@ class CORE_EXPORT QgsPointLocator : public QObject
     std::unique_ptr<QgsRenderContext> mContext;
     std::unique_ptr<QgsFeatureRenderer> mRenderer;
     std::unique_ptr<QgsVectorLayerFeatureSource> mSource;
+    std::vector< std::unique_ptr<QgsPointLocator_IndexPartition> > mIndexPartitions;
+    QgsRectangle mLayerExtent;
+    //! Number of parts the layer was read in by the last rebuildIndex(), 0 if it was read at once
+    int mIndexPartitionsRead = 0;
     int mMaxFeaturesToIndex = -1;
     bool mIsIndexing = false;
     bool mIsDestroying = false;
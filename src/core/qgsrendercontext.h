@@ -85,6 +85,7 @@ class CORE_EXPORT QgsRenderContext : public QgsTemporalRangeObject
       ApplyScalingWorkaroundForTextRendering = 0x2000, //!< Whether a scaling workaround designed to stablise the rendering of small font sizes (or for painters scaled out by a large amount) when rendering text. Generally this is recommended, but it may incur some performance cost.
       Render3DMap              = 0x4000, //!< Render is for a 3D map
       ApplyClipAfterReprojection = 0x8000, //!< Feature geometry clipping to mapExtent() must be performed after the geometries are transformed using coordinateTransform(). Usually feature geometry clipping occurs using the extent() in the layer's CRS prior to geometry transformation, but in some cases when extent() could not be accurately calculated it is necessary to clip geometries to mapExtent() AFTER transforming them using coordinateTransform().
+      RasterizeMarkerStamps    = 0x10000, //!< Draw markers by copying pre-rasterized images of each distinct marker, which is much faster for layers with many points. Marker positions are rounded to a quarter of a pixel and rotations to whole degrees. Only applies to raster output (since QGIS 3.18)
     };
     Q_DECLARE_FLAGS( Flags, Flag )
 
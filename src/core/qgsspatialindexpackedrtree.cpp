@@ -0,0 +1,625 @@
+/***************************************************************************
+                             qgsspatialindexpackedrtree.cpp
+                             -----------------
+    begin                : November 2020
+    copyright            : (C) 2020 by the QGIS project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsspatialindexpackedrtree.h"
+#include "qgsspatialindexpackedrtree_p.h"
+#include "qgsfeatureiterator.h"
+#include "qgsfeedback.h"
+#include "qgsfeaturesource.h"
+#include "qgsgeometry.h"
+
+#include <QDataStream>
+#include <QFile>
+#include <QThread>
+#include <QtConcurrentMap>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <queue>
+
+///@cond PRIVATE
+
+//! Items below this count are processed on the calling thread only
+static const qgssize MIN_PARALLEL_COUNT = 16384;
+
+static const char FILE_MAGIC[] = "QGSPRTREE";
+static const quint32 FILE_VERSION = 1;
+
+//! Position of the 16 bit \a x, \a y coordinates along a Hilbert curve, see https://github.com/rawrunprotected/hilbert_curves
+static quint32 hilbert( quint32 x, quint32 y )
+{
+  quint32 a = x ^ y;
+  quint32 b = 0xFFFF ^ a;
+  quint32 c = 0xFFFF ^ ( x | y );
+  quint32 d = x & ( y ^ 0xFFFF );
+
+  quint32 A = a | ( b >> 1 );
+  quint32 B = ( a >> 1 ) ^ a;
+  quint32 C = ( ( c >> 1 ) ^ ( b & ( d >> 1 ) ) ) ^ c;
+  quint32 D = ( ( a & ( c >> 1 ) ) ^ ( d >> 1 ) ) ^ d;
+
+  a = A;
+  b = B;
+  c = C;
+  d = D;
+  A = ( ( a & ( a >> 2 ) ) ^ ( b & ( b >> 2 ) ) );
+  B = ( ( a & ( b >> 2 ) ) ^ ( b & ( ( a ^ b ) >> 2 ) ) );
+  C ^= ( ( a & ( c >> 2 ) ) ^ ( b & ( d >> 2 ) ) );
+  D ^= ( ( b & ( c >> 2 ) ) ^ ( ( a ^ b ) & ( d >> 2 ) ) );
+
+  a = A;
+  b = B;
+  c = C;
+  d = D;
+  A = ( ( a & ( a >> 4 ) ) ^ ( b & ( b >> 4 ) ) );
+  B = ( ( a & ( b >> 4 ) ) ^ ( b & ( ( a ^ b ) >> 4 ) ) );
+  C ^= ( ( a & ( c >> 4 ) ) ^ ( b & ( d >> 4 ) ) );
+  D ^= ( ( b & ( c >> 4 ) ) ^ ( ( a ^ b ) & ( d >> 4 ) ) );
+
+  a = A;
+  b = B;
+  c = C;
+  d = D;
+  C ^= ( ( a & ( c >> 8 ) ) ^ ( b & ( d >> 8 ) ) );
+  D ^= ( ( b & ( c >> 8 ) ) ^ ( ( a ^ b ) & ( d >> 8 ) ) );
+
+  a = C ^ ( C >> 1 );
+  b = D ^ ( D >> 1 );
+
+  quint32 i0 = x ^ y;
+  quint32 i1 = b | ( 0xFFFF ^ ( i0 | a ) );
+
+  i0 = ( i0 | ( i0 << 8 ) ) & 0x00FF00FF;
+  i0 = ( i0 | ( i0 << 4 ) ) & 0x0F0F0F0F;
+  i0 = ( i0 | ( i0 << 2 ) ) & 0x33333333;
+  i0 = ( i0 | ( i0 << 1 ) ) & 0x55555555;
+
+  i1 = ( i1 | ( i1 << 8 ) ) & 0x00FF00FF;
+  i1 = ( i1 | ( i1 << 4 ) ) & 0x0F0F0F0F;
+  i1 = ( i1 | ( i1 << 2 ) ) & 0x33333333;
+  i1 = ( i1 | ( i1 << 1 ) ) & 0x55555555;
+
+  return ( i1 << 1 ) | i0;
+}
+
+namespace
+{
+  struct Range
+  {
+    qgssize begin;
+    qgssize end;
+  };
+
+  struct Merge
+  {
+    qgssize begin;
+    qgssize middle;
+    qgssize end;
+  };
+}
+
+//! Splits [0, \a count) into one range per available thread, or a single range for small counts
+static QVector< Range > splitRange( qgssize count )
+{
+  const qgssize threads = static_cast< qgssize >( std::max( 1, QThread::idealThreadCount() ) );
+  const qgssize chunks = count < MIN_PARALLEL_COUNT ? 1 : threads;
+  const qgssize chunkSize = ( count + chunks - 1 ) / chunks;
+
+  QVector< Range > ranges;
+  for ( qgssize begin = 0; begin < count; begin += chunkSize )
+    ranges.append( { begin, std::min( begin + chunkSize, count ) } );
+  return ranges;
+}
+
+//! Calls \a function for ranges covering [0, \a count), in parallel for large counts
+static void parallelFor( qgssize count, const std::function< void( qgssize, qgssize ) > &function )
+{
+  QVector< Range > ranges = splitRange( count );
+  if ( ranges.size() <= 1 )
+  {
+    if ( count > 0 )
+      function( 0, count );
+    return;
+  }
+
+  QtConcurrent::blockingMap( ranges, [&function]( Range & range ) { function( range.begin, range.end ); } );
+}
+
+//! Sorts the \a items along the Hilbert curve: the chunks are sorted in parallel, then merged pairwise
+static void parallelSort( std::vector< QgsSpatialIndexPackedRTreePrivate::Item > &items )
+{
+  typedef QgsSpatialIndexPackedRTreePrivate::Item Item;
+  const auto lessThan = []( const Item & a, const Item & b )
+  {
+    return a.hilbert < b.hilbert || ( a.hilbert == b.hilbert && a.id < b.id );
+  };
+
+  QVector< Range > chunks = splitRange( items.size() );
+  QtConcurrent::blockingMap( chunks, [&items, &lessThan]( Range & range )
+  {
+    std::sort( items.begin() + range.begin, items.begin() + range.end, lessThan );
+  } );
+
+  while ( chunks.size() > 1 )
+  {
+    QVector< Merge > merges;
+    QVector< Range > merged;
+    for ( int i = 0; i + 1 < chunks.size(); i += 2 )
+    {
+      merges.append( { chunks.at( i ).begin, chunks.at( i ).end, chunks.at( i + 1 ).end } );
+      merged.append( { chunks.at( i ).begin, chunks.at( i + 1 ).end } );
+    }
+    if ( chunks.size() % 2 )
+      merged.append( chunks.last() );
+
+    QtConcurrent::blockingMap( merges, [&items, &lessThan]( Merge & merge )
+    {
+      std::inplace_merge( items.begin() + merge.begin, items.begin() + merge.middle, items.begin() + merge.end, lessThan );
+    } );
+    chunks = merged;
+  }
+}
+
+void QgsSpatialIndexPackedRTreePrivate::build( QgsFeatureIterator &fi, QgsFeedback *feedback, int nodeSize, long expectedCount )
+{
+  std::vector< Item > items;
+  if ( expectedCount > 0 )
+    items.reserve( static_cast< std::size_t >( expectedCount ) );
+
+  QgsFeature f;
+  while ( fi.nextFeature( f ) )
+  {
+    if ( feedback && feedback->isCanceled() )
+      return;
+
+    if ( !f.hasGeometry() )
+      continue;
+
+    const QgsRectangle r = f.geometry().boundingBox();
+    if ( r.isNull() || !std::isfinite( r.xMinimum() ) || !std::isfinite( r.yMinimum() )
+         || !std::isfinite( r.xMaximum() ) || !std::isfinite( r.yMaximum() ) )
+      continue;
+
+    items.push_back( { 0, f.id(), r.xMinimum(), r.yMinimum(), r.xMaximum(), r.yMaximum() } );
+  }
+
+  this->nodeSize = std::min( std::max( nodeSize, 2 ), 65535 );
+  load( items );
+}
+
+//! Returns the end of each level of the tree for \a numItems items, the root node is always the last box
+static QVector< qgssize > levelBoundsForItems( qgssize numItems, int nodeSize )
+{
+  QVector< qgssize > levelBounds;
+  if ( numItems == 0 )
+    return levelBounds;
+
+  qgssize count = numItems;
+  qgssize numBoxes = count;
+  levelBounds.append( numBoxes );
+  do
+  {
+    count = ( count + nodeSize - 1 ) / nodeSize;
+    numBoxes += count;
+    levelBounds.append( numBoxes );
+  }
+  while ( count != 1 );
+  return levelBounds;
+}
+
+//! Maps a box center coordinate to the 16 bit Hilbert grid, clamping values out of the grid (or NaN) to its edges
+static quint32 hilbertCoordinate( double center, double min, double size )
+{
+  const double hilbertMax = 0xFFFF;
+  if ( !( size > 0 ) )
+    return 0;
+
+  const double value = hilbertMax * ( center - min ) / size;
+  if ( !( value > 0 ) )
+    return 0;
+  return value >= hilbertMax ? 0xFFFF : static_cast< quint32 >( value );
+}
+
+void QgsSpatialIndexPackedRTreePrivate::load( std::vector< Item > &items )
+{
+  numItems = items.size();
+  levelBounds = levelBoundsForItems( numItems, nodeSize );
+  boxes.clear();
+  indices.clear();
+  if ( numItems == 0 )
+    return;
+
+  const qgssize numBoxes = levelBounds.last();
+
+  double xMin = std::numeric_limits< double >::max();
+  double yMin = std::numeric_limits< double >::max();
+  double xMax = std::numeric_limits< double >::lowest();
+  double yMax = std::numeric_limits< double >::lowest();
+  for ( const Item &item : items )
+  {
+    xMin = std::min( xMin, item.xMin );
+    yMin = std::min( yMin, item.yMin );
+    xMax = std::max( xMax, item.xMax );
+    yMax = std::max( yMax, item.yMax );
+  }
+
+  // map the box centers to the Hilbert curve covering the extent
+  const double width = xMax - xMin;
+  const double height = yMax - yMin;
+  parallelFor( numItems, [&items, xMin, yMin, width, height]( qgssize begin, qgssize end )
+  {
+    for ( qgssize i = begin; i < end; ++i )
+    {
+      Item &item = items[i];
+      const quint32 x = hilbertCoordinate( ( item.xMin + item.xMax ) / 2, xMin, width );
+      const quint32 y = hilbertCoordinate( ( item.yMin + item.yMax ) / 2, yMin, height );
+      item.hilbert = hilbert( x, y );
+    }
+  } );
+
+  parallelSort( items );
+
+  boxes.resize( static_cast< int >( numBoxes * 4 ) );
+  indices.resize( static_cast< int >( numBoxes ) );
+  double *boxData = boxes.data();
+  qint64 *indexData = indices.data();
+
+  parallelFor( numItems, [&items, boxData, indexData]( qgssize begin, qgssize end )
+  {
+    for ( qgssize i = begin; i < end; ++i )
+    {
+      const Item &item = items[i];
+      boxData[4 * i] = item.xMin;
+      boxData[4 * i + 1] = item.yMin;
+      boxData[4 * i + 2] = item.xMax;
+      boxData[4 * i + 3] = item.yMax;
+      indexData[i] = item.id;
+    }
+  } );
+
+  // build the node levels bottom up, each node covering nodeSize boxes of the level below
+  const qgssize size = static_cast< qgssize >( nodeSize );
+  for ( int level = 1; level < levelBounds.size(); ++level )
+  {
+    const qgssize childStart = level == 1 ? 0 : levelBounds.at( level - 2 );
+    const qgssize childEnd = levelBounds.at( level - 1 );
+    const qgssize nodeStart = childEnd;
+    const qgssize nodeCount = levelBounds.at( level ) - nodeStart;
+
+    parallelFor( nodeCount, [boxData, indexData, childStart, childEnd, nodeStart, size]( qgssize begin, qgssize end )
+    {
+      for ( qgssize node = begin; node < end; ++node )
+      {
+        const qgssize first = childStart + node * size;
+        const qgssize last = std::min( first + size, childEnd );
+
+        double nodeXMin = std::numeric_limits< double >::max();
+        double nodeYMin = std::numeric_limits< double >::max();
+        double nodeXMax = std::numeric_limits< double >::lowest();
+        double nodeYMax = std::numeric_limits< double >::lowest();
+        for ( qgssize child = first; child < last; ++child )
+        {
+          nodeXMin = std::min( nodeXMin, boxData[4 * child] );
+          nodeYMin = std::min( nodeYMin, boxData[4 * child + 1] );
+          nodeXMax = std::max( nodeXMax, boxData[4 * child + 2] );
+          nodeYMax = std::max( nodeYMax, boxData[4 * child + 3] );
+        }
+
+        const qgssize position = nodeStart + node;
+        boxData[4 * position] = nodeXMin;
+        boxData[4 * position + 1] = nodeYMin;
+        boxData[4 * position + 2] = nodeXMax;
+        boxData[4 * position + 3] = nodeYMax;
+        indexData[position] = static_cast< qint64 >( first );
+      }
+    } );
+  }
+}
+
+qgssize QgsSpatialIndexPackedRTreePrivate::levelEnd( qgssize position ) const
+{
+  const auto it = std::upper_bound( levelBounds.constBegin(), levelBounds.constEnd(), position );
+  return it == levelBounds.constEnd() ? levelBounds.last() : *it;
+}
+
+void QgsSpatialIndexPackedRTreePrivate::intersects( const QgsRectangle &rectangle, const std::function<void( QgsFeatureId )> &visitor ) const
+{
+  if ( numItems == 0 || rectangle.isNull() )
+    return;
+
+  const double xMin = rectangle.xMinimum();
+  const double yMin = rectangle.yMinimum();
+  const double xMax = rectangle.xMaximum();
+  const double yMax = rectangle.yMaximum();
+  const double *boxData = boxes.constData();
+
+  // all the state lives on the stack, so that concurrent queries need no locking
+  std::vector< qgssize > queue;
+  qgssize nodeIndex = levelBounds.last() - 1;
+  while ( true )
+  {
+    const qgssize end = std::min( nodeIndex + static_cast< qgssize >( nodeSize ), levelEnd( nodeIndex ) );
+    const bool leaves = nodeIndex < numItems;
+    for ( qgssize position = nodeIndex; position < end; ++position )
+    {
+      const double *box = boxData + 4 * position;
+      if ( xMax < box[0] || yMax < box[1] || xMin > box[2] || yMin > box[3] )
+        continue;
+
+      if ( leaves )
+        visitor( indices.at( static_cast< int >( position ) ) );
+      else
+        queue.push_back( static_cast< qgssize >( indices.at( static_cast< int >( position ) ) ) );
+    }
+
+    if ( queue.empty() )
+      break;
+
+    nodeIndex = queue.back();
+    queue.pop_back();
+  }
+}
+
+QList<QgsFeatureId> QgsSpatialIndexPackedRTreePrivate::nearestNeighbor( const QgsPointXY &point, int neighbors, double maxDistance ) const
+{
+  QList<QgsFeatureId> result;
+  if ( numItems == 0 || neighbors <= 0 )
+    return result;
+
+  struct Candidate
+  {
+    double distance;
+    qgssize position;
+    bool leaf;
+
+    bool operator>( const Candidate &other ) const { return distance > other.distance; }
+  };
+
+  const auto axisDistance = []( double k, double min, double max )
+  {
+    return k < min ? min - k : ( k <= max ? 0 : k - max );
+  };
+
+  const double x = point.x();
+  const double y = point.y();
+  const double maxDistanceSquared = maxDistance > 0 ? maxDistance * maxDistance : std::numeric_limits< double >::infinity();
+  const double *boxData = boxes.constData();
+
+  std::priority_queue< Candidate, std::vector< Candidate >, std::greater< Candidate > > queue;
+  qgssize nodeIndex = levelBounds.last() - 1;
+  while ( true )
+  {
+    const qgssize end = std::min( nodeIndex + static_cast< qgssize >( nodeSize ), levelEnd( nodeIndex ) );
+    const bool leaves = nodeIndex < numItems;
+    for ( qgssize position = nodeIndex; position < end; ++position )
+    {
+      const double *box = boxData + 4 * position;
+      const double dx = axisDistance( x, box[0], box[2] );
+      const double dy = axisDistance( y, box[1], box[3] );
+      const double distance = dx * dx + dy * dy;
+      if ( distance > maxDistanceSquared )
+        continue;
+
+      if ( leaves )
+        queue.push( { distance, position, true } );
+      else
+        queue.push( { distance, static_cast< qgssize >( indices.at( static_cast< int >( position ) ) ), false } );
+    }
+
+    // features closer than any remaining node are final
+    while ( !queue.empty() && queue.top().leaf )
+    {
+      result << indices.at( static_cast< int >( queue.top().position ) );
+      queue.pop();
+      if ( result.size() == neighbors )
+        return result;
+    }
+
+    if ( queue.empty() )
+      break;
+
+    nodeIndex = queue.top().position;
+    queue.pop();
+  }
+
+  return result;
+}
+
+///@endcond
+
+
+QgsSpatialIndexPackedRTree::QgsSpatialIndexPackedRTree()
+  : d( new QgsSpatialIndexPackedRTreePrivate() )
+{
+}
+
+QgsSpatialIndexPackedRTree::QgsSpatialIndexPackedRTree( QgsFeatureIterator &fi, QgsFeedback *feedback, int nodeSize )
+  : d( new QgsSpatialIndexPackedRTreePrivate() )
+{
+  d->build( fi, feedback, nodeSize );
+}
+
+QgsSpatialIndexPackedRTree::QgsSpatialIndexPackedRTree( const QgsFeatureSource &source, QgsFeedback *feedback, int nodeSize )
+  : d( new QgsSpatialIndexPackedRTreePrivate() )
+{
+  QgsFeatureIterator it = source.getFeatures( QgsFeatureRequest().setNoAttributes() );
+  d->build( it, feedback, nodeSize, source.featureCount() );
+}
+
+QgsSpatialIndexPackedRTree::QgsSpatialIndexPackedRTree( const QgsSpatialIndexPackedRTree &other ): d( other.d )
+{
+  d->ref.ref();
+}
+
+QgsSpatialIndexPackedRTree &QgsSpatialIndexPackedRTree::operator=( const QgsSpatialIndexPackedRTree &other )
+{
+  if ( this != &other )
+  {
+    if ( !d->ref.deref() )
+    {
+      delete d;
+    }
+
+    d = other.d;
+    d->ref.ref();
+  }
+  return *this;
+}
+
+QgsSpatialIndexPackedRTree::~QgsSpatialIndexPackedRTree()
+{
+  if ( !d->ref.deref() )
+    delete d;
+}
+
+QList<QgsFeatureId> QgsSpatialIndexPackedRTree::intersects( const QgsRectangle &rectangle ) const
+{
+  QList<QgsFeatureId> result;
+  d->intersects( rectangle, [&result]( QgsFeatureId id ) { result << id; } );
+  return result;
+}
+
+void QgsSpatialIndexPackedRTree::intersects( const QgsRectangle &rectangle, const std::function<void( QgsFeatureId )> &visitor ) const
+{
+  d->intersects( rectangle, visitor );
+}
+
+QList<QgsFeatureId> QgsSpatialIndexPackedRTree::nearestNeighbor( const QgsPointXY &point, int neighbors, double maxDistance ) const
+{
+  return d->nearestNeighbor( point, neighbors, maxDistance );
+}
+
+qgssize QgsSpatialIndexPackedRTree::size() const
+{
+  return d->numItems;
+}
+
+QgsRectangle QgsSpatialIndexPackedRTree::extent() const
+{
+  if ( d->numItems == 0 )
+    return QgsRectangle();
+
+  // the root node is the last box
+  const double *root = d->boxes.constData() + d->boxes.size() - 4;
+  return QgsRectangle( root[0], root[1], root[2], root[3], false );
+}
+
+bool QgsSpatialIndexPackedRTree::writeToFile( const QString &path ) const
+{
+  QFile file( path );
+  if ( !file.open( QIODevice::WriteOnly | QIODevice::Truncate ) )
+    return false;
+
+  QDataStream stream( &file );
+  stream.setByteOrder( QDataStream::LittleEndian );
+  stream.writeRawData( FILE_MAGIC, sizeof( FILE_MAGIC ) );
+  stream << FILE_VERSION << static_cast< quint32 >( d->nodeSize ) << static_cast< quint64 >( d->numItems ) << static_cast< quint32 >( d->levelBounds.size() );
+  for ( qgssize bound : qgis::as_const( d->levelBounds ) )
+    stream << static_cast< quint64 >( bound );
+
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+  stream.writeRawData( reinterpret_cast< const char * >( d->boxes.constData() ), d->boxes.size() * static_cast< int >( sizeof( double ) ) );
+  stream.writeRawData( reinterpret_cast< const char * >( d->indices.constData() ), d->indices.size() * static_cast< int >( sizeof( qint64 ) ) );
+#else
+  for ( double value : qgis::as_const( d->boxes ) )
+    stream << value;
+  for ( qint64 value : qgis::as_const( d->indices ) )
+    stream << value;
+#endif
+
+  return stream.status() == QDataStream::Ok && file.error() == QFileDevice::NoError;
+}
+
+bool QgsSpatialIndexPackedRTree::readFromFile( const QString &path )
+{
+  QFile file( path );
+  if ( !file.open( QIODevice::ReadOnly ) )
+    return false;
+
+  QDataStream stream( &file );
+  stream.setByteOrder( QDataStream::LittleEndian );
+
+  char magic[sizeof( FILE_MAGIC )];
+  if ( stream.readRawData( magic, sizeof( FILE_MAGIC ) ) != sizeof( FILE_MAGIC ) || memcmp( magic, FILE_MAGIC, sizeof( FILE_MAGIC ) ) != 0 )
+    return false;
+
+  quint32 version = 0;
+  quint32 nodeSize = 0;
+  quint64 numItems = 0;
+  quint32 levelCount = 0;
+  stream >> version >> nodeSize >> numItems >> levelCount;
+  if ( stream.status() != QDataStream::Ok || version != FILE_VERSION || nodeSize < 2 || nodeSize > 65535 || levelCount > 64 )
+    return false;
+
+  std::unique_ptr< QgsSpatialIndexPackedRTreePrivate > data = qgis::make_unique< QgsSpatialIndexPackedRTreePrivate >();
+  data->nodeSize = static_cast< int >( nodeSize );
+  data->numItems = numItems;
+  for ( quint32 i = 0; i < levelCount; ++i )
+  {
+    quint64 bound = 0;
+    stream >> bound;
+    data->levelBounds.append( bound );
+  }
+
+  // the shape of the tree only depends on the item count and the node size
+  if ( stream.status() != QDataStream::Ok
+       || numItems > static_cast< quint64 >( std::numeric_limits< int >::max() / 4 )
+       || data->levelBounds != levelBoundsForItems( numItems, data->nodeSize ) )
+    return false;
+
+  const qgssize numBoxes = data->levelBounds.isEmpty() ? 0 : data->levelBounds.last();
+  if ( numBoxes > static_cast< qgssize >( std::numeric_limits< int >::max() / 4 )
+       || static_cast< qint64 >( numBoxes * ( 4 * sizeof( double ) + sizeof( qint64 ) ) ) > file.size() - file.pos() )
+    return false;
+
+  data->boxes.resize( static_cast< int >( numBoxes * 4 ) );
+  data->indices.resize( static_cast< int >( numBoxes ) );
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+  const int boxesSize = data->boxes.size() * static_cast< int >( sizeof( double ) );
+  const int indicesSize = data->indices.size() * static_cast< int >( sizeof( qint64 ) );
+  if ( stream.readRawData( reinterpret_cast< char * >( data->boxes.data() ), boxesSize ) != boxesSize
+       || stream.readRawData( reinterpret_cast< char * >( data->indices.data() ), indicesSize ) != indicesSize )
+    return false;
+#else
+  for ( double &value : data->boxes )
+    stream >> value;
+  for ( qint64 &value : data->indices )
+    stream >> value;
+#endif
+
+  if ( stream.status() != QDataStream::Ok )
+    return false;
+
+  // each node must point to the first of its children in the level below
+  const qgssize size = static_cast< qgssize >( data->nodeSize );
+  for ( int level = 1; level < data->levelBounds.size(); ++level )
+  {
+    const qgssize childStart = level == 1 ? 0 : data->levelBounds.at( level - 2 );
+    const qgssize nodeStart = data->levelBounds.at( level - 1 );
+    for ( qgssize position = nodeStart; position < data->levelBounds.at( level ); ++position )
+    {
+      if ( data->indices.at( static_cast< int >( position ) ) != static_cast< qint64 >( childStart + ( position - nodeStart ) * size ) )
+        return false;
+    }
+  }
+
+  if ( !d->ref.deref() )
+    delete d;
+  d = data.release();
+  return true;
+}
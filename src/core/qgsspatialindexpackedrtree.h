@@ -0,0 +1,152 @@
+/***************************************************************************
+                             qgsspatialindexpackedrtree.h
+                             -----------------
+    begin                : November 2020
+    copyright            : (C) 2020 by the QGIS project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSSPATIALINDEXPACKEDRTREE_H
+#define QGSSPATIALINDEXPACKEDRTREE_H
+
+class QgsFeatureIterator;
+class QgsFeedback;
+class QgsFeatureSource;
+class QgsSpatialIndexPackedRTreePrivate;
+class QgsRectangle;
+
+#include "qgis_core.h"
+#include "qgis_sip.h"
+#include "qgsfeatureid.h"
+#include "qgspointxy.h"
+#include <QList>
+#include <functional>
+
+/**
+ * \class QgsSpatialIndexPackedRTree
+ * \ingroup core
+ *
+ * A static spatial index for geometry bounding boxes, stored as a packed Hilbert R-tree.
+ *
+ * Compared to QgsSpatialIndex, this index:
+ *
+ * - is static (features cannot be added or removed from the index after construction)
+ * - is bulk loaded in parallel: the features are sorted along a Hilbert curve and packed
+ *   into completely filled nodes
+ * - stores all nodes in two flat arrays, which uses much less memory
+ * - is safe to query from several threads at the same time, without any locking
+ * - can be written to a file and loaded again without rebuilding it
+ *
+ * QgsSpatialIndexPackedRTree objects are implicitly shared and can be inexpensively copied.
+ *
+ * \see QgsSpatialIndex, which is an general, mutable index for geometry bounding boxes.
+ * \see QgsSpatialIndexKDBush, which is a static index for points.
+ * \since QGIS 3.18
+*/
+class CORE_EXPORT QgsSpatialIndexPackedRTree
+{
+  public:
+
+    //! Constructor for an empty index
+    QgsSpatialIndexPackedRTree();
+
+    /**
+     * Constructor - creates the index and bulk loads it with the bounding boxes of
+     * the features from the iterator.
+     *
+     * The optional \a feedback object can be used to allow cancellation of bulk feature loading. Ownership
+     * of \a feedback is not transferred, and callers must take care that the lifetime of feedback exceeds
+     * that of the spatial index construction. A canceled index is empty.
+     *
+     * \a nodeSize sets the number of children of each tree node.
+     *
+     * Features without geometry are ignored.
+     */
+    explicit QgsSpatialIndexPackedRTree( QgsFeatureIterator &fi, QgsFeedback *feedback = nullptr, int nodeSize = 16 );
+
+    /**
+     * Constructor - creates the index and bulk loads it with the bounding boxes of
+     * the features from the source.
+     *
+     * The optional \a feedback object can be used to allow cancellation of bulk feature loading. Ownership
+     * of \a feedback is not transferred, and callers must take care that the lifetime of feedback exceeds
+     * that of the spatial index construction. A canceled index is empty.
+     *
+     * \a nodeSize sets the number of children of each tree node.
+     *
+     * Features without geometry are ignored.
+     */
+    explicit QgsSpatialIndexPackedRTree( const QgsFeatureSource &source, QgsFeedback *feedback = nullptr, int nodeSize = 16 );
+
+    //! Copy constructor
+    QgsSpatialIndexPackedRTree( const QgsSpatialIndexPackedRTree &other );
+
+    //! Assignment operator
+    QgsSpatialIndexPackedRTree &operator=( const QgsSpatialIndexPackedRTree &other );
+
+    ~QgsSpatialIndexPackedRTree();
+
+    /**
+     * Returns the IDs of the features whose bounding box intersects the specified \a rectangle.
+     */
+    QList<QgsFeatureId> intersects( const QgsRectangle &rectangle ) const;
+
+    /**
+     * Calls a \a visitor function for the IDs of all features whose bounding box intersects
+     * the specified \a rectangle.
+     *
+     * \note Not available in Python bindings
+     */
+    void intersects( const QgsRectangle &rectangle, const std::function<void( QgsFeatureId )> &visitor ) const SIP_SKIP;
+
+    /**
+     * Returns the IDs of the \a neighbors features whose bounding boxes are the nearest
+     * to the specified \a point, sorted by increasing distance.
+     *
+     * If \a maxDistance is greater than 0, only features within this distance are returned.
+     */
+    QList<QgsFeatureId> nearestNeighbor( const QgsPointXY &point, int neighbors = 1, double maxDistance = 0 ) const;
+
+    /**
+     * Returns the size of the index, i.e. the number of features contained within the index.
+     */
+    qgssize size() const;
+
+    /**
+     * Returns the extent of all the bounding boxes contained within the index.
+     */
+    QgsRectangle extent() const;
+
+    /**
+     * Writes the index to a file at \a path. Returns TRUE on success.
+     *
+     * \see readFromFile()
+     */
+    bool writeToFile( const QString &path ) const;
+
+    /**
+     * Replaces the content of the index with the index stored in a file at \a path.
+     * Returns TRUE on success, or FALSE if the file could not be read or is not a valid
+     * index file, in which case the index is left unchanged.
+     *
+     * \see writeToFile()
+     */
+    bool readFromFile( const QString &path );
+
+  private:
+
+    //! Implicitly shared data pointer
+    QgsSpatialIndexPackedRTreePrivate *d = nullptr;
+
+    friend class TestQgsSpatialIndexPackedRTree;
+};
+
+#endif // QGSSPATIALINDEXPACKEDRTREE_H
@@ -0,0 +1,101 @@
+/***************************************************************************
+                             qgsspatialindexpackedrtree_p.h
+                             -----------------
+    begin                : November 2020
+    copyright            : (C) 2020 by the QGIS project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSSPATIALINDEXPACKEDRTREE_PRIVATE_H
+#define QGSSPATIALINDEXPACKEDRTREE_PRIVATE_H
+
+#define SIP_NO_FILE
+
+/// @cond PRIVATE
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the QGIS API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+
+#include "qgsfeatureid.h"
+#include "qgspointxy.h"
+#include "qgsrectangle.h"
+#include <QAtomicInt>
+#include <QVector>
+#include <functional>
+#include <vector>
+
+class QgsFeatureIterator;
+class QgsFeedback;
+
+/**
+ * Flat storage of a packed Hilbert R-tree.
+ *
+ * All boxes are stored in a single array, level by level: first the feature boxes
+ * sorted along the Hilbert curve, then each level of nodes up to the root, which is
+ * the last box. For feature boxes, indices holds the feature id, for node boxes the
+ * position of the first child box.
+ */
+class QgsSpatialIndexPackedRTreePrivate
+{
+  public:
+
+    QgsSpatialIndexPackedRTreePrivate() = default;
+
+    /**
+     * Bulk loads the bounding boxes of the features from \a fi. \a expectedCount
+     * is used to reserve storage.
+     */
+    void build( QgsFeatureIterator &fi, QgsFeedback *feedback, int nodeSize, long expectedCount = 0 );
+
+    //! A bounding box with its feature id, used while bulk loading
+    struct Item
+    {
+      quint32 hilbert;
+      QgsFeatureId id;
+      double xMin;
+      double yMin;
+      double xMax;
+      double yMax;
+    };
+
+    //! Packs the \a items into the tree
+    void load( std::vector< Item > &items );
+
+    //! Returns the end position of the level containing the box at \a position
+    qgssize levelEnd( qgssize position ) const;
+
+    void intersects( const QgsRectangle &rectangle, const std::function<void( QgsFeatureId )> &visitor ) const;
+
+    QList<QgsFeatureId> nearestNeighbor( const QgsPointXY &point, int neighbors, double maxDistance ) const;
+
+    QAtomicInt ref = 1;
+
+    int nodeSize = 16;
+    qgssize numItems = 0;
+
+    //! End position of each level, from the feature boxes up to the root
+    QVector< qgssize > levelBounds;
+
+    //! xMin, yMin, xMax, yMax of each box
+    QVector< double > boxes;
+
+    QVector< qint64 > indices;
+};
+
+/// @endcond
+
+#endif // QGSSPATIALINDEXPACKEDRTREE_PRIVATE_H
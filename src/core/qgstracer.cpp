@@ -26,7 +26,9 @@
 #include "qgsrenderer.h"
 #include "qgssettings.h"
 #include "qgsexpressioncontextutils.h"
+#include "qgsspatialindex.h"
 
+#include <algorithm>
 #include <queue>
 #include <vector>
 
@@ -123,57 +125,87 @@ struct QgsTracerGraph
   QSet<int> inactiveEdges;
   //! Temporarily added vertices (for each there are two extra edges)
   int joinedVertices{ 0 };
+
+  //! Index of the vertices by their location
+  QHash<QgsPointXY, int> vertexIndex;
+  //! Spatial index of the edges (with edge index as ID), without removed and temporarily added edges
+  QgsSpatialIndex edgeIndex;
+  //! Number of edges removed when the graph was updated (they are kept with empty coordinates)
+  int removedEdges{ 0 };
+
+  //! Extents of the linework of the features in the graph, by layer and feature ID
+  QHash< const QgsVectorLayer *, QHash< QgsFeatureId, QgsRectangle > > featureExtents;
 };
 
 
+int addVertex( QgsTracerGraph &g, const QgsPointXY &pt )
+{
+  // get or add vertex
+  QHash<QgsPointXY, int>::const_iterator it = g.vertexIndex.constFind( pt );
+  if ( it != g.vertexIndex.constEnd() )
+    return it.value();
+
+  int vIdx = g.v.count();
+  QgsTracerGraph::V v;
+  v.pt = pt;
+  g.v.append( v );
+  g.vertexIndex.insert( pt, vIdx );
+  return vIdx;
+}
+
+
+int addEdge( QgsTracerGraph &g, const QgsPolylineXY &line )
+{
+  int v1 = addVertex( g, line[0] );
+  int v2 = addVertex( g, line[line.count() - 1] );
+
+  // add edge
+  QgsTracerGraph::E e;
+  e.v1 = v1;
+  e.v2 = v2;
+  e.coords = line;
+  g.e.append( e );
+
+  // link edge to vertices
+  int eIdx = g.e.count() - 1;
+  g.v[v1].edges << eIdx;
+  g.v[v2].edges << eIdx;
+
+  QgsFeature indexFeature( eIdx );
+  indexFeature.setGeometry( QgsGeometry::fromPolylineXY( line ) );
+  g.edgeIndex.addFeature( indexFeature );
+
+  return eIdx;
+}
+
+
+void removeEdge( QgsTracerGraph &g, int eIdx )
+{
+  QgsTracerGraph::E &e = g.e[eIdx];
+
+  QgsFeature indexFeature( eIdx );
+  indexFeature.setGeometry( QgsGeometry::fromPolylineXY( e.coords ) );
+  g.edgeIndex.deleteFeature( indexFeature );
+
+  // the edge is kept in place so that indices of other edges stay valid, but nothing refers to it anymore
+  g.v[e.v1].edges.removeAll( eIdx );
+  g.v[e.v2].edges.removeAll( eIdx );
+  e.coords.clear();
+  g.removedEdges++;
+}
+
+
 QgsTracerGraph *makeGraph( const QVector<QgsPolylineXY> &edges )
 {
   QgsTracerGraph *g = new QgsTracerGraph();
   g->joinedVertices = 0;
-  QHash<QgsPointXY, int> point2vertex;
 
-  const auto constEdges = edges;
-  for ( const QgsPolylineXY &line : constEdges )
+  for ( const QgsPolylineXY &line : edges )
   {
-    QgsPointXY p1( line[0] );
-    QgsPointXY p2( line[line.count() - 1] );
-
-    int v1 = -1, v2 = -1;
-    // get or add vertex 1
-    if ( point2vertex.contains( p1 ) )
-      v1 = point2vertex.value( p1 );
-    else
-    {
-      v1 = g->v.count();
-      QgsTracerGraph::V v;
-      v.pt = p1;
-      g->v.append( v );
-      point2vertex[p1] = v1;
-    }
-
-    // get or add vertex 2
-    if ( point2vertex.contains( p2 ) )
-      v2 = point2vertex.value( p2 );
-    else
-    {
-      v2 = g->v.count();
-      QgsTracerGraph::V v;
-      v.pt = p2;
-      g->v.append( v );
-      point2vertex[p2] = v2;
-    }
-
-    // add edge
-    QgsTracerGraph::E e;
-    e.v1 = v1;
-    e.v2 = v2;
-    e.coords = line;
-    g->e.append( e );
+    if ( line.count() < 2 )
+      continue;
 
-    // link edge to vertices
-    int eIdx = g->e.count() - 1;
-    g->v[v1].edges << eIdx;
-    g->v[v2].edges << eIdx;
+    addEdge( *g, line );
   }
 
   return g;
@@ -261,14 +293,34 @@ QVector<QgsPointXY> shortestPath( const QgsTracerGraph &g, int v1, int v2 )
 }
 
 
+bool vertexNear( const QgsTracerGraph &g, int vIdx, const QgsPointXY &pt, double epsilon )
+{
+  const QgsTracerGraph::V &v = g.v.at( vIdx );
+  return v.pt == pt || ( std::fabs( v.pt.x() - pt.x() ) < epsilon && std::fabs( v.pt.y() - pt.y() ) < epsilon );
+}
+
+
 int point2vertex( const QgsTracerGraph &g, const QgsPointXY &pt, double epsilon = 1e-6 )
 {
-  // TODO: use spatial index
+  // vertices are end points of the edges near the point (vertices left without edges are ignored)
+  int found = -1;
+  const QList<QgsFeatureId> candidates = g.edgeIndex.intersects( QgsRectangle( pt.x() - epsilon, pt.y() - epsilon, pt.x() + epsilon, pt.y() + epsilon ) );
+  for ( QgsFeatureId id : candidates )
+  {
+    const QgsTracerGraph::E &e = g.e.at( static_cast< int >( id ) );
+    for ( int vIdx : { e.v1, e.v2 } )
+    {
+      if ( ( found == -1 || vIdx < found ) && vertexNear( g, vIdx, pt, epsilon ) )
+        found = vIdx;
+    }
+  }
+  if ( found != -1 )
+    return found;
 
-  for ( int i = 0; i < g.v.count(); ++i )
+  // temporarily added vertices are not indexed
+  for ( int i = g.v.count() - g.joinedVertices; i < g.v.count(); ++i )
   {
-    const QgsTracerGraph::V &v = g.v.at( i );
-    if ( v.pt == pt || ( std::fabs( v.pt.x() - pt.x() ) < epsilon && std::fabs( v.pt.y() - pt.y() ) < epsilon ) )
+    if ( vertexNear( g, i, pt, epsilon ) )
       return i;
   }
 
@@ -278,8 +330,18 @@ int point2vertex( const QgsTracerGraph &g, const QgsPointXY &pt, double epsilon
 
 int point2edge( const QgsTracerGraph &g, const QgsPointXY &pt, int &lineVertexAfter, double epsilon = 1e-6 )
 {
-  for ( int i = 0; i < g.e.count(); ++i )
+  // epsilon is a tolerance of squared distances
+  const double searchRadius = std::sqrt( epsilon );
+  QList<QgsFeatureId> candidates = g.edgeIndex.intersects( QgsRectangle( pt.x() - searchRadius, pt.y() - searchRadius, pt.x() + searchRadius, pt.y() + searchRadius ) );
+  std::sort( candidates.begin(), candidates.end() );
+
+  // temporarily added edges are not indexed
+  for ( int i = g.e.count() - g.joinedVertices * 2; i < g.e.count(); ++i )
+    candidates << i;
+
+  for ( QgsFeatureId id : qgis::as_const( candidates ) )
   {
+    const int i = static_cast< int >( id );
     if ( g.inactiveEdges.contains( i ) )
       continue;  // ignore temporarily disabled edges
 
@@ -464,136 +526,413 @@ void extractLinework( const QgsGeometry &g, QgsMultiPolylineXY &mpl )
   }
 }
 
+
+bool nodeLinework( QgsMultiPolylineXY &mpl )
+{
+  QgsGeometry allGeom = QgsGeometry::fromMultiPolylineXY( mpl );
+
+  try
+  {
+    // GEOSNode_r may throw an exception
+    geos::unique_ptr allGeomGeos( QgsGeos::asGeos( allGeom ) );
+    geos::unique_ptr allNoded( GEOSNode_r( QgsGeos::getGEOSHandler(), allGeomGeos.get() ) );
+
+    QgsGeometry noded = QgsGeos::geometryFromGeos( allNoded.release() );
+
+    mpl = noded.asMultiPolyline();
+  }
+  catch ( GEOSException &e )
+  {
+    // no big deal... we will just not have nicely noded linework, potentially
+    // missing some intersections
+    QgsDebugMsg( QStringLiteral( "Tracer Noding Exception: %1" ).arg( e.what() ) );
+    return false;
+  }
+  return true;
+}
+
+
+//! Returns a point in the interior of an edge (the middle of its first segment), which lies on the linework the edge comes from
+QgsPointXY edgeInteriorPoint( const QgsPolylineXY &coords )
+{
+  return QgsPointXY( ( coords.at( 0 ).x() + coords.at( 1 ).x() ) / 2, ( coords.at( 0 ).y() + coords.at( 1 ).y() ) / 2 );
+}
+
+
+bool pointOnLinework( const QgsMultiPolylineXY &mpl, const QgsRectangle &extent, const QgsPointXY &pt )
+{
+  if ( !extent.contains( pt ) )
+    return false;
+
+  for ( const QgsPolylineXY &line : mpl )
+  {
+    if ( line.count() < 2 )
+      continue;
+
+    int vertexAfter = -1;
+    if ( closestSegment( line, pt, vertexAfter, 1e-16 ) == 0 )
+      return true;
+  }
+  return false;
+}
+
 // -------------
 
 
 QgsTracer::QgsTracer() = default;
 
+bool QgsTracer::visitFeatures( const QgsVectorLayer *vl, const QgsFeatureRequest &featureRequest, const std::function< bool( const QgsFeature & ) > &visitor ) const
+{
+  QgsFeatureRequest request( featureRequest );
+  bool filter = false;
+  std::unique_ptr< QgsFeatureRenderer > renderer;
+  std::unique_ptr<QgsRenderContext> ctx;
+
+  bool enableInvisibleFeature = QgsSettings().value( QStringLiteral( "/qgis/digitizing/snap_invisible_feature" ), false ).toBool();
+  if ( !enableInvisibleFeature && mRenderContext && vl->renderer() )
+  {
+    renderer.reset( vl->renderer()->clone() );
+    ctx.reset( new QgsRenderContext( *mRenderContext.get() ) );
+    ctx->expressionContext() << QgsExpressionContextUtils::layerScope( vl );
+
+    // setup scale for scale dependent visibility (rule based)
+    renderer->startRender( *ctx.get(), vl->fields() );
+    filter = renderer->capabilities() & QgsFeatureRenderer::Filter;
+    request.setSubsetOfAttributes( renderer->usedAttributes( *ctx.get() ), vl->fields() );
+  }
+  else
+  {
+    request.setNoAttributes();
+  }
+
+  request.setDestinationCrs( mCRS, mTransformContext );
+
+  // features are limited to the ones intersecting the extent, when a more specific filter
+  // rectangle is requested they are checked one by one
+  bool checkExtent = false;
+  if ( !mExtent.isEmpty() )
+  {
+    if ( request.filterRect().isNull() )
+      request.setFilterRect( mExtent );
+    else
+      checkExtent = true;
+  }
+
+  bool completed = true;
+  QgsFeature f;
+  QgsFeatureIterator fi = vl->getFeatures( request );
+  while ( fi.nextFeature( f ) )
+  {
+    if ( !f.hasGeometry() )
+      continue;
+
+    if ( checkExtent && !f.geometry().boundingBox().intersects( mExtent ) )
+      continue;
+
+    if ( filter )
+    {
+      ctx->expressionContext().setFeature( f );
+      if ( !renderer->willRenderFeature( f, *ctx.get() ) )
+      {
+        continue;
+      }
+    }
+
+    if ( !visitor( f ) )
+    {
+      completed = false;
+      break;
+    }
+  }
+
+  if ( renderer )
+  {
+    renderer->stopRender( *ctx.get() );
+  }
+
+  return completed;
+}
+
 bool QgsTracer::initGraph()
 {
+  // apply the feature changes since the graph was built, which may invalidate it
+  updatePendingFeatures();
   if ( mGraph )
     return true; // already initialized
 
   mHasTopologyProblem = false;
 
-  QgsFeature f;
   QgsMultiPolylineXY mpl;
+  QHash< const QgsVectorLayer *, QHash< QgsFeatureId, QgsRectangle > > featureExtents;
 
   // extract linestrings
 
   // TODO: use QgsPointLocator as a source for the linework
 
-  QElapsedTimer t1, t2, t2a, t3;
+  QElapsedTimer t1, t2, t3;
 
   t1.start();
   int featuresCounted = 0;
-  bool enableInvisibleFeature = QgsSettings().value( QStringLiteral( "/qgis/digitizing/snap_invisible_feature" ), false ).toBool();
   for ( const QgsVectorLayer *vl : qgis::as_const( mLayers ) )
   {
-    QgsFeatureRequest request;
-    bool filter = false;
-    std::unique_ptr< QgsFeatureRenderer > renderer;
-    std::unique_ptr<QgsRenderContext> ctx;
-
-    if ( !enableInvisibleFeature && mRenderContext && vl->renderer() )
+    QHash< QgsFeatureId, QgsRectangle > &layerExtents = featureExtents[ vl ];
+    bool complete = visitFeatures( vl, QgsFeatureRequest(), [this, &mpl, &layerExtents, &featuresCounted]( const QgsFeature & f ) -> bool
     {
-      renderer.reset( vl->renderer()->clone() );
-      ctx.reset( new QgsRenderContext( *mRenderContext.get() ) );
-      ctx->expressionContext() << QgsExpressionContextUtils::layerScope( vl );
-
-      // setup scale for scale dependent visibility (rule based)
-      renderer->startRender( *ctx.get(), vl->fields() );
-      filter = renderer->capabilities() & QgsFeatureRenderer::Filter;
-      request.setSubsetOfAttributes( renderer->usedAttributes( *ctx.get() ), vl->fields() );
-    }
-    else
-    {
-      request.setNoAttributes();
-    }
+      extractLinework( f.geometry(), mpl );
+      layerExtents.insert( f.id(), f.geometry().boundingBox() );
 
-    request.setDestinationCrs( mCRS, mTransformContext );
-    if ( !mExtent.isEmpty() )
-      request.setFilterRect( mExtent );
+      ++featuresCounted;
+      return mMaxFeatureCount == 0 || featuresCounted < mMaxFeatureCount;
+    } );
+    if ( !complete )
+      return false;
+  }
+  int timeExtract = t1.elapsed();
 
-    QgsFeatureIterator fi = vl->getFeatures( request );
-    while ( fi.nextFeature( f ) )
-    {
-      if ( !f.hasGeometry() )
-        continue;
+  // resolve intersections
 
-      if ( filter )
-      {
-        ctx->expressionContext().setFeature( f );
-        if ( !renderer->willRenderFeature( f, *ctx.get() ) )
-        {
-          continue;
-        }
-      }
+  t2.start();
 
-      extractLinework( f.geometry(), mpl );
+  if ( !nodeLinework( mpl ) )
+    mHasTopologyProblem = true;
 
-      ++featuresCounted;
-      if ( mMaxFeatureCount != 0 && featuresCounted >= mMaxFeatureCount )
-        return false;
-    }
+  int timeNoding = t2.elapsed();
+
+  t3.start();
+
+  mGraph.reset( makeGraph( mpl ) );
+  mGraph->featureExtents = featureExtents;
+
+  int timeMake = t3.elapsed();
+
+  Q_UNUSED( timeExtract )
+  Q_UNUSED( timeNoding )
+  Q_UNUSED( timeMake )
+  QgsDebugMsgLevel( QStringLiteral( "tracer extract %1 ms, noding %2 ms, make %3 ms" )
+                    .arg( timeExtract ).arg( timeNoding ).arg( timeMake ), 2 );
+
+  return true;
+}
+
+//! Maximum number of changed features applied to the graph, beyond that it is built from scratch
+static const int MAX_PENDING_FEATURES = 100;
+
+bool QgsTracer::isFiltered( const QgsVectorLayer *layer ) const
+{
+  // same conditions as for checking the features with the renderer in visitFeatures()
+  if ( !mRenderContext || !layer->renderer() )
+    return false;
+
+  if ( QgsSettings().value( QStringLiteral( "/qgis/digitizing/snap_invisible_feature" ), false ).toBool() )
+    return false;
+
+  return layer->renderer()->capabilities() & QgsFeatureRenderer::Filter;
+}
+
+void QgsTracer::queueFeatureUpdate( const QgsVectorLayer *layer, QgsFeatureId fid )
+{
+  if ( !mGraph )
+    return;  // nothing to update, the graph will be built when needed
+
+  if ( !layer )
+  {
+    invalidateGraph();
+    return;
+  }
+
+  QgsFeatureIds &fids = mPendingFeatureIds[ layer ];
+  if ( fids.contains( fid ) )
+    return;
+
+  fids.insert( fid );
+  if ( ++mPendingFeatureCount > MAX_PENDING_FEATURES )
+  {
+    // building the graph from scratch is cheaper than updating it for a large batch of edits
+    invalidateGraph();
+  }
+}
+
+void QgsTracer::updatePendingFeatures()
+{
+  if ( mPendingFeatureIds.isEmpty() )
+    return;
+
+  const QHash< const QgsVectorLayer *, QgsFeatureIds > pendingFeatureIds = mPendingFeatureIds;
+  mPendingFeatureIds.clear();
+  mPendingFeatureCount = 0;
+
+  if ( !mGraph )
+    return;
+
+  if ( mGraph->joinedVertices != 0 || mHasTopologyProblem )
+  {
+    invalidateGraph();
+    return;
+  }
+
+  QElapsedTimer t;
+  t.start();
 
-    if ( renderer )
+  // the changed features' extents before and after the changes
+  QVector< QgsRectangle > regions;
+  QHash< const QgsVectorLayer *, QHash< QgsFeatureId, QgsRectangle > > newExtents;
+  for ( auto it = pendingFeatureIds.constBegin(); it != pendingFeatureIds.constEnd(); ++it )
+  {
+    const QHash< QgsFeatureId, QgsRectangle > layerExtents = mGraph->featureExtents.value( it.key() );
+    for ( QgsFeatureId fid : it.value() )
     {
-      renderer->stopRender( *ctx.get() );
+      const auto extentIt = layerExtents.constFind( fid );
+      if ( extentIt != layerExtents.constEnd() )
+        regions << extentIt.value();
     }
+
+    QHash< QgsFeatureId, QgsRectangle > &layerNewExtents = newExtents[ it.key() ];
+    visitFeatures( it.key(), QgsFeatureRequest().setFilterFids( it.value() ), [&layerNewExtents, &regions]( const QgsFeature & f ) -> bool
+    {
+      const QgsRectangle extent = f.geometry().boundingBox();
+      layerNewExtents.insert( f.id(), extent );
+      regions << extent;
+      return true;
+    } );
   }
-  int timeExtract = t1.elapsed();
 
-  // resolve intersections
+  if ( regions.isEmpty() )
+    return;  // not traced before nor after the changes
 
-  t2.start();
+  QgsRectangle region = regions.at( 0 );
+  for ( const QgsRectangle &extent : qgis::as_const( regions ) )
+    region.combineExtentWith( extent );
 
-  int timeNodingCall = 0;
+  struct TracerFeature
+  {
+    QgsMultiPolylineXY linework;
+    QgsRectangle extent;
+    bool affected;
+  };
 
-#if 0
-  // without noding - if data are known to be noded beforehand
-#else
-  QgsGeometry allGeom = QgsGeometry::fromMultiPolylineXY( mpl );
+  // the edges of all features in the changed regions are built again. These features need to be
+  // noded with all features around them, but only their own pieces are added back to the graph
+  QSet< QPair< const QgsVectorLayer *, QgsFeatureId > > affectedFeatures;
+  QgsRectangle affectedExtent = region;
+  for ( const QgsVectorLayer *vl : qgis::as_const( mLayers ) )
+  {
+    visitFeatures( vl, QgsFeatureRequest().setFilterRect( region ), [vl, &regions, &affectedFeatures, &affectedExtent]( const QgsFeature & f ) -> bool
+    {
+      const QgsRectangle extent = f.geometry().boundingBox();
+      if ( std::any_of( regions.constBegin(), regions.constEnd(), [&extent]( const QgsRectangle & changed ) { return changed.intersects( extent ); } ) )
+      {
+        affectedFeatures.insert( qMakePair( vl, f.id() ) );
+        affectedExtent.combineExtentWith( extent );
+      }
+      return true;
+    } );
+  }
 
-  try
+  QVector< TracerFeature > features;
+  QgsMultiPolylineXY mpl;
+  for ( const QgsVectorLayer *vl : qgis::as_const( mLayers ) )
   {
-    t2a.start();
-    // GEOSNode_r may throw an exception
-    geos::unique_ptr allGeomGeos( QgsGeos::asGeos( allGeom ) );
-    geos::unique_ptr allNoded( GEOSNode_r( QgsGeos::getGEOSHandler(), allGeomGeos.get() ) );
-    timeNodingCall = t2a.elapsed();
+    visitFeatures( vl, QgsFeatureRequest().setFilterRect( affectedExtent ), [vl, &affectedFeatures, &features, &mpl]( const QgsFeature & f ) -> bool
+    {
+      TracerFeature feature;
+      extractLinework( f.geometry(), feature.linework );
+      // tolerate rounding errors of points along the extent's border
+      feature.extent = f.geometry().boundingBox().buffered( 1e-8 );
+      feature.affected = affectedFeatures.contains( qMakePair( vl, f.id() ) );
+      mpl << feature.linework;
+      features << feature;
+      return true;
+    } );
+  }
 
-    QgsGeometry noded = QgsGeos::geometryFromGeos( allNoded.release() );
+  // remove the edges of the affected features, and the edges left from the old linework
+  // which do not lie on any current feature anymore
+  const QList<QgsFeatureId> candidates = mGraph->edgeIndex.intersects( affectedExtent );
+  for ( QgsFeatureId id : candidates )
+  {
+    const QgsPointXY pt = edgeInteriorPoint( mGraph->e.at( static_cast< int >( id ) ).coords );
+    bool onAffected = false;
+    bool onOther = false;
+    for ( const TracerFeature &feature : qgis::as_const( features ) )
+    {
+      if ( ( feature.affected ? onAffected : onOther ) || !pointOnLinework( feature.linework, feature.extent, pt ) )
+        continue;
 
-    mpl = noded.asMultiPolyline();
+      if ( feature.affected )
+        onAffected = true;
+      else
+        onOther = true;
+    }
+
+    if ( onAffected || !onOther )
+      removeEdge( *mGraph, static_cast< int >( id ) );
   }
-  catch ( GEOSException &e )
+
+  if ( !nodeLinework( mpl ) )
   {
-    // no big deal... we will just not have nicely noded linework, potentially
-    // missing some intersections
+    // leave it to a complete rebuild to report the topology problem
+    invalidateGraph();
+    return;
+  }
 
-    mHasTopologyProblem = true;
+  // add the pieces of the affected features
+  for ( const QgsPolylineXY &line : qgis::as_const( mpl ) )
+  {
+    if ( line.count() < 2 )
+      continue;
 
-    QgsDebugMsg( QStringLiteral( "Tracer Noding Exception: %1" ).arg( e.what() ) );
+    const QgsPointXY pt = edgeInteriorPoint( line );
+    for ( const TracerFeature &feature : qgis::as_const( features ) )
+    {
+      if ( feature.affected && pointOnLinework( feature.linework, feature.extent, pt ) )
+      {
+        addEdge( *mGraph, line );
+        break;
+      }
+    }
   }
-#endif
 
-  int timeNoding = t2.elapsed();
-
-  t3.start();
+  for ( auto it = pendingFeatureIds.constBegin(); it != pendingFeatureIds.constEnd(); ++it )
+  {
+    QHash< QgsFeatureId, QgsRectangle > &extents = mGraph->featureExtents[ it.key() ];
+    const QHash< QgsFeatureId, QgsRectangle > &layerNewExtents = newExtents[ it.key() ];
+    for ( QgsFeatureId fid : it.value() )
+    {
+      const auto extentIt = layerNewExtents.constFind( fid );
+      if ( extentIt != layerNewExtents.constEnd() )
+        extents.insert( fid, extentIt.value() );
+      else
+        extents.remove( fid );
+    }
+  }
 
-  mGraph.reset( makeGraph( mpl ) );
+  int featureCount = 0;
+  for ( const QHash< QgsFeatureId, QgsRectangle > &layerFeatureExtents : qgis::as_const( mGraph->featureExtents ) )
+    featureCount += layerFeatureExtents.count();
+  if ( mMaxFeatureCount != 0 && featureCount >= mMaxFeatureCount )
+  {
+    // too many features now, as if the graph was built from scratch
+    invalidateGraph();
+    return;
+  }
 
-  int timeMake = t3.elapsed();
+  if ( mGraph->removedEdges > mGraph->e.count() / 2 )
+  {
+    // get rid of the removed edges
+    QVector<QgsPolylineXY> lines;
+    lines.reserve( mGraph->e.count() - mGraph->removedEdges );
+    for ( const QgsTracerGraph::E &e : qgis::as_const( mGraph->e ) )
+    {
+      if ( !e.coords.isEmpty() )
+        lines << e.coords;
+    }
 
-  Q_UNUSED( timeExtract )
-  Q_UNUSED( timeNoding )
-  Q_UNUSED( timeNodingCall )
-  Q_UNUSED( timeMake )
-  QgsDebugMsgLevel( QStringLiteral( "tracer extract %1 ms, noding %2 ms (call %3 ms), make %4 ms" )
-                    .arg( timeExtract ).arg( timeNoding ).arg( timeNodingCall ).arg( timeMake ), 2 );
+    std::unique_ptr< QgsTracerGraph > compacted( makeGraph( lines ) );
+    compacted->featureExtents = mGraph->featureExtents;
+    mGraph = std::move( compacted );
+  }
 
-  return true;
+  QgsDebugMsgLevel( QStringLiteral( "tracer graph updated in %1 ms" ).arg( t.elapsed() ), 2 );
 }
 
 QgsTracer::~QgsTracer()
@@ -676,6 +1015,7 @@ void QgsTracer::setOffsetParameters( int quadSegments, int joinStyle, double mit
 
 bool QgsTracer::init()
 {
+  updatePendingFeatures();
   if ( mGraph )
     return true;
 
@@ -689,33 +1029,35 @@ bool QgsTracer::init()
 void QgsTracer::invalidateGraph()
 {
   mGraph.reset( nullptr );
+  mPendingFeatureIds.clear();
+  mPendingFeatureCount = 0;
 }
 
 void QgsTracer::onFeatureAdded( QgsFeatureId fid )
 {
-  Q_UNUSED( fid )
-  invalidateGraph();
+  queueFeatureUpdate( qobject_cast< QgsVectorLayer * >( sender() ), fid );
 }
 
 void QgsTracer::onFeatureDeleted( QgsFeatureId fid )
 {
-  Q_UNUSED( fid )
-  invalidateGraph();
+  queueFeatureUpdate( qobject_cast< QgsVectorLayer * >( sender() ), fid );
 }
 
 void QgsTracer::onGeometryChanged( QgsFeatureId fid, const QgsGeometry &geom )
 {
-  Q_UNUSED( fid )
   Q_UNUSED( geom )
-  invalidateGraph();
+  queueFeatureUpdate( qobject_cast< QgsVectorLayer * >( sender() ), fid );
 }
 
 void QgsTracer::onAttributeValueChanged( QgsFeatureId fid, int idx, const QVariant &value )
 {
-  Q_UNUSED( fid )
   Q_UNUSED( idx )
   Q_UNUSED( value )
-  invalidateGraph();
+  // attributes only matter when they may change the visibility of the feature through the
+  // renderer's filter, otherwise the graph is left untouched
+  const QgsVectorLayer *layer = qobject_cast< QgsVectorLayer * >( sender() );
+  if ( layer && isFiltered( layer ) )
+    queueFeatureUpdate( layer, fid );
 }
 
 void QgsTracer::onDataChanged( )
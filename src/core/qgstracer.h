@@ -21,6 +21,7 @@ class QgsVectorLayer;
 #include "qgis_core.h"
 #include <QSet>
 #include <QVector>
+#include <functional>
 #include <memory>
 
 #include "qgsfeatureid.h"
@@ -29,7 +30,9 @@ class QgsVectorLayer;
 #include "qgsgeometry.h"
 
 struct QgsTracerGraph;
+class QgsFeature;
 class QgsFeatureRenderer;
+class QgsFeatureRequest;
 class QgsRenderContext;
 
 /**
@@ -164,6 +167,26 @@ class CORE_EXPORT QgsTracer : public QObject
   private:
     bool initGraph();
 
+    /**
+     * Calls \a visitor with the features of \a layer matching \a request which are used for tracing,
+     * with their geometry in the destination CRS. Returns FALSE if the visitor stopped the iteration.
+     */
+    bool visitFeatures( const QgsVectorLayer *layer, const QgsFeatureRequest &request, const std::function< bool( const QgsFeature & ) > &visitor ) const;
+
+    //! Returns TRUE if the traced features of \a layer are filtered by its renderer, so that attribute changes matter
+    bool isFiltered( const QgsVectorLayer *layer ) const;
+
+    /**
+     * Queues the update of the graph after the feature \a fid of \a layer was added, deleted or changed.
+     * The graph is invalidated instead if there are too many queued features.
+     */
+    void queueFeatureUpdate( const QgsVectorLayer *layer, QgsFeatureId fid );
+
+    /**
+     * Updates the graph for the queued features. Only the edges in the regions of the changes are rebuilt.
+     */
+    void updatePendingFeatures();
+
   private slots:
     void onFeatureAdded( QgsFeatureId fid );
     void onFeatureDeleted( QgsFeatureId fid );
@@ -207,6 +230,11 @@ class CORE_EXPORT QgsTracer : public QObject
      * due to noding exception, indicating some input data topology problems
      */
     bool mHasTopologyProblem = false;
+
+    //! Features added, deleted or changed since the graph was updated, by layer
+    QHash< const QgsVectorLayer *, QgsFeatureIds > mPendingFeatureIds;
+    //! Number of features in mPendingFeatureIds
+    int mPendingFeatureCount = 0;
 };
 
 
@@ -27,6 +27,10 @@
 #include "qgsmessagelog.h"
 #include "qgsexception.h"
 #include "qgsexpressioncontextutils.h"
+#include "qgsfeaturebatch.h"
+
+//! Number of provider features read ahead to fetch the attributes of joins without memory cache at once
+static const int JOIN_BATCH_SIZE = 1000;
 
 QgsVectorLayerFeatureSource::QgsVectorLayerFeatureSource( const QgsVectorLayer *layer )
 {
@@ -250,6 +254,32 @@ QgsVectorLayerFeatureIterator::QgsVectorLayerFeatureIterator( QgsVectorLayerFeat
     }
   }
 
+  // a filter expression which can't be handled by the provider is evaluated while reading ahead features
+  // for batched joins if it doesn't depend on virtual fields, so that joined attributes are only fetched
+  // for the features matching the filter
+  if ( !mBatchedJoinInfoList.isEmpty() && mRequest.filterType() == QgsFeatureRequest::FilterExpression && mProviderRequest.filterType() != QgsFeatureRequest::FilterExpression )
+  {
+    mFilterJoinBatch = true;
+    const QSet<QString> referencedColumns = mRequest.filterExpression()->referencedColumns();
+    for ( const QString &field : referencedColumns )
+    {
+      switch ( mSource->mFields.fieldOrigin( mSource->mFields.lookupField( field ) ) )
+      {
+        case QgsFields::OriginProvider:
+        case QgsFields::OriginEdit:
+          break;
+
+        case QgsFields::OriginUnknown:
+        case QgsFields::OriginJoin:
+        case QgsFields::OriginExpression:
+          mFilterJoinBatch = false;
+          break;
+      }
+      if ( !mFilterJoinBatch )
+        break;
+    }
+  }
+
   if ( mSource->mHasEditBuffer )
   {
     mChangedFeaturesRequest = mProviderRequest;
@@ -432,29 +462,20 @@ bool QgsVectorLayerFeatureIterator::fetchFeature( QgsFeature &f )
   }
   // no more added features
 
-  if ( mProviderIterator.isClosed() )
+  // when reading ahead for batched joins the provider iterator may already be at its end while there are features left
+  if ( mProviderIterator.isClosed() && !mProviderIteratorAtEnd )
   {
     mChangedFeaturesIterator.close();
     mProviderIterator = mSource->mProviderFeatureSource->getFeatures( mProviderRequest );
     mProviderIterator.setInterruptionChecker( mInterruptionChecker );
   }
 
-  while ( mProviderIterator.nextFeature( f ) )
+  while ( fetchNextProviderFeature( f ) )
   {
-    if ( mFetchConsidered.contains( f.id() ) )
-      continue;
-
-    // TODO[MD]: just one resize of attributes
-    f.setFields( mSource->mFields );
-
-    // update attributes
-    if ( mSource->mHasEditBuffer )
-      updateChangedAttributes( f );
-
     if ( mHasVirtualAttributes )
       addVirtualAttributes( f );
 
-    if ( mRequest.filterType() == QgsFeatureRequest::FilterExpression && mProviderRequest.filterType() != QgsFeatureRequest::FilterExpression )
+    if ( mRequest.filterType() == QgsFeatureRequest::FilterExpression && mProviderRequest.filterType() != QgsFeatureRequest::FilterExpression && !mFilterJoinBatch )
     {
       //filtering by expression, and couldn't do it on the provider side
       mRequest.expressionContext()->setFeature( f );
@@ -495,6 +516,9 @@ bool QgsVectorLayerFeatureIterator::rewind()
   else
   {
     mProviderIterator.rewind();
+    mJoinBatchFeatures.clear();
+    mJoinBatchAttributes.clear();
+    mProviderIteratorAtEnd = false;
     rewindEditBuffer();
   }
 
@@ -507,6 +531,8 @@ bool QgsVectorLayerFeatureIterator::close()
     return false;
 
   mProviderIterator.close();
+  mJoinBatchFeatures.clear();
+  mJoinBatchAttributes.clear();
 
   iteratorClosed();
 
@@ -781,6 +807,7 @@ void QgsVectorLayerFeatureIterator::prepareFields()
   mFieldsToPrepare.clear();
   mFetchJoinInfo.clear();
   mOrderedJoinInfoList.clear();
+  mBatchedJoinInfoList.clear();
 
   mExpressionContext.reset();
 
@@ -801,6 +828,27 @@ void QgsVectorLayerFeatureIterator::prepareFields()
   {
     createOrderedJoinList();
   }
+
+  // joins without memory cache and driven by a provider field can be fetched for a batch of features at once,
+  // instead of requesting the joined layer for every single feature
+  for ( const FetchJoinInfo &info : qgis::as_const( mOrderedJoinInfoList ) )
+  {
+    if ( !info.joinInfo->cachedAttributes.isEmpty() || info.joinField < 0 || !mSource->mFields.exists( info.targetField ) )
+      continue;
+
+    switch ( mSource->mFields.fieldOrigin( info.targetField ) )
+    {
+      case QgsFields::OriginProvider:
+      case QgsFields::OriginEdit:
+        mBatchedJoinInfoList << info;
+        break;
+
+      case QgsFields::OriginUnknown:
+      case QgsFields::OriginJoin:
+      case QgsFields::OriginExpression:
+        break;
+    }
+  }
 }
 
 void QgsVectorLayerFeatureIterator::createOrderedJoinList()
@@ -860,6 +908,41 @@ void QgsVectorLayerFeatureIterator::createOrderedJoinList()
   }
 }
 
+int QgsVectorLayerFeatureIterator::fetchBatch( QgsFeatureBatch &batch, int maxRows )
+{
+  // the provider iterator can only fill the batch when the layer does not change or add
+  // anything to the provider features. Features already read ahead for batched joins
+  // are drained feature by feature first, so that mixing nextFeature() and nextBatch()
+  // neither drops nor duplicates features.
+  bool delegate = !mClosed && !mSource->mHasEditBuffer && !mHasVirtualAttributes && !mTransform.isValid()
+                  && mJoinBatchFeatures.isEmpty()
+                  && !mSource->mJoinBuffer->containsJoins()
+                  && mSource->mExpressionFieldBuffer->expressions().isEmpty()
+                  && mRequest.invalidGeometryCheck() == QgsFeatureRequest::GeometryNoCheck
+                  && !mProviderIterator.isClosed();
+  if ( delegate )
+  {
+    const QgsAttributeList attributes = batch.attributes();
+    for ( int idx : attributes )
+    {
+      if ( mSource->mFields.fieldOrigin( idx ) != QgsFields::OriginProvider )
+      {
+        delegate = false;
+        break;
+      }
+    }
+  }
+
+  if ( !delegate )
+    return QgsAbstractFeatureIterator::fetchBatch( batch, maxRows );
+
+  // the provider features are returned unchanged, let the provider fill the batch
+  const int rows = mProviderIterator.nextBatch( batch, maxRows );
+  if ( rows < maxRows )
+    close();
+  return rows;
+}
+
 bool QgsVectorLayerFeatureIterator::postProcessFeature( QgsFeature &feature )
 {
   bool result = checkGeometryValidity( feature );
@@ -940,6 +1023,24 @@ void QgsVectorLayerFeatureIterator::addJoinedAttributes( QgsFeature &f )
     if ( !targetFieldValue.isValid() )
       continue;
 
+    if ( !targetFieldValue.isNull() )
+    {
+      // joined attributes already fetched along with the current batch of features?
+      QHash< const QgsVectorLayerJoinInfo *, QHash< QString, QgsAttributes > >::const_iterator batchIt = mJoinBatchAttributes.constFind( joinIt->joinInfo );
+      if ( batchIt != mJoinBatchAttributes.constEnd() )
+      {
+        QHash< QString, QgsAttributes >::const_iterator valueIt = batchIt->constFind( targetFieldValue.toString() );
+        if ( valueIt != batchIt->constEnd() )
+        {
+          int index = joinIt->indexOffset;
+          const QgsAttributes &joinedAttributes = valueIt.value();
+          for ( int i = 0; i < joinedAttributes.count(); ++i )
+            f.setAttribute( index++, joinedAttributes.at( i ) );
+          continue;
+        }
+      }
+    }
+
     const QHash< QString, QgsAttributes> &memoryCache = joinIt->joinInfo->cachedAttributes;
     if ( memoryCache.isEmpty() )
       joinIt->addJoinedAttributesDirect( f, targetFieldValue );
@@ -1020,6 +1121,31 @@ bool QgsVectorLayerFeatureIterator::providerCanSimplify( QgsSimplifyMethod::Meth
 }
 
 
+//! Returns the attributes of the joined feature with attributes \a attr which are added to the target feature
+static QgsAttributes joinedAttributesFromFeature( const QgsVectorLayerFeatureIterator::FetchJoinInfo &info, const QgsAttributes &attr, const QVector<int> &subsetIndices )
+{
+  QgsAttributes joinedAttributes;
+  if ( info.joinInfo->hasSubset() )
+  {
+    joinedAttributes.reserve( subsetIndices.count() );
+    for ( int i = 0; i < subsetIndices.count(); ++i )
+      joinedAttributes << attr.at( subsetIndices.at( i ) );
+  }
+  else
+  {
+    // use all fields except for the one used for join (has same value as exiting field in target layer)
+    joinedAttributes.reserve( attr.count() );
+    for ( int i = 0; i < attr.count(); ++i )
+    {
+      if ( i == info.joinField )
+        continue;
+
+      joinedAttributes << attr.at( i );
+    }
+  }
+  return joinedAttributes;
+}
+
 void QgsVectorLayerFeatureIterator::FetchJoinInfo::addJoinedAttributesCached( QgsFeature &f, const QVariant &joinValue ) const
 {
   const QHash<QString, QgsAttributes> &memoryCache = joinInfo->cachedAttributes;
@@ -1098,27 +1224,159 @@ void QgsVectorLayerFeatureIterator::FetchJoinInfo::addJoinedAttributesDirect( Qg
   if ( fi.nextFeature( fet ) )
   {
     int index = indexOffset;
-    QgsAttributes attr = fet.attributes();
-    if ( joinInfo->hasSubset() )
+    const QgsAttributes joinedAttributes = joinedAttributesFromFeature( *this, fet.attributes(), subsetIndices );
+    for ( int i = 0; i < joinedAttributes.count(); ++i )
+      f.setAttribute( index++, joinedAttributes.at( i ) );
+  }
+  else
+  {
+    // no suitable join feature found, keeping empty (null) attributes
+  }
+}
+
+bool QgsVectorLayerFeatureIterator::fetchNextProviderFeature( QgsFeature &f )
+{
+  if ( mBatchedJoinInfoList.isEmpty() )
+  {
+    while ( mProviderIterator.nextFeature( f ) )
     {
-      for ( int i = 0; i < subsetIndices.count(); ++i )
-        f.setAttribute( index++, attr.at( subsetIndices.at( i ) ) );
+      if ( mFetchConsidered.contains( f.id() ) )
+        continue;
+
+      // TODO[MD]: just one resize of attributes
+      f.setFields( mSource->mFields );
+
+      // update attributes
+      if ( mSource->mHasEditBuffer )
+        updateChangedAttributes( f );
+
+      return true;
     }
-    else
+    return false;
+  }
+
+  if ( mJoinBatchFeatures.isEmpty() )
+  {
+    // read ahead a batch of features, so that their joined attributes can be fetched at once
+    mJoinBatchAttributes.clear();
+    if ( mProviderIteratorAtEnd )
+      return false;
+
+    // with a filter evaluated after the joins, the number of provider features needed for the limit is unknown
+    const long limit = mFilterJoinBatch ? mRequest.limit() : mProviderRequest.limit();
+    const long batchSize = limit > 0 ? std::min( limit, static_cast< long >( JOIN_BATCH_SIZE ) ) : JOIN_BATCH_SIZE;
+    QgsFeature fet;
+    while ( mJoinBatchFeatures.size() < batchSize )
     {
-      // use all fields except for the one used for join (has same value as exiting field in target layer)
-      for ( int i = 0; i < attr.count(); ++i )
+      if ( !mProviderIterator.nextFeature( fet ) )
       {
-        if ( i == joinField )
-          continue;
+        mProviderIteratorAtEnd = true;
+        break;
+      }
+
+      if ( mFetchConsidered.contains( fet.id() ) )
+        continue;
 
-        f.setAttribute( index++, attr.at( i ) );
+      fet.setFields( mSource->mFields );
+      if ( mSource->mHasEditBuffer )
+        updateChangedAttributes( fet );
+
+      if ( mFilterJoinBatch )
+      {
+        mRequest.expressionContext()->setFeature( fet );
+        if ( !mRequest.filterExpression()->evaluate( mRequest.expressionContext() ).toBool() )
+          continue;
       }
+
+      mJoinBatchFeatures.enqueue( fet );
     }
+
+    if ( mJoinBatchFeatures.isEmpty() )
+      return false;
+
+    fetchJoinBatch();
   }
-  else
+
+  f = mJoinBatchFeatures.dequeue();
+  return true;
+}
+
+void QgsVectorLayerFeatureIterator::fetchJoinBatch()
+{
+  for ( const FetchJoinInfo &info : qgis::as_const( mBatchedJoinInfoList ) )
   {
-    // no suitable join feature found, keeping empty (null) attributes
+    QHash< QString, QgsAttributes > &joinedAttributes = mJoinBatchAttributes[ info.joinInfo ];
+
+    // the join layer compares the join values converted to the join field type, so
+    // the joined features are matched by the converted values
+    const QgsField joinField = info.joinLayer->fields().at( info.joinField );
+    QHash< QString, QStringList > targetKeys;
+
+    // collect the distinct join values of the batch. NULL values are left to the per feature request,
+    // as they can't be part of an IN list, as are values which can't be converted to the join field type
+    QStringList values;
+    for ( const QgsFeature &feature : qgis::as_const( mJoinBatchFeatures ) )
+    {
+      const QVariant targetFieldValue = feature.attribute( info.targetField );
+      if ( targetFieldValue.isNull() )
+        continue;
+
+      const QString key = targetFieldValue.toString();
+      if ( joinedAttributes.contains( key ) )
+        continue;
+
+      QVariant joinValue = targetFieldValue;
+      if ( !joinField.convertCompatible( joinValue ) || joinValue.isNull() )
+        continue;
+
+      // join values without a suitable join feature keep empty (null) attributes
+      joinedAttributes.insert( key, QgsAttributes() );
+      QStringList &keys = targetKeys[ joinValue.toString() ];
+      if ( keys.isEmpty() )
+        values << QgsExpression::quotedValue( joinValue );
+      keys << key;
+    }
+
+    if ( values.isEmpty() || !info.joinLayer->hasFeatures() )
+      continue;
+
+    // maybe user requested just a subset of layer's attributes
+    // so we do not have to fetch everything
+    QVector<int> subsetIndices;
+    if ( info.joinInfo->hasSubset() )
+    {
+      const QStringList subsetNames = QgsVectorLayerJoinInfo::joinFieldNamesSubset( *info.joinInfo );
+      subsetIndices = QgsVectorLayerJoinBuffer::joinSubsetIndices( info.joinLayer, subsetNames );
+    }
+
+    QgsAttributeList attributes = info.attributes;
+    if ( !attributes.contains( info.joinField ) )
+      attributes << info.joinField;
+
+    // select (no geometry) all join features matching one of the values in a single request
+    QgsFeatureRequest request;
+    request.setFlags( QgsFeatureRequest::NoGeometry );
+    request.setSubsetOfAttributes( attributes );
+    request.setFilterExpression( QStringLiteral( "%1 IN (%2)" ).arg( QgsExpression::quotedColumnRef( info.joinInfo->joinFieldName() ),
+                                 values.join( ',' ) ) );
+    QgsFeatureIterator fi = info.joinLayer->getFeatures( request );
+
+    QgsFeature fet;
+    while ( fi.nextFeature( fet ) )
+    {
+      QVariant joinValue = fet.attribute( info.joinField );
+      joinField.convertCompatible( joinValue );
+      const QStringList keys = targetKeys.value( joinValue.toString() );
+      for ( const QString &key : keys )
+      {
+        QHash< QString, QgsAttributes >::iterator it = joinedAttributes.find( key );
+        // like the per feature request, the first matching join feature wins
+        if ( it == joinedAttributes.end() || !it->isEmpty() )
+          continue;
+
+        *it = joinedAttributesFromFeature( info, fet.attributes(), subsetIndices );
+      }
+    }
   }
 }
 
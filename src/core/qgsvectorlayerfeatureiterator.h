@@ -24,6 +24,7 @@
 #include "qgsexpressioncontextscopegenerator.h"
 
 #include <QPointer>
+#include <QQueue>
 #include <QSet>
 #include <memory>
 
@@ -162,6 +163,12 @@ class CORE_EXPORT QgsVectorLayerFeatureIterator : public QgsAbstractFeatureItera
      */
     bool nextFeatureFilterExpression( QgsFeature &f ) override { return fetchFeature( f ); }
 
+    /**
+     * Hands the batch over to the provider iterator when the features need no edit buffer,
+     * join, expression field, geometry check or reprojection processing.
+     */
+    int fetchBatch( QgsFeatureBatch &batch, int maxRows ) override;
+
     //! Setup the simplification of geometries to fetch using the specified simplify method
     bool prepareSimplification( const QgsSimplifyMethod &simplifyMethod ) override;
 
@@ -269,6 +276,34 @@ class CORE_EXPORT QgsVectorLayerFeatureIterator : public QgsAbstractFeatureItera
     //! Join list sorted by dependency
     QList< FetchJoinInfo > mOrderedJoinInfoList;
 
+    //! Joins without memory cache whose attributes are fetched for a whole batch of features at once
+    QList< FetchJoinInfo > mBatchedJoinInfoList;
+
+    //! Provider features read ahead to fetch their joined attributes in a single request
+    QQueue< QgsFeature > mJoinBatchFeatures;
+
+    /**
+     * Joined attributes of the current batch of features, by join and join value.
+     * Join values without matching feature map to empty attributes.
+     */
+    QHash< const QgsVectorLayerJoinInfo *, QHash< QString, QgsAttributes > > mJoinBatchAttributes;
+
+    //! TRUE if the provider features were all read ahead for batched joins
+    bool mProviderIteratorAtEnd = false;
+
+    //! TRUE if the filter expression is evaluated while reading ahead features for batched joins
+    bool mFilterJoinBatch = false;
+
+    /**
+     * Fetches the next feature from the provider iterator which was not already considered from
+     * the edit buffer, with its changed attributes applied. If there are batched joins, features
+     * are read ahead from the provider and their joined attributes fetched in a single request.
+     */
+    bool fetchNextProviderFeature( QgsFeature &f );
+
+    //! Fetches the joined attributes of the features in mJoinBatchFeatures for all batched joins
+    void fetchJoinBatch();
+
     /**
      * Will always return TRUE. We assume that ordering has been done on provider level already.
      *
@@ -646,13 +646,67 @@ void ProjectorData::calcCP( int row, int col, const QgsCoordinateTransform &ct )
   }
 }
 
+void ProjectorData::calcCPs( const QVector< QPair< int, int > > &cells, const QgsCoordinateTransform &ct )
+{
+  if ( !ct.isValid() )
+  {
+    for ( const QPair< int, int > &cell : cells )
+    {
+      mCPLegalMatrix[cell.first][cell.second] = false;
+    }
+    return;
+  }
+
+  const int count = cells.count();
+  QVector< double > x( count );
+  QVector< double > y( count );
+  QVector< double > z( count );
+  for ( int i = 0; i < count; i++ )
+  {
+    destPointOnCPMatrix( cells.at( i ).first, cells.at( i ).second, &x[i], &y[i] );
+  }
+
+  try
+  {
+    ct.transformInPlace( x, y, z );
+  }
+  catch ( QgsCsException & )
+  {
+    // find out which points failed
+    for ( const QPair< int, int > &cell : cells )
+    {
+      calcCP( cell.first, cell.second, ct );
+    }
+    return;
+  }
+
+  for ( int i = 0; i < count; i++ )
+  {
+    const int row = cells.at( i ).first;
+    const int col = cells.at( i ).second;
+    if ( std::isfinite( x.at( i ) ) && std::isfinite( y.at( i ) ) )
+    {
+      mCPMatrix[row][col] = QgsPointXY( x.at( i ), y.at( i ) );
+      mCPLegalMatrix[row][col] = true;
+    }
+    else
+    {
+      // failures are only reported when transforming single points
+      calcCP( row, col, ct );
+    }
+  }
+}
+
 bool ProjectorData::calcRow( int row, const QgsCoordinateTransform &ct )
 {
   QgsDebugMsgLevel( QStringLiteral( "theRow = %1" ).arg( row ), 3 );
+  QVector< QPair< int, int > > cells;
+  cells.reserve( mCPCols );
   for ( int i = 0; i < mCPCols; i++ )
   {
-    calcCP( row, i, ct );
+    cells << qMakePair( row, i );
   }
+  calcCPs( cells, ct );
 
   return true;
 }
@@ -660,10 +714,13 @@ bool ProjectorData::calcRow( int row, const QgsCoordinateTransform &ct )
 bool ProjectorData::calcCol( int col, const QgsCoordinateTransform &ct )
 {
   QgsDebugMsgLevel( QStringLiteral( "theCol = %1" ).arg( col ), 3 );
+  QVector< QPair< int, int > > cells;
+  cells.reserve( mCPRows );
   for ( int i = 0; i < mCPRows; i++ )
   {
-    calcCP( i, col, ct );
+    cells << qMakePair( i, col );
   }
+  calcCPs( cells, ct );
 
   return true;
 }
@@ -182,6 +182,9 @@ class ProjectorData
     //! Calculate single control point in current matrix
     void calcCP( int row, int col, const QgsCoordinateTransform &ct );
 
+    //! Calculate the control points at the given (row, column) \a cells of current matrix with a single transform
+    void calcCPs( const QVector< QPair< int, int > > &cells, const QgsCoordinateTransform &ct );
+
     //! \brief calculate matrix row
     bool calcRow( int row, const QgsCoordinateTransform &ct );
 
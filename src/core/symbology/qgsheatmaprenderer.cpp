@@ -31,6 +31,15 @@
 
 #include <QDomDocument>
 #include <QDomElement>
+#include <QtConcurrentMap>
+#include <algorithm>
+#include <numeric>
+
+//! Number of points which are buffered before they are added to the heatmap
+static const int MAX_BUFFERED_POINTS = 65536;
+
+//! Number of heatmap rows accumulated by a single task
+static const int ROWS_PER_TASK = 32;
 
 QgsHeatmapRenderer::QgsHeatmapRenderer()
   : QgsFeatureRenderer( QStringLiteral( "heatmapRenderer" ) )
@@ -51,6 +60,28 @@ void QgsHeatmapRenderer::initializeValues( QgsRenderContext &context )
   mFeaturesRendered = 0;
   mRadiusPixels = std::round( context.convertToPainterUnits( mRadius, mRadiusUnit, mRadiusMapUnitScale ) / mRenderQuality );
   mRadiusSquared = mRadiusPixels * mRadiusPixels;
+  mWidth = context.painter()->device()->width() / mRenderQuality;
+  mHeight = context.painter()->device()->height() / mRenderQuality;
+  mBufferedPoints.clear();
+
+  // the kernel only depends on the offset from a point, so calculate it once for all points. A stamp
+  // larger than the heatmap itself would cost more than it saves (and could exhaust memory with large
+  // radii), the kernel is then evaluated for each heatmap pixel covered by a point instead
+  const int diameter = 2 * mRadiusPixels;
+  if ( static_cast< qint64 >( diameter ) * diameter > mValues.size() )
+  {
+    mKernel.clear();
+    return;
+  }
+  mKernel.resize( diameter * diameter );
+  for ( int dy = -mRadiusPixels; dy < mRadiusPixels; ++dy )
+  {
+    for ( int dx = -mRadiusPixels; dx < mRadiusPixels; ++dx )
+    {
+      double distanceSquared = std::pow( dx, 2.0 ) + std::pow( dy, 2.0 );
+      mKernel[( dy + mRadiusPixels ) * diameter + dx + mRadiusPixels ] = distanceSquared > mRadiusSquared ? 0 : quarticKernel( std::sqrt( distanceSquared ), mRadiusPixels );
+    }
+  }
 }
 
 void QgsHeatmapRenderer::startRender( QgsRenderContext &context, const QgsFields &fields )
@@ -127,9 +158,6 @@ bool QgsHeatmapRenderer::renderFeature( const QgsFeature &feature, QgsRenderCont
     }
   }
 
-  int width = context.painter()->device()->width() / mRenderQuality;
-  int height = context.painter()->device()->height() / mRenderQuality;
-
   //transform geometry if required
   QgsGeometry geom = feature.geometry();
   QgsCoordinateTransform xform = context.coordinateTransform();
@@ -147,33 +175,19 @@ bool QgsHeatmapRenderer::renderFeature( const QgsFeature &feature, QgsRenderCont
     QgsPointXY pixel = context.mapToPixel().transform( *pointIt );
     int pointX = pixel.x() / mRenderQuality;
     int pointY = pixel.y() / mRenderQuality;
-    for ( int x = std::max( pointX - mRadiusPixels, 0 ); x < std::min( pointX + mRadiusPixels, width ); ++x )
+    if ( pointX + mRadiusPixels <= 0 || pointX - mRadiusPixels >= mWidth || pointY + mRadiusPixels <= 0 || pointY - mRadiusPixels >= mHeight )
     {
-      if ( context.renderingStopped() )
-        break;
-
-      for ( int y = std::max( pointY - mRadiusPixels, 0 ); y < std::min( pointY + mRadiusPixels, height ); ++y )
-      {
-        int index = y * width + x;
-        if ( index >= mValues.count() )
-        {
-          continue;
-        }
-        double distanceSquared = std::pow( pointX - x, 2.0 ) + std::pow( pointY - y, 2.0 );
-        if ( distanceSquared > mRadiusSquared )
-        {
-          continue;
-        }
-
-        double score = weight * quarticKernel( std::sqrt( distanceSquared ), mRadiusPixels );
-        double value = mValues.at( index ) + score;
-        if ( value > mCalculatedMaxValue )
-        {
-          mCalculatedMaxValue = value;
-        }
-        mValues[ index ] = value;
-      }
+      // kernel is completely outside of the heatmap
+      continue;
     }
+
+    mBufferedPoints.append( BufferedPoint{ pointX, pointY, weight } );
+  }
+
+  // points are added to the heatmap in batches, so that rows of the heatmap can be accumulated in parallel
+  if ( mBufferedPoints.size() >= MAX_BUFFERED_POINTS )
+  {
+    addBufferedPoints( context );
   }
 
   mFeaturesRendered++;
@@ -188,6 +202,96 @@ bool QgsHeatmapRenderer::renderFeature( const QgsFeature &feature, QgsRenderCont
 }
 
 
+void QgsHeatmapRenderer::addBufferedPoints( QgsRenderContext &context )
+{
+  if ( mBufferedPoints.isEmpty() )
+  {
+    return;
+  }
+  if ( context.renderingStopped() )
+  {
+    mBufferedPoints.clear();
+    return;
+  }
+
+  double *values = mValues.data();
+  const int taskCount = ( mHeight + ROWS_PER_TASK - 1 ) / ROWS_PER_TASK;
+  if ( taskCount < 2 )
+  {
+    for ( const BufferedPoint &point : qgis::as_const( mBufferedPoints ) )
+    {
+      addPointToRows( values, point, 0, mHeight );
+    }
+  }
+  else
+  {
+    // each task adds the points to a block of rows, so that tasks never write the same values
+    // and every value receives the contributions of the points in their original order
+    QVector< QVector< int > > taskPoints( taskCount );
+    for ( int i = 0; i < mBufferedPoints.size(); ++i )
+    {
+      const BufferedPoint &point = mBufferedPoints.at( i );
+      const int firstTask = std::max( point.y - mRadiusPixels, 0 ) / ROWS_PER_TASK;
+      const int lastTask = ( std::min( point.y + mRadiusPixels, mHeight ) - 1 ) / ROWS_PER_TASK;
+      for ( int task = firstTask; task <= lastTask; ++task )
+      {
+        taskPoints[ task ].append( i );
+      }
+    }
+
+    QVector< int > tasks( taskCount );
+    std::iota( tasks.begin(), tasks.end(), 0 );
+    QtConcurrent::blockingMap( tasks, [this, values, &taskPoints]( int task )
+    {
+      const int firstRow = task * ROWS_PER_TASK;
+      const int endRow = std::min( firstRow + ROWS_PER_TASK, mHeight );
+      for ( int index : taskPoints.at( task ) )
+      {
+        addPointToRows( values, mBufferedPoints.at( index ), firstRow, endRow );
+      }
+    } );
+  }
+
+  mBufferedPoints.clear();
+}
+
+void QgsHeatmapRenderer::addPointToRows( double *values, const BufferedPoint &point, int firstRow, int endRow ) const
+{
+  const int diameter = 2 * mRadiusPixels;
+  const int startX = std::max( point.x - mRadiusPixels, 0 );
+  const int columns = std::min( point.x + mRadiusPixels, mWidth ) - startX;
+  const int startY = std::max( point.y - mRadiusPixels, firstRow );
+  const int endY = std::min( point.y + mRadiusPixels, endRow );
+
+  if ( mKernel.isEmpty() )
+  {
+    for ( int y = startY; y < endY; ++y )
+    {
+      double *row = values + y * mWidth + startX;
+      const int dy = y - point.y;
+      for ( int column = 0; column < columns; ++column )
+      {
+        const int dx = startX + column - point.x;
+        const double distanceSquared = std::pow( dx, 2.0 ) + std::pow( dy, 2.0 );
+        if ( distanceSquared <= mRadiusSquared )
+          row[ column ] += point.weight * quarticKernel( std::sqrt( distanceSquared ), mRadiusPixels );
+      }
+    }
+    return;
+  }
+
+  for ( int y = startY; y < endY; ++y )
+  {
+    // plain loop over contiguous values and kernel values, which compilers can vectorize
+    double *row = values + y * mWidth + startX;
+    const double *kernelRow = mKernel.constData() + ( y - point.y + mRadiusPixels ) * diameter + startX - point.x + mRadiusPixels;
+    for ( int column = 0; column < columns; ++column )
+    {
+      row[ column ] += point.weight * kernelRow[ column ];
+    }
+  }
+}
+
 double QgsHeatmapRenderer::uniformKernel( const double distance, const int bandwidth ) const
 {
   Q_UNUSED( distance )
@@ -219,6 +323,12 @@ void QgsHeatmapRenderer::stopRender( QgsRenderContext &context )
 {
   QgsFeatureRenderer::stopRender( context );
 
+  addBufferedPoints( context );
+  if ( !mValues.isEmpty() )
+  {
+    mCalculatedMaxValue = std::max( mCalculatedMaxValue, *std::max_element( mValues.constBegin(), mValues.constEnd() ) );
+  }
+
   renderImage( context );
   mWeightExpression.reset();
 }
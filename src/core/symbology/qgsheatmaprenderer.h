@@ -202,6 +202,25 @@ class CORE_EXPORT QgsHeatmapRenderer : public QgsFeatureRenderer
 
     int mFeaturesRendered = 0;
 
+    //! Size of the heatmap, in heatmap pixels
+    int mWidth = 0;
+    int mHeight = 0;
+
+    /**
+     * Kernel values for all pixel offsets covered by a point, in rows of mRadiusPixels * 2 values. Empty
+     * if the radius is too large compared to the heatmap, in which case kernel values are calculated per pixel.
+     */
+    QVector<double> mKernel;
+
+    //! A point which has not been added to the heatmap yet, in heatmap pixels
+    struct BufferedPoint
+    {
+      int x;
+      int y;
+      double weight;
+    };
+    QVector<BufferedPoint> mBufferedPoints;
+
     double uniformKernel( double distance, int bandwidth ) const;
     double quarticKernel( double distance, int bandwidth ) const;
     double triweightKernel( double distance, int bandwidth ) const;
@@ -210,7 +229,11 @@ class CORE_EXPORT QgsHeatmapRenderer : public QgsFeatureRenderer
 
     QgsMultiPointXY convertToMultipoint( const QgsGeometry *geom );
     void initializeValues( QgsRenderContext &context );
+    void addBufferedPoints( QgsRenderContext &context );
+    void addPointToRows( double *values, const BufferedPoint &point, int firstRow, int endRow ) const;
     void renderImage( QgsRenderContext &context );
+
+    friend class TestQgsHeatmapRenderer;
 };
 
 
@@ -0,0 +1,131 @@
+/***************************************************************************
+                         qgsmarkerstampcache.cpp
+                         -----------------------
+    begin                : November 2020
+    copyright            : (C) 2020 by the QGIS project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsmarkerstampcache.h"
+#include "qgis.h"
+
+#include <QPaintDevice>
+#include <QPainter>
+#include <cmath>
+#include <memory>
+
+bool QgsMarkerStampCache::Key::operator==( const QgsMarkerStampCache::Key &other ) const
+{
+  return shape == other.shape
+         && width == other.width
+         && height == other.height
+         && fillColor == other.fillColor
+         && strokeColor == other.strokeColor
+         && strokeWidth == other.strokeWidth
+         && strokeStyle == other.strokeStyle
+         && joinStyle == other.joinStyle
+         && capStyle == other.capStyle
+         && opacity == other.opacity
+         && selected == other.selected
+         && name == other.name;
+}
+
+QgsMarkerStampCache::QgsMarkerStampCache( int maxBytes )
+  : mStamps( maxBytes )
+{
+}
+
+bool QgsMarkerStampCache::canDrawStamps( const QPainter *painter )
+{
+  // blitting only pays off (and only looks right) for raster output without scaling. High DPI
+  // images scale the painter by their device pixel ratio, stamps would be drawn blurred
+  return painter && painter->device() && painter->device()->devType() == QInternal::Image
+         && qgsDoubleNear( painter->device()->devicePixelRatioF(), 1.0 )
+         && painter->transform().type() <= QTransform::TxTranslate;
+}
+
+bool QgsMarkerStampCache::drawMarker( QPainter *painter, QPointF point, double angle, const QgsMarkerStampCache::Key &key,
+                                      const QRectF &bounds, const std::function<void ( QPainter * )> &render )
+{
+  if ( !canDrawStamps( painter ) || !std::isfinite( point.x() ) || !std::isfinite( point.y() ) || !std::isfinite( angle ) )
+    return false;
+
+  // round the device position of the anchor to subpixel steps, so that stamps can be
+  // drawn at whole pixels
+  const QPointF translation( painter->transform().dx(), painter->transform().dy() );
+  const QPointF device = point + translation;
+  const double stepsX = std::round( device.x() * SUBPIXEL_STEPS );
+  const double stepsY = std::round( device.y() * SUBPIXEL_STEPS );
+  const double pixelX = std::floor( stepsX / SUBPIXEL_STEPS );
+  const double pixelY = std::floor( stepsY / SUBPIXEL_STEPS );
+
+  StampKey stampKey;
+  stampKey.key = key;
+  stampKey.subpixelX = static_cast< int >( stepsX - pixelX * SUBPIXEL_STEPS );
+  stampKey.subpixelY = static_cast< int >( stepsY - pixelY * SUBPIXEL_STEPS );
+  stampKey.angle = static_cast< int >( std::round( std::fmod( angle, 360.0 ) / 360.0 * ROTATION_STEPS ) ) % ROTATION_STEPS;
+  if ( stampKey.angle < 0 )
+    stampKey.angle += ROTATION_STEPS;
+
+  Stamp *stamp = mStamps.object( stampKey );
+  if ( !stamp )
+  {
+    const double stampAngle = stampKey.angle * 360.0 / ROTATION_STEPS;
+    const QPointF subpixel( static_cast< double >( stampKey.subpixelX ) / SUBPIXEL_STEPS,
+                            static_cast< double >( stampKey.subpixelY ) / SUBPIXEL_STEPS );
+
+    // leave a pixel around the marker for antialiasing
+    QTransform rotation;
+    rotation.rotate( stampAngle );
+    const QRectF area = rotation.mapRect( bounds ).translated( subpixel ).adjusted( -1, -1, 1, 1 );
+    const QPoint topLeft( static_cast< int >( std::floor( area.left() ) ), static_cast< int >( std::floor( area.top() ) ) );
+    const QSize size( static_cast< int >( std::ceil( area.right() ) ) - topLeft.x(), static_cast< int >( std::ceil( area.bottom() ) ) - topLeft.y() );
+    if ( size.width() <= 0 || size.height() <= 0 || size.width() > MAXIMUM_STAMP_SIZE || size.height() > MAXIMUM_STAMP_SIZE )
+      return false;
+
+    std::unique_ptr< Stamp > newStamp = qgis::make_unique< Stamp >();
+    newStamp->origin = topLeft;
+    newStamp->image = QImage( size, QImage::Format_ARGB32_Premultiplied );
+    newStamp->image.fill( Qt::transparent );
+    // match the resolution of the destination, for markers which depend on it (e.g. pictures)
+    const QImage *destination = static_cast< const QImage * >( painter->device() );
+    newStamp->image.setDotsPerMeterX( destination->dotsPerMeterX() );
+    newStamp->image.setDotsPerMeterY( destination->dotsPerMeterY() );
+
+    QPainter stampPainter( &newStamp->image );
+    stampPainter.setRenderHints( painter->renderHints() );
+    stampPainter.translate( subpixel - topLeft );
+    stampPainter.rotate( stampAngle );
+    render( &stampPainter );
+    stampPainter.end();
+
+    stamp = newStamp.get();
+    const int cost = newStamp->image.bytesPerLine() * newStamp->image.height();
+    if ( !mStamps.insert( stampKey, newStamp.release(), cost ) )
+    {
+      // too large for the cache, it has been deleted already
+      return false;
+    }
+  }
+
+  painter->drawImage( QPointF( pixelX + stamp->origin.x(), pixelY + stamp->origin.y() ) - translation, stamp->image );
+  return true;
+}
+
+void QgsMarkerStampCache::clear()
+{
+  mStamps.clear();
+}
+
+int QgsMarkerStampCache::count() const
+{
+  return mStamps.count();
+}
@@ -0,0 +1,180 @@
+/***************************************************************************
+                         qgsmarkerstampcache.h
+                         ---------------------
+    begin                : November 2020
+    copyright            : (C) 2020 by the QGIS project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSMARKERSTAMPCACHE_H
+#define QGSMARKERSTAMPCACHE_H
+
+#define SIP_NO_FILE
+
+#include "qgis_core.h"
+
+#include <QCache>
+#include <QColor>
+#include <QHash>
+#include <QImage>
+#include <QPoint>
+#include <QRectF>
+#include <QString>
+#include <functional>
+
+class QPainter;
+
+/**
+ * \ingroup core
+ * \class QgsMarkerStampCache
+ * \brief A cache of pre-rasterized marker images ("stamps"), used to draw large numbers
+ * of identical markers by blitting images instead of rendering their vector shapes.
+ *
+ * Each distinct marker variant is rasterized once per quantized rotation and subpixel
+ * offset, so markers drawn through the cache may be shifted by up to half a
+ * subpixel step and rotated by up to half a rotation step compared to markers
+ * drawn directly.
+ *
+ * Stamps are only used when drawing to a QImage through a painter without scaling,
+ * rotation or shearing. In every other case drawMarker() returns FALSE and the caller
+ * must draw the marker itself.
+ *
+ * The cache is not thread safe, each symbol layer keeps its own cache for the
+ * duration of a render and clears it when the render stops.
+ *
+ * \note not available in Python bindings
+ * \since QGIS 3.18
+ */
+class CORE_EXPORT QgsMarkerStampCache
+{
+  public:
+
+    /**
+     * Identifies a marker variant. All markers drawn with equal keys must look
+     * identical, apart from their position and rotation.
+     */
+    struct Key
+    {
+      //! Image path or other name of the marker
+      QString name;
+      //! Built-in shape of the marker
+      int shape = 0;
+      //! Marker width, in painter units
+      double width = 0;
+      //! Marker height, in painter units
+      double height = 0;
+      //! Fill color
+      QRgb fillColor = 0;
+      //! Stroke color
+      QRgb strokeColor = 0;
+      //! Stroke width, in painter units
+      double strokeWidth = 0;
+      //! Stroke pen style
+      int strokeStyle = 0;
+      //! Stroke join style
+      int joinStyle = 0;
+      //! Stroke cap style
+      int capStyle = 0;
+      //! Marker opacity
+      double opacity = 1.0;
+      //! TRUE for markers of selected features
+      bool selected = false;
+
+      bool operator==( const QgsMarkerStampCache::Key &other ) const;
+    };
+
+    //! Number of steps per pixel to which marker positions are rounded
+    static const int SUBPIXEL_STEPS = 4;
+
+    //! Number of steps per full turn to which marker rotations are rounded
+    static const int ROTATION_STEPS = 360;
+
+    //! Maximum width or height of a stamp, in pixels. Larger markers are drawn directly.
+    static const int MAXIMUM_STAMP_SIZE = 256;
+
+    /**
+     * Constructor for QgsMarkerStampCache, storing at most \a maxBytes bytes of stamp images.
+     */
+    explicit QgsMarkerStampCache( int maxBytes = 16 * 1024 * 1024 );
+
+    /**
+     * Draws the marker identified by \a key on \a painter, with its anchor at \a point
+     * (in painter coordinates) and rotated by \a angle degrees clockwise.
+     *
+     * \a bounds is the area covered by the unrotated marker, relative to its anchor. If
+     * no stamp exists yet for the marker variant, \a render is called to draw the
+     * unrotated marker with its anchor at the origin of the painter it is given, and the
+     * result is kept for the following markers.
+     *
+     * Returns FALSE if the marker cannot be drawn as a stamp, in which case nothing is drawn.
+     */
+    bool drawMarker( QPainter *painter, QPointF point, double angle, const QgsMarkerStampCache::Key &key,
+                     const QRectF &bounds, const std::function< void( QPainter * ) > &render );
+
+    /**
+     * Returns TRUE if markers drawn on \a painter can use stamps, i.e. if it paints on an
+     * image with a device pixel ratio of 1 and is not scaled or rotated.
+     */
+    static bool canDrawStamps( const QPainter *painter );
+
+    /**
+     * Removes all stamps from the cache.
+     */
+    void clear();
+
+    /**
+     * Returns the number of stamps in the cache.
+     */
+    int count() const;
+
+  private:
+
+    struct StampKey
+    {
+      QgsMarkerStampCache::Key key;
+      int angle = 0;
+      int subpixelX = 0;
+      int subpixelY = 0;
+
+      bool operator==( const StampKey &other ) const
+      {
+        return angle == other.angle && subpixelX == other.subpixelX && subpixelY == other.subpixelY && key == other.key;
+      }
+
+      friend uint qHash( const StampKey &key, uint seed = 0 )
+      {
+        uint hash = qHash( key.key.name, seed );
+        hash = hash * 31 + qHash( key.key.shape );
+        hash = hash * 31 + qHash( key.key.width );
+        hash = hash * 31 + qHash( key.key.height );
+        hash = hash * 31 + qHash( key.key.fillColor );
+        hash = hash * 31 + qHash( key.key.strokeColor );
+        hash = hash * 31 + qHash( key.key.strokeWidth );
+        hash = hash * 31 + qHash( key.key.strokeStyle );
+        hash = hash * 31 + qHash( key.key.joinStyle );
+        hash = hash * 31 + qHash( key.key.capStyle );
+        hash = hash * 31 + qHash( key.angle );
+        hash = hash * 31 + qHash( key.subpixelX * SUBPIXEL_STEPS + key.subpixelY );
+        return hash;
+      }
+    };
+
+    struct Stamp
+    {
+      QImage image;
+      //! Position of the top left corner of the image, relative to the pixel containing the anchor
+      QPoint origin;
+    };
+
+    QCache< StampKey, Stamp > mStamps;
+};
+
+#endif // QGSMARKERSTAMPCACHE_H
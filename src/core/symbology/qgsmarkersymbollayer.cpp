@@ -874,6 +874,19 @@ void QgsSimpleMarkerSymbolLayer::startRender( QgsSymbolRenderContext &context )
     mCache = QImage();
     mSelCache = QImage();
   }
+
+  // markers which can't use the cached image may still be drawn from rasterized
+  // stamps of each distinct variant, when requested
+  mStampCache.clear();
+  mUsingStamps = !mUsingCache && !context.renderContext().forceVectorOutput()
+                 && context.renderContext().testFlag( QgsRenderContext::RasterizeMarkerStamps );
+}
+
+void QgsSimpleMarkerSymbolLayer::stopRender( QgsSymbolRenderContext &context )
+{
+  QgsSimpleMarkerSymbolLayerBase::stopRender( context );
+  // stamps are only valid for a single render, don't keep them around with the layer
+  mStampCache.clear();
 }
 
 
@@ -949,17 +962,8 @@ bool QgsSimpleMarkerSymbolLayer::prepareCache( QgsSymbolRenderContext &context )
   return true;
 }
 
-void QgsSimpleMarkerSymbolLayer::draw( QgsSymbolRenderContext &context, QgsSimpleMarkerSymbolLayerBase::Shape shape, const QPolygonF &polygon, const QPainterPath &path )
+void QgsSimpleMarkerSymbolLayer::applyDataDefinedStyle( QgsSymbolRenderContext &context )
 {
-  //making changes here? Don't forget to also update ::bounds if the changes affect the bounding box
-  //of the rendered point!
-
-  QPainter *p = context.renderContext().painter();
-  if ( !p )
-  {
-    return;
-  }
-
   bool ok = true;
   if ( mDataDefinedProperties.isActive( QgsSymbolLayer::PropertyFillColor ) )
   {
@@ -1008,6 +1012,108 @@ void QgsSimpleMarkerSymbolLayer::draw( QgsSymbolRenderContext &context, QgsSimpl
       mSelPen.setJoinStyle( QgsSymbolLayerUtils::decodePenJoinStyle( style ) );
     }
   }
+}
+
+bool QgsSimpleMarkerSymbolLayer::renderPointUsingStamp( QPointF point, QgsSymbolRenderContext &context )
+{
+  QPainter *p = context.renderContext().painter();
+  if ( !QgsMarkerStampCache::canDrawStamps( p ) )
+    return false;
+
+  bool hasDataDefinedSize = false;
+  double scaledSize = calculateSize( context, hasDataDefinedSize );
+
+  bool hasDataDefinedRotation = false;
+  QPointF offset;
+  double angle = 0;
+  calculateOffsetAndRotation( context, scaledSize, hasDataDefinedRotation, offset, angle );
+
+  Shape shape = mShape;
+  bool shapeChanged = false;
+  if ( mDataDefinedProperties.isActive( QgsSymbolLayer::PropertyName ) )
+  {
+    context.setOriginalValueVariable( encodeShape( shape ) );
+    QVariant exprVal = mDataDefinedProperties.value( QgsSymbolLayer::PropertyName, context.renderContext().expressionContext() );
+    if ( exprVal.isValid() )
+    {
+      bool ok = true;
+      Shape decoded = decodeShape( exprVal.toString(), &ok );
+      if ( ok )
+      {
+        shape = decoded;
+        shapeChanged = true;
+      }
+    }
+  }
+
+  double size = context.renderContext().convertToPainterUnits( scaledSize, mSizeUnit, mSizeMapUnitScale );
+  if ( mSizeUnit == QgsUnitTypes::RenderMetersInMapUnits && context.renderContext().flags() & QgsRenderContext::RenderSymbolPreview )
+  {
+    // rendering for symbol previews -- a size in meters in map units can't be calculated, so treat the size as millimeters
+    // and clamp it to a reasonable range. It's the best we can do in this situation!
+    size = std::min( std::max( context.renderContext().convertToPainterUnits( mSize, QgsUnitTypes::RenderMillimeters ), 3.0 ), 100.0 );
+  }
+
+  // same rotation as QgsSimpleMarkerSymbolLayerBase::renderPoint, where a fixed rotation is applied in startRender()
+  const double rotation = hasDataDefinedRotation || shapeChanged ? angle : mAngle;
+
+  applyDataDefinedStyle( context );
+
+  const bool filled = shapeIsFilled( shape );
+  const QBrush brush = filled ? ( context.selected() ? mSelBrush : mBrush ) : QBrush( Qt::NoBrush );
+  const QPen pen = context.selected() ? mSelPen : mPen;
+
+  QgsMarkerStampCache::Key key;
+  key.shape = shape;
+  key.width = size;
+  key.height = size;
+  key.fillColor = filled ? brush.color().rgba() : 0;
+  key.strokeColor = pen.color().rgba();
+  key.strokeWidth = pen.widthF();
+  key.strokeStyle = pen.style();
+  key.joinStyle = pen.joinStyle();
+  key.capStyle = pen.capStyle();
+  key.selected = context.selected();
+
+  // leave room for the stroke, including mitered corners
+  const double extent = size / 2.0 + std::max( pen.widthF(), 1.0 );
+  const QRectF bounds( -extent, -extent, 2 * extent, 2 * extent );
+
+  return mStampCache.drawMarker( p, point + offset, rotation, key, bounds, [this, shape, size, &brush, &pen]( QPainter * painter )
+  {
+    painter->setBrush( brush );
+    painter->setPen( pen );
+
+    QTransform transform;
+    transform.scale( size / 2.0, size / 2.0 );
+    QPolygonF polygon;
+    if ( shapeToPolygon( shape, polygon ) )
+    {
+      painter->drawPolygon( transform.map( polygon ) );
+    }
+    else
+    {
+      // mPath holds the shape prepared for direct rendering, don't disturb it
+      const QPainterPath preparedPath = mPath;
+      prepareMarkerPath( shape );
+      painter->drawPath( transform.map( mPath ) );
+      mPath = preparedPath;
+    }
+  } );
+}
+
+void QgsSimpleMarkerSymbolLayer::draw( QgsSymbolRenderContext &context, QgsSimpleMarkerSymbolLayerBase::Shape shape, const QPolygonF &polygon, const QPainterPath &path )
+{
+  //making changes here? Don't forget to also update ::bounds if the changes affect the bounding box
+  //of the rendered point!
+
+  QPainter *p = context.renderContext().painter();
+  if ( !p )
+  {
+    return;
+  }
+
+  applyDataDefinedStyle( context );
 
   if ( shapeIsFilled( shape ) )
   {
@@ -1053,7 +1159,7 @@ void QgsSimpleMarkerSymbolLayer::renderPoint( QPointF point, QgsSymbolRenderCont
                           point.y() - s / 2.0 + offset.y(),
                           s, s ), img );
   }
-  else
+  else if ( !mUsingStamps || !renderPointUsingStamp( point, context ) )
   {
     QgsSimpleMarkerSymbolLayerBase::renderPoint( point, context );
   }
@@ -1950,12 +2056,17 @@ QString QgsSvgMarkerSymbolLayer::layerType() const
 void QgsSvgMarkerSymbolLayer::startRender( QgsSymbolRenderContext &context )
 {
   QgsMarkerSymbolLayer::startRender( context ); // get anchor point expressions
-  Q_UNUSED( context )
+
+  mStampCache.clear();
+  mUsingStamps = !context.renderContext().forceVectorOutput()
+                 && context.renderContext().testFlag( QgsRenderContext::RasterizeMarkerStamps );
 }
 
 void QgsSvgMarkerSymbolLayer::stopRender( QgsSymbolRenderContext &context )
 {
   Q_UNUSED( context )
+  // stamps are only valid for a single render, don't keep them around with the layer
+  mStampCache.clear();
 }
 
 void QgsSvgMarkerSymbolLayer::renderPoint( QPointF point, QgsSymbolRenderContext &context )
@@ -2026,6 +2137,55 @@ void QgsSvgMarkerSymbolLayer::renderPoint( QPointF point, QgsSymbolRenderContext
   double angle = 0.0;
   calculateOffsetAndRotation( context, scaledWidth, scaledHeight, outputOffset, angle );
 
+  bool rasterizeSelected = !mHasFillParam || mDataDefinedProperties.isActive( QgsSymbolLayer::PropertyName );
+
+  if ( mUsingStamps && QgsMarkerStampCache::canDrawStamps( p ) )
+  {
+    QgsMarkerStampCache::Key key;
+    key.name = path;
+    key.width = width;
+    key.height = context.renderContext().convertToPainterUnits( scaledHeight, mSizeUnit, mSizeMapUnitScale );
+    key.fillColor = fillColor.rgba();
+    key.strokeColor = strokeColor.rgba();
+    key.strokeWidth = strokeWidth;
+    key.opacity = context.opacity();
+    key.selected = context.selected();
+
+    // leave room for strokes drawn outside of the SVG view box
+    const double extentX = key.width / 2.0 + strokeWidth + 1;
+    const double extentY = key.height / 2.0 + strokeWidth + 1;
+    const QRectF bounds( -extentX, -extentY, 2 * extentX, 2 * extentY );
+
+    const bool drawn = mStampCache.drawMarker( p, point + outputOffset, angle, key, bounds, [ & ]( QPainter * painter )
+    {
+      painter->setOpacity( context.opacity() );
+      if ( context.selected() && rasterizeSelected )
+      {
+        bool fitsInCache = true;
+        QImage img = QgsApplication::svgCache()->svgAsImage( path, width, fillColor, strokeColor, strokeWidth,
+                     context.renderContext().scaleFactor(), fitsInCache, aspectRatio,
+                     ( context.renderContext().flags() & QgsRenderContext::RenderBlocking ) );
+        if ( fitsInCache && img.width() > 1 )
+        {
+          QgsImageOperation::adjustHueSaturation( img, 1.0, context.renderContext().selectionColor(), 1.0 );
+          painter->drawImage( -img.width() / 2.0, -img.height() / 2.0, img );
+          return;
+        }
+      }
+
+      QPicture pct = QgsApplication::svgCache()->svgAsPicture( path, width, fillColor, strokeColor, strokeWidth,
+                     context.renderContext().scaleFactor(), false, aspectRatio,
+                     ( context.renderContext().flags() & QgsRenderContext::RenderBlocking ) );
+      if ( pct.width() > 1 )
+      {
+        _fixQPictureDPI( painter );
+        painter->drawPicture( 0, 0, pct );
+      }
+    } );
+    if ( drawn )
+      return;
+  }
+
   p->translate( point + outputOffset );
 
   bool rotated = !qgsDoubleNear( angle, 0 );
@@ -2034,7 +2194,6 @@ void QgsSvgMarkerSymbolLayer::renderPoint( QPointF point, QgsSymbolRenderContext
 
   bool fitsInCache = true;
   bool usePict = true;
-  bool rasterizeSelected = !mHasFillParam || mDataDefinedProperties.isActive( QgsSymbolLayer::PropertyName );
   if ( ( !context.renderContext().forceVectorOutput() && !rotated ) || ( context.selected() && rasterizeSelected ) )
   {
     QImage img = QgsApplication::svgCache()->svgAsImage( path, width, fillColor, strokeColor, strokeWidth,
@@ -19,6 +19,7 @@
 #include "qgis_core.h"
 #include "qgis_sip.h"
 #include "qgssymbollayer.h"
+#include "qgsmarkerstampcache.h"
 
 #define DEFAULT_SIMPLEMARKER_NAME         "circle"
 #define DEFAULT_SIMPLEMARKER_COLOR        QColor(255,0,0)
@@ -237,6 +238,7 @@ class CORE_EXPORT QgsSimpleMarkerSymbolLayer : public QgsSimpleMarkerSymbolLayer
 
     QString layerType() const override;
     void startRender( QgsSymbolRenderContext &context ) override;
+    void stopRender( QgsSymbolRenderContext &context ) override;
     void renderPoint( QPointF point, QgsSymbolRenderContext &context ) override;
     QgsStringMap properties() const override;
     QgsSimpleMarkerSymbolLayer *clone() const override SIP_FACTORY;
@@ -414,6 +416,21 @@ class CORE_EXPORT QgsSimpleMarkerSymbolLayer : public QgsSimpleMarkerSymbolLayer
   private:
 
     void draw( QgsSymbolRenderContext &context, QgsSimpleMarkerSymbolLayerBase::Shape shape, const QPolygonF &polygon, const QPainterPath &path ) override SIP_FORCE;
+
+    //! Updates the pens and brushes from data defined properties
+    void applyDataDefinedStyle( QgsSymbolRenderContext &context );
+
+    /**
+     * Draws the marker from a rasterized stamp. Returns FALSE if the marker has to be
+     * drawn directly instead.
+     */
+    bool renderPointUsingStamp( QPointF point, QgsSymbolRenderContext &context );
+
+    //! Rasterized marker variants, used when the marker can't be drawn from mCache
+    QgsMarkerStampCache mStampCache;
+
+    //! TRUE if markers are drawn from mStampCache
+    bool mUsingStamps = false;
 };
 
 /**
@@ -635,6 +652,13 @@ class CORE_EXPORT QgsSvgMarkerSymbolLayer : public QgsMarkerSymbolLayer
     double calculateSize( QgsSymbolRenderContext &context, bool &hasDataDefinedSize ) const;
     void calculateOffsetAndRotation( QgsSymbolRenderContext &context, double scaledWidth, double scaledHeight, QPointF &offset, double &angle ) const;
 
+    //! Rasterized marker variants, used when the RasterizeMarkerStamps render flag is set
+    QgsMarkerStampCache mStampCache;
+
+    //! TRUE if markers are drawn from mStampCache
+    bool mUsingStamps = false;
+    friend class TestQgsSvgMarkerSymbol;
+
 };
 
 
@@ -16,6 +16,8 @@
 #include "qgsrulebasedrenderer.h"
 #include "qgssymbollayer.h"
 #include "qgsexpression.h"
+#include "qgsexpressionnodeimpl.h"
+#include "qgsexpressionutils.h"
 #include "qgssymbollayerutils.h"
 #include "qgsrendercontext.h"
 #include "qgsvectorlayer.h"
@@ -34,6 +36,301 @@
 #include <QDomDocument>
 #include <QDomElement>
 #include <QUuid>
+#include <cmath>
+
+///@cond PRIVATE
+
+// minimum number of children filtering on the same field before a lookup by value is used
+static const int MIN_INDEXED_CHILDREN = 4;
+
+// integer lookup keys are limited to values which are exactly representable as doubles,
+// with enough room to tell near equal values apart
+static const double MAX_INTEGER_KEY = 4503599627370496.0; // 2^52
+
+/**
+ * Lookup of the child rules which have to be processed for a feature, built for the
+ * duration of a render.
+ *
+ * Children which were not started for the render (because they are disabled or
+ * outside the current scale range) can never render anything, so they are skipped
+ * altogether unless there are else rules which need to know whether they matched.
+ *
+ * Children whose filter compares a field to literal values ("class" = 'x' or
+ * "class" IN ('x', 'y')), on their own or as part of an AND, are looked up by the
+ * value of that field instead of evaluating each filter in turn.
+ */
+struct QgsRuleBasedRenderer::Rule::ChildRenderIndex
+{
+  enum Condition
+  {
+    NotIndexed, //!< Filter is evaluated for every feature
+    WholeFilter, //!< Filter is fully decided by the lookup
+    PartOfFilter, //!< Lookup decides a condition which is ANDed into the filter, the filter is only evaluated when the condition matches
+  };
+
+  //! Positions in mChildren of the children to process for each feature, in order
+  QVector< int > children;
+
+  //! Condition for each child, by position in mChildren
+  QVector< Condition > conditions;
+
+  //! Returns the value of the indexed field, or nullptr if no children are indexed
+  std::unique_ptr< QgsExpression > key;
+
+  //! Sorted child positions matching each string value
+  QHash< QString, QVector< int > > stringMatches;
+
+  //! Sorted child positions matching each integer value
+  QHash< qlonglong, QVector< int > > integerMatches;
+
+  void build( const Rule *rule, QgsRenderContext &context );
+
+  /**
+   * Looks up the children whose indexed condition matches \a feature. \a matches is
+   * set to nullptr if none match. Returns FALSE if the lookup cannot be used for the
+   * field value, in which case all filters must be evaluated.
+   */
+  bool matchingChildren( const QgsFeature &feature, QgsRenderContext &context, const QVector< int > *&matches ) const;
+};
+
+namespace
+{
+  struct FieldCondition
+  {
+    QString field;
+    QVariantList keys;
+  };
+}
+
+// Converts a literal compared to a field into a lookup key. Only literals which the
+// expression engine compares either by exact string value or as a number against
+// an integer are accepted, so that the lookup gives the same result as evaluating
+// the comparison.
+static QVariant lookupKey( const QVariant &literal )
+{
+  if ( literal.isNull() )
+    return QVariant();
+
+  switch ( literal.type() )
+  {
+    case QVariant::String:
+      // numeric strings compare as numbers or as strings depending on the field value
+      return QgsExpressionUtils::isDoubleSafe( literal ) ? QVariant() : literal;
+
+    case QVariant::Int:
+    case QVariant::UInt:
+    case QVariant::LongLong:
+    {
+      const qlonglong value = literal.toLongLong();
+      if ( std::fabs( static_cast< double >( value ) ) >= MAX_INTEGER_KEY )
+        return QVariant();
+      return value;
+    }
+
+    default:
+      return QVariant();
+  }
+}
+
+static bool fieldCondition( const QgsExpressionNode *node, FieldCondition &condition )
+{
+  condition.keys.clear();
+  switch ( node->nodeType() )
+  {
+    case QgsExpressionNode::ntBinaryOperator:
+    {
+      const QgsExpressionNodeBinaryOperator *op = static_cast< const QgsExpressionNodeBinaryOperator * >( node );
+      if ( op->op() != QgsExpressionNodeBinaryOperator::boEQ )
+        return false;
+
+      const QgsExpressionNode *column = op->opLeft();
+      const QgsExpressionNode *literal = op->opRight();
+      if ( column->nodeType() == QgsExpressionNode::ntLiteral )
+        std::swap( column, literal );
+      if ( column->nodeType() != QgsExpressionNode::ntColumnRef || literal->nodeType() != QgsExpressionNode::ntLiteral )
+        return false;
+
+      const QVariant key = lookupKey( static_cast< const QgsExpressionNodeLiteral * >( literal )->value() );
+      if ( !key.isValid() )
+        return false;
+
+      condition.field = static_cast< const QgsExpressionNodeColumnRef * >( column )->name();
+      condition.keys << key;
+      return true;
+    }
+
+    case QgsExpressionNode::ntInOperator:
+    {
+      const QgsExpressionNodeInOperator *in = static_cast< const QgsExpressionNodeInOperator * >( node );
+      if ( in->isNotIn() || in->node()->nodeType() != QgsExpressionNode::ntColumnRef )
+        return false;
+
+      const QList< QgsExpressionNode * > nodeList = in->list()->list();
+      for ( const QgsExpressionNode *item : nodeList )
+      {
+        if ( item->nodeType() != QgsExpressionNode::ntLiteral )
+          return false;
+        const QVariant key = lookupKey( static_cast< const QgsExpressionNodeLiteral * >( item )->value() );
+        if ( !key.isValid() )
+          return false;
+        condition.keys << key;
+      }
+      condition.field = static_cast< const QgsExpressionNodeColumnRef * >( in->node() )->name();
+      return !condition.keys.isEmpty();
+    }
+
+    default:
+      return false;
+  }
+}
+
+// Collects the field conditions which must all hold for node to be true
+static void collectFieldConditions( const QgsExpressionNode *node, QList< FieldCondition > &conditions )
+{
+  if ( node->nodeType() == QgsExpressionNode::ntBinaryOperator
+       && static_cast< const QgsExpressionNodeBinaryOperator * >( node )->op() == QgsExpressionNodeBinaryOperator::boAnd )
+  {
+    const QgsExpressionNodeBinaryOperator *op = static_cast< const QgsExpressionNodeBinaryOperator * >( node );
+    collectFieldConditions( op->opLeft(), conditions );
+    collectFieldConditions( op->opRight(), conditions );
+    return;
+  }
+
+  FieldCondition condition;
+  if ( fieldCondition( node, condition ) )
+    conditions << condition;
+}
+
+void QgsRuleBasedRenderer::Rule::ChildRenderIndex::build( const Rule *rule, QgsRenderContext &context )
+{
+  const int childCount = rule->mChildren.count();
+  conditions.fill( NotIndexed, childCount );
+
+  // children which were not started can only ever be inactive or filtered out, which
+  // makes a difference to else rules only
+  const bool hasElseRules = !rule->mElseRules.isEmpty();
+  QVector< QList< FieldCondition > > childConditions( childCount );
+  QHash< QString, int > fieldCounts;
+  for ( int position = 0; position < childCount; ++position )
+  {
+    Rule *child = rule->mChildren.at( position );
+    if ( child->isElse() )
+      continue;
+
+    const bool started = rule->mActiveChildren.contains( child );
+    if ( !started && ( !hasElseRules || ( child->mIsActive && !child->mSymbol ) ) )
+      continue;
+
+    children << position;
+
+    if ( !child->mFilter || !child->mFilter->rootNode() )
+      continue;
+
+    collectFieldConditions( child->mFilter->rootNode(), childConditions[position] );
+    QSet< QString > fields;
+    for ( const FieldCondition &condition : qgis::as_const( childConditions[position] ) )
+      fields.insert( condition.field );
+    for ( const QString &field : qgis::as_const( fields ) )
+      fieldCounts[field]++;
+  }
+
+  // index the field which is filtered on by the most children
+  QString indexedField;
+  int indexedCount = 0;
+  for ( auto it = fieldCounts.constBegin(); it != fieldCounts.constEnd(); ++it )
+  {
+    if ( it.value() > indexedCount || ( it.value() == indexedCount && it.key() < indexedField ) )
+    {
+      indexedField = it.key();
+      indexedCount = it.value();
+    }
+  }
+  if ( indexedCount < MIN_INDEXED_CHILDREN )
+    return;
+
+  for ( int position : qgis::as_const( children ) )
+  {
+    for ( const FieldCondition &condition : qgis::as_const( childConditions.at( position ) ) )
+    {
+      if ( condition.field != indexedField )
+        continue;
+
+      const QgsExpressionNode *root = rule->mChildren.at( position )->mFilter->rootNode();
+      const bool isWholeFilter = root->nodeType() != QgsExpressionNode::ntBinaryOperator
+                                 || static_cast< const QgsExpressionNodeBinaryOperator * >( root )->op() != QgsExpressionNodeBinaryOperator::boAnd;
+      conditions[position] = isWholeFilter ? WholeFilter : PartOfFilter;
+
+      // children are visited in order, so the match lists stay sorted
+      for ( const QVariant &value : condition.keys )
+      {
+        QVector< int > &matches = value.type() == QVariant::String ? stringMatches[ value.toString() ] : integerMatches[ value.toLongLong() ];
+        if ( matches.isEmpty() || matches.last() != position )
+          matches << position;
+      }
+      break;
+    }
+  }
+
+  key = qgis::make_unique< QgsExpression >( QgsExpression::quotedColumnRef( indexedField ) );
+  key->prepare( &context.expressionContext() );
+}
+
+bool QgsRuleBasedRenderer::Rule::ChildRenderIndex::matchingChildren( const QgsFeature &feature, QgsRenderContext &context, const QVector< int > *&matches ) const
+{
+  matches = nullptr;
+  if ( !key )
+    return false;
+
+  context.expressionContext().setFeature( feature );
+  const QVariant value = key->evaluate( &context.expressionContext() );
+
+  // NULL never equals a literal
+  if ( QgsExpressionUtils::isNull( value ) )
+    return true;
+
+  const bool isString = value.type() == QVariant::String;
+  if ( isString && !QgsExpressionUtils::isDoubleSafe( value ) )
+  {
+    auto it = stringMatches.constFind( value.toString() );
+    if ( it != stringMatches.constEnd() )
+      matches = &it.value();
+    return true;
+  }
+
+  // numbers can only match integer literals, since their string representation is numeric too
+  switch ( value.type() )
+  {
+    case QVariant::String:
+    case QVariant::Int:
+    case QVariant::UInt:
+    case QVariant::LongLong:
+    case QVariant::ULongLong:
+    case QVariant::Double:
+    {
+      const double number = value.toDouble();
+      // infinite and NaN values convert to non numeric strings, leave them to the filters
+      if ( !std::isfinite( number ) )
+        return false;
+
+      if ( std::fabs( number ) < MAX_INTEGER_KEY )
+      {
+        const qlonglong integer = std::llround( number );
+        if ( qgsDoubleNear( number, static_cast< double >( integer ) ) )
+        {
+          auto it = integerMatches.constFind( integer );
+          if ( it != integerMatches.constEnd() )
+            matches = &it.value();
+        }
+      }
+      return true;
+    }
+
+    default:
+      return false;
+  }
+}
+
+///@endcond
 
 
 QgsRuleBasedRenderer::Rule::Rule( QgsSymbol *symbol, int scaleMinDenom, int scaleMaxDenom, const QString &filterExp, const QString &label, const QString &description, bool elseRule )
@@ -412,6 +709,7 @@ void QgsRuleBasedRenderer::Rule::toSld( QDomDocument &doc, QDomElement &element,
 bool QgsRuleBasedRenderer::Rule::startRender( QgsRenderContext &context, const QgsFields &fields, QString &filter )
 {
   mActiveChildren.clear();
+  mChildRenderIndex.reset();
 
   if ( ! mIsActive )
     return false;
@@ -441,6 +739,9 @@ bool QgsRuleBasedRenderer::Rule::startRender( QgsRenderContext &context, const Q
     }
   }
 
+  mChildRenderIndex.reset( new ChildRenderIndex() );
+  mChildRenderIndex->build( this, context );
+
   // subfilters (on the same level) are joined with OR
   // Finally they are joined with their parent (this) with AND
   QString sf;
@@ -556,6 +857,11 @@ QgsRuleBasedRenderer::Rule::RenderResult QgsRuleBasedRenderer::Rule::renderFeatu
   if ( !isFilterOK( featToRender.feat, &context ) )
     return Filtered;
 
+  return renderMatchingFeature( featToRender, context, renderQueue );
+}
+
+QgsRuleBasedRenderer::Rule::RenderResult QgsRuleBasedRenderer::Rule::renderMatchingFeature( QgsRuleBasedRenderer::FeatureToRender &featToRender, QgsRenderContext &context, QgsRuleBasedRenderer::RenderQueue &renderQueue )
+{
   bool rendered = false;
 
   // create job for this feature and this symbol, add to list of jobs
@@ -573,18 +879,41 @@ QgsRuleBasedRenderer::Rule::RenderResult QgsRuleBasedRenderer::Rule::renderFeatu
 
   bool willrendersomething = false;
 
-  // process children
-  const auto constMChildren = mChildren;
-  for ( Rule *rule : constMChildren )
+  // process children, skipping the ones which can't be rendered or whose filter
+  // is known not to match
+  const QVector< int > *matches = nullptr;
+  const bool useIndex = mChildRenderIndex && mChildRenderIndex->matchingChildren( featToRender.feat, context, matches );
+  int nextMatch = 0;
+  const int count = mChildRenderIndex ? mChildRenderIndex->children.count() : mChildren.count();
+  for ( int i = 0; i < count; ++i )
   {
+    const int position = mChildRenderIndex ? mChildRenderIndex->children.at( i ) : i;
+    Rule *rule = mChildren.at( position );
     // Don't process else rules yet
-    if ( !rule->isElse() )
+    if ( rule->isElse() )
+      continue;
+
+    const ChildRenderIndex::Condition condition = useIndex ? mChildRenderIndex->conditions.at( position ) : ChildRenderIndex::NotIndexed;
+    RenderResult res;
+    if ( condition == ChildRenderIndex::NotIndexed )
     {
-      RenderResult res = rule->renderFeature( featToRender, context, renderQueue );
-      // consider inactive items as "rendered" so the else rule will ignore them
-      willrendersomething |= ( res == Rendered || res == Inactive );
-      rendered |= ( res == Rendered );
+      res = rule->renderFeature( featToRender, context, renderQueue );
     }
+    else
+    {
+      // matches are sorted by position, like the children
+      while ( matches && nextMatch < matches->count() && matches->at( nextMatch ) < position )
+        ++nextMatch;
+      if ( !matches || nextMatch >= matches->count() || matches->at( nextMatch ) != position )
+        continue;
+
+      res = condition == ChildRenderIndex::WholeFilter ? rule->renderMatchingFeature( featToRender, context, renderQueue )
+            : rule->renderFeature( featToRender, context, renderQueue );
+    }
+
+    // consider inactive items as "rendered" so the else rule will ignore them
+    willrendersomething |= ( res == Rendered || res == Inactive );
+    rendered |= ( res == Rendered );
   }
 
   // If none of the rules passed then we jump into the else rules and process them.
@@ -723,6 +1052,7 @@ void QgsRuleBasedRenderer::Rule::stopRender( QgsRenderContext &context )
   }
 
   mActiveChildren.clear();
+  mChildRenderIndex.reset();
   mSymbolNormZLevels.clear();
 }
 
@@ -470,6 +470,15 @@ class CORE_EXPORT QgsRuleBasedRenderer : public QgsFeatureRenderer
         QSet<int> mSymbolNormZLevels;
         RuleList mActiveChildren;
 
+        struct ChildRenderIndex;
+        //! Lookup of the children to process for each feature, built in startRender()
+        std::unique_ptr< ChildRenderIndex > mChildRenderIndex;
+
+        /**
+         * Renders a feature which is already known to pass the filter of this rule
+         */
+        QgsRuleBasedRenderer::Rule::RenderResult renderMatchingFeature( QgsRuleBasedRenderer::FeatureToRender &featToRender, QgsRenderContext &context, QgsRuleBasedRenderer::RenderQueue &renderQueue );
+
         /**
          * Check which child rules are else rules and update the internal list of else rules
          *
@@ -127,53 +127,82 @@ QImage QgsSvgCache::svgAsImage( const QString &file, double size, const QColor &
   fitsInCache = true;
   QgsSvgCacheEntry *currentEntry = cacheEntry( file, size, fill, stroke, strokeWidth, widthScaleFactor, fixedAspectRatio, blocking );
 
-  QImage result;
+  // if another thread is already rendering the same entry, wait for it and look up the entry again
+  while ( !currentEntry->image && !startFillingEntry( currentEntry, locker ) )
+  {
+    currentEntry = cacheEntry( file, size, fill, stroke, strokeWidth, widthScaleFactor, fixedAspectRatio, blocking );
+  }
+
+  if ( currentEntry->image )
+  {
+    mHitCount++;
+    return *( currentEntry->image );
+  }
+
+  // render without holding the lock, so that other threads can use the cache meanwhile. The
+  // svg content of an entry never changes once it has been set
+  const bool renderUnlocked = !currentEntry->svgContent.isEmpty();
+  if ( renderUnlocked )
+    locker.unlock();
 
   //if current entry image is 0: cache image for entry
   // checks to see if image will fit into cache
   //update stats for memory usage
-  if ( !currentEntry->image )
+  QImage result;
+  std::unique_ptr< QImage > image;
+  std::unique_ptr< QPicture > picture;
+
+  QSvgRenderer r( currentEntry->svgContent );
+  double hwRatio = 1.0;
+  if ( r.viewBoxF().width() > 0 )
   {
-    QSvgRenderer r( currentEntry->svgContent );
-    double hwRatio = 1.0;
-    if ( r.viewBoxF().width() > 0 )
+    if ( currentEntry->fixedAspectRatio > 0 )
     {
-      if ( currentEntry->fixedAspectRatio > 0 )
-      {
-        hwRatio = currentEntry->fixedAspectRatio;
-      }
-      else
-      {
-        hwRatio = r.viewBoxF().height() / r.viewBoxF().width();
-      }
+      hwRatio = currentEntry->fixedAspectRatio;
     }
-    long cachedDataSize = 0;
-    cachedDataSize += currentEntry->svgContent.size();
-    cachedDataSize += static_cast< int >( currentEntry->size * currentEntry->size * hwRatio * 32 );
-    if ( cachedDataSize > mMaxCacheSize / 2 )
+    else
     {
-      fitsInCache = false;
-      currentEntry->image.reset();
-
-      // instead cache picture
-      if ( !currentEntry->picture )
-      {
-        cachePicture( currentEntry, false );
-      }
-
-      // ...and render cached picture to result image
-      result = imageFromCachedPicture( *currentEntry );
+      hwRatio = r.viewBoxF().height() / r.viewBoxF().width();
     }
-    else
+  }
+  long cachedDataSize = 0;
+  cachedDataSize += currentEntry->svgContent.size();
+  cachedDataSize += static_cast< int >( currentEntry->size * currentEntry->size * hwRatio * 32 );
+  if ( cachedDataSize > mMaxCacheSize / 2 )
+  {
+    fitsInCache = false;
+
+    // instead cache picture
+    if ( !currentEntry->picture )
     {
-      cacheImage( currentEntry );
-      result = *( currentEntry->image );
+      picture = renderPicture( *currentEntry );
     }
-    trimToMaximumSize();
+
+    // ...and render cached picture to result image
+    result = imageFromPicture( *currentEntry, picture ? *picture : *currentEntry->picture );
   }
   else
   {
-    result = *( currentEntry->image );
+    image = renderImage( *currentEntry );
+    result = *image;
+  }
+
+  if ( renderUnlocked )
+    locker.relock();
+
+  if ( finishFillingEntry( currentEntry ) )
+  {
+    if ( image )
+    {
+      mTotalSize += ( image->width() * image->height() * 32 );
+      currentEntry->image = std::move( image );
+    }
+    if ( picture )
+    {
+      mTotalSize += picture->size();
+      currentEntry->picture = std::move( picture );
+    }
+    trimToMaximumSize();
   }
 
   return result;
@@ -182,19 +211,44 @@ QImage QgsSvgCache::svgAsImage( const QString &file, double size, const QColor &
 QPicture QgsSvgCache::svgAsPicture( const QString &path, double size, const QColor &fill, const QColor &stroke, double strokeWidth,
                                     double widthScaleFactor, bool forceVectorOutput, double fixedAspectRatio, bool blocking )
 {
+  Q_UNUSED( forceVectorOutput )
   QMutexLocker locker( &mMutex );
 
   QgsSvgCacheEntry *currentEntry = cacheEntry( path, size, fill, stroke, strokeWidth, widthScaleFactor, fixedAspectRatio, blocking );
 
+  // if another thread is already rendering the same entry, wait for it and look up the entry again
+  while ( !currentEntry->picture && !startFillingEntry( currentEntry, locker ) )
+  {
+    currentEntry = cacheEntry( path, size, fill, stroke, strokeWidth, widthScaleFactor, fixedAspectRatio, blocking );
+  }
+
+  QPicture p;
+
   //if current entry picture is 0: cache picture for entry
   //update stats for memory usage
   if ( !currentEntry->picture )
   {
-    cachePicture( currentEntry, forceVectorOutput );
-    trimToMaximumSize();
+    // render without holding the lock, so that other threads can use the cache meanwhile
+    const bool renderUnlocked = !currentEntry->svgContent.isEmpty();
+    if ( renderUnlocked )
+      locker.unlock();
+
+    std::unique_ptr< QPicture > picture = renderPicture( *currentEntry );
+
+    if ( renderUnlocked )
+      locker.relock();
+
+    p.setData( picture->data(), picture->size() );
+    if ( finishFillingEntry( currentEntry ) )
+    {
+      mTotalSize += picture->size();
+      currentEntry->picture = std::move( picture );
+      trimToMaximumSize();
+    }
+    return p;
   }
 
-  QPicture p;
+  mHitCount++;
   // For some reason p.detach() doesn't seem to always work as intended, at
   // least with QT 5.5 on Ubuntu 16.04
   // Serialization/deserialization is a safe way to be ensured we don't
@@ -414,27 +468,20 @@ bool QgsSvgCache::checkReply( QNetworkReply *reply, const QString &path ) const
   return true;
 }
 
-void QgsSvgCache::cacheImage( QgsSvgCacheEntry *entry )
+std::unique_ptr< QImage > QgsSvgCache::renderImage( const QgsSvgCacheEntry &entry ) const
 {
-  if ( !entry )
-  {
-    return;
-  }
-
-  entry->image.reset();
-
   QSizeF viewBoxSize;
   QSizeF scaledSize;
-  QSize imageSize = sizeForImage( *entry, viewBoxSize, scaledSize );
+  QSize imageSize = sizeForImage( entry, viewBoxSize, scaledSize );
 
   // cast double image sizes to int for QImage
   std::unique_ptr< QImage > image = qgis::make_unique< QImage >( imageSize, QImage::Format_ARGB32_Premultiplied );
   image->fill( 0 ); // transparent background
 
-  const bool isFixedAR = entry->fixedAspectRatio > 0;
+  const bool isFixedAR = entry.fixedAspectRatio > 0;
 
   QPainter p( image.get() );
-  QSvgRenderer r( entry->svgContent );
+  QSvgRenderer r( entry.svgContent );
   if ( qgsDoubleNear( viewBoxSize.width(), viewBoxSize.height() ) )
   {
     r.render( &p );
@@ -447,32 +494,23 @@ void QgsSvgCache::cacheImage( QgsSvgCacheEntry *entry )
     r.render( &p, rect );
   }
 
-  mTotalSize += ( image->width() * image->height() * 32 );
-  entry->image = std::move( image );
+  return image;
 }
 
-void QgsSvgCache::cachePicture( QgsSvgCacheEntry *entry, bool forceVectorOutput )
+std::unique_ptr< QPicture > QgsSvgCache::renderPicture( const QgsSvgCacheEntry &entry ) const
 {
-  Q_UNUSED( forceVectorOutput )
-  if ( !entry )
-  {
-    return;
-  }
-
-  entry->picture.reset();
-
-  bool isFixedAR = entry->fixedAspectRatio > 0;
+  bool isFixedAR = entry.fixedAspectRatio > 0;
 
   //correct QPictures dpi correction
   std::unique_ptr< QPicture > picture = qgis::make_unique< QPicture >();
   QRectF rect;
-  QSvgRenderer r( entry->svgContent );
+  QSvgRenderer r( entry.svgContent );
   double hwRatio = 1.0;
   if ( r.viewBoxF().width() > 0 )
   {
     if ( isFixedAR )
     {
-      hwRatio = entry->fixedAspectRatio;
+      hwRatio = entry.fixedAspectRatio;
     }
     else
     {
@@ -480,7 +518,7 @@ void QgsSvgCache::cachePicture( QgsSvgCacheEntry *entry, bool forceVectorOutput
     }
   }
 
-  double wSize = entry->size;
+  double wSize = entry.size;
   double hSize = wSize * hwRatio;
 
   QSizeF s( r.viewBoxF().size() );
@@ -489,8 +527,8 @@ void QgsSvgCache::cachePicture( QgsSvgCacheEntry *entry, bool forceVectorOutput
 
   QPainter p( picture.get() );
   r.render( &p, rect );
-  entry->picture = std::move( picture );
-  mTotalSize += entry->picture->size();
+  p.end();
+  return picture;
 }
 
 QgsSvgCacheEntry *QgsSvgCache::cacheEntry( const QString &path, double size, const QColor &fill, const QColor &stroke, double strokeWidth,
@@ -814,7 +852,7 @@ QSize QgsSvgCache::sizeForImage( const QgsSvgCacheEntry &entry, QSizeF &viewBoxS
   return QSize( wImgSize, hImgSize );
 }
 
-QImage QgsSvgCache::imageFromCachedPicture( const QgsSvgCacheEntry &entry ) const
+QImage QgsSvgCache::imageFromPicture( const QgsSvgCacheEntry &entry, const QPicture &picture ) const
 {
   QSizeF viewBoxSize;
   QSizeF scaledSize;
@@ -822,7 +860,7 @@ QImage QgsSvgCache::imageFromCachedPicture( const QgsSvgCacheEntry &entry ) cons
   image.fill( 0 ); // transparent background
 
   QPainter p( &image );
-  p.drawPicture( QPoint( 0, 0 ), *entry.picture );
+  p.drawPicture( QPoint( 0, 0 ), picture );
   return image;
 }
 
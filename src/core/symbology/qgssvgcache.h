@@ -269,8 +269,10 @@ class CORE_EXPORT QgsSvgCache : public QgsAbstractContentCache< QgsSvgCacheEntry
   private:
 
     void replaceParamsAndCacheSvg( QgsSvgCacheEntry *entry, bool blocking = false );
-    void cacheImage( QgsSvgCacheEntry *entry );
-    void cachePicture( QgsSvgCacheEntry *entry, bool forceVectorOutput = false );
+    //! Renders the image for a cache \a entry
+    std::unique_ptr< QImage > renderImage( const QgsSvgCacheEntry &entry ) const;
+    //! Renders the picture for a cache \a entry
+    std::unique_ptr< QPicture > renderPicture( const QgsSvgCacheEntry &entry ) const;
     //! Returns entry from cache or creates a new entry if it does not exist already
     QgsSvgCacheEntry *cacheEntry( const QString &path, double size, const QColor &fill, const QColor &stroke, double strokeWidth,
                                   double widthScaleFactor, double fixedAspectRatio = 0, bool blocking = false, bool *isMissingImage = nullptr );
@@ -295,9 +297,9 @@ class CORE_EXPORT QgsSvgCache : public QgsAbstractContentCache< QgsSvgCacheEntry
     QSize sizeForImage( const QgsSvgCacheEntry &entry, QSizeF &viewBoxSize, QSizeF &scaledSize ) const;
 
     /**
-     * Returns a rendered image for a cached picture \a entry.
+     * Returns a rendered image of the \a picture for a cache \a entry.
      */
-    QImage imageFromCachedPicture( const QgsSvgCacheEntry &entry ) const;
+    QImage imageFromPicture( const QgsSvgCacheEntry &entry, const QPicture &picture ) const;
 
     //! SVG content to be rendered if SVG file was not found.
     QByteArray mMissingSvg;
@@ -0,0 +1,91 @@
+/***************************************************************************
+  qgstextpathcache.cpp
+  --------------------
+   begin                : November 2020
+   copyright            : (C) 2020 by the QGIS project
+
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstextpathcache_p.h"
+
+#include <QGuiApplication>
+#include <QMutexLocker>
+#include <algorithm>
+
+///@cond PRIVATE
+
+Q_GLOBAL_STATIC( QgsTextPathCache, sTextPathCache )
+
+QgsTextPathCache::QgsTextPathCache( int maxElements )
+  : mPaths( maxElements )
+{
+#if QT_VERSION >= QT_VERSION_CHECK( 5, 11, 0 )
+  // the outlines depend on the fonts available
+  if ( QGuiApplication *application = qobject_cast< QGuiApplication * >( QCoreApplication::instance() ) )
+    mFontDatabaseConnection = QObject::connect( application, &QGuiApplication::fontDatabaseChanged, [this] { clear(); } );
+#endif
+}
+
+QgsTextPathCache::~QgsTextPathCache()
+{
+  QObject::disconnect( mFontDatabaseConnection );
+}
+
+QgsTextPathCache *QgsTextPathCache::instance()
+{
+  return sTextPathCache();
+}
+
+QPainterPath QgsTextPathCache::textPath( const QFont &font, const QString &text )
+{
+  if ( text.isEmpty() )
+    return QPainterPath();
+
+  const Key key( font, text );
+  {
+    QMutexLocker locker( &mMutex );
+    if ( const QPainterPath *cached = mPaths.object( key ) )
+      return *cached;
+  }
+
+  // shape the text outside of the lock, so that other threads are not blocked while
+  // an expensive string is converted. If two threads race on the same key the
+  // resulting paths are identical, so it does not matter which one ends up cached
+  QPainterPath path;
+  path.addText( 0, 0, font, text );
+
+  QMutexLocker locker( &mMutex );
+  // QCache takes ownership, and deletes the copy straight away if it's larger than the whole cache
+  mPaths.insert( key, new QPainterPath( path ), std::max( 1, path.elementCount() ) );
+  return path;
+}
+
+void QgsTextPathCache::addText( QPainterPath &path, double x, double y, const QFont &font, const QString &text )
+{
+  const QPainterPath textOutline = textPath( font, text );
+  if ( textOutline.isEmpty() )
+    return;
+
+  path.addPath( textOutline.translated( x, y ) );
+}
+
+void QgsTextPathCache::clear()
+{
+  QMutexLocker locker( &mMutex );
+  mPaths.clear();
+}
+
+int QgsTextPathCache::count() const
+{
+  QMutexLocker locker( &mMutex );
+  return mPaths.count();
+}
+
+///@endcond
@@ -0,0 +1,117 @@
+/***************************************************************************
+  qgstextpathcache_p.h
+  --------------------
+   begin                : November 2020
+   copyright            : (C) 2020 by the QGIS project
+
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSTEXTPATHCACHE_PRIVATE_H
+#define QGSTEXTPATHCACHE_PRIVATE_H
+
+#define SIP_NO_FILE
+
+#include "qgis_core.h"
+
+#include <QCache>
+#include <QFont>
+#include <QMetaObject>
+#include <QMutex>
+#include <QPainterPath>
+#include <QPair>
+#include <QString>
+
+/// @cond PRIVATE
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the QGIS API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+
+/**
+ * \ingroup core
+ * A thread-safe cache of the outlines of text strings.
+ *
+ * Shaping a string and converting its glyphs to a QPainterPath is one of the
+ * most expensive parts of rendering labels with a buffer. Labels often repeat
+ * the same strings (street names, "River") many times, so outlines are cached
+ * by string and font and shared between all features, label providers and
+ * rendering threads.
+ *
+ * The font is compared in full, so the cache key includes the family, style,
+ * size, letter and word spacing, capitalization and kerning.
+ *
+ * As outlines depend on the fonts available, the cache is cleared whenever
+ * application fonts are added or removed.
+ *
+ * \since QGIS 3.18
+ */
+class CORE_EXPORT QgsTextPathCache
+{
+  public:
+
+    /**
+     * Constructor for QgsTextPathCache. \a maxElements is the maximum total
+     * number of path elements stored in the cache.
+     */
+    explicit QgsTextPathCache( int maxElements = 1000000 );
+
+    ~QgsTextPathCache();
+
+    QgsTextPathCache( const QgsTextPathCache &other ) = delete;
+    QgsTextPathCache &operator=( const QgsTextPathCache &other ) = delete;
+
+    /**
+     * Returns the shared cache instance.
+     */
+    static QgsTextPathCache *instance();
+
+    /**
+     * Returns the outline of \a text drawn with \a font, with the left end of
+     * the text baseline at the origin.
+     *
+     * The result matches a path created with QPainterPath::addText( 0, 0, font, text ).
+     */
+    QPainterPath textPath( const QFont &font, const QString &text );
+
+    /**
+     * Adds the outline of \a text drawn with \a font to \a path, with the left end of
+     * the text baseline at \a x, \a y.
+     *
+     * This is a cached equivalent of QPainterPath::addText().
+     */
+    void addText( QPainterPath &path, double x, double y, const QFont &font, const QString &text );
+
+    /**
+     * Removes all paths from the cache.
+     */
+    void clear();
+
+    /**
+     * Returns the number of paths currently stored in the cache.
+     */
+    int count() const;
+
+  private:
+
+    typedef QPair< QFont, QString > Key;
+
+    mutable QMutex mMutex;
+    QCache< Key, QPainterPath > mPaths;
+    QMetaObject::Connection mFontDatabaseConnection;
+};
+
+/// @endcond
+
+#endif // QGSTEXTPATHCACHE_PRIVATE_H
@@ -23,6 +23,7 @@
 #include "qgspainterswapper.h"
 #include "qgsmarkersymbollayer.h"
 #include "qgssymbollayerutils.h"
+#include "qgstextpathcache_p.h"
 
 Q_GUI_EXPORT extern int qt_defaultDpiX();
 Q_GUI_EXPORT extern int qt_defaultDpiY();
@@ -307,7 +308,7 @@ double QgsTextRenderer::drawBuffer( QgsRenderContext &context, const QgsTextRend
         if ( component.extraWordSpacing || component.extraLetterSpacing )
           applyExtraSpacingForLineJustification( fragmentFont, component.extraWordSpacing, component.extraLetterSpacing );
 
-        path.addText( xOffset, 0, fragmentFont, fragment.text() );
+        QgsTextPathCache::instance()->addText( path, xOffset, 0, fragmentFont, fragment.text() );
 
         xOffset += fragment.horizontalAdvance( fragmentFont, true, scaleFactor );
       }
@@ -336,7 +337,7 @@ double QgsTextRenderer::drawBuffer( QgsRenderContext &context, const QgsTextRend
 #else
           double partXOffset = ( labelWidth - ( fragmentMetrics.horizontalAdvance( part ) - letterSpacing ) ) / 2;
 #endif
-          path.addText( partXOffset, partYOffset, fragmentFont, part );
+          QgsTextPathCache::instance()->addText( path, partXOffset, partYOffset, fragmentFont, part );
           partYOffset += fragmentMetrics.ascent() + letterSpacing;
         }
       }
@@ -446,7 +447,7 @@ void QgsTextRenderer::drawMask( QgsRenderContext &context, const QgsTextRenderer
     QFont fragmentFont = font;
     fragment.characterFormat().updateFontForFormat( fragmentFont, scaleFactor );
 
-    path.addText( xOffset, 0, fragmentFont, fragment.text() );
+    QgsTextPathCache::instance()->addText( path, xOffset, 0, fragmentFont, fragment.text() );
 
     xOffset += fragment.horizontalAdvance( fragmentFont, true );
   }
@@ -1558,7 +1559,7 @@ void QgsTextRenderer::drawTextInternalHorizontal( QgsRenderContext &context, con
         if ( extraWordSpace || extraLetterSpace )
           applyExtraSpacingForLineJustification( fragmentFont, extraWordSpace * fontScale, extraLetterSpace * fontScale );
 
-        path.addText( xOffset, 0, fragmentFont, fragment.text() );
+        QgsTextPathCache::instance()->addText( path, xOffset, 0, fragmentFont, fragment.text() );
 
         QColor textColor = fragment.characterFormat().textColor().isValid() ? fragment.characterFormat().textColor() : format.color();
         textColor.setAlphaF( format.opacity() );
@@ -1795,7 +1796,7 @@ void QgsTextRenderer::drawTextInternalVertical( QgsRenderContext &context, const
 #else
           double partXOffset = ( labelWidth - ( fragmentMetrics.horizontalAdvance( part ) / fontScale - letterSpacing ) ) / 2;
 #endif
-          path.addText( partXOffset * fontScale, partYOffset * fontScale, fragmentFont, part );
+          QgsTextPathCache::instance()->addText( path, partXOffset * fontScale, partYOffset * fontScale, fragmentFont, part );
           partYOffset += fragmentMetrics.ascent() / fontScale + letterSpacing;
         }
 
@@ -24,6 +24,7 @@
 #include "qgsspatialindex.h"
 #include "qgsexception.h"
 #include "qgsexpressioncontextutils.h"
+#include "qgsfeaturebatch.h"
 
 #include <QtAlgorithms>
 #include <QTextStream>
@@ -326,26 +327,8 @@ bool QgsDelimitedTextFeatureIterator::nextFeatureInternal( QgsFeature &feature )
 
     // Load the geometry if required
 
-    if ( mLoadGeometry )
-    {
-      bool nullGeom = false;
-      if ( mSource->mGeomRep == QgsDelimitedTextProvider::GeomAsWkt )
-      {
-        geom = loadGeometryWkt( tokens, nullGeom );
-      }
-      else if ( mSource->mGeomRep == QgsDelimitedTextProvider::GeomAsXy )
-      {
-        geom = loadGeometryXY( tokens, nullGeom );
-      }
-
-      if ( ( geom.isNull() && !nullGeom ) || ( nullGeom && mTestGeometry ) )
-      {
-        // if we didn't get a geom and not because it's null, or we got a null
-        // geom and we are testing for intersecting geometries then ignore this
-        // record
-        continue;
-      }
-    }
+    if ( mLoadGeometry && !loadGeometry( tokens, geom ) )
+      continue;
 
     // At this point the current feature values are valid
 
@@ -391,6 +374,84 @@ bool QgsDelimitedTextFeatureIterator::nextFeatureInternal( QgsFeature &feature )
   return false;
 }
 
+int QgsDelimitedTextFeatureIterator::fetchBatch( QgsFeatureBatch &batch, int maxRows )
+{
+  // records selected by id, subset expression or extent, and reprojected
+  // geometries, are handled feature by feature
+  if ( mMode != FileScan || mTestSubset || mTestGeometry || mTransform.isValid() )
+    return QgsAbstractFeatureIterator::fetchBatch( batch, maxRows );
+
+  if ( mClosed )
+    return 0;
+
+  const QgsAttributeList batchAttributes = batch.attributes();
+  const bool subsetOfAttributes = mRequest.flags() & QgsFeatureRequest::SubsetOfAttributes;
+  const QgsAttributeList requestedAttributes = mRequest.subsetOfAttributes();
+  QVector<int> columns;
+  for ( int column = 0; column < batchAttributes.count(); ++column )
+  {
+    if ( !subsetOfAttributes || requestedAttributes.contains( batchAttributes.at( column ) ) )
+      columns << column;
+  }
+
+  QgsDelimitedTextFile *file = mSource->mFile.get();
+  QStringList tokens;
+  QVariant value;
+  int rows = 0;
+  while ( rows < maxRows )
+  {
+    QgsDelimitedTextFile::Status status = file->nextRecord( tokens );
+    if ( status == QgsDelimitedTextFile::RecordEOF )
+    {
+      close();
+      break;
+    }
+    if ( status != QgsDelimitedTextFile::RecordOk ) continue;
+
+    // We ignore empty records, such as added randomly by spreadsheets
+
+    if ( QgsDelimitedTextProvider::recordIsEmpty( tokens ) ) continue;
+
+    while ( tokens.size() < mSource->mFieldCount )
+      tokens.append( QString() );
+
+    QgsGeometry geom;
+    if ( mLoadGeometry && !loadGeometry( tokens, geom ) )
+      continue;
+
+    batch.addRow( file->recordId() );
+    batch.setGeometry( geom );
+
+    for ( int column : qgis::as_const( columns ) )
+    {
+      if ( attributeValue( batchAttributes.at( column ), tokens, value ) )
+        batch.setValue( column, value );
+    }
+
+    ++rows;
+  }
+
+  return rows;
+}
+
+bool QgsDelimitedTextFeatureIterator::loadGeometry( const QStringList &tokens, QgsGeometry &geom )
+{
+  bool nullGeom = false;
+  if ( mSource->mGeomRep == QgsDelimitedTextProvider::GeomAsWkt )
+  {
+    geom = loadGeometryWkt( tokens, nullGeom );
+  }
+  else if ( mSource->mGeomRep == QgsDelimitedTextProvider::GeomAsXy )
+  {
+    geom = loadGeometryXY( tokens, nullGeom );
+  }
+
+  // if we didn't get a geom and not because it's null, or we got a null
+  // geom and we are testing for intersecting geometries then ignore this
+  // record
+  return !( ( geom.isNull() && !nullGeom ) || ( nullGeom && mTestGeometry ) );
+}
+
 bool QgsDelimitedTextFeatureIterator::setNextFeatureId( qint64 fid )
 {
   return mSource->mFile->setNextRecordId( ( long ) fid );
@@ -458,11 +519,17 @@ QgsGeometry QgsDelimitedTextFeatureIterator::loadGeometryXY( const QStringList &
 
 void QgsDelimitedTextFeatureIterator::fetchAttribute( QgsFeature &feature, int fieldIdx, const QStringList &tokens )
 {
-  if ( fieldIdx < 0 || fieldIdx >= mSource->attributeColumns.count() ) return;
+  QVariant val;
+  if ( attributeValue( fieldIdx, tokens, val ) )
+    feature.setAttribute( fieldIdx, val );
+}
+
+bool QgsDelimitedTextFeatureIterator::attributeValue( int fieldIdx, const QStringList &tokens, QVariant &val ) const
+{
+  if ( fieldIdx < 0 || fieldIdx >= mSource->attributeColumns.count() ) return false;
   int column = mSource->attributeColumns.at( fieldIdx );
-  if ( column < 0 || column >= tokens.count() ) return;
+  if ( column < 0 || column >= tokens.count() ) return false;
   const QString &value = tokens[column];
-  QVariant val;
   switch ( mSource->mFields.at( fieldIdx ).type() )
   {
     case QVariant::Int:
@@ -520,7 +587,7 @@ void QgsDelimitedTextFeatureIterator::fetchAttribute( QgsFeature &feature, int f
       val = QVariant( value );
       break;
   }
-  feature.setAttribute( fieldIdx, val );
+  return true;
 }
 
 // ------------
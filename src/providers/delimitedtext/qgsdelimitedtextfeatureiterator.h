@@ -79,6 +79,7 @@ class QgsDelimitedTextFeatureIterator final: public QgsAbstractFeatureIteratorFr
 
   protected:
     bool fetchFeature( QgsFeature &feature ) override;
+    int fetchBatch( QgsFeatureBatch &batch, int maxRows ) override;
 
   private:
 
@@ -87,8 +88,17 @@ class QgsDelimitedTextFeatureIterator final: public QgsAbstractFeatureIteratorFr
     bool nextFeatureInternal( QgsFeature &feature );
     QgsGeometry loadGeometryWkt( const QStringList &tokens, bool &isNull );
     QgsGeometry loadGeometryXY( const QStringList &tokens, bool &isNull );
+
+    /**
+     * Loads the geometry of a record into \a geom, returns FALSE if the record
+     * must be skipped because of its geometry
+     */
+    bool loadGeometry( const QStringList &tokens, QgsGeometry &geom );
     void fetchAttribute( QgsFeature &feature, int fieldIdx, const QStringList &tokens );
 
+    //! Converts the token of an attribute to \a value, returns FALSE if the record has no such attribute
+    bool attributeValue( int fieldIdx, const QStringList &tokens, QVariant &value ) const;
+
     QList<QgsFeatureId> mFeatureIds;
     IteratorMode mMode = FileScan;
     long mNextId = 0;
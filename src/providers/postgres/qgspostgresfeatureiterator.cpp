@@ -22,6 +22,7 @@
 #include "qgsmessagelog.h"
 #include "qgssettings.h"
 #include "qgsexception.h"
+#include "qgsfeaturebatch.h"
 
 #include <QElapsedTimer>
 #include <QObject>
@@ -328,6 +329,100 @@ bool QgsPostgresFeatureIterator::fetchFeature( QgsFeature &feature )
   return true;
 }
 
+int QgsPostgresFeatureIterator::fetchBatch( QgsFeatureBatch &batch, int maxRows )
+{
+  // rows are decoded straight into the batch for oid, ctid and integer keys,
+  // other keys go through the shared fid map and reprojection needs complete features
+  if ( mTransform.isValid() || mRequest.filterType() != QgsFeatureRequest::FilterNone
+       || ( mSource->mPrimaryKeyType != PktOid && mSource->mPrimaryKeyType != PktTid && mSource->mPrimaryKeyType != PktInt ) )
+    return QgsAbstractFeatureIterator::fetchBatch( batch, maxRows );
+
+  if ( mClosed )
+    return 0;
+
+  int rows = 0;
+
+  // features already queued by fetchFeature() come first
+  while ( rows < maxRows && !mFeatureQueue.empty() )
+  {
+    batch.appendFeature( mFeatureQueue.dequeue() );
+    mFetched++;
+    rows++;
+  }
+
+  // map the batch columns to the columns of the cursor, see declareCursor()
+  const bool subsetOfAttributes = mRequest.flags() & QgsFeatureRequest::SubsetOfAttributes;
+  const QgsAttributeList fetchAttributes = subsetOfAttributes ? mRequest.subsetOfAttributes() : mSource->mFields.allAttributesList();
+  QVector<int> attributeColumns( mSource->mFields.count(), -1 );
+  const int keyCol = mFetchGeometry ? 1 : 0;
+  int col = keyCol + 1;
+  for ( int idx : fetchAttributes )
+  {
+    if ( mSource->mPrimaryKeyAttrs.contains( idx ) )
+      continue;
+    attributeColumns[idx] = col++;
+  }
+  if ( mSource->mPrimaryKeyType == PktInt && fetchAttributes.contains( mSource->mPrimaryKeyAttrs.at( 0 ) ) )
+    attributeColumns[mSource->mPrimaryKeyAttrs.at( 0 )] = keyCol;
+
+  const QgsAttributeList batchAttributes = batch.attributes();
+  QVector<int> resultColumns;
+  QVector<QVariant::Type> columnTypes;
+  for ( int idx : batchAttributes )
+  {
+    resultColumns << attributeColumns.at( idx );
+    columnTypes << mSource->mFields.at( idx ).type();
+  }
+
+  while ( rows < maxRows && !mLastFetch )
+  {
+    const int count = std::min( maxRows - rows, mFeatureQueueSize );
+    QString fetch = QStringLiteral( "FETCH FORWARD %1 FROM %2" ).arg( count ).arg( mCursorName );
+    QgsDebugMsgLevel( QStringLiteral( "fetching %1 features into batch." ).arg( count ), 4 );
+
+    lock();
+    if ( mConn->PQsendQuery( fetch ) == 0 ) // fetch features asynchronously
+    {
+      QgsMessageLog::logMessage( QObject::tr( "Fetching from cursor %1 failed\nDatabase error: %2" ).arg( mCursorName, mConn->PQerrorMessage() ), QObject::tr( "PostGIS" ) );
+    }
+
+    int fetched = 0;
+    QgsPostgresResult queryResult;
+    for ( ;; )
+    {
+      queryResult = mConn->PQgetResult();
+      if ( !queryResult.result() )
+        break;
+
+      if ( queryResult.PQresultStatus() != PGRES_TUPLES_OK )
+      {
+        QgsMessageLog::logMessage( QObject::tr( "Fetching from cursor %1 failed\nDatabase error: %2" ).arg( mCursorName, mConn->PQerrorMessage() ), QObject::tr( "PostGIS" ) );
+        break;
+      }
+
+      const int resultRows = queryResult.PQntuples();
+      for ( int row = 0; row < resultRows; row++ )
+        getBatchRow( queryResult, row, batch, resultColumns, columnTypes );
+      fetched += resultRows;
+    }
+    unlock();
+
+    mLastFetch = fetched < count;
+    mFetched += fetched;
+    rows += fetched;
+  }
+
+  if ( rows < maxRows )
+  {
+    QgsDebugMsg( QStringLiteral( "Finished after %1 features" ).arg( mFetched ) );
+    close();
+
+    mSource->mShared->ensureFeaturesCountedAtLeast( mFetched );
+  }
+
+  return rows;
+}
+
 bool QgsPostgresFeatureIterator::nextFeatureFilterExpression( QgsFeature &f )
 {
   if ( !mExpressionCompiled )
@@ -664,6 +759,50 @@ bool QgsPostgresFeatureIterator::declareCursor( const QString &whereClause, long
   return true;
 }
 
+//! Converts the OGC geometry type of a WKB returned by PostGIS to the QGIS one, in place
+static void convertWkbType( unsigned char *featureGeom )
+{
+  unsigned int wkbType;
+  memcpy( &wkbType, featureGeom + 1, sizeof( wkbType ) );
+  QgsWkbTypes::Type newType = QgsPostgresConn::wkbTypeFromOgcWkbType( wkbType );
+
+  if ( ( unsigned int )newType != wkbType )
+  {
+    // overwrite type
+    unsigned int n = newType;
+    memcpy( featureGeom + 1, &n, sizeof( n ) );
+  }
+
+  // PostGIS stores TIN as a collection of Triangles.
+  // Since Triangles are not supported, they have to be converted to Polygons
+  const int nDims = 2 + ( QgsWkbTypes::hasZ( newType ) ? 1 : 0 ) + ( QgsWkbTypes::hasM( newType ) ? 1 : 0 );
+  if ( wkbType % 1000 == 16 )
+  {
+    unsigned int numGeoms;
+    memcpy( &numGeoms, featureGeom + 5, sizeof( unsigned int ) );
+    unsigned char *wkb = featureGeom + 9;
+    for ( unsigned int i = 0; i < numGeoms; ++i )
+    {
+      const unsigned int localType = QgsWkbTypes::singleType( newType ); // polygon(Z|M)
+      memcpy( wkb + 1, &localType, sizeof( localType ) );
+
+      // skip endian and type info
+      wkb += sizeof( unsigned int ) + 1;
+
+      // skip coordinates
+      unsigned int nRings;
+      memcpy( &nRings, wkb, sizeof( int ) );
+      wkb += sizeof( int );
+      for ( unsigned int j = 0; j < nRings; ++j )
+      {
+        unsigned int nPoints;
+        memcpy( &nPoints, wkb, sizeof( int ) );
+        wkb += sizeof( nPoints ) + sizeof( double ) * nDims * nPoints;
+      }
+    }
+  }
+}
+
 bool QgsPostgresFeatureIterator::getFeature( QgsPostgresResult &queryResult, int row, QgsFeature &feature )
 {
   feature.initAttributes( mSource->mFields.count() );
@@ -679,45 +818,7 @@ bool QgsPostgresFeatureIterator::getFeature( QgsPostgresResult &queryResult, int
       memcpy( featureGeom, PQgetvalue( queryResult.result(), row, col ), returnedLength );
       memset( featureGeom + returnedLength, 0, 1 );
 
-      unsigned int wkbType;
-      memcpy( &wkbType, featureGeom + 1, sizeof( wkbType ) );
-      QgsWkbTypes::Type newType = QgsPostgresConn::wkbTypeFromOgcWkbType( wkbType );
-
-      if ( ( unsigned int )newType != wkbType )
-      {
-        // overwrite type
-        unsigned int n = newType;
-        memcpy( featureGeom + 1, &n, sizeof( n ) );
-      }
-
-      // PostGIS stores TIN as a collection of Triangles.
-      // Since Triangles are not supported, they have to be converted to Polygons
-      const int nDims = 2 + ( QgsWkbTypes::hasZ( newType ) ? 1 : 0 ) + ( QgsWkbTypes::hasM( newType ) ? 1 : 0 );
-      if ( wkbType % 1000 == 16 )
-      {
-        unsigned int numGeoms;
-        memcpy( &numGeoms, featureGeom + 5, sizeof( unsigned int ) );
-        unsigned char *wkb = featureGeom + 9;
-        for ( unsigned int i = 0; i < numGeoms; ++i )
-        {
-          const unsigned int localType = QgsWkbTypes::singleType( newType ); // polygon(Z|M)
-          memcpy( wkb + 1, &localType, sizeof( localType ) );
-
-          // skip endian and type info
-          wkb += sizeof( unsigned int ) + 1;
-
-          // skip coordinates
-          unsigned int nRings;
-          memcpy( &nRings, wkb, sizeof( int ) );
-          wkb += sizeof( int );
-          for ( unsigned int j = 0; j < nRings; ++j )
-          {
-            unsigned int nPoints;
-            memcpy( &nPoints, wkb, sizeof( int ) );
-            wkb += sizeof( nPoints ) + sizeof( double ) * nDims * nPoints;
-          }
-        }
-      }
+      convertWkbType( featureGeom );
 
       QgsGeometry g;
       g.fromWkb( featureGeom, returnedLength + 1 );
@@ -835,8 +936,13 @@ void QgsPostgresFeatureIterator::getFeatureAttribute( int idx, QgsPostgresResult
   if ( mSource->mPrimaryKeyAttrs.contains( idx ) )
     return;
 
-  const QgsField fld = mSource->mFields.at( idx );
+  feature.setAttribute( idx, getAttributeValue( mSource->mFields.at( idx ), queryResult, row, col ) );
+
+  col++;
+}
 
+QVariant QgsPostgresFeatureIterator::getAttributeValue( const QgsField &fld, QgsPostgresResult &queryResult, int row, int col )
+{
   QVariant v;
 
   switch ( fld.type() )
@@ -883,9 +989,85 @@ void QgsPostgresFeatureIterator::getFeatureAttribute( int idx, QgsPostgresResult
       break;
     }
   }
-  feature.setAttribute( idx, v );
 
-  col++;
+  return v;
+}
+
+void QgsPostgresFeatureIterator::getBatchRow( QgsPostgresResult &queryResult, int row, QgsFeatureBatch &batch,
+    const QVector<int> &resultColumns, const QVector<QVariant::Type> &columnTypes )
+{
+  int col = 0;
+
+  const int geometryCol = mFetchGeometry ? col++ : -1;
+
+  // only oid, ctid and integer keys get here, see fetchBatch()
+  const int keyCol = col++;
+  const qint64 key = mConn->getBinaryInt( queryResult, row, keyCol );
+  batch.addRow( mSource->mPrimaryKeyType == PktInt ? QgsPostgresUtils::int32pk_to_fid( key ) : key );
+
+  if ( geometryCol >= 0 && batch.includesGeometry() )
+  {
+    const int returnedLength = ::PQgetlength( queryResult.result(), row, geometryCol );
+    if ( returnedLength > 0 )
+    {
+      unsigned char *featureGeom = reinterpret_cast<unsigned char *>( batch.reserveWkb( returnedLength ) );
+      memcpy( featureGeom, ::PQgetvalue( queryResult.result(), row, geometryCol ), returnedLength );
+      convertWkbType( featureGeom );
+    }
+  }
+
+  for ( int column = 0; column < resultColumns.count(); ++column )
+  {
+    const int resultCol = resultColumns.at( column );
+    if ( resultCol < 0 )
+      continue;
+
+    if ( resultCol == keyCol )
+    {
+      // the integer primary key attribute keeps the database value
+      batch.setInt64( column, key );
+      continue;
+    }
+
+    if ( ::PQgetisnull( queryResult.result(), row, resultCol ) )
+      continue;
+
+    const char *value = ::PQgetvalue( queryResult.result(), row, resultCol );
+    const int length = ::PQgetlength( queryResult.result(), row, resultCol );
+    switch ( columnTypes.at( column ) )
+    {
+      case QVariant::Int:
+      {
+        bool ok = false;
+        const int i = QByteArray::fromRawData( value, length ).toInt( &ok );
+        if ( ok )
+          batch.setInt64( column, i );
+        break;
+      }
+
+      case QVariant::LongLong:
+        batch.setInt64( column, mConn->getBinaryInt( queryResult, row, resultCol ) );
+        break;
+
+      case QVariant::Double:
+      {
+        bool ok = false;
+        const double d = QByteArray::fromRawData( value, length ).toDouble( &ok );
+        if ( ok )
+          batch.setDouble( column, d );
+        break;
+      }
+
+      case QVariant::String:
+        // the connection uses the UNICODE client encoding, values are UTF-8 already
+        batch.setString( column, value, length );
+        break;
+
+      default:
+        batch.setValue( column, getAttributeValue( mSource->mFields.at( batch.attributes().at( column ) ), queryResult, row, resultCol ) );
+        break;
+    }
+  }
 }
 
 
@@ -81,6 +81,7 @@ class QgsPostgresFeatureIterator final: public QgsAbstractFeatureIteratorFromSou
 
   protected:
     bool fetchFeature( QgsFeature &feature ) override;
+    int fetchBatch( QgsFeatureBatch &batch, int maxRows ) override;
     bool nextFeatureFilterExpression( QgsFeature &f ) override;
     bool prepareSimplification( const QgsSimplifyMethod &simplifyMethod ) override;
 
@@ -92,6 +93,15 @@ class QgsPostgresFeatureIterator final: public QgsAbstractFeatureIteratorFromSou
     QString whereClauseRect();
     bool getFeature( QgsPostgresResult &queryResult, int row, QgsFeature &feature );
     void getFeatureAttribute( int idx, QgsPostgresResult &queryResult, int row, int &col, QgsFeature &feature );
+    QVariant getAttributeValue( const QgsField &fld, QgsPostgresResult &queryResult, int row, int col );
+
+    /**
+     * Appends a \a row of the query result to \a batch. \a resultColumns holds the query
+     * result column of each batch column, or -1 for columns which are not fetched, and
+     * \a columnTypes the type of their fields.
+     */
+    void getBatchRow( QgsPostgresResult &queryResult, int row, QgsFeatureBatch &batch,
+                      const QVector<int> &resultColumns, const QVector<QVariant::Type> &columnTypes );
     bool declareCursor( const QString &whereClause, long limit = -1, bool closeOnFail = true, const QString &orderBy = QString() );
 
     QString mCursorName;
@@ -159,6 +159,8 @@ struct VTable
 
     QgsFields fields() const { return mFields; }
 
+    bool hasGeometry() const { return mHasGeometry; }
+
   private:
 
     VTable( const VTable &other ) = delete;
@@ -190,6 +192,9 @@ struct VTable
 
     QgsFields mFields;
 
+    // whether the table exposes a geometry (and a _search_frame_) column
+    bool mHasGeometry = false;
+
     void init_()
     {
       mFields = mLayer ? mLayer->fields() : mProvider->fields();
@@ -233,6 +238,8 @@ struct VTable
 
         // add a hidden field for rtree filtering
         sqlFields << QStringLiteral( "_search_frame_ HIDDEN BLOB" );
+
+        mHasGeometry = true;
       }
 
       QgsAttributeList pkAttributeIndexes = provider->pkAttributeIndexes();
@@ -474,9 +481,51 @@ int vtableRename( sqlite3_vtab *vtab, const char *newName )
   return SQLITE_OK;
 }
 
+/**
+ * Returns the description of the columns needed by a query plan, stored at the
+ * beginning of the index string. It is a comma separated list of attribute indexes,
+ * with "g" standing for the geometry column, or "*" if all columns are needed.
+ */
+QString usedColumns( VTable *vtab, const sqlite3_index_info *indexInfo )
+{
+#if SQLITE_VERSION_NUMBER >= 3010000
+  const int fieldCount = vtab->fields().count();
+  // the last bit of colUsed stands for all the columns beyond the 63rd one
+  if ( fieldCount >= 63 )
+    return QStringLiteral( "*" );
+
+  QStringList columns;
+  for ( int i = 0; i < fieldCount; i++ )
+  {
+    if ( indexInfo->colUsed & ( static_cast< sqlite3_uint64 >( 1 ) << i ) )
+      columns << QString::number( i );
+  }
+  if ( vtab->hasGeometry() && ( indexInfo->colUsed & ( static_cast< sqlite3_uint64 >( 1 ) << fieldCount ) ) )
+    columns << QStringLiteral( "g" );
+  return columns.join( QLatin1Char( ',' ) );
+#else
+  Q_UNUSED( vtab )
+  Q_UNUSED( indexInfo )
+  return QStringLiteral( "*" );
+#endif
+}
+
+void setIndexString( sqlite3_index_info *indexInfo, const QString &str )
+{
+  QByteArray ba = str.toUtf8();
+  char *cp = ( char * )sqlite3_malloc( ba.size() + 1 );
+  memcpy( cp, ba.constData(), ba.size() + 1 );
+
+  indexInfo->idxStr = cp;
+  indexInfo->needToFreeIdxStr = 1;
+}
+
 int vtableBestIndex( sqlite3_vtab *pvtab, sqlite3_index_info *indexInfo )
 {
   VTable *vtab = reinterpret_cast< VTable * >( pvtab );
+  // index string format: used columns;expression
+  const QString columns = usedColumns( vtab, indexInfo ) + ';';
+
   for ( int i = 0; i < indexInfo->nConstraint; i++ )
   {
     // request for primary key filter with '='
@@ -488,11 +537,48 @@ int vtableBestIndex( sqlite3_vtab *pvtab, sqlite3_index_info *indexInfo )
       indexInfo->aConstraintUsage[i].omit = 1;
       indexInfo->idxNum = 1; // PK filter
       indexInfo->estimatedCost = 1.0;
-      indexInfo->idxStr = nullptr;
-      indexInfo->needToFreeIdxStr = 0;
+      setIndexString( indexInfo, columns );
+      return SQLITE_OK;
+    }
+  }
+
+  for ( int i = 0; i < indexInfo->nConstraint; i++ )
+  {
+    // request for rtree filtering
+    if ( ( indexInfo->aConstraint[i].usable ) &&
+         // request on _search_frame_ column
+         ( vtab->fields().count() + 1 == indexInfo->aConstraint[i].iColumn ) &&
+         ( indexInfo->aConstraint[i].op == SQLITE_INDEX_CONSTRAINT_EQ ) )
+    {
+      indexInfo->aConstraintUsage[i].argvIndex = 1;
+      // do not test for equality, since it is used for filtering, not to return an actual value
+      indexInfo->aConstraintUsage[i].omit = 1;
+      indexInfo->idxNum = 2; // RTree filter
+      indexInfo->estimatedCost = 1.0;
+      setIndexString( indexInfo, columns );
+      return SQLITE_OK;
+    }
+
+#ifdef SQLITE_INDEX_CONSTRAINT_FUNCTION
+    // request for a spatial predicate on the geometry column, overloaded by vtableFindFunction
+    if ( ( indexInfo->aConstraint[i].usable ) &&
+         ( vtab->hasGeometry() ) &&
+         ( vtab->fields().count() == indexInfo->aConstraint[i].iColumn ) &&
+         ( indexInfo->aConstraint[i].op >= SQLITE_INDEX_CONSTRAINT_FUNCTION ) )
+    {
+      indexInfo->aConstraintUsage[i].argvIndex = 1;
+      // the bounding box of the second argument is only a prefilter, the predicate itself still has to be evaluated
+      indexInfo->aConstraintUsage[i].omit = 0;
+      indexInfo->idxNum = 2; // RTree filter
+      indexInfo->estimatedCost = 1.0;
+      setIndexString( indexInfo, columns );
       return SQLITE_OK;
     }
+#endif
+  }
 
+  for ( int i = 0; i < indexInfo->nConstraint; i++ )
+  {
     // request for filter with a comparison operator
     if ( ( indexInfo->aConstraint[i].usable ) &&
          ( indexInfo->aConstraint[i].iColumn >= 0 ) &&
@@ -539,35 +625,13 @@ int vtableBestIndex( sqlite3_vtab *pvtab, sqlite3_index_info *indexInfo )
           break;
       }
 
-      QByteArray ba = expr.toUtf8();
-      char *cp = ( char * )sqlite3_malloc( ba.size() + 1 );
-      memcpy( cp, ba.constData(), ba.size() + 1 );
-
-      indexInfo->idxStr = cp;
-      indexInfo->needToFreeIdxStr = 1;
-      return SQLITE_OK;
-    }
-
-    // request for rtree filtering
-    if ( ( indexInfo->aConstraint[i].usable ) &&
-         // request on _search_frame_ column
-         ( vtab->fields().count() + 1 == indexInfo->aConstraint[i].iColumn ) &&
-         ( indexInfo->aConstraint[i].op == SQLITE_INDEX_CONSTRAINT_EQ ) )
-    {
-      indexInfo->aConstraintUsage[i].argvIndex = 1;
-      // do not test for equality, since it is used for filtering, not to return an actual value
-      indexInfo->aConstraintUsage[i].omit = 1;
-      indexInfo->idxNum = 2; // RTree filter
-      indexInfo->estimatedCost = 1.0;
-      indexInfo->idxStr = nullptr;
-      indexInfo->needToFreeIdxStr = 0;
+      setIndexString( indexInfo, columns + expr );
       return SQLITE_OK;
     }
   }
   indexInfo->idxNum = 0;
   indexInfo->estimatedCost = 10.0;
-  indexInfo->idxStr = nullptr;
-  indexInfo->needToFreeIdxStr = 0;
+  setIndexString( indexInfo, columns );
   return SQLITE_OK;
 }
 
@@ -591,6 +655,13 @@ int vtableFilter( sqlite3_vtab_cursor *cursor, int idxNum, const char *idxStr, i
 {
   Q_UNUSED( argc )
 
+  // index string format: used columns;expression
+  const QString indexStr = QString::fromUtf8( idxStr );
+  const int separator = indexStr.indexOf( ';' );
+  const QString columns = separator >= 0 ? indexStr.left( separator ) : QStringLiteral( "*" );
+
+  VTableCursor *c = reinterpret_cast<VTableCursor *>( cursor );
+
   QgsFeatureRequest request;
   if ( idxNum == 1 )
   {
@@ -600,19 +671,26 @@ int vtableFilter( sqlite3_vtab_cursor *cursor, int idxNum, const char *idxStr, i
   else if ( idxNum == 2 )
   {
     // rtree filter
-    const char *blob = reinterpret_cast< const char * >( sqlite3_value_blob( argv[0] ) );
-    if ( blob )
+    // (the argument of a spatial predicate may be anything, only SpatiaLite geometries are used)
+    const char *blob = sqlite3_value_type( argv[0] ) == SQLITE_BLOB ? reinterpret_cast< const char * >( sqlite3_value_blob( argv[0] ) ) : nullptr;
+    int bytes = blob ? sqlite3_value_bytes( argv[0] ) : 0;
+    if ( blob && bytes >= static_cast< int >( SpatialiteBlobHeader::LENGTH ) && blob[0] == 0 )
     {
-      int bytes = sqlite3_value_bytes( argv[0] );
-      QgsRectangle r( spatialiteBlobBbox( blob, bytes ) );
-      request.setFilterRect( r );
+      // a bounding box in another CRS can't be used as a filter on the layer
+      SpatialiteBlobHeader header;
+      header.readFrom( blob );
+      if ( header.srid == c->mVtab->crs() )
+      {
+        QgsRectangle r( header.mbrMinX, header.mbrMinY, header.mbrMaxX, header.mbrMaxY );
+        request.setFilterRect( r );
+      }
     }
   }
   else if ( idxNum == 3 )
   {
     // comparison operator filter
     // build an expression filter and rely on expression compiler if available
-    QString expr = idxStr;
+    QString expr = indexStr.mid( separator + 1 );
     switch ( sqlite3_value_type( argv[0] ) )
     {
       case SQLITE_INTEGER:
@@ -637,7 +715,28 @@ int vtableFilter( sqlite3_vtab_cursor *cursor, int idxNum, const char *idxStr, i
     }
     request.setFilterExpression( expr );
   }
-  VTableCursor *c = reinterpret_cast<VTableCursor *>( cursor );
+
+  // only fetch the columns needed by the query
+  if ( columns != QLatin1String( "*" ) )
+  {
+    QgsAttributeList attributes;
+    bool needGeometry = false;
+    if ( !columns.isEmpty() )
+    {
+      const QStringList columnList = columns.split( ',' );
+      for ( const QString &column : columnList )
+      {
+        if ( column == QLatin1String( "g" ) )
+          needGeometry = true;
+        else
+          attributes << column.toInt();
+      }
+    }
+    request.setSubsetOfAttributes( attributes );
+    if ( !needGeometry && request.filterRect().isNull() )
+      request.setFlags( request.flags() | QgsFeatureRequest::NoGeometry );
+  }
+
   c->filter( request );
   return SQLITE_OK;
 }
@@ -715,6 +814,107 @@ int vtableColumn( sqlite3_vtab_cursor *cursor, sqlite3_context *ctxt, int idx )
   return SQLITE_OK;
 }
 
+#ifdef SQLITE_INDEX_CONSTRAINT_FUNCTION
+
+// spatial predicates overloaded when applied to the geometry column of a virtual table,
+// so that the bounding box of their second argument can be pushed down to the provider
+enum SpatialPredicate
+{
+  PredicateIntersects = 0,
+  PredicateContains,
+  PredicateWithin,
+  PredicateMbrIntersects,
+  PredicateMbrContains,
+  PredicateMbrWithin,
+};
+
+void spatialPredicateFunction( sqlite3_context *ctxt, int nArgs, sqlite3_value **args )
+{
+  const SpatialPredicate predicate = static_cast< SpatialPredicate >( reinterpret_cast< intptr_t >( sqlite3_user_data( ctxt ) ) );
+
+  const char *blobs[2] = { nullptr, nullptr };
+  int sizes[2] = { 0, 0 };
+  for ( int i = 0; i < 2 && i < nArgs; i++ )
+  {
+    if ( sqlite3_value_type( args[i] ) != SQLITE_BLOB )
+      continue;
+    sizes[i] = sqlite3_value_bytes( args[i] );
+    blobs[i] = reinterpret_cast< const char * >( sqlite3_value_blob( args[i] ) );
+    // SpatiaLite blobs start with a 0 byte
+    if ( sizes[i] < static_cast< int >( SpatialiteBlobHeader::LENGTH ) || blobs[i][0] != 0 )
+      blobs[i] = nullptr;
+  }
+  if ( !blobs[0] || !blobs[1] )
+  {
+    // same as SpatiaLite for invalid arguments
+    sqlite3_result_int( ctxt, -1 );
+    return;
+  }
+
+  bool result = false;
+  switch ( predicate )
+  {
+    case PredicateMbrIntersects:
+      result = spatialiteBlobBbox( blobs[0], sizes[0] ).intersects( spatialiteBlobBbox( blobs[1], sizes[1] ) );
+      break;
+    case PredicateMbrContains:
+      result = spatialiteBlobBbox( blobs[0], sizes[0] ).contains( spatialiteBlobBbox( blobs[1], sizes[1] ) );
+      break;
+    case PredicateMbrWithin:
+      result = spatialiteBlobBbox( blobs[1], sizes[1] ).contains( spatialiteBlobBbox( blobs[0], sizes[0] ) );
+      break;
+    case PredicateIntersects:
+    case PredicateContains:
+    case PredicateWithin:
+    {
+      // cheap rejection on bounding boxes before calling GEOS
+      if ( !spatialiteBlobBbox( blobs[0], sizes[0] ).intersects( spatialiteBlobBbox( blobs[1], sizes[1] ) ) )
+        break;
+
+      const QgsGeometry g1 = spatialiteBlobToQgsGeometry( blobs[0], sizes[0] );
+      const QgsGeometry g2 = spatialiteBlobToQgsGeometry( blobs[1], sizes[1] );
+      if ( predicate == PredicateIntersects )
+        result = g1.intersects( g2 );
+      else if ( predicate == PredicateContains )
+        result = g1.contains( g2 );
+      else
+        result = g1.within( g2 );
+      break;
+    }
+  }
+  sqlite3_result_int( ctxt, result ? 1 : 0 );
+}
+
+int vtableFindFunction( sqlite3_vtab *pvtab, int nArg, const char *zName, void ( **pxFunc )( sqlite3_context *, int, sqlite3_value ** ), void **ppArg )
+{
+  VTable *vtab = reinterpret_cast< VTable * >( pvtab );
+  if ( nArg != 2 || !vtab->hasGeometry() )
+    return 0;
+
+  static const QMap< QString, SpatialPredicate > sPredicates
+  {
+    { QStringLiteral( "intersects" ), PredicateIntersects },
+    { QStringLiteral( "st_intersects" ), PredicateIntersects },
+    { QStringLiteral( "contains" ), PredicateContains },
+    { QStringLiteral( "st_contains" ), PredicateContains },
+    { QStringLiteral( "within" ), PredicateWithin },
+    { QStringLiteral( "st_within" ), PredicateWithin },
+    { QStringLiteral( "mbrintersects" ), PredicateMbrIntersects },
+    { QStringLiteral( "mbrcontains" ), PredicateMbrContains },
+    { QStringLiteral( "mbrwithin" ), PredicateMbrWithin },
+  };
+
+  const auto it = sPredicates.constFind( QString::fromUtf8( zName ).toLower() );
+  if ( it == sPredicates.constEnd() )
+    return 0;
+
+  *pxFunc = spatialPredicateFunction;
+  *ppArg = reinterpret_cast< void * >( static_cast< intptr_t >( it.value() ) );
+  // all these predicates imply that the bounding boxes of both arguments intersect
+  return SQLITE_INDEX_CONSTRAINT_FUNCTION;
+}
+
+#endif
 
 static QCoreApplication *sCoreApp = nullptr;
 
@@ -946,7 +1146,11 @@ int qgsvlayerModuleInit( sqlite3 *db, char **pzErrMsg, void *unused /*const sqli
   module.xSync = nullptr;
   module.xCommit = nullptr;
   module.xRollback = nullptr;
+#ifdef SQLITE_INDEX_CONSTRAINT_FUNCTION
+  module.xFindFunction = vtableFindFunction;
+#else
   module.xFindFunction = nullptr;
+#endif
   module.xSavepoint = nullptr;
   module.xRelease = nullptr;
   module.xRollbackTo = nullptr;
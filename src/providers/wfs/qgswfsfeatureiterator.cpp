@@ -34,6 +34,7 @@
 
 #include <algorithm>
 #include <QDir>
+#include <QThread>
 #include <QTimer>
 
 QgsWFSFeatureHitsAsyncRequest::QgsWFSFeatureHitsAsyncRequest( QgsWFSDataSourceURI &uri )
@@ -432,6 +433,7 @@ void QgsWFSFeatureDownloaderImpl::run( bool serializeFeatures, int maxFeatures )
 
     int featureCountForThisResponse = 0;
     bool bytesStillAvailableInReply = false;
+    bool dataParsedForThisResponse = false;
     // Loop until there is no data coming from the current request
     while ( true )
     {
@@ -462,7 +464,14 @@ void QgsWFSFeatureDownloaderImpl::run( bool serializeFeatures, int maxFeatures )
       }
       // Parse the received chunk of data
       QString gmlProcessErrorMsg;
-      if ( !parser->processData( data, finished, gmlProcessErrorMsg ) )
+      // A response that is complete before any of it has been parsed can be
+      // split at feature boundaries and parsed on several threads
+      const bool parsed = finished && !dataParsedForThisResponse ?
+                          parser->processDataInParallel( data, QThread::idealThreadCount(), gmlProcessErrorMsg ) :
+                          parser->processData( data, finished, gmlProcessErrorMsg );
+      if ( !data.isEmpty() )
+        dataParsedForThisResponse = true;
+      if ( !parsed )
       {
         success = false;
         // Only add an error message if no general networking related error has been
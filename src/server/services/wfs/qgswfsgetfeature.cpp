@@ -36,6 +36,12 @@
 #include "qgsjsonutils.h"
 #include "qgsexpressioncontextutils.h"
 #include "qgswkbtypes.h"
+#include "qgspoint.h"
+#include "qgslinestring.h"
+#include "qgspolygon.h"
+#include "qgsgeometrycollection.h"
+
+#include <nlohmann/json.hpp>
 
 #include "qgswfsgetfeature.h"
 
@@ -61,32 +67,44 @@ namespace QgsWfs
       const QgsCoordinateReferenceSystem &outputCrs;
 
       bool forceGeomToMulti;
+
+      const QgsCoordinateTransform &transform;
+
+      const QVector<QByteArray> &attributeTagNames;
     };
 
-    QString createFeatureGeoJSON( const QgsFeature &feature, const createFeatureParams &params, const QgsAttributeList &pkAttributes );
+    void writeFeatureGeoJSON( QByteArray &buffer, const QgsFeature &feature, const createFeatureParams &params, const QgsAttributeList &pkAttributes );
 
     QString encodeValueToText( const QVariant &value, const QgsEditorWidgetSetup &setup );
 
-    QDomElement createFeatureGML2( const QgsFeature &feature, QDomDocument &doc, const createFeatureParams &params, const QgsProject *project, const QgsAttributeList &pkAttributes );
+    void writeFeatureGML( QByteArray &buffer, QgsWfsParameters::Format format, const QgsFeature &feature, const createFeatureParams &params, const QgsAttributeList &pkAttributes );
 
-    QDomElement createFeatureGML3( const QgsFeature &feature, QDomDocument &doc, const createFeatureParams &params, const QgsProject *project, const QgsAttributeList &pkAttributes );
+    bool writeGeometryGML( QByteArray &buffer, QgsWfsParameters::Format format, const QgsAbstractGeometry *geom, int prec, const QByteArray &srsName, int depth );
 
     void hitGetFeature( const QgsServerRequest &request, QgsServerResponse &response, const QgsProject *project,
                         QgsWfsParameters::Format format, int numberOfFeatures, const QStringList &typeNames );
 
     void startGetFeature( const QgsServerRequest &request, QgsServerResponse &response, const QgsProject *project,
                           QgsWfsParameters::Format format, int prec, QgsCoordinateReferenceSystem &crs,
-                          QgsRectangle *rect, const QStringList &typeNames );
+                          QgsRectangle *rect, const QStringList &typeNames, QByteArray &featureBuffer );
 
     void setGetFeature( QgsServerResponse &response, QgsWfsParameters::Format format, const QgsFeature &feature, int featIdx,
-                        const createFeatureParams &params, const QgsProject *project, const QgsAttributeList &pkAttributes = QgsAttributeList() );
+                        const createFeatureParams &params, QByteArray &featureBuffer, const QgsAttributeList &pkAttributes = QgsAttributeList() );
 
-    void endGetFeature( QgsServerResponse &response, QgsWfsParameters::Format format );
+    void endGetFeature( QgsServerResponse &response, QgsWfsParameters::Format format, QByteArray &featureBuffer );
+
+    void flushFeatureBuffer( QgsServerResponse &response, QByteArray &featureBuffer );
 
     QgsServerRequest::Parameters mRequestParameters;
     QgsWfsParameters mWfsParameters;
     /* GeoJSON Exporter */
     QgsJsonExporter mJsonExporter;
+
+    /* Serialized features are collected in a reusable buffer owned by the request
+     * and written to the response every FEATURE_BUFFER_FLUSH_SIZE bytes */
+    const int FEATURE_BUFFER_FLUSH_SIZE = 64 * 1024;
+
+    const char GML_XMLNS[] = " xmlns=\"http://www.opengis.net/gml\"";
   }
 
   void writeGetFeature( QgsServerInterface *serverIface, const QgsProject *project,
@@ -195,6 +213,8 @@ namespace QgsWfs
     long iteratedFeatures = 0;
     // sent features
     QgsFeature feature;
+    // serialized features not yet written to the response
+    QByteArray featureBuffer;
     qIt = aRequest.queries.begin();
     for ( ; qIt != aRequest.queries.end(); ++qIt )
     {
@@ -424,6 +444,16 @@ namespace QgsWfs
       }
       else
       {
+        // the output transformation and the attribute element names are shared by all the layer features
+        const QgsCoordinateTransform outputTransform( layerCrs, outputCrs, project );
+        QVector<QByteArray> attributeTagNames;
+        attributeTagNames.reserve( fields.count() );
+        for ( const QgsField &field : fields )
+        {
+          QString attributeName = field.name();
+          attributeTagNames.append( "qgs:" + attributeName.replace( ' ', '_' ).replace( cleanTagNameRegExp, QString() ).toUtf8() );
+        }
+
         const createFeatureParams cfp = { layerPrecision,
                                           layerCrs,
                                           attrIndexes,
@@ -431,16 +461,18 @@ namespace QgsWfs
                                           withGeom,
                                           geometryName,
                                           outputCrs,
-                                          forceGeomToMulti
+                                          forceGeomToMulti,
+                                          outputTransform,
+                                          attributeTagNames
                                         };
         while ( fit.nextFeature( feature ) && ( aRequest.maxFeatures == -1 || sentFeatures < aRequest.maxFeatures ) )
         {
           if ( iteratedFeatures == aRequest.startIndex )
-            startGetFeature( request, response, project, aRequest.outputFormat, requestPrecision, requestCrs, &requestRect, typeNameList );
+            startGetFeature( request, response, project, aRequest.outputFormat, requestPrecision, requestCrs, &requestRect, typeNameList, featureBuffer );
 
           if ( iteratedFeatures >= aRequest.startIndex )
           {
-            setGetFeature( response, aRequest.outputFormat, feature, sentFeatures, cfp, project, provider->pkAttributeIndexes() );
+            setGetFeature( response, aRequest.outputFormat, feature, sentFeatures, cfp, featureBuffer, pkAttributes );
             ++sentFeatures;
           }
           ++iteratedFeatures;
@@ -461,8 +493,8 @@ namespace QgsWfs
     {
       // End of GetFeature
       if ( iteratedFeatures <= aRequest.startIndex )
-        startGetFeature( request, response, project, aRequest.outputFormat, requestPrecision, requestCrs, &requestRect, typeNameList );
-      endGetFeature( response, aRequest.outputFormat );
+        startGetFeature( request, response, project, aRequest.outputFormat, requestPrecision, requestCrs, &requestRect, typeNameList, featureBuffer );
+      endGetFeature( response, aRequest.outputFormat, featureBuffer );
     }
 
   }
@@ -1077,12 +1109,15 @@ namespace QgsWfs
     }
 
     void startGetFeature( const QgsServerRequest &request, QgsServerResponse &response, const QgsProject *project, QgsWfsParameters::Format format,
-                          int prec, QgsCoordinateReferenceSystem &crs, QgsRectangle *rect, const QStringList &typeNames )
+                          int prec, QgsCoordinateReferenceSystem &crs, QgsRectangle *rect, const QStringList &typeNames, QByteArray &featureBuffer )
     {
       QString fcString;
 
       std::unique_ptr< QgsRectangle > transformedRect;
 
+      featureBuffer.clear();
+      featureBuffer.reserve( FEATURE_BUFFER_FLUSH_SIZE + FEATURE_BUFFER_FLUSH_SIZE / 2 );
+
       if ( format == QgsWfsParameters::Format::GeoJSON )
       {
         response.setHeader( "Content-Type", "application/vnd.geo+json; charset=utf-8" );
@@ -1207,204 +1242,386 @@ namespace QgsWfs
     }
 
     void setGetFeature( QgsServerResponse &response, QgsWfsParameters::Format format, const QgsFeature &feature, int featIdx,
-                        const createFeatureParams &params, const QgsProject *project, const QgsAttributeList &pkAttributes )
+                        const createFeatureParams &params, QByteArray &featureBuffer, const QgsAttributeList &pkAttributes )
     {
       if ( !feature.isValid() )
         return;
 
       if ( format == QgsWfsParameters::Format::GeoJSON )
       {
-        QString fcString;
         if ( featIdx == 0 )
-          fcString += QLatin1String( "  " );
+          featureBuffer.append( "  " );
         else
-          fcString += QLatin1String( " ," );
-        mJsonExporter.setSourceCrs( params.crs );
+          featureBuffer.append( " ," );
+        if ( mJsonExporter.sourceCrs() != params.crs )
+          mJsonExporter.setSourceCrs( params.crs );
         mJsonExporter.setIncludeGeometry( false );
         mJsonExporter.setIncludeAttributes( !params.attributeIndexes.isEmpty() );
         mJsonExporter.setAttributes( params.attributeIndexes );
-        fcString += createFeatureGeoJSON( feature, params, pkAttributes );
-        fcString += QLatin1String( "\n" );
-
-        response.write( fcString.toUtf8() );
+        writeFeatureGeoJSON( featureBuffer, feature, params, pkAttributes );
+        featureBuffer.append( '\n' );
       }
       else
       {
-        QDomDocument gmlDoc;
-        QDomElement featureElement;
-        if ( format == QgsWfsParameters::Format::GML3 )
-        {
-          featureElement = createFeatureGML3( feature, gmlDoc, params, project, pkAttributes );
-          gmlDoc.appendChild( featureElement );
-        }
-        else
-        {
-          featureElement = createFeatureGML2( feature, gmlDoc, params, project, pkAttributes );
-          gmlDoc.appendChild( featureElement );
-        }
-        response.write( gmlDoc.toByteArray() );
+        writeFeatureGML( featureBuffer, format, feature, params, pkAttributes );
       }
 
       // Stream partial content
-      response.flush();
+      if ( featureBuffer.size() >= FEATURE_BUFFER_FLUSH_SIZE )
+        flushFeatureBuffer( response, featureBuffer );
     }
 
-    void endGetFeature( QgsServerResponse &response, QgsWfsParameters::Format format )
+    void endGetFeature( QgsServerResponse &response, QgsWfsParameters::Format format, QByteArray &featureBuffer )
     {
-      QString fcString;
       if ( format == QgsWfsParameters::Format::GeoJSON )
       {
-        fcString += QLatin1String( " ]\n" );
-        fcString += QLatin1Char( '}' );
+        featureBuffer.append( " ]\n" );
+        featureBuffer.append( '}' );
       }
       else
       {
-        fcString = QStringLiteral( "</wfs:FeatureCollection>\n" );
+        featureBuffer.append( "</wfs:FeatureCollection>\n" );
       }
-      response.write( fcString.toUtf8() );
+      response.write( featureBuffer );
+      featureBuffer.clear();
     }
 
-
-    QString createFeatureGeoJSON( const QgsFeature &feature, const createFeatureParams &params, const QgsAttributeList &pkAttributes )
+    void flushFeatureBuffer( QgsServerResponse &response, QByteArray &featureBuffer )
     {
-      QString id = QStringLiteral( "%1.%2" ).arg( params.typeName, QgsServerFeatureId::getServerFid( feature, pkAttributes ) );
-      //QgsJsonExporter force transform geometry to EPSG:4326
-      //and the RFC 7946 GeoJSON specification recommends limiting coordinate precision to 6
-      //Q_UNUSED( prec )
+      response.write( featureBuffer );
+      response.flush();
 
-      //copy feature so we can modify its geometry as required
-      QgsFeature f( feature );
-      QgsGeometry geom = feature.geometry();
-      if ( !geom.isNull() && params.withGeom && params.geometryName != QLatin1String( "NONE" ) )
+      // keep the reserved capacity for the next features, unless a huge feature made it grow
+      if ( featureBuffer.capacity() > 4 * FEATURE_BUFFER_FLUSH_SIZE )
       {
-        mJsonExporter.setIncludeGeometry( true );
-        if ( params.geometryName == QLatin1String( "EXTENT" ) )
-        {
-          QgsRectangle box = geom.boundingBox();
-          f.setGeometry( QgsGeometry::fromRect( box ) );
-        }
-        else if ( params.geometryName == QLatin1String( "CENTROID" ) )
+        featureBuffer.clear();
+        featureBuffer.reserve( FEATURE_BUFFER_FLUSH_SIZE + FEATURE_BUFFER_FLUSH_SIZE / 2 );
+      }
+      else
+      {
+        featureBuffer.resize( 0 );
+      }
+    }
+
+    void appendDouble( QByteArray &buffer, double value, int precision )
+    {
+      // same output as qgsDoubleToString, without the QString round trip
+      QByteArray number = QByteArray::number( value, 'f', precision );
+      if ( precision )
+      {
+        if ( number.contains( '.' ) )
         {
-          f.setGeometry( geom.centroid() );
+          // remove ending 0s
+          int idx = number.length() - 1;
+          while ( number.at( idx ) == '0' && idx > 1 )
+          {
+            idx--;
+          }
+          if ( idx < number.length() - 1 )
+            number.truncate( number.at( idx ) == '.' ? idx : idx + 1 );
         }
       }
+      else if ( number == "-0" )
+      {
+        number = QByteArrayLiteral( "0" );
+      }
+      buffer.append( number );
+    }
 
-      return mJsonExporter.exportFeature( f, QVariantMap(), id );
+    void appendEscapedText( QByteArray &buffer, const QString &text, bool attribute )
+    {
+      // escape the text the same way QDomDocument does when serializing
+      const QByteArray utf8 = text.toUtf8();
+      const char *data = utf8.constData();
+      const int size = utf8.size();
+      int start = 0;
+      for ( int i = 0; i < size; ++i )
+      {
+        const char *entity = nullptr;
+        switch ( data[i] )
+        {
+          case '<':
+            entity = "&lt;";
+            break;
+          case '&':
+            entity = "&amp;";
+            break;
+          case '>':
+            if ( i >= 2 && data[i - 1] == ']' && data[i - 2] == ']' )
+              entity = "&gt;";
+            break;
+          case '"':
+            if ( attribute )
+              entity = "&quot;";
+            break;
+          case '\n':
+            if ( attribute )
+              entity = "&#xa;";
+            break;
+          case '\r':
+            // QDomDocument escapes carriage returns in text nodes too
+            entity = "&#xd;";
+            break;
+          case '\t':
+            if ( attribute )
+              entity = "&#x9;";
+            break;
+          default:
+            break;
+        }
+        if ( entity )
+        {
+          buffer.append( data + start, i - start );
+          buffer.append( entity );
+          start = i + 1;
+        }
+      }
+      buffer.append( data + start, size - start );
     }
 
+    void startGmlElement( QByteArray &buffer, int depth, const char *name, const QByteArray &attributes = QByteArray() )
+    {
+      buffer.append( depth, ' ' );
+      buffer.append( '<' );
+      buffer.append( name );
+      buffer.append( GML_XMLNS );
+      buffer.append( attributes );
+    }
 
-    QDomElement createFeatureGML2( const QgsFeature &feature, QDomDocument &doc, const createFeatureParams &params, const QgsProject *project, const QgsAttributeList &pkAttributes )
+    void endElement( QByteArray &buffer, int depth, const char *name )
     {
-      //gml:FeatureMember
-      QDomElement featureElement = doc.createElement( QStringLiteral( "gml:featureMember" )/*wfs:FeatureMember*/ );
+      buffer.append( depth, ' ' );
+      buffer.append( "</" );
+      buffer.append( name );
+      buffer.append( ">\n" );
+    }
 
-      //qgs:%TYPENAME%
-      QDomElement typeNameElement = doc.createElement( "qgs:" + params.typeName /*qgs:%TYPENAME%*/ );
-      QString id = QStringLiteral( "%1.%2" ).arg( params.typeName, QgsServerFeatureId::getServerFid( feature, pkAttributes ) );
-      typeNameElement.setAttribute( QStringLiteral( "fid" ), id );
-      featureElement.appendChild( typeNameElement );
+    void writeLineStringGML( QByteArray &buffer, QgsWfsParameters::Format format, const QgsLineString *line, const char *name, int prec, const QByteArray &srsName, int depth )
+    {
+      startGmlElement( buffer, depth, name, srsName );
+      if ( line->isEmpty() )
+      {
+        buffer.append( "/>\n" );
+        return;
+      }
+      buffer.append( ">\n" );
 
-      //add geometry column (as gml)
-      QgsGeometry geom = feature.geometry();
-      if ( !geom.isNull() && params.withGeom && params.geometryName != QLatin1String( "NONE" ) )
+      const int count = line->numPoints();
+      const double *x = line->xData();
+      const double *y = line->yData();
+      if ( format == QgsWfsParameters::Format::GML3 )
       {
-        int prec = params.precision;
-        QgsCoordinateReferenceSystem crs = params.crs;
-        QgsCoordinateTransform mTransform( crs, params.outputCrs, project );
-        try
-        {
-          QgsGeometry transformed = geom;
-          if ( transformed.transform( mTransform ) == 0 )
+        const double *z = line->zData();
+        startGmlElement( buffer, depth + 1, "posList" );
+        buffer.append( z ? " srsDimension=\"3\">" : " srsDimension=\"2\">" );
+        for ( int i = 0; i < count; ++i )
+        {
+          if ( i > 0 )
+            buffer.append( ' ' );
+          appendDouble( buffer, x[i], prec );
+          buffer.append( ' ' );
+          appendDouble( buffer, y[i], prec );
+          if ( z )
           {
-            geom = transformed;
-            crs = params.outputCrs;
-            if ( crs.isGeographic() && !params.crs.isGeographic() )
-              prec = std::min( params.precision + 3, 6 );
+            buffer.append( ' ' );
+            appendDouble( buffer, z[i], prec );
           }
         }
-        catch ( QgsCsException &cse )
+        buffer.append( "</posList>\n" );
+      }
+      else
+      {
+        startGmlElement( buffer, depth + 1, "coordinates" );
+        buffer.append( " cs=\",\" ts=\" \">" );
+        for ( int i = 0; i < count; ++i )
         {
-          Q_UNUSED( cse )
+          if ( i > 0 )
+            buffer.append( ' ' );
+          appendDouble( buffer, x[i], prec );
+          buffer.append( ',' );
+          appendDouble( buffer, y[i], prec );
         }
+        buffer.append( "</coordinates>\n" );
+      }
+      endElement( buffer, depth, name );
+    }
 
-        QDomElement geomElem = doc.createElement( QStringLiteral( "qgs:geometry" ) );
-        QDomElement gmlElem;
-        QgsGeometry cloneGeom( geom );
-        if ( params.geometryName == QLatin1String( "EXTENT" ) )
-        {
-          cloneGeom = QgsGeometry::fromRect( geom.boundingBox() );
-        }
-        else if ( params.geometryName == QLatin1String( "CENTROID" ) )
+    bool writeGeometryGML( QByteArray &buffer, QgsWfsParameters::Format format, const QgsAbstractGeometry *geom, int prec, const QByteArray &srsName, int depth )
+    {
+      // writes the same elements as QgsAbstractGeometry::asGml2() / asGml3()
+      // for the linear geometry types, returns false for the other ones
+      const bool gml3 = format == QgsWfsParameters::Format::GML3;
+      const QgsWkbTypes::Type flatType = QgsWkbTypes::flatType( geom->wkbType() );
+      switch ( flatType )
+      {
+        case QgsWkbTypes::Point:
         {
-          cloneGeom = geom.centroid();
+          const QgsPoint *point = qgsgeometry_cast<const QgsPoint *>( geom );
+          if ( !point )
+            return false;
+
+          startGmlElement( buffer, depth, "Point", srsName );
+          buffer.append( ">\n" );
+          if ( gml3 )
+          {
+            startGmlElement( buffer, depth + 1, "pos" );
+            buffer.append( point->is3D() ? " srsDimension=\"3\">" : " srsDimension=\"2\">" );
+            appendDouble( buffer, point->x(), prec );
+            buffer.append( ' ' );
+            appendDouble( buffer, point->y(), prec );
+            if ( point->is3D() )
+            {
+              buffer.append( ' ' );
+              appendDouble( buffer, point->z(), prec );
+            }
+            buffer.append( "</pos>\n" );
+          }
+          else
+          {
+            startGmlElement( buffer, depth + 1, "coordinates" );
+            buffer.append( " cs=\",\" ts=\" \">" );
+            appendDouble( buffer, point->x(), prec );
+            buffer.append( ',' );
+            appendDouble( buffer, point->y(), prec );
+            buffer.append( "</coordinates>\n" );
+          }
+          endElement( buffer, depth, "Point" );
+          return true;
         }
-        else if ( params.forceGeomToMulti && ! QgsWkbTypes::isMultiType( geom.wkbType() ) )
+
+        case QgsWkbTypes::LineString:
         {
-          cloneGeom.convertToMultiType();
+          const QgsLineString *line = qgsgeometry_cast<const QgsLineString *>( geom );
+          if ( !line )
+            return false;
+
+          writeLineStringGML( buffer, format, line, "LineString", prec, srsName, depth );
+          return true;
         }
-        const QgsAbstractGeometry *abstractGeom = cloneGeom.constGet();
-        if ( abstractGeom )
+
+        case QgsWkbTypes::Polygon:
         {
-          gmlElem = abstractGeom->asGml2( doc, prec, "http://www.opengis.net/gml" );
+          const QgsPolygon *polygon = qgsgeometry_cast<const QgsPolygon *>( geom );
+          if ( !polygon )
+            return false;
+
+          startGmlElement( buffer, depth, "Polygon", srsName );
+          if ( polygon->isEmpty() )
+          {
+            buffer.append( "/>\n" );
+            return true;
+          }
+          buffer.append( ">\n" );
+          for ( int i = 0, n = polygon->numInteriorRings(); i <= n; ++i )
+          {
+            const QgsLineString *ring = qgsgeometry_cast<const QgsLineString *>( i == 0 ? polygon->exteriorRing() : polygon->interiorRing( i - 1 ) );
+            if ( !ring )
+              return false;
+
+            const char *boundary = nullptr;
+            if ( gml3 )
+              boundary = i == 0 ? "exterior" : "interior";
+            else
+              boundary = i == 0 ? "outerBoundaryIs" : "innerBoundaryIs";
+            startGmlElement( buffer, depth + 1, boundary );
+            buffer.append( ">\n" );
+            writeLineStringGML( buffer, format, ring, "LinearRing", prec, QByteArray(), depth + 2 );
+            endElement( buffer, depth + 1, boundary );
+          }
+          endElement( buffer, depth, "Polygon" );
+          return true;
         }
 
-        if ( !gmlElem.isNull() )
+        case QgsWkbTypes::MultiPoint:
+        case QgsWkbTypes::MultiLineString:
+        case QgsWkbTypes::MultiPolygon:
         {
-          QgsRectangle box = geom.boundingBox();
-          QDomElement bbElem = doc.createElement( QStringLiteral( "gml:boundedBy" ) );
-          QDomElement boxElem = QgsOgcUtils::rectangleToGMLBox( &box, doc, prec );
+          const QgsGeometryCollection *collection = qgsgeometry_cast<const QgsGeometryCollection *>( geom );
+          if ( !collection )
+            return false;
 
-          if ( crs.isValid() )
+          const char *name = "MultiPoint";
+          const char *member = "pointMember";
+          if ( flatType == QgsWkbTypes::MultiLineString )
           {
-            boxElem.setAttribute( QStringLiteral( "srsName" ), crs.authid() );
-            gmlElem.setAttribute( QStringLiteral( "srsName" ), crs.authid() );
+            name = gml3 ? "MultiCurve" : "MultiLineString";
+            member = gml3 ? "curveMember" : "lineStringMember";
+          }
+          else if ( flatType == QgsWkbTypes::MultiPolygon )
+          {
+            name = "MultiPolygon";
+            member = "polygonMember";
           }
 
-          bbElem.appendChild( boxElem );
-          typeNameElement.appendChild( bbElem );
-
-          geomElem.appendChild( gmlElem );
-          typeNameElement.appendChild( geomElem );
+          startGmlElement( buffer, depth, name, srsName );
+          if ( collection->isEmpty() )
+          {
+            buffer.append( "/>\n" );
+            return true;
+          }
+          buffer.append( ">\n" );
+          for ( int i = 0; i < collection->numGeometries(); ++i )
+          {
+            startGmlElement( buffer, depth + 1, member );
+            buffer.append( ">\n" );
+            if ( !writeGeometryGML( buffer, format, collection->geometryN( i ), prec, QByteArray(), depth + 2 ) )
+              return false;
+            endElement( buffer, depth + 1, member );
+          }
+          endElement( buffer, depth, name );
+          return true;
         }
+
+        default:
+          return false;
       }
+    }
 
-      //read all attribute values from the feature
-      QgsAttributes featureAttributes = feature.attributes();
-      QgsFields fields = feature.fields();
-      for ( int i = 0; i < params.attributeIndexes.count(); ++i )
+    void writeFeatureGeoJSON( QByteArray &buffer, const QgsFeature &feature, const createFeatureParams &params, const QgsAttributeList &pkAttributes )
+    {
+      QString id = QStringLiteral( "%1.%2" ).arg( params.typeName, QgsServerFeatureId::getServerFid( feature, pkAttributes ) );
+      //QgsJsonExporter force transform geometry to EPSG:4326
+      //and the RFC 7946 GeoJSON specification recommends limiting coordinate precision to 6
+      //Q_UNUSED( prec )
+
+      //copy feature so we can modify its geometry as required
+      QgsFeature f( feature );
+      QgsGeometry geom = feature.geometry();
+      if ( !geom.isNull() && params.withGeom && params.geometryName != QLatin1String( "NONE" ) )
       {
-        int idx = params.attributeIndexes[i];
-        if ( idx >= fields.count() )
+        mJsonExporter.setIncludeGeometry( true );
+        if ( params.geometryName == QLatin1String( "EXTENT" ) )
         {
-          continue;
+          QgsRectangle box = geom.boundingBox();
+          f.setGeometry( QgsGeometry::fromRect( box ) );
         }
-        const QgsField field = fields.at( idx );
-        const QgsEditorWidgetSetup setup = field.editorWidgetSetup();
-        QString attributeName = field.name();
-
-        QDomElement fieldElem = doc.createElement( "qgs:" + attributeName.replace( ' ', '_' ).replace( cleanTagNameRegExp, QString() ) );
-        QDomText fieldText = doc.createTextNode( encodeValueToText( featureAttributes[idx], setup ) );
-        if ( featureAttributes[idx].isNull() )
+        else if ( params.geometryName == QLatin1String( "CENTROID" ) )
         {
-          fieldElem.setAttribute( QStringLiteral( "xsi:nil" ), QStringLiteral( "true" ) );
+          f.setGeometry( geom.centroid() );
         }
-        fieldElem.appendChild( fieldText );
-        typeNameElement.appendChild( fieldElem );
       }
 
-      return featureElement;
+      // dump the utf-8 json straight into the buffer
+      const std::string json = mJsonExporter.exportFeatureToJsonObject( f, QVariantMap(), id ).dump();
+      buffer.append( json.data(), static_cast< int >( json.size() ) );
     }
 
-    QDomElement createFeatureGML3( const QgsFeature &feature, QDomDocument &doc, const createFeatureParams &params, const QgsProject *project, const QgsAttributeList &pkAttributes )
+
+    void writeFeatureGML( QByteArray &buffer, QgsWfsParameters::Format format, const QgsFeature &feature, const createFeatureParams &params, const QgsAttributeList &pkAttributes )
     {
+      const bool gml3 = format == QgsWfsParameters::Format::GML3;
+
       //gml:FeatureMember
-      QDomElement featureElement = doc.createElement( QStringLiteral( "gml:featureMember" )/*wfs:FeatureMember*/ );
+      buffer.append( "<gml:featureMember>\n" );
 
       //qgs:%TYPENAME%
-      QDomElement typeNameElement = doc.createElement( "qgs:" + params.typeName /*qgs:%TYPENAME%*/ );
+      const QByteArray typeNameTag = "qgs:" + params.typeName.toUtf8();
       QString id = QStringLiteral( "%1.%2" ).arg( params.typeName, QgsServerFeatureId::getServerFid( feature, pkAttributes ) );
-      typeNameElement.setAttribute( QStringLiteral( "gml:id" ), id );
-      featureElement.appendChild( typeNameElement );
+      buffer.append( " <" );
+      buffer.append( typeNameTag );
+      buffer.append( gml3 ? " gml:id=\"" : " fid=\"" );
+      appendEscapedText( buffer, id, true );
+      buffer.append( "\">\n" );
 
       //add geometry column (as gml)
       QgsGeometry geom = feature.geometry();
@@ -1412,11 +1629,10 @@ namespace QgsWfs
       {
         int prec = params.precision;
         QgsCoordinateReferenceSystem crs = params.crs;
-        QgsCoordinateTransform mTransform( crs, params.outputCrs, project );
         try
         {
           QgsGeometry transformed = geom;
-          if ( transformed.transform( mTransform ) == 0 )
+          if ( transformed.transform( params.transform ) == 0 )
           {
             geom = transformed;
             crs = params.outputCrs;
@@ -1429,8 +1645,6 @@ namespace QgsWfs
           Q_UNUSED( cse )
         }
 
-        QDomElement geomElem = doc.createElement( QStringLiteral( "qgs:geometry" ) );
-        QDomElement gmlElem;
         QgsGeometry cloneGeom( geom );
         if ( params.geometryName == QLatin1String( "EXTENT" ) )
         {
@@ -1444,59 +1658,109 @@ namespace QgsWfs
         {
           cloneGeom.convertToMultiType();
         }
+
         const QgsAbstractGeometry *abstractGeom = cloneGeom.constGet();
         if ( abstractGeom )
         {
-          gmlElem = abstractGeom->asGml3( doc, prec, "http://www.opengis.net/gml" );
-        }
-
-        if ( !gmlElem.isNull() )
-        {
-          QgsRectangle box = geom.boundingBox();
-          QDomElement bbElem = doc.createElement( QStringLiteral( "gml:boundedBy" ) );
-          QDomElement boxElem = QgsOgcUtils::rectangleToGMLEnvelope( &box, doc, prec );
-
+          QByteArray srsName;
           if ( crs.isValid() )
           {
-            boxElem.setAttribute( QStringLiteral( "srsName" ), crs.authid() );
-            gmlElem.setAttribute( QStringLiteral( "srsName" ), crs.authid() );
+            srsName = " srsName=\"";
+            appendEscapedText( srsName, crs.authid(), true );
+            srsName.append( '"' );
           }
 
-          bbElem.appendChild( boxElem );
-          typeNameElement.appendChild( bbElem );
+          const int boundedBySize = buffer.size();
+          const QgsRectangle box = geom.boundingBox();
+          buffer.append( "  <gml:boundedBy>\n" );
+          if ( gml3 )
+          {
+            buffer.append( "   <gml:Envelope" );
+            buffer.append( srsName );
+            buffer.append( ">\n    <gml:lowerCorner>" );
+            appendDouble( buffer, box.xMinimum(), prec );
+            buffer.append( ' ' );
+            appendDouble( buffer, box.yMinimum(), prec );
+            buffer.append( "</gml:lowerCorner>\n    <gml:upperCorner>" );
+            appendDouble( buffer, box.xMaximum(), prec );
+            buffer.append( ' ' );
+            appendDouble( buffer, box.yMaximum(), prec );
+            buffer.append( "</gml:upperCorner>\n   </gml:Envelope>\n" );
+          }
+          else
+          {
+            buffer.append( "   <gml:Box" );
+            buffer.append( srsName );
+            buffer.append( ">\n    <gml:coordinates cs=\",\" ts=\" \">" );
+            appendDouble( buffer, box.xMinimum(), prec );
+            buffer.append( ',' );
+            appendDouble( buffer, box.yMinimum(), prec );
+            buffer.append( ' ' );
+            appendDouble( buffer, box.xMaximum(), prec );
+            buffer.append( ',' );
+            appendDouble( buffer, box.yMaximum(), prec );
+            buffer.append( "</gml:coordinates>\n   </gml:Box>\n" );
+          }
+          buffer.append( "  </gml:boundedBy>\n" );
+
+          buffer.append( "  <qgs:geometry>\n" );
+          const int geometrySize = buffer.size();
+          bool geometryWritten = writeGeometryGML( buffer, format, abstractGeom, prec, srsName, 3 );
+          if ( !geometryWritten )
+          {
+            // curved geometries still go through the DOM
+            buffer.truncate( geometrySize );
+            QDomDocument doc;
+            QDomElement gmlElem = gml3 ? abstractGeom->asGml3( doc, prec, GML_NAMESPACE ) : abstractGeom->asGml2( doc, prec, GML_NAMESPACE );
+            if ( !gmlElem.isNull() )
+            {
+              if ( crs.isValid() )
+              {
+                gmlElem.setAttribute( QStringLiteral( "srsName" ), crs.authid() );
+              }
+              doc.appendChild( gmlElem );
+              buffer.append( doc.toByteArray() );
+              geometryWritten = true;
+            }
+          }
 
-          geomElem.appendChild( gmlElem );
-          typeNameElement.appendChild( geomElem );
+          if ( geometryWritten )
+            buffer.append( "  </qgs:geometry>\n" );
+          else
+            buffer.truncate( boundedBySize );
         }
       }
 
       //read all attribute values from the feature
-      QgsAttributes featureAttributes = feature.attributes();
-      QgsFields fields = feature.fields();
+      const QgsAttributes featureAttributes = feature.attributes();
+      const QgsFields fields = feature.fields();
       for ( int i = 0; i < params.attributeIndexes.count(); ++i )
       {
         int idx = params.attributeIndexes[i];
-        if ( idx >= fields.count() )
+        if ( idx >= fields.count() || idx >= params.attributeTagNames.count() )
         {
           continue;
         }
 
-        const QgsField field = fields.at( idx );
-        const QgsEditorWidgetSetup setup = field.editorWidgetSetup();
-
-        QString attributeName = field.name();
+        const QgsEditorWidgetSetup setup = fields.at( idx ).editorWidgetSetup();
+        const QByteArray &tagName = params.attributeTagNames.at( idx );
 
-        QDomElement fieldElem = doc.createElement( "qgs:" + attributeName.replace( ' ', '_' ).replace( cleanTagNameRegExp, QString() ) );
-        QDomText fieldText = doc.createTextNode( encodeValueToText( featureAttributes[idx], setup ) );
-        if ( featureAttributes[idx].isNull() )
+        buffer.append( "  <" );
+        buffer.append( tagName );
+        if ( featureAttributes.at( idx ).isNull() )
         {
-          fieldElem.setAttribute( QStringLiteral( "xsi:nil" ), QStringLiteral( "true" ) );
+          buffer.append( " xsi:nil=\"true\"" );
         }
-        fieldElem.appendChild( fieldText );
-        typeNameElement.appendChild( fieldElem );
+        buffer.append( '>' );
+        appendEscapedText( buffer, encodeValueToText( featureAttributes.at( idx ), setup ), false );
+        buffer.append( "</" );
+        buffer.append( tagName );
+        buffer.append( ">\n" );
       }
 
-      return featureElement;
+      buffer.append( " </" );
+      buffer.append( typeNameTag );
+      buffer.append( ">\n</gml:featureMember>\n" );
     }
 
     QString encodeValueToText( const QVariant &value, const QgsEditorWidgetSetup &setup )
@@ -115,6 +115,10 @@ class TestQgsProcessingAlgs: public QObject
 
     void layoutMapExtent();
 
+    void tiledOverlay();
+    void dissolveCascaded();
+    void fixGeometriesChunked();
+
     void styleFromProject();
     void combineStyles();
 
@@ -3173,6 +3177,218 @@ void TestQgsProcessingAlgs::layoutMapExtent()
 
 }
 
+void TestQgsProcessingAlgs::tiledOverlay()
+{
+  // large enough inputs to use the tiled parallel overlay: two grids of unit squares,
+  // the second one shifted by half a square
+  const int size = 110;
+  QgsVectorLayer *layerA = new QgsVectorLayer( QStringLiteral( "Polygon?crs=epsg:3857&field=id_a:integer" ), QStringLiteral( "a" ), QStringLiteral( "memory" ) );
+  QgsVectorLayer *layerB = new QgsVectorLayer( QStringLiteral( "Polygon?crs=epsg:3857&field=id_b:integer" ), QStringLiteral( "b" ), QStringLiteral( "memory" ) );
+  QVERIFY( layerA->isValid() );
+  QVERIFY( layerB->isValid() );
+  QgsFeatureList featuresA;
+  QgsFeatureList featuresB;
+  for ( int row = 0; row < size; ++row )
+  {
+    for ( int column = 0; column < size; ++column )
+    {
+      QgsFeature f;
+      f.setAttributes( QgsAttributes() << row * size + column );
+      f.setGeometry( QgsGeometry::fromRect( QgsRectangle( column, row, column + 1, row + 1 ) ) );
+      featuresA << f;
+      f.setGeometry( QgsGeometry::fromRect( QgsRectangle( column + 0.5, row + 0.5, column + 1.5, row + 1.5 ) ) );
+      featuresB << f;
+    }
+  }
+  // features without geometry are kept by the difference
+  QgsFeature noGeometry;
+  noGeometry.setAttributes( QgsAttributes() << -1 );
+  featuresA << noGeometry;
+  layerA->dataProvider()->addFeatures( featuresA );
+  layerB->dataProvider()->addFeatures( featuresB );
+
+  QgsProject p;
+  p.addMapLayers( QList< QgsMapLayer * >() << layerA << layerB );
+  std::unique_ptr< QgsProcessingContext > context = qgis::make_unique< QgsProcessingContext >();
+  context->setProject( &p );
+  QgsProcessingFeedback feedback;
+
+  QVariantMap parameters;
+  parameters.insert( QStringLiteral( "INPUT" ), layerA->id() );
+  parameters.insert( QStringLiteral( "OVERLAY" ), layerB->id() );
+  parameters.insert( QStringLiteral( "OUTPUT" ), QgsProcessing::TEMPORARY_OUTPUT );
+
+  std::unique_ptr< QgsProcessingAlgorithm > alg( QgsApplication::processingRegistry()->createAlgorithmById( QStringLiteral( "native:intersection" ) ) );
+  bool ok = false;
+  QVariantMap results = alg->run( parameters, *context, &feedback, &ok );
+  QVERIFY( ok );
+  // the feature without geometry counts as processed too
+  QCOMPARE( feedback.progress(), 100.0 );
+
+  QgsVectorLayer *intersectionLayer = qobject_cast< QgsVectorLayer * >( context->getMapLayer( results.value( QStringLiteral( "OUTPUT" ) ).toString() ) );
+  QVERIFY( intersectionLayer );
+  // each pair of overlapping squares must be output exactly once, even when crossing tile borders
+  QCOMPARE( intersectionLayer->featureCount(), static_cast< long >( ( 2 * size - 1 ) * ( 2 * size - 1 ) ) );
+  QSet< QPair< int, int > > pairs;
+  double area = 0;
+  QgsFeature f;
+  QgsFeatureIterator it = intersectionLayer->getFeatures();
+  while ( it.nextFeature( f ) )
+  {
+    pairs.insert( qMakePair( f.attribute( 0 ).toInt(), f.attribute( 1 ).toInt() ) );
+    area += f.geometry().area();
+  }
+  QCOMPARE( pairs.size(), ( 2 * size - 1 ) * ( 2 * size - 1 ) );
+  QGSCOMPARENEAR( area, ( size - 0.5 ) * ( size - 0.5 ), 1e-6 );
+
+  alg.reset( QgsApplication::processingRegistry()->createAlgorithmById( QStringLiteral( "native:difference" ) ) );
+  results = alg->run( parameters, *context, &feedback, &ok );
+  QVERIFY( ok );
+
+  QgsVectorLayer *differenceLayer = qobject_cast< QgsVectorLayer * >( context->getMapLayer( results.value( QStringLiteral( "OUTPUT" ) ).toString() ) );
+  QVERIFY( differenceLayer );
+  // only the squares of the first row and column are not completely covered
+  QCOMPARE( differenceLayer->featureCount(), static_cast< long >( 2 * size - 1 + 1 ) );
+  area = 0;
+  QList< int > ids;
+  it = differenceLayer->getFeatures();
+  while ( it.nextFeature( f ) )
+  {
+    ids << f.attribute( 0 ).toInt();
+    area += f.geometry().area();
+  }
+  // the features are written in the order of the input, as with the serial code path
+  QCOMPARE( ids.size(), 2 * size - 1 + 1 );
+  QCOMPARE( ids.last(), -1 );
+  ids.removeLast();
+  QVERIFY( std::is_sorted( ids.constBegin(), ids.constEnd() ) );
+  QCOMPARE( qgis::listToSet( ids ).size(), 2 * size - 1 );
+  QGSCOMPARENEAR( area, size * size - ( size - 0.5 ) * ( size - 0.5 ), 1e-6 );
+}
+
+void TestQgsProcessingAlgs::dissolveCascaded()
+{
+  // enough squares for several levels of the union tree
+  const int size = 60;
+  QgsVectorLayer *layer = new QgsVectorLayer( QStringLiteral( "Polygon?crs=epsg:3857&field=grp:integer" ), QStringLiteral( "squares" ), QStringLiteral( "memory" ) );
+  QVERIFY( layer->isValid() );
+  QgsFeatureList features;
+  for ( int row = 0; row < size; ++row )
+  {
+    for ( int column = 0; column < size; ++column )
+    {
+      QgsFeature f;
+      f.setAttributes( QgsAttributes() << ( column < size / 2 ? 1 : 2 ) );
+      f.setGeometry( QgsGeometry::fromRect( QgsRectangle( column, row, column + 1, row + 1 ) ) );
+      features << f;
+    }
+  }
+  layer->dataProvider()->addFeatures( features );
+
+  QgsProject p;
+  p.addMapLayer( layer );
+  std::unique_ptr< QgsProcessingContext > context = qgis::make_unique< QgsProcessingContext >();
+  context->setProject( &p );
+  QgsProcessingFeedback feedback;
+
+  std::unique_ptr< QgsProcessingAlgorithm > alg( QgsApplication::processingRegistry()->createAlgorithmById( QStringLiteral( "native:dissolve" ) ) );
+  QVariantMap parameters;
+  parameters.insert( QStringLiteral( "INPUT" ), layer->id() );
+  parameters.insert( QStringLiteral( "OUTPUT" ), QgsProcessing::TEMPORARY_OUTPUT );
+
+  bool ok = false;
+  QVariantMap results = alg->run( parameters, *context, &feedback, &ok );
+  QVERIFY( ok );
+  QgsVectorLayer *outputLayer = qobject_cast< QgsVectorLayer * >( context->getMapLayer( results.value( QStringLiteral( "OUTPUT" ) ).toString() ) );
+  QVERIFY( outputLayer );
+  QCOMPARE( outputLayer->featureCount(), 1L );
+  QgsFeature f;
+  QVERIFY( outputLayer->getFeatures().nextFeature( f ) );
+  QCOMPARE( f.geometry().constGet()->partCount(), 1 );
+  QGSCOMPARENEAR( f.geometry().area(), size * size, 1e-6 );
+
+  parameters.insert( QStringLiteral( "FIELD" ), QStringLiteral( "grp" ) );
+  results = alg->run( parameters, *context, &feedback, &ok );
+  QVERIFY( ok );
+  outputLayer = qobject_cast< QgsVectorLayer * >( context->getMapLayer( results.value( QStringLiteral( "OUTPUT" ) ).toString() ) );
+  QVERIFY( outputLayer );
+  QCOMPARE( outputLayer->featureCount(), 2L );
+  QgsFeatureIterator it = outputLayer->getFeatures();
+  while ( it.nextFeature( f ) )
+  {
+    QCOMPARE( f.geometry().constGet()->partCount(), 1 );
+    QGSCOMPARENEAR( f.geometry().area(), size * size / 2, 1e-6 );
+    QCOMPARE( f.geometry().boundingBox().width(), size / 2.0 );
+  }
+}
+
+void TestQgsProcessingAlgs::fixGeometriesChunked()
+{
+  // enough features for several chunks, alternating valid squares, bow ties and features without geometry
+  const int count = 2500;
+  QgsVectorLayer *layer = new QgsVectorLayer( QStringLiteral( "Polygon?crs=epsg:3857&field=id:integer" ), QStringLiteral( "polys" ), QStringLiteral( "memory" ) );
+  QVERIFY( layer->isValid() );
+  QgsFeatureList features;
+  for ( int i = 0; i < count; ++i )
+  {
+    QgsFeature f;
+    f.setAttributes( QgsAttributes() << i );
+    if ( i % 3 == 0 )
+      f.setGeometry( QgsGeometry::fromRect( QgsRectangle( i, 0, i + 2, 2 ) ) );
+    else if ( i % 3 == 1 )
+      f.setGeometry( QgsGeometry::fromWkt( QStringLiteral( "POLYGON((%1 0, %2 2, %2 0, %1 2, %1 0))" ).arg( i ).arg( i + 2 ) ) );
+    features << f;
+  }
+  layer->dataProvider()->addFeatures( features );
+
+  QgsProject p;
+  p.addMapLayer( layer );
+  std::unique_ptr< QgsProcessingContext > context = qgis::make_unique< QgsProcessingContext >();
+  context->setProject( &p );
+  QgsProcessingFeedback feedback;
+
+  std::unique_ptr< QgsProcessingAlgorithm > alg( QgsApplication::processingRegistry()->createAlgorithmById( QStringLiteral( "native:fixgeometries" ) ) );
+  QVariantMap parameters;
+  parameters.insert( QStringLiteral( "INPUT" ), layer->id() );
+  parameters.insert( QStringLiteral( "OUTPUT" ), QgsProcessing::TEMPORARY_OUTPUT );
+
+  bool ok = false;
+  const QVariantMap results = alg->run( parameters, *context, &feedback, &ok );
+  QVERIFY( ok );
+  QgsVectorLayer *outputLayer = qobject_cast< QgsVectorLayer * >( context->getMapLayer( results.value( QStringLiteral( "OUTPUT" ) ).toString() ) );
+  QVERIFY( outputLayer );
+  QCOMPARE( outputLayer->featureCount(), static_cast< long >( count ) );
+  QCOMPARE( outputLayer->wkbType(), QgsWkbTypes::MultiPolygon );
+
+  // features keep the order of the input
+  QgsFeatureIterator it = outputLayer->getFeatures();
+  QgsFeature f;
+  int expectedId = 0;
+  while ( it.nextFeature( f ) )
+  {
+    QCOMPARE( f.attribute( 0 ).toInt(), expectedId );
+    switch ( expectedId % 3 )
+    {
+      case 0:
+        QVERIFY( f.geometry().isGeosValid() );
+        QCOMPARE( f.geometry().constGet()->partCount(), 1 );
+        QGSCOMPARENEAR( f.geometry().area(), 4, 1e-6 );
+        break;
+      case 1:
+        // bow ties are split into two triangles
+        QVERIFY( f.geometry().isGeosValid() );
+        QCOMPARE( f.geometry().constGet()->partCount(), 2 );
+        QGSCOMPARENEAR( f.geometry().area(), 2, 1e-6 );
+        break;
+      case 2:
+        QVERIFY( !f.hasGeometry() );
+        break;
+    }
+    expectedId++;
+  }
+  QCOMPARE( expectedId, count );
+}
+
 void TestQgsProcessingAlgs::styleFromProject()
 {
   QgsProject p;
@@ -46,6 +46,7 @@ class TestQgsCoordinateTransform: public QObject
     void transform2DPoint();
     void transformErrorMultiplePoints();
     void transformErrorOnePoint();
+    void transformWebMercator();
     void testDeprecated4240to4326();
     void testCustomProjTransform();
 };
@@ -540,6 +541,55 @@ void TestQgsCoordinateTransform::transformErrorOnePoint()
   }
 }
 
+void TestQgsCoordinateTransform::transformWebMercator()
+{
+  // WGS 84 to web mercator is computed directly, check it against the results from PROJ
+  QgsCoordinateTransformContext context;
+  QgsCoordinateTransform ct( QgsCoordinateReferenceSystem::fromEpsgId( 4326 ), QgsCoordinateReferenceSystem::fromEpsgId( 3857 ), context );
+  QVERIFY( ct.isValid() );
+
+  double x[] = { 10, -75.5, 0 };
+  double y[] = { 45, -33.25, 0 };
+  double z[] = { 0, 0, 0 };
+  ct.transformCoords( 3, x, y, z );
+  QGSCOMPARENEAR( x[0], 1113194.907933, 0.000001 );
+  QGSCOMPARENEAR( y[0], 5621521.486192, 0.000001 );
+  QGSCOMPARENEAR( x[1], -8404621.554892, 0.000001 );
+  QGSCOMPARENEAR( y[1], -3928534.490427, 0.000001 );
+  QGSCOMPARENEAR( x[2], 0, 0.000001 );
+  QGSCOMPARENEAR( y[2], 0, 0.000001 );
+
+  // and back, in reverse direction
+  ct.transformCoords( 3, x, y, z, QgsCoordinateTransform::ReverseTransform );
+  QGSCOMPARENEAR( x[0], 10, 0.000000001 );
+  QGSCOMPARENEAR( y[0], 45, 0.000000001 );
+  QGSCOMPARENEAR( x[1], -75.5, 0.000000001 );
+  QGSCOMPARENEAR( y[1], -33.25, 0.000000001 );
+
+  // reversed transform
+  QgsCoordinateTransform reverseCt( QgsCoordinateReferenceSystem::fromEpsgId( 3857 ), QgsCoordinateReferenceSystem::fromEpsgId( 4326 ), context );
+  QgsPointXY p = reverseCt.transform( QgsPointXY( 1113194.907933, 5621521.486192 ) );
+  QGSCOMPARENEAR( p.x(), 10, 0.000000001 );
+  QGSCOMPARENEAR( p.y(), 45, 0.000000001 );
+
+  // a point close to the pole is left to PROJ, with the other points
+  double x2[] = { 10, 10 };
+  double y2[] = { 45, 89 };
+  double z2[] = { 0, 0 };
+  ct.transformCoords( 2, x2, y2, z2 );
+  QGSCOMPARENEAR( x2[0], 1113194.907933, 0.000001 );
+  QGSCOMPARENEAR( y2[0], 5621521.486192, 0.000001 );
+  QGSCOMPARENEAR( x2[1], 1113194.907933, 0.000001 );
+  QGSCOMPARENEAR( y2[1], 30240971.958386, 0.0001 );
+
+  // z values are not changed
+  double x3[] = { 10 };
+  double y3[] = { 45 };
+  double z3[] = { 15 };
+  ct.transformCoords( 1, x3, y3, z3 );
+  QCOMPARE( z3[0], 15.0 );
+}
+
 void TestQgsCoordinateTransform::testDeprecated4240to4326()
 {
 #if PROJ_VERSION_MAJOR >= 6
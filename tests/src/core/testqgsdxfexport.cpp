@@ -63,6 +63,7 @@ class TestQgsDxfExport : public QObject
     void testCurveExport();
     void testCurveExport_data();
     void testDashedLine();
+    void testMultipleLayers();
 
   private:
     QgsVectorLayer *mPointLayer = nullptr;
@@ -1173,6 +1174,52 @@ void TestQgsDxfExport::testDashedLine()
                               , &debugInfo ), debugInfo.toUtf8().constData() );
 }
 
+void TestQgsDxfExport::testMultipleLayers()
+{
+  // features are fetched in the background, make sure that layers larger than a
+  // single batch are written completely, and to the right dxf layers
+  std::unique_ptr< QgsVectorLayer > vl = qgis::make_unique< QgsVectorLayer >( QStringLiteral( "Point?crs=epsg:4326" ), QStringLiteral( "many_points" ), QStringLiteral( "memory" ) );
+  QgsFeatureList features;
+  for ( int i = 0; i < 2500; ++i )
+  {
+    QgsFeature f;
+    f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( -118 + ( i % 50 ) * 0.5, 24 + ( i / 50 ) * 0.5 ) ) );
+    features << f;
+  }
+  vl->dataProvider()->addFeatures( features );
+
+  QgsDxfExport d;
+  d.addLayers( QList< QgsDxfExport::DxfLayer >() << QgsDxfExport::DxfLayer( vl.get() ) << QgsDxfExport::DxfLayer( mLineLayer ) );
+
+  QgsRectangle extent = vl->extent();
+  extent.combineExtentWith( mLineLayer->extent() );
+
+  QgsMapSettings mapSettings;
+  QSize size( 640, 480 );
+  mapSettings.setOutputSize( size );
+  mapSettings.setExtent( extent );
+  mapSettings.setLayers( QList<QgsMapLayer *>() << vl.get() << mLineLayer );
+  mapSettings.setOutputDpi( 96 );
+  mapSettings.setDestinationCrs( vl->crs() );
+
+  d.setMapSettings( mapSettings );
+  d.setSymbologyScale( 1000 );
+
+  QString file = getTempFileName( "multiple_layers_dxf" );
+  QFile dxfFile( file );
+  QCOMPARE( d.writeToFile( &dxfFile, QStringLiteral( "CP1252" ) ), QgsDxfExport::ExportResult::Success );
+  dxfFile.close();
+
+  // reload and compare
+  std::unique_ptr< QgsVectorLayer > result = qgis::make_unique< QgsVectorLayer >( file, "dxf" );
+  QVERIFY( result->isValid() );
+  QCOMPARE( result->featureCount(), 2500 + mLineLayer->featureCount() );
+  QVERIFY( result->setSubsetString( QStringLiteral( "\"Layer\" = 'many_points'" ) ) );
+  QCOMPARE( result->featureCount(), 2500L );
+  QVERIFY( result->setSubsetString( QStringLiteral( "\"Layer\" = 'lines'" ) ) );
+  QCOMPARE( result->featureCount(), mLineLayer->featureCount() );
+}
+
 bool TestQgsDxfExport::fileContainsText( const QString &path, const QString &text, QString *debugInfo ) const
 {
   QStringList debugLines;
@@ -0,0 +1,253 @@
+/***************************************************************************
+     testqgsfeatureexternalsorter.cpp
+     --------------------------------------
+    Date                 : November 2020
+    Copyright            : (C) 2020 by the QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+#include <QObject>
+#include <QSet>
+#include <QString>
+
+#include <qgsapplication.h>
+#include "qgsfeatureiterator.h"
+#include "qgsgeometry.h"
+#include "qgsinterval.h"
+#include "qgsvectordataprovider.h"
+#include "qgsvectorlayer.h"
+#include "qgsfeatureexternalsorter_p.h"
+
+#include <random>
+
+static QgsFields _fields()
+{
+  QgsFields fields;
+  fields.append( QgsField( QStringLiteral( "key" ), QVariant::Int ) );
+  fields.append( QgsField( QStringLiteral( "name" ), QVariant::String ) );
+  return fields;
+}
+
+//! Returns \a count features with random keys, some of them NULL, and their key as order by value
+static QList<QgsIndexedFeature> _randomFeatures( int count )
+{
+  std::mt19937 generator( 42 );
+  std::uniform_int_distribution< int > keys( 0, count / 4 );
+
+  const QgsFields fields = _fields();
+  QList<QgsIndexedFeature> features;
+  for ( int i = 0; i < count; ++i )
+  {
+    const QVariant key = i % 97 == 0 ? QVariant() : QVariant( keys( generator ) );
+
+    QgsIndexedFeature feature;
+    feature.mFeature = QgsFeature( fields, i );
+    feature.mFeature.setAttributes( QgsAttributes() << key << QStringLiteral( "feature %1" ).arg( i ) );
+    feature.mFeature.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( i, -i ) ) );
+    feature.mIndexes << key;
+    features << feature;
+  }
+  return features;
+}
+
+class TestQgsFeatureExternalSorter : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void inMemory();
+    void runs_data();
+    void runs();
+    void empty();
+    void userTypes();
+    void orderByRequest();
+
+  private:
+
+    //! Checks that \a sorted holds all the \a features ordered by key
+    void checkSorted( const QList<QgsFeature> &sorted, const QList<QgsIndexedFeature> &features, bool ascending, bool nullsFirst );
+};
+
+void TestQgsFeatureExternalSorter::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+}
+
+void TestQgsFeatureExternalSorter::cleanupTestCase()
+{
+  QgsApplication::exitQgis();
+}
+
+void TestQgsFeatureExternalSorter::checkSorted( const QList<QgsFeature> &sorted, const QList<QgsIndexedFeature> &features, bool ascending, bool nullsFirst )
+{
+  QCOMPARE( sorted.count(), features.count() );
+
+  QSet<QgsFeatureId> ids;
+  for ( int i = 0; i < sorted.count(); ++i )
+  {
+    const QgsFeature &feature = sorted.at( i );
+    ids << feature.id();
+
+    // attributes, geometry and fields survive the temporary files
+    QCOMPARE( feature.fields(), _fields() );
+    QCOMPARE( feature.attribute( QStringLiteral( "name" ) ).toString(), QStringLiteral( "feature %1" ).arg( feature.id() ) );
+    QCOMPARE( feature.geometry().asWkt(), QStringLiteral( "Point (%1 %2)" ).arg( feature.id() ).arg( -feature.id() ) );
+
+    if ( i == 0 )
+      continue;
+
+    const QVariant previous = sorted.at( i - 1 ).attribute( 0 );
+    const QVariant key = feature.attribute( 0 );
+    if ( previous.isNull() || key.isNull() )
+    {
+      if ( previous.isNull() != key.isNull() )
+        QCOMPARE( previous.isNull(), nullsFirst );
+    }
+    else if ( ascending )
+    {
+      QVERIFY( previous.toInt() <= key.toInt() );
+    }
+    else
+    {
+      QVERIFY( previous.toInt() >= key.toInt() );
+    }
+  }
+  QCOMPARE( ids.count(), features.count() );
+}
+
+void TestQgsFeatureExternalSorter::inMemory()
+{
+  const QList<QgsIndexedFeature> features = _randomFeatures( 1000 );
+
+  QgsFeatureExternalSorter sorter( QList<QgsFeatureRequest::OrderByClause>() << QgsFeatureRequest::OrderByClause( QStringLiteral( "key" ), true, false ) );
+  for ( const QgsIndexedFeature &feature : features )
+    sorter.addFeature( feature );
+  sorter.finish();
+
+  // everything fits in memory, no temporary file
+  QCOMPARE( sorter.runCount(), 0 );
+
+  QList<QgsFeature> sorted;
+  QgsFeature feature;
+  while ( sorter.nextFeature( feature ) )
+    sorted << feature;
+  checkSorted( sorted, features, true, false );
+  QVERIFY( !sorter.nextFeature( feature ) );
+}
+
+void TestQgsFeatureExternalSorter::runs_data()
+{
+  QTest::addColumn<bool>( "ascending" );
+  QTest::addColumn<bool>( "nullsFirst" );
+
+  QTest::newRow( "ascending nulls last" ) << true << false;
+  QTest::newRow( "ascending nulls first" ) << true << true;
+  QTest::newRow( "descending nulls last" ) << false << false;
+  QTest::newRow( "descending nulls first" ) << false << true;
+}
+
+void TestQgsFeatureExternalSorter::runs()
+{
+  QFETCH( bool, ascending );
+  QFETCH( bool, nullsFirst );
+
+  const QList<QgsIndexedFeature> features = _randomFeatures( 20000 );
+
+  // tiny memory budget, to force many sorted runs
+  QgsFeatureExternalSorter sorter( QList<QgsFeatureRequest::OrderByClause>() << QgsFeatureRequest::OrderByClause( QStringLiteral( "key" ), ascending, nullsFirst ), 64 * 1024 );
+  for ( const QgsIndexedFeature &feature : features )
+    sorter.addFeature( feature );
+  sorter.finish();
+
+  QVERIFY( sorter.runCount() > 10 );
+
+  QList<QgsFeature> sorted;
+  QgsFeature feature;
+  while ( sorter.nextFeature( feature ) )
+    sorted << feature;
+  checkSorted( sorted, features, ascending, nullsFirst );
+}
+
+void TestQgsFeatureExternalSorter::empty()
+{
+  QgsFeatureExternalSorter sorter( QList<QgsFeatureRequest::OrderByClause>() << QgsFeatureRequest::OrderByClause( QStringLiteral( "key" ) ) );
+  sorter.finish();
+  QgsFeature feature;
+  QVERIFY( !sorter.nextFeature( feature ) );
+}
+
+void TestQgsFeatureExternalSorter::userTypes()
+{
+  // the second half of the features has an order by value without stream operators
+  QList<QgsIndexedFeature> features = _randomFeatures( 20000 );
+  for ( int i = 10000; i < features.count(); ++i )
+    features[i].mIndexes << QVariant::fromValue( QgsInterval( i ) );
+
+  QgsFeatureExternalSorter sorter( QList<QgsFeatureRequest::OrderByClause>() << QgsFeatureRequest::OrderByClause( QStringLiteral( "key" ) )
+                                   << QgsFeatureRequest::OrderByClause( QStringLiteral( "duration" ) ), 64 * 1024 );
+  for ( int i = 0; i < 10000; ++i )
+    sorter.addFeature( features.at( i ) );
+  const int runCount = sorter.runCount();
+  QVERIFY( runCount > 0 );
+
+  // those features are kept in memory, and merged with the runs written before
+  for ( int i = 10000; i < features.count(); ++i )
+    sorter.addFeature( features.at( i ) );
+  sorter.finish();
+  QCOMPARE( sorter.runCount(), runCount );
+
+  QList<QgsFeature> sorted;
+  QgsFeature feature;
+  while ( sorter.nextFeature( feature ) )
+    sorted << feature;
+  checkSorted( sorted, features, true, false );
+}
+
+void TestQgsFeatureExternalSorter::orderByRequest()
+{
+  QgsVectorLayer layer( QStringLiteral( "Point?field=key:integer&field=name:string" ), QStringLiteral( "layer" ), QStringLiteral( "memory" ) );
+  QVERIFY( layer.isValid() );
+
+  QgsFeatureList features;
+  for ( const QgsIndexedFeature &feature : _randomFeatures( 5000 ) )
+    features << feature.mFeature;
+  QVERIFY( layer.dataProvider()->addFeatures( features ) );
+
+  QgsFeatureRequest request;
+  request.addOrderBy( QStringLiteral( "key" ), true, false );
+  request.addOrderBy( QStringLiteral( "name" ), false );
+  QgsFeatureIterator it = layer.getFeatures( request );
+
+  QgsFeature previous;
+  QgsFeature feature;
+  int count = 0;
+  while ( it.nextFeature( feature ) )
+  {
+    if ( count++ > 0 && !previous.attribute( 0 ).isNull() && !feature.attribute( 0 ).isNull() )
+    {
+      QVERIFY( previous.attribute( 0 ).toInt() <= feature.attribute( 0 ).toInt() );
+      if ( previous.attribute( 0 ) == feature.attribute( 0 ) )
+        QVERIFY( previous.attribute( 1 ).toString().localeAwareCompare( feature.attribute( 1 ).toString() ) >= 0 );
+    }
+    else if ( count > 1 )
+    {
+      // NULLs last
+      QVERIFY( feature.attribute( 0 ).isNull() );
+    }
+    previous = feature;
+  }
+  QCOMPARE( count, 5000 );
+}
+
+QGSTEST_MAIN( TestQgsFeatureExternalSorter )
+#include "testqgsfeatureexternalsorter.moc"
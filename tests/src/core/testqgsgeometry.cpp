@@ -49,11 +49,14 @@
 #include "qgscircularstring.h"
 #include "qgsgeometrycollection.h"
 #include "qgsgeometryfactory.h"
+#include "qgsgeometrytransformbatch.h"
 #include "qgscurvepolygon.h"
 #include "qgsproject.h"
 #include "qgslinesegment.h"
 #include "qgsgeos.h"
+#include "qgsgeometryvalidator.h"
 #include "qgsreferencedgeometry.h"
+#include "qgsexception.h"
 
 //qgs unit test utility class
 #include "qgsrenderchecker.h"
@@ -149,6 +152,7 @@ class TestQgsGeometry : public QObject
     void poleOfInaccessibility();
 
     void makeValid();
+    void validateGeometries();
 
     void isSimple();
 
@@ -168,6 +172,8 @@ class TestQgsGeometry : public QObject
 
     void wktParser();
 
+    void transformBatch();
+
   private:
     //! Must be called before each render test
     void initPainterTest();
@@ -17559,6 +17565,46 @@ void TestQgsGeometry::makeValid()
   }
 }
 
+void TestQgsGeometry::validateGeometries()
+{
+  // alternate valid squares, self intersecting bow ties and null geometries, enough
+  // to be split across several chunks
+  QVector< QgsGeometry > geometries;
+  for ( int i = 0; i < 300; ++i )
+  {
+    switch ( i % 3 )
+    {
+      case 0:
+        geometries << QgsGeometry::fromRect( QgsRectangle( i, 0, i + 1, 1 ) );
+        break;
+      case 1:
+        geometries << QgsGeometry::fromWkt( QStringLiteral( "POLYGON((%1 0, %2 1, %2 0, %1 1, %1 0))" ).arg( i ).arg( i + 1 ) );
+        break;
+      case 2:
+        geometries << QgsGeometry();
+        break;
+    }
+  }
+
+  const QList< QgsGeometry::ValidationMethod > methods = QList< QgsGeometry::ValidationMethod >() << QgsGeometry::ValidatorQgisInternal << QgsGeometry::ValidatorGeos;
+  for ( QgsGeometry::ValidationMethod method : methods )
+  {
+    const QVector< QVector< QgsGeometry::Error > > errors = QgsGeometryValidator::validateGeometries( geometries, method );
+    QCOMPARE( errors.size(), geometries.size() );
+    for ( int i = 0; i < geometries.size(); ++i )
+    {
+      QVector< QgsGeometry::Error > expected;
+      geometries.at( i ).validateGeometry( expected, method );
+      QCOMPARE( errors.at( i ).size(), expected.size() );
+      QCOMPARE( errors.at( i ).isEmpty(), i % 3 != 1 );
+      if ( !expected.isEmpty() )
+        QCOMPARE( errors.at( i ).at( 0 ).what(), expected.at( 0 ).what() );
+    }
+  }
+
+  QVERIFY( QgsGeometryValidator::validateGeometries( QVector< QgsGeometry >() ).isEmpty() );
+}
+
 void TestQgsGeometry::isSimple()
 {
   typedef QPair<QString, bool> InputWktAndExpectedResult;
@@ -18134,6 +18180,90 @@ void TestQgsGeometry::testRandomPointsInPolygon()
   QVERIFY( foundp2Point );
 }
 
+void TestQgsGeometry::transformBatch()
+{
+  QgsCoordinateReferenceSystem sourceSrs( QStringLiteral( "EPSG:3994" ) );
+  QgsCoordinateReferenceSystem destSrs( QStringLiteral( "EPSG:4202" ) );
+  QgsCoordinateTransform tr( sourceSrs, destSrs, QgsProject::instance() );
+
+  // parts and rings transformed at once must match the vertices transformed one by one
+  const QStringList wkts = QStringList()
+                           << QStringLiteral( "MultiPoint ((6374985 -3626584),(6474985 -3526584))" )
+                           << QStringLiteral( "MultiPointZ ((6374985 -3626584 1),(6474985 -3526584 2))" )
+                           << QStringLiteral( "PolygonZ ((6374985 -3626584 1, 6474985 -3526584 2, 6474985 -3626584 3, 6374985 -3626584 1),(6400000 -3600000 4, 6410000 -3590000 5, 6410000 -3600000 6, 6400000 -3600000 4))" )
+                           << QStringLiteral( "MultiPolygon (((6374985 -3626584, 6474985 -3526584, 6474985 -3626584, 6374985 -3626584)),((6500000 -3600000, 6510000 -3590000, 6510000 -3600000, 6500000 -3600000)))" )
+                           << QStringLiteral( "CurvePolygon (CompoundCurve (CircularString (6374985 -3626584, 6474985 -3526584, 6574985 -3626584),(6574985 -3626584, 6374985 -3626584)),(6400000 -3600000, 6410000 -3590000, 6410000 -3600000, 6400000 -3600000))" )
+                           << QStringLiteral( "GeometryCollection (Point (6374985 -3626584), LineString (6374985 -3626584, 6474985 -3526584), Polygon ((6374985 -3626584, 6474985 -3526584, 6474985 -3626584, 6374985 -3626584)))" );
+
+  for ( const QString &wkt : wkts )
+  {
+    for ( bool transformZ : { false, true } )
+    {
+      QgsGeometry geom = QgsGeometry::fromWkt( wkt );
+      std::unique_ptr< QgsAbstractGeometry > expected( geom.constGet()->clone() );
+      QgsVertexId id;
+      QgsPoint vertex;
+      while ( geom.constGet()->nextVertex( id, vertex ) )
+      {
+        vertex.transform( tr, QgsCoordinateTransform::ForwardTransform, transformZ );
+        expected->moveVertex( id, vertex );
+      }
+
+      geom.get()->transform( tr, QgsCoordinateTransform::ForwardTransform, transformZ );
+      QCOMPARE( geom.asWkt( 6 ), expected->asWkt( 6 ) );
+      // cached bounding boxes were cleared
+      QCOMPARE( geom.boundingBox().toString( 6 ), expected->boundingBox().toString( 6 ) );
+    }
+  }
+
+  // several geometries in a single batch
+  QgsGeometry point = QgsGeometry::fromWkt( QStringLiteral( "Point (6374985 -3626584)" ) );
+  QgsGeometry line = QgsGeometry::fromWkt( QStringLiteral( "LineString (6374985 -3626584, 6474985 -3526584)" ) );
+  QgsGeometryTransformBatch batch( tr );
+  batch.addGeometry( point.get() );
+  batch.addGeometry( line.get() );
+  QCOMPARE( batch.vertexCount(), 3 );
+  batch.transform();
+  QCOMPARE( batch.vertexCount(), 0 );
+  const QgsPoint *transformedPoint = qgsgeometry_cast< const QgsPoint * >( point.constGet() );
+  QGSCOMPARENEAR( transformedPoint->x(), 175.771, 0.001 );
+  QGSCOMPARENEAR( transformedPoint->y(), -39.724, 0.001 );
+  const QgsLineString *transformedLine = qgsgeometry_cast< const QgsLineString * >( line.constGet() );
+  QGSCOMPARENEAR( transformedLine->xAt( 0 ), 175.771, 0.001 );
+  QGSCOMPARENEAR( transformedLine->yAt( 0 ), -39.724, 0.001 );
+  QGSCOMPARENEAR( transformedLine->xAt( 1 ), 176.959, 0.001 );
+  QGSCOMPARENEAR( transformedLine->yAt( 1 ), -38.7999, 0.001 );
+  QGSCOMPARENEAR( line.boundingBox().xMaximum(), 176.959, 0.001 );
+
+  // a point which cannot be transformed raises an exception, and leaves the other parts untouched
+  QgsCoordinateTransform invalidTr( QgsCoordinateReferenceSystem( QStringLiteral( "EPSG:4326" ) ), QgsCoordinateReferenceSystem( QStringLiteral( "EPSG:28356" ) ), QgsProject::instance() );
+  QgsGeometry invalidPoint = QgsGeometry::fromWkt( QStringLiteral( "Point (-99999999999 99999999999)" ) );
+  QgsGeometry validLine = QgsGeometry::fromWkt( QStringLiteral( "LineString (151 -33, 152 -34)" ) );
+  QgsGeometryTransformBatch invalidBatch( invalidTr );
+  invalidBatch.addGeometry( validLine.get() );
+  invalidBatch.addGeometry( invalidPoint.get() );
+  bool errorObtained = false;
+  try
+  {
+    invalidBatch.transform();
+  }
+  catch ( QgsCsException & )
+  {
+    errorObtained = true;
+  }
+  QVERIFY( errorObtained );
+  QCOMPARE( invalidBatch.vertexCount(), 0 );
+  QCOMPARE( validLine.asWkt(), QStringLiteral( "LineString (151 -33, 152 -34)" ) );
+  QCOMPARE( invalidPoint.asWkt(), QStringLiteral( "Point (-99999999999 99999999999)" ) );
+
+  // the line alone is transformed as when transforming it directly
+  QgsGeometry expectedLine = validLine;
+  expectedLine.transform( invalidTr );
+  invalidBatch.addGeometry( validLine.get() );
+  invalidBatch.transform();
+  QCOMPARE( validLine.asWkt( 3 ), expectedLine.asWkt( 3 ) );
+}
+
 void TestQgsGeometry::wktParser()
 {
   // POINT
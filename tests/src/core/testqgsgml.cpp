@@ -81,6 +81,9 @@ class TestQgsGML : public QObject
     void testThroughOGRGeometry_urn_EPSG_4326();
     void testAccents();
     void testSameTypeameAsGeomName();
+    void testCoordinatesParsing();
+    void testCoordinatesSeparators();
+    void testParallelParsing();
 };
 
 const QString data1( "<myns:FeatureCollection "
@@ -1272,5 +1275,170 @@ void TestQgsGML::testSameTypeameAsGeomName()
   delete features[0].first;
 }
 
+void TestQgsGML::testCoordinatesParsing()
+{
+  QgsFields fields;
+  QgsGmlStreamingParser gmlParser( QStringLiteral( "mytypename" ), QStringLiteral( "mygeom" ), fields );
+  QCOMPARE( gmlParser.processData( QByteArray( "<myns:FeatureCollection "
+                                   "xmlns:myns='http://myns' "
+                                   "xmlns:gml='http://www.opengis.net/gml'>"
+                                   "<gml:featureMember>"
+                                   "<myns:mytypename fid='mytypename.1'>"
+                                   "<myns:mygeom>"
+                                   "<gml:LineString srsName='EPSG:27700'>"
+                                   "<gml:coordinates cs=';' ts='|'>1.5;-2e1|  +3 ; .25 |</gml:coordinates>"
+                                   "</gml:LineString>"
+                                   "</myns:mygeom>"
+                                   "</myns:mytypename>"
+                                   "</gml:featureMember>"
+                                   "<gml:featureMember>"
+                                   "<myns:mytypename fid='mytypename.2'>"
+                                   "<myns:mygeom>"
+                                   "<gml:LineString srsName='EPSG:27700'>"
+                                   "<gml:posList>\n\t10 20\n  1.2345678901234567890123 -0.000001\n"
+                                   "12345678901234567890 1E-3 </gml:posList>"
+                                   "</gml:LineString>"
+                                   "</myns:mygeom>"
+                                   "</myns:mytypename>"
+                                   "</gml:featureMember>"
+                                   "</myns:FeatureCollection>" ), true ), true );
+  QVector<QgsGmlStreamingParser::QgsGmlFeaturePtrGmlIdPair> features = gmlParser.getAndStealReadyFeatures();
+  QCOMPARE( features.size(), 2 );
+
+  QgsPolylineXY line = features[0].first->geometry().asPolyline();
+  QCOMPARE( line.size(), 2 );
+  QCOMPARE( line[0], QgsPointXY( 1.5, -20 ) );
+  QCOMPARE( line[1], QgsPointXY( 3, 0.25 ) );
+
+  line = features[1].first->geometry().asPolyline();
+  QCOMPARE( line.size(), 3 );
+  QCOMPARE( line[0], QgsPointXY( 10, 20 ) );
+  QCOMPARE( line[1].x(), 1.2345678901234567890123 );
+  QCOMPARE( line[1].y(), -0.000001 );
+  QCOMPARE( line[2].x(), 12345678901234567890.0 );
+  QCOMPARE( line[2].y(), 0.001 );
+
+  delete features[0].first;
+  delete features[1].first;
+}
+
+void TestQgsGML::testCoordinatesSeparators()
+{
+  QgsFields fields;
+  QgsGmlStreamingParser gmlParser( QStringLiteral( "mytypename" ), QStringLiteral( "mygeom" ), fields );
+  QCOMPARE( gmlParser.processData( QByteArray( "<myns:FeatureCollection "
+                                   "xmlns:myns='http://myns' "
+                                   "xmlns:gml='http://www.opengis.net/gml'>"
+                                   "<gml:featureMember>"
+                                   "<myns:mytypename fid='mytypename.1'>"
+                                   "<myns:mygeom>"
+                                   "<gml:LineString srsName='EPSG:27700'>"
+                                   "<gml:coordinates cs=' ' ts=';'>1 2;3  4; 5 6</gml:coordinates>"
+                                   "</gml:LineString>"
+                                   "</myns:mygeom>"
+                                   "</myns:mytypename>"
+                                   "</gml:featureMember>"
+                                   "<gml:featureMember>"
+                                   "<myns:mytypename fid='mytypename.2'>"
+                                   "<myns:mygeom>"
+                                   "<gml:LineString srsName='EPSG:27700'>"
+                                   "<gml:coordinates cs=':' ts='//'>1:2//3:4/5//6:7</gml:coordinates>"
+                                   "</gml:LineString>"
+                                   "</myns:mygeom>"
+                                   "</myns:mytypename>"
+                                   "</gml:featureMember>"
+                                   "<gml:featureMember>"
+                                   "<myns:mytypename fid='mytypename.3'>"
+                                   "<myns:mygeom>"
+                                   "<gml:LineString srsName='EPSG:27700'>"
+                                   // the default tuple separator is a single space, not any white space
+                                   "<gml:coordinates>1,2\t3,4 5,6 7,8</gml:coordinates>"
+                                   "</gml:LineString>"
+                                   "</myns:mygeom>"
+                                   "</myns:mytypename>"
+                                   "</gml:featureMember>"
+                                   "</myns:FeatureCollection>" ), true ), true );
+  QVector<QgsGmlStreamingParser::QgsGmlFeaturePtrGmlIdPair> features = gmlParser.getAndStealReadyFeatures();
+  QCOMPARE( features.size(), 3 );
+
+  QgsPolylineXY line = features[0].first->geometry().asPolyline();
+  QCOMPARE( line.size(), 3 );
+  QCOMPARE( line[0], QgsPointXY( 1, 2 ) );
+  QCOMPARE( line[1], QgsPointXY( 3, 4 ) );
+  QCOMPARE( line[2], QgsPointXY( 5, 6 ) );
+
+  line = features[1].first->geometry().asPolyline();
+  QCOMPARE( line.size(), 2 );
+  QCOMPARE( line[0], QgsPointXY( 1, 2 ) );
+  QCOMPARE( line[1], QgsPointXY( 6, 7 ) );
+
+  line = features[2].first->geometry().asPolyline();
+  QCOMPARE( line.size(), 2 );
+  QCOMPARE( line[0], QgsPointXY( 5, 6 ) );
+  QCOMPARE( line[1], QgsPointXY( 7, 8 ) );
+
+  delete features[0].first;
+  delete features[1].first;
+  delete features[2].first;
+}
+
+void TestQgsGML::testParallelParsing()
+{
+  QgsFields fields;
+  fields.append( QgsField( QStringLiteral( "intfield" ), QVariant::Int, QStringLiteral( "int" ) ) );
+
+  // large enough to be split into several chunks
+  QByteArray data( "<?xml version='1.0' encoding='UTF-8'?>"
+                   "<wfs:FeatureCollection "
+                   "xmlns:myns='http://myns' "
+                   "xmlns:wfs='http://www.opengis.net/wfs/2.0' "
+                   "xmlns:gml='http://www.opengis.net/gml/3.2' numberMatched='50000' numberReturned='50000'>"
+                   "<wfs:boundedBy><gml:Envelope srsName='urn:ogc:def:crs:EPSG::4326'>"
+                   "<gml:lowerCorner>0 0</gml:lowerCorner><gml:upperCorner>49999 1</gml:upperCorner>"
+                   "</gml:Envelope></wfs:boundedBy>" );
+  const int featureCount = 50000;
+  for ( int i = 0; i < featureCount; ++i )
+  {
+    // reported in the middle of a chunk, not by the parser of the whole document
+    if ( i == featureCount / 2 )
+      data += "<wfs:truncatedResponse>too many features</wfs:truncatedResponse>";
+    data += QStringLiteral( "<wfs:member><myns:mytypename gml:id='mytypename.%1'>"
+                            "<myns:intfield>%1</myns:intfield>"
+                            "<myns:mygeom><gml:Point gml:id='p%1' srsName='urn:ogc:def:crs:EPSG::4326'>"
+                            "<gml:pos>%2 %1</gml:pos></gml:Point></myns:mygeom>"
+                            "</myns:mytypename></wfs:member>" ).arg( i ).arg( i % 2 ).toUtf8();
+  }
+  data += "</wfs:FeatureCollection>";
+
+  QgsGmlStreamingParser sequentialParser( QStringLiteral( "mytypename" ), QStringLiteral( "mygeom" ), fields );
+  QVERIFY( sequentialParser.processData( data, true ) );
+  QVector<QgsGmlStreamingParser::QgsGmlFeaturePtrGmlIdPair> expected = sequentialParser.getAndStealReadyFeatures();
+
+  QgsGmlStreamingParser parallelParser( QStringLiteral( "mytypename" ), QStringLiteral( "mygeom" ), fields );
+  QString errorMsg;
+  QVERIFY( parallelParser.processDataInParallel( data, 4, errorMsg ) );
+  QVector<QgsGmlStreamingParser::QgsGmlFeaturePtrGmlIdPair> features = parallelParser.getAndStealReadyFeatures();
+
+  QCOMPARE( features.size(), featureCount );
+  QCOMPARE( expected.size(), featureCount );
+  QCOMPARE( parallelParser.numberMatched(), 50000 );
+  QCOMPARE( parallelParser.getEPSGCode(), 4326 );
+  QCOMPARE( parallelParser.wkbType(), QgsWkbTypes::Point );
+  QCOMPARE( parallelParser.layerExtent(), sequentialParser.layerExtent() );
+  QVERIFY( sequentialParser.isTruncatedResponse() );
+  QVERIFY( parallelParser.isTruncatedResponse() );
+  for ( int i = 0; i < featureCount; ++i )
+  {
+    QCOMPARE( features[i].first->id(), expected[i].first->id() );
+    QCOMPARE( features[i].second, expected[i].second );
+    QCOMPARE( features[i].first->attributes(), expected[i].first->attributes() );
+    // axis order is inverted for urn:ogc:def:crs:EPSG::4326 in every chunk
+    QCOMPARE( features[i].first->geometry().asPoint(), QgsPointXY( i, i % 2 ) );
+    QCOMPARE( features[i].first->geometry().asPoint(), expected[i].first->geometry().asPoint() );
+    delete features[i].first;
+    delete expected[i].first;
+  }
+}
+
 QGSTEST_MAIN( TestQgsGML )
 #include "testqgsgml.moc"
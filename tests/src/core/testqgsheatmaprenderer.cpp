@@ -0,0 +1,243 @@
+/***************************************************************************
+     testqgsheatmaprenderer.cpp
+     --------------------------
+    Date                 : November 2020
+    Copyright            : (C) 2020 by the QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include "qgstest.h"
+#include <QObject>
+#include <QString>
+#include <QImage>
+#include <QPainter>
+#include <algorithm>
+#include <cmath>
+
+#include "qgsapplication.h"
+#include "qgsheatmaprenderer.h"
+#include "qgscolorramp.h"
+#include "qgsfeature.h"
+#include "qgsfields.h"
+#include "qgsgeometry.h"
+#include "qgsmaptopixel.h"
+#include "qgsrendercontext.h"
+
+/**
+ * \ingroup UnitTests
+ * This is a unit test for the heatmap renderer.
+ */
+class TestQgsHeatmapRenderer : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();// will be called before the first testfunction is executed.
+    void cleanupTestCase();// will be called after the last testfunction was executed.
+    void init() {} // will be called before each testfunction is executed.
+    void cleanup() {} // will be called after every testfunction.
+
+    void pointsNearEdges();
+    void radiusLargerThanTaskRows();
+    void radiusLargerThanImage();
+    void manyPoints();
+    void explicitMaximum();
+
+  private:
+
+    struct TestPoint
+    {
+      int x;
+      int y;
+      double weight;
+    };
+
+    /**
+     * Renders \a points (in image pixels) to an image of \a width by \a height pixels with a heatmap of
+     * the specified \a radius in pixels, and compares the heat values, their maximum and the rendered colors
+     * with those calculated one point and one pixel at a time.
+     */
+    bool renderAndCompare( int width, int height, int radius, const QVector< TestPoint > &points, double maximum, QString &error );
+};
+
+void TestQgsHeatmapRenderer::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+}
+
+void TestQgsHeatmapRenderer::cleanupTestCase()
+{
+  QgsApplication::exitQgis();
+}
+
+void TestQgsHeatmapRenderer::pointsNearEdges()
+{
+  // the image is more than two task rows high, so rows are accumulated in parallel
+  const int width = 200;
+  const int height = 150;
+  QVector< TestPoint > points;
+  // corners
+  points << TestPoint{ 0, 0, 1 } << TestPoint{ width - 1, 0, 2 } << TestPoint{ 0, height - 1, 1 } << TestPoint{ width - 1, height - 1, 3 };
+  // middle of each edge
+  points << TestPoint{ width / 2, 0, 1 } << TestPoint{ 0, height / 2, 1 } << TestPoint{ width - 1, height / 2, 1 } << TestPoint{ width / 2, height - 1, 1 };
+  // outside of the image, but close enough for their kernels to reach it
+  points << TestPoint{ -3, 70, 1 } << TestPoint{ width + 2, 10, 1 } << TestPoint{ 40, -9, 1 } << TestPoint{ 120, height + 5, 1 };
+  // on the boundaries between task rows
+  points << TestPoint{ 50, 31, 1 } << TestPoint{ 52, 32, 1 } << TestPoint{ 150, 64, 1 };
+  // overlapping points
+  points << TestPoint{ 100, 75, 1 } << TestPoint{ 100, 75, 0.5 } << TestPoint{ 104, 78, 1 };
+
+  QString error;
+  QVERIFY2( renderAndCompare( width, height, 10, points, 0, error ), error.toLocal8Bit().constData() );
+}
+
+void TestQgsHeatmapRenderer::radiusLargerThanTaskRows()
+{
+  // kernels span several blocks of rows accumulated by different tasks
+  const int width = 300;
+  const int height = 200;
+  QVector< TestPoint > points;
+  points << TestPoint{ 0, 0, 1 } << TestPoint{ width - 1, height - 1, 1 } << TestPoint{ 150, 100, 2 }
+         << TestPoint{ 20, 180, 1 } << TestPoint{ 280, 30, 1 } << TestPoint{ 160, 96, 1 } << TestPoint{ -40, 100, 1 };
+
+  QString error;
+  QVERIFY2( renderAndCompare( width, height, 50, points, 0, error ), error.toLocal8Bit().constData() );
+  QVERIFY2( renderAndCompare( width, height, 130, points, 0, error ), error.toLocal8Bit().constData() );
+}
+
+void TestQgsHeatmapRenderer::radiusLargerThanImage()
+{
+  // the kernel is too large to be precalculated, it is evaluated for each pixel instead
+  const int width = 60;
+  const int height = 40;
+  QVector< TestPoint > points;
+  points << TestPoint{ 30, 20, 1 } << TestPoint{ 0, 0, 2 } << TestPoint{ width - 1, height - 1, 1 }
+         << TestPoint{ -150, 20, 1 } << TestPoint{ 30, height + 180, 1 } << TestPoint{ width + 100, -100, 1 };
+
+  QString error;
+  QVERIFY2( renderAndCompare( width, height, 200, points, 0, error ), error.toLocal8Bit().constData() );
+  // a radius far too large to allocate a kernel for
+  QVERIFY2( renderAndCompare( width, height, 20000, points, 0, error ), error.toLocal8Bit().constData() );
+}
+
+void TestQgsHeatmapRenderer::manyPoints()
+{
+  // more points than are buffered at once, so that they are added to the heatmap in several batches
+  const int width = 200;
+  const int height = 150;
+  QVector< TestPoint > points;
+  points.reserve( 70000 );
+  quint32 seed = 1;
+  for ( int i = 0; i < 70000; ++i )
+  {
+    // deterministic pseudo random positions, partly outside of the image
+    seed = seed * 1103515245 + 12345;
+    const int x = static_cast< int >( ( seed >> 8 ) % ( width + 10 ) ) - 5;
+    seed = seed * 1103515245 + 12345;
+    const int y = static_cast< int >( ( seed >> 8 ) % ( height + 10 ) ) - 5;
+    points << TestPoint{ x, y, static_cast< double >( 1 + i % 3 ) };
+  }
+
+  QString error;
+  QVERIFY2( renderAndCompare( width, height, 4, points, 0, error ), error.toLocal8Bit().constData() );
+}
+
+void TestQgsHeatmapRenderer::explicitMaximum()
+{
+  QVector< TestPoint > points;
+  points << TestPoint{ 50, 50, 1 } << TestPoint{ 55, 50, 1 } << TestPoint{ 0, 99, 1 };
+
+  QString error;
+  QVERIFY2( renderAndCompare( 100, 100, 20, points, 0.5, error ), error.toLocal8Bit().constData() );
+}
+
+bool TestQgsHeatmapRenderer::renderAndCompare( int width, int height, int radius, const QVector< TestPoint > &points, double maximum, QString &error )
+{
+  QgsFields fields;
+  fields.append( QgsField( QStringLiteral( "weight" ), QVariant::Double ) );
+
+  QgsHeatmapRenderer renderer;
+  renderer.setRadius( radius );
+  renderer.setRadiusUnit( QgsUnitTypes::RenderPixels );
+  renderer.setRenderQuality( 1 );
+  renderer.setMaximumValue( maximum );
+  renderer.setWeightExpression( QStringLiteral( "weight" ) );
+  renderer.setColorRamp( new QgsGradientColorRamp( QColor( 255, 255, 255 ), QColor( 0, 0, 0 ) ) );
+
+  QImage image( width, height, QImage::Format_ARGB32 );
+  image.fill( Qt::transparent );
+  QPainter painter( &image );
+  QgsRenderContext context = QgsRenderContext::fromQPainter( &painter );
+  // one map unit per pixel, with the map y axis pointing up from the top of the image
+  context.setMapToPixel( QgsMapToPixel( 1, width / 2.0, -height / 2.0, width, height, 0 ) );
+
+  renderer.startRender( context, fields );
+  for ( const TestPoint &point : points )
+  {
+    QgsFeature feature( fields );
+    feature.setAttributes( QgsAttributes() << point.weight );
+    feature.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( point.x + 0.5, -( point.y + 0.5 ) ) ) );
+    renderer.renderFeature( feature, context );
+  }
+  renderer.stopRender( context );
+  painter.end();
+
+  // expected values, adding the kernel of each point to each pixel in turn
+  QVector< double > expected( width * height, 0 );
+  for ( const TestPoint &point : points )
+  {
+    // the renderer truncates pixel positions, which rounds positions left of or above the image towards it
+    const int pointX = static_cast< int >( point.x + 0.5 );
+    const int pointY = static_cast< int >( point.y + 0.5 );
+    for ( int x = std::max( pointX - radius, 0 ); x < std::min( pointX + radius, width ); ++x )
+    {
+      for ( int y = std::max( pointY - radius, 0 ); y < std::min( pointY + radius, height ); ++y )
+      {
+        const double distanceSquared = std::pow( pointX - x, 2.0 ) + std::pow( pointY - y, 2.0 );
+        if ( distanceSquared > radius * radius )
+          continue;
+
+        expected[ y * width + x ] += point.weight * std::pow( 1. - std::pow( std::sqrt( distanceSquared ) / radius, 2 ), 2 );
+      }
+    }
+  }
+  const double expectedMax = *std::max_element( expected.constBegin(), expected.constEnd() );
+
+  if ( !qgsDoubleNear( renderer.mCalculatedMaxValue, expectedMax, 1e-9 ) )
+  {
+    error = QStringLiteral( "Maximum value %1, expected %2" ).arg( renderer.mCalculatedMaxValue ).arg( expectedMax );
+    return false;
+  }
+
+  const double scaleMax = maximum > 0 ? maximum : expectedMax;
+  QgsGradientColorRamp ramp( QColor( 255, 255, 255 ), QColor( 0, 0, 0 ) );
+  for ( int y = 0; y < height; ++y )
+  {
+    for ( int x = 0; x < width; ++x )
+    {
+      const double value = expected.at( y * width + x );
+      if ( !qgsDoubleNear( renderer.mValues.at( y * width + x ), value, 1e-9 ) )
+      {
+        error = QStringLiteral( "Value at %1, %2 is %3, expected %4" ).arg( x ).arg( y ).arg( renderer.mValues.at( y * width + x ) ).arg( value );
+        return false;
+      }
+
+      const QRgb expectedColor = ramp.color( value > 0 ? std::min( value / scaleMax, 1.0 ) : 0 ).rgba();
+      if ( image.pixel( x, y ) != expectedColor )
+      {
+        error = QStringLiteral( "Color at %1, %2 is %3, expected %4" ).arg( x ).arg( y ).arg( QColor::fromRgba( image.pixel( x, y ) ).name( QColor::HexArgb ), QColor::fromRgba( expectedColor ).name( QColor::HexArgb ) );
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+QGSTEST_MAIN( TestQgsHeatmapRenderer )
+#include "testqgsheatmaprenderer.moc"
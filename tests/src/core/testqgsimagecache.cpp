@@ -49,6 +49,7 @@ class TestQgsImageCache : public QObject
     void cleanup() {} // will be called after every testfunction.
     void fillCache();
     void threadSafeImage();
+    void hitsAndMisses();
     void broken();
     void changeImage(); // check that cache is updated if image source file changes
     void size(); // check various size-specific handling
@@ -139,6 +140,35 @@ void TestQgsImageCache::threadSafeImage()
   QtConcurrent::blockingMap( list, RenderImageWrapper( cache, imagePath ) );
 }
 
+void TestQgsImageCache::hitsAndMisses()
+{
+  QgsImageCache cache;
+  QString imagePath = TEST_DATA_DIR + QStringLiteral( "/sample_image.png" );
+  bool fitInCache = false;
+
+  QCOMPARE( cache.hitCount(), 0LL );
+  QCOMPARE( cache.missCount(), 0LL );
+  QImage image = cache.pathAsImage( imagePath, QSize( 100, 100 ), true, 1.0, fitInCache );
+  QVERIFY( !image.isNull() );
+  QCOMPARE( cache.hitCount(), 0LL );
+  QCOMPARE( cache.missCount(), 1LL );
+  image = cache.pathAsImage( imagePath, QSize( 100, 100 ), true, 1.0, fitInCache );
+  QVERIFY( !image.isNull() );
+  QCOMPARE( cache.hitCount(), 1LL );
+  QCOMPARE( cache.missCount(), 1LL );
+  image = cache.pathAsImage( imagePath, QSize( 120, 120 ), true, 1.0, fitInCache );
+  QCOMPARE( cache.hitCount(), 1LL );
+  QCOMPARE( cache.missCount(), 2LL );
+
+  // concurrent requests for the same image must only render it once
+  QgsImageCache concurrentCache;
+  QVector< int > list;
+  list.resize( 100 );
+  QtConcurrent::blockingMap( list, RenderImageWrapper( concurrentCache, imagePath ) );
+  QCOMPARE( concurrentCache.missCount(), 1LL );
+  QCOMPARE( concurrentCache.hitCount(), 99LL );
+}
+
 void TestQgsImageCache::broken()
 {
   QgsImageCache cache;
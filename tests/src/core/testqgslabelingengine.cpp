@@ -90,6 +90,8 @@ class TestQgsLabelingEngine : public QObject
     void testLineAnchorHorizontal();
     void testLineAnchorHorizontalConstraints();
     void testShowAllLabelsWhenALabelHasNoCandidates();
+    void testManyFeaturesDeterministic();
+    void testSolveIndependentClusters();
 
   private:
     QgsVectorLayer *vl = nullptr;
@@ -3317,5 +3319,170 @@ void TestQgsLabelingEngine::testShowAllLabelsWhenALabelHasNoCandidates()
   QVERIFY( imageCheck( QStringLiteral( "show_all_labels_when_no_candidates" ), img, 20 ) );
 }
 
+void TestQgsLabelingEngine::testManyFeaturesDeterministic()
+{
+  // enough features for candidates to be generated and tested against obstacles in parallel. The
+  // placed labels must not depend on how the work was split between threads.
+  QgsPalLayerSettings settings;
+  setDefaultLabelParams( settings );
+
+  QgsTextFormat format = settings.format();
+  format.setSize( 12 );
+  format.setColor( QColor( 0, 0, 0 ) );
+  settings.setFormat( format );
+
+  settings.fieldName = QStringLiteral( "\"id\"" );
+  settings.isExpression = true;
+  settings.placement = QgsPalLayerSettings::Horizontal;
+
+  std::unique_ptr< QgsVectorLayer> polygons( new QgsVectorLayer( QStringLiteral( "Polygon?crs=epsg:3857&field=id:integer" ), QStringLiteral( "polygons" ), QStringLiteral( "memory" ) ) );
+  polygons->setRenderer( new QgsNullSymbolRenderer() );
+  std::unique_ptr< QgsVectorLayer> points( new QgsVectorLayer( QStringLiteral( "Point?crs=epsg:3857&field=id:integer" ), QStringLiteral( "points" ), QStringLiteral( "memory" ) ) );
+  points->setRenderer( new QgsNullSymbolRenderer() );
+
+  QgsFeatureList polygonFeatures;
+  QgsFeatureList pointFeatures;
+  for ( int row = 0; row < 30; ++row )
+  {
+    for ( int column = 0; column < 30; ++column )
+    {
+      QgsFeature f;
+      f.setAttributes( QgsAttributes() << row * 30 + column );
+      f.setGeometry( QgsGeometry::fromRect( QgsRectangle( column * 100, row * 100, column * 100 + 80, row * 100 + 80 ) ) );
+      polygonFeatures << f;
+      f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( column * 100 + 90, row * 100 + 90 ) ) );
+      pointFeatures << f;
+    }
+  }
+  QVERIFY( polygons->dataProvider()->addFeatures( polygonFeatures ) );
+  QVERIFY( points->dataProvider()->addFeatures( pointFeatures ) );
+
+  polygons->setLabeling( new QgsVectorLayerSimpleLabeling( settings ) );  // TODO: this should not be necessary!
+  polygons->setLabelsEnabled( true );
+  settings.placement = QgsPalLayerSettings::AroundPoint;
+  points->setLabeling( new QgsVectorLayerSimpleLabeling( settings ) );  // TODO: this should not be necessary!
+  points->setLabelsEnabled( true );
+
+  QgsMapSettings mapSettings;
+  mapSettings.setLabelingEngineSettings( createLabelEngineSettings() );
+  mapSettings.setDestinationCrs( polygons->crs() );
+  mapSettings.setOutputSize( QSize( 800, 800 ) );
+  mapSettings.setExtent( QgsRectangle( -50, -50, 3050, 3050 ) );
+  mapSettings.setLayers( QList<QgsMapLayer *>() << polygons.get() << points.get() );
+  mapSettings.setOutputDpi( 96 );
+
+  auto placedLabels = [&mapSettings]() -> QStringList
+  {
+    QgsMapRendererSequentialJob job( mapSettings );
+    job.start();
+    job.waitForFinished();
+
+    std::unique_ptr< QgsLabelingResults > results( job.takeLabelingResults() );
+    QStringList labels;
+    if ( !results )
+      return labels;
+
+    const QList<QgsLabelPosition> positions = results->labelsWithinRect( mapSettings.extent() );
+    for ( const QgsLabelPosition &position : positions )
+      labels << QStringLiteral( "%1:%2:%3" ).arg( position.layerID ).arg( position.featureId ).arg( position.labelRect.toString( 1 ) );
+    labels.sort();
+    return labels;
+  };
+
+  const QStringList labels = placedLabels();
+  QVERIFY( labels.size() > 100 );
+  QCOMPARE( placedLabels(), labels );
+  QCOMPARE( placedLabels(), labels );
+}
+
+void TestQgsLabelingEngine::testSolveIndependentClusters()
+{
+  // many small clusters of points whose labels only conflict inside the cluster, so that the
+  // problem is split and solved as independent sub problems
+  QgsPalLayerSettings settings;
+  setDefaultLabelParams( settings );
+
+  QgsTextFormat format = settings.format();
+  format.setSize( 10 );
+  format.setColor( QColor( 0, 0, 0 ) );
+  settings.setFormat( format );
+
+  settings.fieldName = QStringLiteral( "\"id\"" );
+  settings.isExpression = true;
+  settings.placement = QgsPalLayerSettings::AroundPoint;
+
+  std::unique_ptr< QgsVectorLayer> vl( new QgsVectorLayer( QStringLiteral( "Point?crs=epsg:3857&field=id:integer" ), QStringLiteral( "vl" ), QStringLiteral( "memory" ) ) );
+  vl->setRenderer( new QgsNullSymbolRenderer() );
+
+  QgsFeatureList features;
+  int id = 0;
+  for ( int row = 0; row < 25; ++row )
+  {
+    for ( int column = 0; column < 25; ++column )
+    {
+      const QList< QgsPointXY > clusterPoints = QList< QgsPointXY >() << QgsPointXY( column * 1000 + 500, row * 1000 + 500 )
+          << QgsPointXY( column * 1000 + 550, row * 1000 + 500 )
+          << QgsPointXY( column * 1000 + 500, row * 1000 + 550 );
+      for ( const QgsPointXY &point : clusterPoints )
+      {
+        QgsFeature f;
+        f.setAttributes( QgsAttributes() << id++ );
+        f.setGeometry( QgsGeometry::fromPointXY( point ) );
+        features << f;
+      }
+    }
+  }
+  QVERIFY( vl->dataProvider()->addFeatures( features ) );
+
+  vl->setLabeling( new QgsVectorLayerSimpleLabeling( settings ) );  // TODO: this should not be necessary!
+  vl->setLabelsEnabled( true );
+
+  QgsMapSettings mapSettings;
+  mapSettings.setLabelingEngineSettings( createLabelEngineSettings() );
+  mapSettings.setDestinationCrs( vl->crs() );
+  mapSettings.setOutputSize( QSize( 2000, 2000 ) );
+  mapSettings.setExtent( QgsRectangle( 0, 0, 25000, 25000 ) );
+  mapSettings.setLayers( QList<QgsMapLayer *>() << vl.get() );
+  mapSettings.setOutputDpi( 96 );
+
+  auto placedLabels = [&mapSettings]() -> QList<QgsLabelPosition>
+  {
+    QgsMapRendererSequentialJob job( mapSettings );
+    job.start();
+    job.waitForFinished();
+
+    std::unique_ptr< QgsLabelingResults > results( job.takeLabelingResults() );
+    if ( !results )
+      return QList<QgsLabelPosition>();
+
+    QList<QgsLabelPosition> labels = results->labelsWithinRect( mapSettings.extent() );
+    std::sort( labels.begin(), labels.end(), []( const QgsLabelPosition & a, const QgsLabelPosition & b ) { return a.featureId < b.featureId; } );
+    return labels;
+  };
+
+  const QList<QgsLabelPosition> labels = placedLabels();
+  // at least one label per cluster is placed
+  QVERIFY( labels.size() >= 25 * 25 );
+
+  // placed labels never overlap
+  for ( int i = 0; i < labels.size(); ++i )
+  {
+    for ( int j = i + 1; j < labels.size(); ++j )
+    {
+      const QgsRectangle intersection = labels.at( i ).labelRect.intersect( labels.at( j ).labelRect );
+      QVERIFY( intersection.isEmpty() || intersection.width() * intersection.height() < 1 );
+    }
+  }
+
+  // and the solution is deterministic
+  const QList<QgsLabelPosition> secondLabels = placedLabels();
+  QCOMPARE( secondLabels.size(), labels.size() );
+  for ( int i = 0; i < labels.size(); ++i )
+  {
+    QCOMPARE( secondLabels.at( i ).featureId, labels.at( i ).featureId );
+    QCOMPARE( secondLabels.at( i ).labelRect, labels.at( i ).labelRect );
+  }
+}
+
 QGSTEST_MAIN( TestQgsLabelingEngine )
 #include "testqgslabelingengine.moc"
@@ -39,6 +39,7 @@
 #include "qgsannotationmarkeritem.h"
 
 #include <QObject>
+#include <QThreadPool>
 #include "qgstest.h"
 
 class TestQgsLayoutMap : public QObject
@@ -64,6 +65,7 @@ class TestQgsLayoutMap : public QObject
     void dataDefinedCrs(); //test data defined crs
     void dataDefinedTemporalRange(); //test data defined temporal range's start and end values
     void rasterized();
+    void parallelLayerRendering();
     void layersToRender();
     void mapRotation();
     void mapItemRotation();
@@ -585,6 +587,64 @@ void TestQgsLayoutMap::rasterized()
   QVERIFY( checker.testLayout( mReport, 0, 0 ) );
 }
 
+void TestQgsLayoutMap::parallelLayerRendering()
+{
+  QgsLayout l( QgsProject::instance() );
+  l.initializeDefaults();
+
+  // at 254 dpi a millimeter is exactly 10 pixels, so the map lines up with the image pixels
+  // and its layers can be rendered in parallel
+  QgsLayoutItemMap *map = new QgsLayoutItemMap( &l );
+  map->attemptMove( QgsLayoutPoint( 20, 30 ) );
+  map->attemptResize( QgsLayoutSize( 200, 100 ) );
+  map->setFrameEnabled( true );
+  map->setExtent( QgsRectangle( -110.0, 25.0, -90, 40.0 ) );
+  map->setLayers( QList<QgsMapLayer *>() << mPointsLayer << mLinesLayer << mPolysLayer );
+  map->setBackgroundColor( Qt::yellow );
+  l.addLayoutItem( map );
+  QVERIFY( !map->containsAdvancedEffects() );
+
+  // the map is drawn 200, 300 pixels into the page image, with 10 pixels per millimeter
+  QImage destination( 10, 10, QImage::Format_ARGB32_Premultiplied );
+  QPainter painter( &destination );
+  painter.translate( 200, 300 );
+  const QgsMapSettings settings = map->mapSettings( map->extent(), QSizeF( 2000, 1000 ), 254, true );
+
+  // force several threads, even on machines with a single core
+  const int maxThreads = QThreadPool::globalInstance()->maxThreadCount();
+  QThreadPool::globalInstance()->setMaxThreadCount( std::max( maxThreads, 4 ) );
+  const bool renderedInParallel = QgsLayoutItemMap::canRenderLayersInParallel( &painter, settings );
+  QgsLayoutExporter exporter( &l );
+  const QImage parallel = exporter.renderPageToImage( 0, QSize(), 254 );
+
+  // without spare threads the layers are drawn one after another onto the page
+  QThreadPool::globalInstance()->setMaxThreadCount( 1 );
+  const bool renderedSequentially = !QgsLayoutItemMap::canRenderLayersInParallel( &painter, settings );
+  const QImage sequential = exporter.renderPageToImage( 0, QSize(), 254 );
+  QThreadPool::globalInstance()->setMaxThreadCount( maxThreads );
+  painter.end();
+
+  QVERIFY( renderedInParallel );
+  QVERIFY( renderedSequentially );
+  QCOMPARE( parallel.size(), sequential.size() );
+  int mismatches = 0;
+  for ( int y = 0; y < parallel.height(); ++y )
+  {
+    const QRgb *parallelLine = reinterpret_cast< const QRgb * >( parallel.constScanLine( y ) );
+    const QRgb *sequentialLine = reinterpret_cast< const QRgb * >( sequential.constScanLine( y ) );
+    for ( int x = 0; x < parallel.width(); ++x )
+    {
+      // allow for rounding differences where antialiased edges of different layers are composited
+      if ( std::abs( qRed( parallelLine[x] ) - qRed( sequentialLine[x] ) ) > 4
+           || std::abs( qGreen( parallelLine[x] ) - qGreen( sequentialLine[x] ) ) > 4
+           || std::abs( qBlue( parallelLine[x] ) - qBlue( sequentialLine[x] ) ) > 4
+           || std::abs( qAlpha( parallelLine[x] ) - qAlpha( sequentialLine[x] ) ) > 4 )
+        mismatches++;
+    }
+  }
+  QCOMPARE( mismatches, 0 );
+}
+
 void TestQgsLayoutMap::layersToRender()
 {
   QList<QgsMapLayer *> layers = QList<QgsMapLayer *>() << mRasterLayer << mPolysLayer << mPointsLayer << mLinesLayer;
@@ -517,6 +517,76 @@ class TestQgsPointLocator : public QObject
       QCOMPARE( m.vertexIndex(), 2 );
     }
 
+    void testParallelIndex()
+    {
+      // a layer big enough to be read in parallel parts
+      QgsVectorLayer layer( QStringLiteral( "LineString" ), QStringLiteral( "x" ), QStringLiteral( "memory" ) );
+      QgsFeatureList flist;
+      for ( int i = 0; i < 250; ++i )
+      {
+        for ( int j = 0; j < 250; ++j )
+        {
+          QgsFeature f;
+          f.setGeometry( QgsGeometry::fromPolylineXY( QgsPolylineXY() << QgsPointXY( i * 10, j * 10 ) << QgsPointXY( i * 10 + 1, j * 10 + 1 ) ) );
+          flist << f;
+        }
+      }
+      // lines crossing the borders between the parts
+      QgsFeature diagonal;
+      diagonal.setGeometry( QgsGeometry::fromPolylineXY( QgsPolylineXY() << QgsPointXY( 0, 5 ) << QgsPointXY( 2485, 2490 ) ) );
+      flist << diagonal;
+      QgsFeature cross;
+      cross.setGeometry( QgsGeometry::fromPolylineXY( QgsPolylineXY() << QgsPointXY( 5, 1245 ) << QgsPointXY( 2495, 1245 ) ) );
+      flist << cross;
+      layer.dataProvider()->addFeatures( flist );
+      layer.dataProvider()->createSpatialIndex();
+      const QgsFeatureId diagonalId = flist.at( flist.count() - 2 ).id();
+      const QgsFeatureId crossId = flist.at( flist.count() - 1 ).id();
+
+      // a feature outside of the extent cached by the layer
+      QCOMPARE( layer.extent(), QgsRectangle( 0, 0, 2495, 2491 ) );
+      QgsFeature outside;
+      outside.setGeometry( QgsGeometry::fromPolylineXY( QgsPolylineXY() << QgsPointXY( 5000, 5000 ) << QgsPointXY( 5001, 5001 ) ) );
+      QVERIFY( layer.dataProvider()->addFeature( outside ) );
+      QCOMPARE( layer.extent(), QgsRectangle( 0, 0, 2495, 2491 ) );
+      QCOMPARE( layer.featureCount(), 62503L );
+
+      // make sure there are enough threads to read the layer in three parts
+      const int maxThreadCount = QThreadPool::globalInstance()->maxThreadCount();
+      QThreadPool::globalInstance()->setMaxThreadCount( 4 );
+
+      QgsPointLocator loc( &layer );
+      QVERIFY( loc.init() );
+      QVERIFY( loc.mIndexPartitions.empty() );
+      QCOMPARE( loc.mIndexPartitionsRead, 3 );
+
+      // every feature is indexed once
+      QCOMPARE( loc.cachedGeometryCount(), 62503 );
+
+      QgsPointLocator::Match outsideMatch = loc.nearestVertex( QgsPointXY( 5000.2, 5000.1 ), 1 );
+      QVERIFY( outsideMatch.isValid() );
+      QCOMPARE( outsideMatch.point(), QgsPointXY( 5000, 5000 ) );
+
+      QgsPointLocator::Match m = loc.nearestVertex( QgsPointXY( 1241.5, 1241.2 ), 1 );
+      QVERIFY( m.isValid() );
+      QCOMPARE( m.point(), QgsPointXY( 1241, 1241 ) );
+
+      QgsPointLocator::MatchList edges = loc.edgesInRect( QgsRectangle( 1602, 1244, 1604, 1246 ) );
+      QCOMPARE( edges.count(), 1 );
+      QCOMPARE( edges.at( 0 ).featureId(), crossId );
+
+      edges = loc.edgesInRect( QgsRectangle( 2104, 2108, 2106, 2110 ) );
+      QCOMPARE( edges.count(), 1 );
+      QCOMPARE( edges.at( 0 ).featureId(), diagonalId );
+
+      // the limit of features still applies
+      QgsPointLocator limitedLoc( &layer );
+      QVERIFY( !limitedLoc.init( 1000 ) );
+      QVERIFY( !limitedLoc.hasIndex() );
+
+      QThreadPool::globalInstance()->setMaxThreadCount( maxThreadCount );
+    }
+
 };
 
 QGSTEST_MAIN( TestQgsPointLocator )
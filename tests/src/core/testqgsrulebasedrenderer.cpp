@@ -15,6 +15,8 @@
 #include "qgstest.h"
 #include <QDomDocument>
 #include <QFile>
+#include <QImage>
+#include <QPainter>
 //header for class being tested
 #include <qgsrulebasedrenderer.h>
 
@@ -179,6 +181,96 @@ class TestQgsRuleBasedRenderer: public QObject
 
     }
 
+    void test_indexed_rules_render()
+    {
+      QgsVectorLayer *layer = new QgsVectorLayer( QStringLiteral( "point?field=cls:string&field=code:int" ), QStringLiteral( "x" ), QStringLiteral( "memory" ) );
+
+      RRule *rootRule = new RRule( nullptr );
+      for ( int i = 0; i < 8; i++ )
+        rootRule->appendChild( new RRule( QgsSymbol::defaultSymbol( QgsWkbTypes::PointGeometry ), 0, 0, QStringLiteral( "\"cls\" = 'c%1'" ).arg( i ) ) );
+      rootRule->appendChild( new RRule( QgsSymbol::defaultSymbol( QgsWkbTypes::PointGeometry ), 0, 0, QStringLiteral( "\"cls\" IN ('x', 'y')" ) ) );
+      rootRule->appendChild( new RRule( QgsSymbol::defaultSymbol( QgsWkbTypes::PointGeometry ), 0, 0, QStringLiteral( "'z' = \"cls\" AND \"code\" > 5" ) ) );
+      rootRule->appendChild( new RRule( QgsSymbol::defaultSymbol( QgsWkbTypes::PointGeometry ), 0, 0, QStringLiteral( "\"cls\" = 3" ) ) );
+      rootRule->appendChild( new RRule( QgsSymbol::defaultSymbol( QgsWkbTypes::PointGeometry ), 0, 0, QStringLiteral( "\"code\" = 3" ) ) );
+      QgsRuleBasedRenderer r( rootRule );
+
+      QImage image( 10, 10, QImage::Format_ARGB32 );
+      QPainter painter( &image );
+      QgsRenderContext ctx;
+      ctx.setPainter( &painter );
+      ctx.expressionContext().setFields( layer->fields() );
+      r.startRender( ctx, layer->fields() );
+
+      auto render = [&]( const QVariant & cls, const QVariant & code ) -> bool
+      {
+        QgsFeature f( layer->fields() );
+        f.setAttributes( QgsAttributes() << cls << code );
+        f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( 1, 1 ) ) );
+        return r.renderFeature( f, ctx );
+      };
+
+      QVERIFY( render( QStringLiteral( "c0" ), QVariant() ) );
+      QVERIFY( render( QStringLiteral( "c7" ), 1 ) );
+      QVERIFY( !render( QStringLiteral( "c8" ), 1 ) );
+      QVERIFY( !render( QStringLiteral( "C1" ), 1 ) );
+      QVERIFY( render( QStringLiteral( "y" ), 1 ) );
+      QVERIFY( render( QStringLiteral( "z" ), 6 ) );
+      QVERIFY( !render( QStringLiteral( "z" ), 5 ) );
+      QVERIFY( !render( QStringLiteral( "z" ), QVariant() ) );
+      QVERIFY( render( QStringLiteral( "3" ), 1 ) );
+      QVERIFY( render( QStringLiteral( "3.0" ), 1 ) );
+      QVERIFY( !render( QStringLiteral( "4" ), 1 ) );
+      QVERIFY( render( QStringLiteral( "q" ), 3 ) );
+      QVERIFY( !render( QStringLiteral( "q" ), 4 ) );
+      QVERIFY( !render( QString(), QVariant() ) );
+      QVERIFY( render( QVariant(), 3 ) );
+
+      // results must match evaluating every filter
+      const QStringList classes { QStringLiteral( "c0" ), QStringLiteral( "c5" ), QStringLiteral( "c9" ), QStringLiteral( "x" ), QStringLiteral( "z" ), QStringLiteral( "3" ), QStringLiteral( "03" ), QStringLiteral( "3e0" ), QStringLiteral( "inf" ), QStringLiteral( "" ), QString() };
+      for ( const QString &cls : classes )
+      {
+        for ( int code = -1; code < 8; ++code )
+        {
+          QgsFeature f( layer->fields() );
+          f.setAttributes( QgsAttributes() << cls << ( code < 0 ? QVariant() : QVariant( code ) ) );
+          ctx.expressionContext().setFeature( f );
+          const bool expected = !r.symbolsForFeature( f, ctx ).isEmpty();
+          QCOMPARE( r.renderFeature( f, ctx ), expected );
+        }
+      }
+
+      r.stopRender( ctx );
+      painter.end();
+
+      // rules outside of the scale range hide matching features from else rules
+      rootRule = new RRule( nullptr );
+      rootRule->appendChild( new RRule( QgsSymbol::defaultSymbol( QgsWkbTypes::PointGeometry ), 5000, 0, QStringLiteral( "\"cls\" = 'c0'" ) ) );
+      for ( int i = 1; i < 5; i++ )
+        rootRule->appendChild( new RRule( QgsSymbol::defaultSymbol( QgsWkbTypes::PointGeometry ), 0, 0, QStringLiteral( "\"cls\" = 'c%1'" ).arg( i ) ) );
+      rootRule->appendChild( new RRule( QgsSymbol::defaultSymbol( QgsWkbTypes::PointGeometry ), 0, 0, QStringLiteral( "ELSE" ) ) );
+      QgsRuleBasedRenderer r2( rootRule );
+
+      QPainter painter2( &image );
+      ctx.setPainter( &painter2 );
+      ctx.setRendererScale( 1000 );
+      r2.startRender( ctx, layer->fields() );
+
+      QgsFeature f( layer->fields() );
+      f.setAttributes( QgsAttributes() << QStringLiteral( "c0" ) << 1 );
+      QVERIFY( !r2.renderFeature( f, ctx ) );
+      f.setAttributes( QgsAttributes() << QStringLiteral( "c1" ) << 1 );
+      QVERIFY( r2.renderFeature( f, ctx ) );
+      f.setAttributes( QgsAttributes() << QStringLiteral( "q" ) << 1 );
+      QVERIFY( r2.renderFeature( f, ctx ) );
+      f.setAttributes( QgsAttributes() << QVariant() << 1 );
+      QVERIFY( r2.renderFeature( f, ctx ) );
+
+      r2.stopRender( ctx );
+      painter2.end();
+
+      delete layer;
+    }
+
   private:
     void xml2domElement( const QString &testFile, QDomDocument &doc )
     {
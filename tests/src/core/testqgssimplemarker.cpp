@@ -20,6 +20,8 @@
 #include <QFileInfo>
 #include <QDir>
 #include <QDesktopServices>
+#include <QPainter>
+#include <QPicture>
 
 //qgis includes...
 #include <qgsmaplayer.h>
@@ -30,6 +32,7 @@
 #include <qgssymbol.h>
 #include <qgssinglesymbolrenderer.h>
 #include "qgsmarkersymbollayer.h"
+#include "qgsmarkerstampcache.h"
 #include "qgsproperty.h"
 
 //qgis test includes
@@ -81,11 +84,13 @@ class TestQgsSimpleMarkerSymbol : public QObject
     void boundsWithRotation();
     void boundsWithRotationAndOffset();
     void colors();
+    void simpleMarkerSymbolStamps();
+    void stampCache();
 
   private:
     bool mTestHasError =  false ;
 
-    bool imageCheck( const QString &type );
+    bool imageCheck( const QString &type, unsigned int mismatchCount = 0 );
     QgsMapSettings mMapSettings;
     QgsVectorLayer *mpPointsLayer = nullptr;
     QgsSimpleMarkerSymbolLayer *mSimpleMarkerLayer = nullptr;
@@ -333,12 +338,110 @@ void TestQgsSimpleMarkerSymbol::colors()
   QCOMPARE( marker.strokeColor(), QColor( 250, 250, 250 ) );
 }
 
+void TestQgsSimpleMarkerSymbol::simpleMarkerSymbolStamps()
+{
+  mReport += QLatin1String( "<h2>Simple marker symbol layer drawn from stamps</h2>\n" );
+
+  mSimpleMarkerLayer->setColor( Qt::blue );
+  mSimpleMarkerLayer->setStrokeColor( Qt::black );
+  mSimpleMarkerLayer->setShape( QgsSimpleMarkerSymbolLayerBase::Square );
+  mSimpleMarkerLayer->setSize( 15 );
+  mSimpleMarkerLayer->setAngle( 0 );
+  mSimpleMarkerLayer->setStrokeWidth( 0.2 );
+  mSimpleMarkerLayer->setPenJoinStyle( Qt::BevelJoin );
+  // data defined rotation prevents use of the single cached marker image
+  mSimpleMarkerLayer->setDataDefinedProperty( QgsSymbolLayer::PropertyAngle, QgsProperty::fromExpression( QStringLiteral( "45" ) ) );
+  mMapSettings.setFlag( QgsMapSettings::RasterizeMarkerStamps, true );
+
+  // stamps round marker positions to a quarter of a pixel, allow for small differences along the edges
+  const bool result = imageCheck( "simplemarker_rotation", 300 );
+
+  mMapSettings.setFlag( QgsMapSettings::RasterizeMarkerStamps, false );
+  mSimpleMarkerLayer->setDataDefinedProperty( QgsSymbolLayer::PropertyAngle, QgsProperty() );
+  QVERIFY( result );
+}
+
+void TestQgsSimpleMarkerSymbol::stampCache()
+{
+  QImage image( 100, 100, QImage::Format_ARGB32_Premultiplied );
+  image.fill( Qt::transparent );
+  QPainter p( &image );
+
+  QgsMarkerStampCache cache;
+  QgsMarkerStampCache::Key key;
+  key.width = 10;
+  key.height = 10;
+  key.fillColor = qRgb( 0, 0, 0 );
+  const QRectF bounds( -5, -5, 10, 10 );
+  int renders = 0;
+  auto render = [&renders]( QPainter * painter )
+  {
+    renders++;
+    painter->fillRect( QRectF( -5, -5, 10, 10 ), Qt::black );
+  };
+
+  QVERIFY( cache.drawMarker( &p, QPointF( 20, 20 ), 0, key, bounds, render ) );
+  QCOMPARE( renders, 1 );
+  // same variant at another whole pixel position
+  QVERIFY( cache.drawMarker( &p, QPointF( 70, 20 ), 0, key, bounds, render ) );
+  QCOMPARE( renders, 1 );
+  QCOMPARE( cache.count(), 1 );
+  // positions are rounded to subpixels
+  QVERIFY( cache.drawMarker( &p, QPointF( 70.01, 70 ), 0, key, bounds, render ) );
+  QCOMPARE( renders, 1 );
+  QVERIFY( cache.drawMarker( &p, QPointF( 20.25, 70 ), 0, key, bounds, render ) );
+  QCOMPARE( renders, 2 );
+  // and rotations to whole degrees
+  QVERIFY( cache.drawMarker( &p, QPointF( 20, 20 ), 0.2, key, bounds, render ) );
+  QVERIFY( cache.drawMarker( &p, QPointF( 20, 20 ), 360, key, bounds, render ) );
+  QCOMPARE( renders, 2 );
+  QVERIFY( cache.drawMarker( &p, QPointF( 20, 20 ), 45, key, bounds, render ) );
+  QCOMPARE( renders, 3 );
+  // other variants get their own stamp
+  key.fillColor = qRgb( 255, 0, 0 );
+  QVERIFY( cache.drawMarker( &p, QPointF( 70, 20 ), 0, key, bounds, render ) );
+  QCOMPARE( renders, 4 );
+  QCOMPARE( cache.count(), 4 );
+
+  // markers too large for a stamp must be drawn directly
+  QVERIFY( !cache.drawMarker( &p, QPointF( 20, 20 ), 0, key, QRectF( -500, -500, 1000, 1000 ), render ) );
+  QCOMPARE( renders, 4 );
+
+  // as well as markers drawn with scaled painters
+  p.scale( 2, 2 );
+  QVERIFY( !QgsMarkerStampCache::canDrawStamps( &p ) );
+  QVERIFY( !cache.drawMarker( &p, QPointF( 20, 20 ), 0, key, bounds, render ) );
+  p.end();
+
+  QCOMPARE( image.pixelColor( 18, 18 ), QColor( 0, 0, 0 ) );
+  QCOMPARE( image.pixelColor( 12, 12 ).alpha(), 0 );
+
+  // or on high DPI images
+  QImage highDpiImage( 100, 100, QImage::Format_ARGB32_Premultiplied );
+  highDpiImage.setDevicePixelRatio( 2 );
+  highDpiImage.fill( Qt::transparent );
+  QPainter highDpiPainter( &highDpiImage );
+  QVERIFY( !QgsMarkerStampCache::canDrawStamps( &highDpiPainter ) );
+  QVERIFY( !cache.drawMarker( &highDpiPainter, QPointF( 20, 20 ), 0, key, bounds, render ) );
+  highDpiPainter.end();
+  QCOMPARE( renders, 4 );
+
+  // or on anything but images
+  QPicture picture;
+  QPainter picturePainter( &picture );
+  QVERIFY( !QgsMarkerStampCache::canDrawStamps( &picturePainter ) );
+  picturePainter.end();
+
+  cache.clear();
+  QCOMPARE( cache.count(), 0 );
+}
+
 //
 // Private helper functions not called directly by CTest
 //
 
 
-bool TestQgsSimpleMarkerSymbol::imageCheck( const QString &testType )
+bool TestQgsSimpleMarkerSymbol::imageCheck( const QString &testType, unsigned int mismatchCount )
 {
   //use the QgsRenderChecker test utility class to
   //ensure the rendered output matches our control image
@@ -348,7 +451,7 @@ bool TestQgsSimpleMarkerSymbol::imageCheck( const QString &testType )
   myChecker.setControlPathPrefix( QStringLiteral( "symbol_simplemarker" ) );
   myChecker.setControlName( "expected_" + testType );
   myChecker.setMapSettings( mMapSettings );
-  bool myResultFlag = myChecker.runTest( testType );
+  bool myResultFlag = myChecker.runTest( testType, mismatchCount );
   mReport += myChecker.report();
   return myResultFlag;
 }
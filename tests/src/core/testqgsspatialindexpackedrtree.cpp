@@ -0,0 +1,410 @@
+/***************************************************************************
+     testqgsspatialindexpackedrtree.cpp
+     --------------------------------------
+    Date                 : November 2020
+    Copyright            : (C) 2020 by the QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+#include <QObject>
+#include <QString>
+#include <QTemporaryDir>
+#include <QtConcurrentMap>
+
+#include <qgsapplication.h>
+#include "qgsfeatureiterator.h"
+#include "qgsfeedback.h"
+#include "qgsgeometry.h"
+#include "qgsspatialindexpackedrtree.h"
+#include "qgsvectordataprovider.h"
+#include "qgsvectorlayer.h"
+#include "qgsspatialindexpackedrtree_p.h"
+
+#include <limits>
+#include <numeric>
+#include <random>
+
+static QgsFeature _boxFeature( QgsFeatureId id, const QgsRectangle &rect )
+{
+  QgsFeature f( id );
+  f.setGeometry( QgsGeometry::fromRect( rect ) );
+  return f;
+}
+
+static QList<QgsFeature> _boxFeatures()
+{
+  /*
+   *  2   |   1
+   *      |
+   * -----+-----
+   *      |
+   *  3   |   4
+   */
+
+  QList<QgsFeature> feats;
+  feats << _boxFeature( 1, QgsRectangle( 1, 1, 2, 2 ) )
+        << _boxFeature( 2, QgsRectangle( -2, 1, -1, 2 ) )
+        << _boxFeature( 3, QgsRectangle( -2, -2, -1, -1 ) )
+        << _boxFeature( 4, QgsRectangle( 1, -2, 2, -1 ) );
+  return feats;
+}
+
+static QList<QgsRectangle> _randomBoxes( int count )
+{
+  std::mt19937 generator( 42 );
+  std::uniform_real_distribution< double > position( -1000, 1000 );
+  std::uniform_real_distribution< double > size( 0, 20 );
+
+  QList<QgsRectangle> boxes;
+  for ( int i = 0; i < count; ++i )
+  {
+    const double x = position( generator );
+    const double y = position( generator );
+    boxes << QgsRectangle( x, y, x + size( generator ), y + size( generator ) );
+  }
+  return boxes;
+}
+
+static std::unique_ptr< QgsVectorLayer > _boxLayer( const QList<QgsRectangle> &boxes )
+{
+  std::unique_ptr< QgsVectorLayer > vl = qgis::make_unique< QgsVectorLayer >( "Polygon", QString(), QStringLiteral( "memory" ) );
+  QgsFeatureList features;
+  for ( const QgsRectangle &box : boxes )
+    features << _boxFeature( FID_NULL, box );
+  vl->dataProvider()->addFeatures( features );
+  return vl;
+}
+
+//! Distance from \a point to \a box, 0 for points inside the box
+static double _boxDistance( const QgsRectangle &box, const QgsPointXY &point )
+{
+  const double dx = std::max( { box.xMinimum() - point.x(), 0.0, point.x() - box.xMaximum() } );
+  const double dy = std::max( { box.yMinimum() - point.y(), 0.0, point.y() - box.yMaximum() } );
+  return std::sqrt( dx * dx + dy * dy );
+}
+
+static QList<QgsFeatureId> _sorted( QList<QgsFeatureId> ids )
+{
+  std::sort( ids.begin(), ids.end() );
+  return ids;
+}
+
+class TestQgsSpatialIndexPackedRTree : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+
+    void initTestCase()
+    {
+      QgsApplication::init();
+      QgsApplication::initQgis();
+    }
+    void cleanupTestCase()
+    {
+      QgsApplication::exitQgis();
+    }
+
+    void testQuery()
+    {
+      std::unique_ptr< QgsVectorLayer > vl = qgis::make_unique< QgsVectorLayer >( "Polygon", QString(), QStringLiteral( "memory" ) );
+      for ( QgsFeature f : _boxFeatures() )
+        vl->dataProvider()->addFeature( f );
+      QgsSpatialIndexPackedRTree index( *vl->dataProvider() );
+      QCOMPARE( index.size(), static_cast< qgssize >( 4 ) );
+      QCOMPARE( index.extent(), QgsRectangle( -2, -2, 2, 2 ) );
+
+      QList<QgsFeatureId> fids = index.intersects( QgsRectangle( 0, 0, 10, 10 ) );
+      QCOMPARE( fids, QList<QgsFeatureId>() << 1 );
+
+      QList<QgsFeatureId> fids2 = index.intersects( QgsRectangle( -10, -10, 0, 10 ) );
+      QCOMPARE( _sorted( fids2 ), QList<QgsFeatureId>() << 2 << 3 );
+
+      QList<QgsFeatureId> fids3 = index.intersects( QgsRectangle( -1, -1, 1, 1 ) );
+      QCOMPARE( _sorted( fids3 ), QList<QgsFeatureId>() << 1 << 2 << 3 << 4 );
+
+      QVERIFY( index.intersects( QgsRectangle( -0.5, -0.5, 0.5, 0.5 ) ).isEmpty() );
+
+      QList<QgsFeatureId> visited;
+      index.intersects( QgsRectangle( 0, -10, 10, 10 ), [&visited]( QgsFeatureId id ) { visited << id; } );
+      QCOMPARE( _sorted( visited ), QList<QgsFeatureId>() << 1 << 4 );
+    }
+
+    void testNearest()
+    {
+      std::unique_ptr< QgsVectorLayer > vl = qgis::make_unique< QgsVectorLayer >( "Polygon", QString(), QStringLiteral( "memory" ) );
+      for ( QgsFeature f : _boxFeatures() )
+        vl->dataProvider()->addFeature( f );
+      QgsSpatialIndexPackedRTree index( *vl->dataProvider() );
+
+      QCOMPARE( index.nearestNeighbor( QgsPointXY( 5, 5 ) ), QList<QgsFeatureId>() << 1 );
+      QCOMPARE( index.nearestNeighbor( QgsPointXY( 1.5, 1.5 ) ), QList<QgsFeatureId>() << 1 );
+
+      QList<QgsFeatureId> fids = index.nearestNeighbor( QgsPointXY( 1.5, 3 ), 3 );
+      QCOMPARE( fids.size(), 3 );
+      QCOMPARE( fids.at( 0 ), 1 );
+      QCOMPARE( fids.at( 1 ), 2 );
+      QCOMPARE( fids.at( 2 ), 4 );
+
+      QCOMPARE( index.nearestNeighbor( QgsPointXY( 1.5, 3 ), 10 ).size(), 4 );
+      QCOMPARE( index.nearestNeighbor( QgsPointXY( 1.5, 3 ), 10, 1.5 ), QList<QgsFeatureId>() << 1 );
+      QVERIFY( index.nearestNeighbor( QgsPointXY( 10, 10 ), 1, 1 ).isEmpty() );
+    }
+
+    void testEmpty()
+    {
+      QgsSpatialIndexPackedRTree index;
+      QCOMPARE( index.size(), static_cast< qgssize >( 0 ) );
+      QVERIFY( index.extent().isNull() );
+      QVERIFY( index.intersects( QgsRectangle( -10, -10, 10, 10 ) ).isEmpty() );
+      QVERIFY( index.nearestNeighbor( QgsPointXY( 0, 0 ), 3 ).isEmpty() );
+    }
+
+    void testCompareBruteForce()
+    {
+      // enough boxes to use several tree levels and the parallel bulk loading
+      const QList<QgsRectangle> boxes = _randomBoxes( 50000 );
+      std::unique_ptr< QgsVectorLayer > vl = _boxLayer( boxes );
+      QgsSpatialIndexPackedRTree index( *vl->dataProvider() );
+      QCOMPARE( index.size(), static_cast< qgssize >( boxes.size() ) );
+      QCOMPARE( index.d->levelBounds.size(), 5 );
+
+      QgsFeatureIterator it = vl->getFeatures();
+      QHash< QgsFeatureId, QgsRectangle > featureBoxes;
+      QgsFeature f;
+      while ( it.nextFeature( f ) )
+        featureBoxes.insert( f.id(), f.geometry().boundingBox() );
+
+      const QList<QgsRectangle> queries = _randomBoxes( 50 );
+      for ( QgsRectangle query : queries )
+      {
+        query.grow( 50 );
+        QList<QgsFeatureId> expected;
+        for ( auto it = featureBoxes.constBegin(); it != featureBoxes.constEnd(); ++it )
+        {
+          if ( it.value().intersects( query ) )
+            expected << it.key();
+        }
+        QCOMPARE( _sorted( index.intersects( query ) ), _sorted( expected ) );
+
+        const QgsPointXY point = query.center();
+        const QList<QgsFeatureId> nearest = index.nearestNeighbor( point, 5 );
+        QCOMPARE( nearest.size(), 5 );
+        QList<double> distances;
+        for ( auto it = featureBoxes.constBegin(); it != featureBoxes.constEnd(); ++it )
+          distances << _boxDistance( it.value(), point );
+        std::sort( distances.begin(), distances.end() );
+        for ( int i = 0; i < nearest.size(); ++i )
+          QGSCOMPARENEAR( _boxDistance( featureBoxes.value( nearest.at( i ) ), point ), distances.at( i ), 1e-9 );
+      }
+    }
+
+    void testConcurrentQueries()
+    {
+      const QList<QgsRectangle> boxes = _randomBoxes( 20000 );
+      std::unique_ptr< QgsVectorLayer > vl = _boxLayer( boxes );
+      const QgsSpatialIndexPackedRTree index( *vl->dataProvider() );
+
+      QList<QgsRectangle> queries = _randomBoxes( 200 );
+      QList<int> expected;
+      for ( const QgsRectangle &query : qgis::as_const( queries ) )
+        expected << index.intersects( query ).size();
+
+      QVector< int > counts( queries.size() );
+      QVector< int > positions( queries.size() );
+      std::iota( positions.begin(), positions.end(), 0 );
+      QtConcurrent::blockingMap( positions, [&index, &queries, &counts]( int &position )
+      {
+        counts[position] = index.intersects( queries.at( position ) ).size();
+      } );
+
+      for ( int i = 0; i < queries.size(); ++i )
+        QCOMPARE( counts.at( i ), expected.at( i ) );
+    }
+
+    void testCanceled()
+    {
+      const QList<QgsRectangle> boxes = _randomBoxes( 100 );
+      std::unique_ptr< QgsVectorLayer > vl = _boxLayer( boxes );
+      QgsFeedback feedback;
+      feedback.cancel();
+      QgsSpatialIndexPackedRTree index( *vl->dataProvider(), &feedback );
+      QCOMPARE( index.size(), static_cast< qgssize >( 0 ) );
+      QVERIFY( index.intersects( QgsRectangle( -1000, -1000, 1000, 1000 ) ).isEmpty() );
+    }
+
+    void testFile()
+    {
+      const QList<QgsRectangle> boxes = _randomBoxes( 5000 );
+      std::unique_ptr< QgsVectorLayer > vl = _boxLayer( boxes );
+      const QgsSpatialIndexPackedRTree index( *vl->dataProvider(), nullptr, 8 );
+
+      QTemporaryDir dir;
+      const QString path = dir.filePath( QStringLiteral( "index.bin" ) );
+      QVERIFY( index.writeToFile( path ) );
+
+      QgsSpatialIndexPackedRTree loaded;
+      QVERIFY( loaded.readFromFile( path ) );
+      QCOMPARE( loaded.size(), index.size() );
+      QCOMPARE( loaded.extent(), index.extent() );
+      QCOMPARE( loaded.d->nodeSize, 8 );
+
+      const QgsRectangle query( -100, -100, 100, 100 );
+      QCOMPARE( _sorted( loaded.intersects( query ) ), _sorted( index.intersects( query ) ) );
+      QCOMPARE( loaded.nearestNeighbor( QgsPointXY( 3, 4 ), 10 ), index.nearestNeighbor( QgsPointXY( 3, 4 ), 10 ) );
+
+      // invalid files leave the index unchanged
+      QVERIFY( !loaded.readFromFile( dir.filePath( QStringLiteral( "missing.bin" ) ) ) );
+      QFile invalid( dir.filePath( QStringLiteral( "invalid.bin" ) ) );
+      QVERIFY( invalid.open( QIODevice::WriteOnly ) );
+      invalid.write( "not an index" );
+      invalid.close();
+      QVERIFY( !loaded.readFromFile( invalid.fileName() ) );
+      QCOMPARE( loaded.size(), index.size() );
+
+      // empty index
+      const QString emptyPath = dir.filePath( QStringLiteral( "empty.bin" ) );
+      QVERIFY( QgsSpatialIndexPackedRTree().writeToFile( emptyPath ) );
+      QVERIFY( loaded.readFromFile( emptyPath ) );
+      QCOMPARE( loaded.size(), static_cast< qgssize >( 0 ) );
+    }
+
+    void testCorruptFile()
+    {
+      const QList<QgsRectangle> boxes = _randomBoxes( 1000 );
+      std::unique_ptr< QgsVectorLayer > vl = _boxLayer( boxes );
+      const QgsSpatialIndexPackedRTree index( *vl->dataProvider(), nullptr, 4 );
+
+      QTemporaryDir dir;
+      const QString path = dir.filePath( QStringLiteral( "index.bin" ) );
+      QVERIFY( index.writeToFile( path ) );
+      QFile file( path );
+      QVERIFY( file.open( QIODevice::ReadOnly ) );
+      const QByteArray valid = file.readAll();
+      file.close();
+
+      QgsSpatialIndexPackedRTree loaded;
+      auto readModified = [&dir, &loaded]( const QByteArray & data ) -> bool
+      {
+        const QString corruptPath = dir.filePath( QStringLiteral( "corrupt.bin" ) );
+        QFile corrupt( corruptPath );
+        if ( !corrupt.open( QIODevice::WriteOnly | QIODevice::Truncate ) )
+          return false;
+        corrupt.write( data );
+        corrupt.close();
+        return loaded.readFromFile( corruptPath );
+      };
+
+      QVERIFY( readModified( valid ) );
+      QCOMPARE( loaded.size(), index.size() );
+
+      // header: magic, version, node size, item count, level count, then the level bounds
+      const int itemCountOffset = 10 + 4 + 4;
+      const int firstBoundOffset = itemCountOffset + 8 + 4;
+      auto withValue = [&valid]( int offset, quint64 value )
+      {
+        QByteArray data = valid;
+        for ( int i = 0; i < 8; ++i )
+          data[offset + i] = static_cast< char >( ( value >> ( 8 * i ) ) & 0xFF );
+        return data;
+      };
+
+      QgsSpatialIndexPackedRTree empty;
+      loaded = empty;
+      // truncated
+      QVERIFY( !readModified( valid.left( valid.size() - 8 ) ) );
+      QVERIFY( !readModified( valid.left( firstBoundOffset + 4 ) ) );
+      // item count not matching the levels
+      QVERIFY( !readModified( withValue( itemCountOffset, 999 ) ) );
+      QVERIFY( !readModified( withValue( itemCountOffset, Q_UINT64_C( 1 ) << 40 ) ) );
+      // level bound out of the boxes
+      QVERIFY( !readModified( withValue( firstBoundOffset + 8, Q_UINT64_C( 1 ) << 40 ) ) );
+      // child offset of the root node out of the tree
+      QVERIFY( !readModified( withValue( valid.size() - 8, Q_UINT64_C( 1 ) << 40 ) ) );
+      // child offset of the root node pointing to another node
+      QVERIFY( !readModified( withValue( valid.size() - 8, 3 ) ) );
+      QCOMPARE( loaded.size(), static_cast< qgssize >( 0 ) );
+    }
+
+    void testNonFiniteBoxes()
+    {
+      std::unique_ptr< QgsVectorLayer > vl = qgis::make_unique< QgsVectorLayer >( "Point", QString(), QStringLiteral( "memory" ) );
+      QgsFeatureList features;
+      for ( int i = 0; i < 20; ++i )
+      {
+        QgsFeature f;
+        f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( i, i ) ) );
+        features << f;
+      }
+      QgsFeature nan;
+      nan.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( std::numeric_limits< double >::quiet_NaN(), 5 ) ) );
+      features << nan;
+      QgsFeature infinite;
+      infinite.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( 5, std::numeric_limits< double >::infinity() ) ) );
+      features << infinite;
+      vl->dataProvider()->addFeatures( features );
+
+      // features without a finite bounding box are not indexed
+      const QgsSpatialIndexPackedRTree index( *vl->dataProvider(), nullptr, 4 );
+      QCOMPARE( index.size(), static_cast< qgssize >( 20 ) );
+      QCOMPARE( index.extent(), QgsRectangle( 0, 0, 19, 19 ) );
+      QCOMPARE( index.intersects( QgsRectangle( -1, -1, 100, 100 ) ).size(), 20 );
+      QCOMPARE( index.intersects( QgsRectangle( 4.5, 4.5, 5.5, 5.5 ) ).size(), 1 );
+    }
+
+    void testCopy()
+    {
+      std::unique_ptr< QgsVectorLayer > vl = qgis::make_unique< QgsVectorLayer >( "Polygon", QString(), QStringLiteral( "memory" ) );
+      for ( QgsFeature f : _boxFeatures() )
+        vl->dataProvider()->addFeature( f );
+
+      std::unique_ptr< QgsSpatialIndexPackedRTree > index( new QgsSpatialIndexPackedRTree( *vl->dataProvider() ) );
+
+      // create copy of the index
+      std::unique_ptr< QgsSpatialIndexPackedRTree > indexCopy( new QgsSpatialIndexPackedRTree( *index ) );
+
+      QVERIFY( index->d == indexCopy->d );
+      QVERIFY( index->d->ref == 2 );
+
+      // test that copied index works
+      QList<QgsFeatureId> fids = indexCopy->intersects( QgsRectangle( 0, 0, 10, 10 ) );
+      QCOMPARE( fids, QList<QgsFeatureId>() << 1 );
+
+      // check that the index is still shared
+      QVERIFY( index->d == indexCopy->d );
+      QVERIFY( index->d->ref == 2 );
+
+      index.reset();
+
+      // test that copied index still works
+      fids = indexCopy->intersects( QgsRectangle( 0, 0, 10, 10 ) );
+      QCOMPARE( fids, QList<QgsFeatureId>() << 1 );
+      QVERIFY( indexCopy->d->ref == 1 );
+
+      // assignment operator
+      QgsSpatialIndexPackedRTree index3;
+      QVERIFY( index3.size() == 0 );
+      QVERIFY( index3.d->ref == 1 );
+
+      index3 = *indexCopy;
+      QVERIFY( index3.d == indexCopy->d );
+      QVERIFY( index3.d->ref == 2 );
+      fids = index3.intersects( QgsRectangle( 0, 0, 10, 10 ) );
+      QCOMPARE( fids, QList<QgsFeatureId>() << 1 );
+
+      indexCopy.reset();
+      QVERIFY( index3.d->ref == 1 );
+    }
+
+};
+
+QGSTEST_MAIN( TestQgsSpatialIndexPackedRTree )
+
+#include "testqgsspatialindexpackedrtree.moc"
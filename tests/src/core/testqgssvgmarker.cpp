@@ -20,6 +20,7 @@
 #include <QFileInfo>
 #include <QDir>
 #include <QDesktopServices>
+#include <QPainter>
 
 //qgis includes...
 #include <qgsmaplayer.h>
@@ -64,11 +65,13 @@ class TestQgsSvgMarkerSymbol : public QObject
     void dynamicWidthWithAspectRatio();
     void dynamicAspectRatio();
     void resetDefaultAspectRatio();
+    void svgMarkerSymbolStamps();
+    void stampCacheClearedAfterRender();
 
   private:
     bool mTestHasError =  false ;
 
-    bool imageCheck( const QString &type );
+    bool imageCheck( const QString &type, unsigned int mismatchCount = 0 );
     QgsMapSettings mMapSettings;
     QgsVectorLayer *mpPointsLayer = nullptr;
     QgsSvgMarkerSymbolLayer *mSvgMarkerLayer = nullptr;
@@ -297,12 +300,60 @@ void TestQgsSvgMarkerSymbol::resetDefaultAspectRatio()
   QVERIFY( !layer.preservedAspectRatio() );
 }
 
+void TestQgsSvgMarkerSymbol::svgMarkerSymbolStamps()
+{
+  mReport += QLatin1String( "<h2>SVG marker symbol layer drawn from stamps</h2>\n" );
+
+  QString svgPath = QgsSymbolLayerUtils::svgSymbolNameToPath( QStringLiteral( "/transport/transport_airport.svg" ), QgsPathResolver() );
+
+  mSvgMarkerLayer->setPath( svgPath );
+  mSvgMarkerLayer->setStrokeColor( Qt::black );
+  mSvgMarkerLayer->setColor( Qt::blue );
+  mSvgMarkerLayer->setSize( 10 );
+  mSvgMarkerLayer->setFixedAspectRatio( 0.0 );
+  mSvgMarkerLayer->setStrokeWidth( 0.5 );
+  mMapSettings.setFlag( QgsMapSettings::RasterizeMarkerStamps, true );
+
+  // stamps round marker positions to a quarter of a pixel, allow for small differences along the edges
+  const bool result = imageCheck( "svgmarker", 300 );
+
+  mMapSettings.setFlag( QgsMapSettings::RasterizeMarkerStamps, false );
+  QVERIFY( result );
+}
+
+void TestQgsSvgMarkerSymbol::stampCacheClearedAfterRender()
+{
+  QString svgPath = QgsSymbolLayerUtils::svgSymbolNameToPath( QStringLiteral( "/backgrounds/background_square.svg" ), QgsPathResolver() );
+  QgsSvgMarkerSymbolLayer *layer = new QgsSvgMarkerSymbolLayer( svgPath, 10 );
+  QgsMarkerSymbol symbol( QgsSymbolLayerList() << layer );
+
+  QImage image( 200, 200, QImage::Format_ARGB32_Premultiplied );
+  image.fill( Qt::transparent );
+  QPainter p( &image );
+  QgsRenderContext context = QgsRenderContext::fromQPainter( &p );
+  context.setFlag( QgsRenderContext::RasterizeMarkerStamps, true );
+
+  symbol.startRender( context );
+  symbol.renderPoint( QPointF( 50, 50 ), nullptr, context );
+  symbol.renderPoint( QPointF( 150, 50 ), nullptr, context );
+  symbol.renderPoint( QPointF( 50.25, 150 ), nullptr, context );
+  // both positions at whole pixels share a stamp
+  QCOMPARE( layer->mStampCache.count(), 2 );
+  symbol.stopRender( context );
+  p.end();
+
+  // stamps must not outlive the render
+  QCOMPARE( layer->mStampCache.count(), 0 );
+  QVERIFY( image.pixelColor( 50, 50 ).alpha() > 0 );
+  QVERIFY( image.pixelColor( 150, 50 ).alpha() > 0 );
+}
+
 //
 // Private helper functions not called directly by CTest
 //
 
 
-bool TestQgsSvgMarkerSymbol::imageCheck( const QString &testType )
+bool TestQgsSvgMarkerSymbol::imageCheck( const QString &testType, unsigned int mismatchCount )
 {
   //use the QgsRenderChecker test utility class to
   //ensure the rendered output matches our control image
@@ -312,7 +363,7 @@ bool TestQgsSvgMarkerSymbol::imageCheck( const QString &testType )
   myChecker.setControlPathPrefix( QStringLiteral( "symbol_svgmarker" ) );
   myChecker.setControlName( "expected_" + testType );
   myChecker.setMapSettings( mMapSettings );
-  bool myResultFlag = myChecker.runTest( testType );
+  bool myResultFlag = myChecker.runTest( testType, mismatchCount );
   mReport += myChecker.report();
   return myResultFlag;
 }
@@ -0,0 +1,119 @@
+/***************************************************************************
+     testqgstextpathcache.cpp
+     ------------------------
+    Date                 : November 2020
+    Copyright            : (C) 2020 by the QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include "qgstest.h"
+#include <QObject>
+#include <QString>
+#include <QFontDatabase>
+
+#include "qgsapplication.h"
+#include "qgsfontutils.h"
+#include "qgstextpathcache_p.h"
+
+class TestQgsTextPathCache: public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();// will be called before the first testfunction is executed.
+    void cleanupTestCase();// will be called after the last testfunction was executed.
+    void textPath(); //test caching text outlines
+    void fontDatabaseChanged(); //test clearing the cache when application fonts change
+
+};
+
+void TestQgsTextPathCache::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+}
+
+void TestQgsTextPathCache::cleanupTestCase()
+{
+  QgsApplication::exitQgis();
+}
+
+void TestQgsTextPathCache::textPath()
+{
+  QgsTextPathCache cache;
+  QFont f = QgsFontUtils::getStandardTestFont();
+  f.setPointSize( 24 );
+
+  QPainterPath expected;
+  expected.addText( 0, 0, f, QStringLiteral( "River" ) );
+
+  QCOMPARE( cache.textPath( f, QStringLiteral( "River" ) ), expected );
+  QCOMPARE( cache.count(), 1 );
+  // second request must be served from the cache
+  QCOMPARE( cache.textPath( f, QStringLiteral( "River" ) ), expected );
+  QCOMPARE( cache.count(), 1 );
+
+  // empty strings are never cached
+  QVERIFY( cache.textPath( f, QString() ).isEmpty() );
+  QCOMPARE( cache.count(), 1 );
+
+  // any change to the font must result in a separate entry
+  QFont spaced = f;
+  spaced.setLetterSpacing( QFont::AbsoluteSpacing, 5 );
+  expected = QPainterPath();
+  expected.addText( 0, 0, spaced, QStringLiteral( "River" ) );
+  QCOMPARE( cache.textPath( spaced, QStringLiteral( "River" ) ), expected );
+  QCOMPARE( cache.count(), 2 );
+
+  QFont caps = f;
+  caps.setCapitalization( QFont::AllUppercase );
+  cache.textPath( caps, QStringLiteral( "River" ) );
+  QCOMPARE( cache.count(), 3 );
+
+  // adding with an offset must match QPainterPath::addText
+  QPainterPath path;
+  cache.addText( path, 10, 20, f, QStringLiteral( "River" ) );
+  expected = QPainterPath();
+  expected.addText( 10, 20, f, QStringLiteral( "River" ) );
+  QCOMPARE( path, expected );
+
+  cache.clear();
+  QCOMPARE( cache.count(), 0 );
+
+  // paths larger than the whole cache are not stored
+  QgsTextPathCache smallCache( 5 );
+  expected = QPainterPath();
+  expected.addText( 0, 0, f, QStringLiteral( "River" ) );
+  QCOMPARE( smallCache.textPath( f, QStringLiteral( "River" ) ), expected );
+  QCOMPARE( smallCache.count(), 0 );
+}
+
+void TestQgsTextPathCache::fontDatabaseChanged()
+{
+#if QT_VERSION >= QT_VERSION_CHECK( 5, 11, 0 )
+  QgsTextPathCache cache;
+  QFont f = QgsFontUtils::getStandardTestFont();
+  cache.textPath( f, QStringLiteral( "River" ) );
+  QCOMPARE( cache.count(), 1 );
+
+  // outlines cached before may have been drawn with a substituted font
+  const int fontId = QFontDatabase::addApplicationFont( QStringLiteral( TEST_DATA_DIR ) + QStringLiteral( "/font/QGIS-Vera/QGIS-VeraIt.ttf" ) );
+  QVERIFY( fontId != -1 );
+  QCOMPARE( cache.count(), 0 );
+
+  cache.textPath( f, QStringLiteral( "River" ) );
+  QCOMPARE( cache.count(), 1 );
+  QVERIFY( QFontDatabase::removeApplicationFont( fontId ) );
+  QCOMPARE( cache.count(), 0 );
+#else
+  QSKIP( "Changes of the font database are only signaled with Qt 5.11 or later" );
+#endif
+}
+
+QGSTEST_MAIN( TestQgsTextPathCache )
+#include "testqgstextpathcache.moc"
@@ -38,6 +38,7 @@ class TestQgsTracer : public QObject
     void testPolygon();
     void testButterfly();
     void testLayerUpdates();
+    void testIncrementalUpdates();
     void testExtent();
     void testReprojection();
     void testCurved();
@@ -370,6 +371,114 @@ void TestQgsTracer::testLayerUpdates()
   delete vl;
 }
 
+static double path_length( const QgsPolylineXY &points )
+{
+  double length = 0;
+  for ( int i = 1; i < points.count(); ++i )
+    length += points.at( i - 1 ).distance( points.at( i ) );
+  return length;
+}
+
+void TestQgsTracer::testIncrementalUpdates()
+{
+  // check that edits only update the graph around the edited features
+  // and tracing gives the same results as with a graph built from scratch
+
+  // 11 x 11 grid of lines
+  QStringList wkts;
+  for ( int i = 0; i <= 10; ++i )
+  {
+    wkts << QStringLiteral( "LINESTRING(0 %1, 10 %1)" ).arg( i )
+         << QStringLiteral( "LINESTRING(%1 0, %1 10)" ).arg( i );
+  }
+
+  QgsVectorLayer *vl = make_layer( wkts );
+
+  QgsTracer tracer;
+  tracer.setLayers( QList<QgsVectorLayer *>() << vl );
+  QVERIFY( tracer.init() );
+
+  const QList< QPair< QgsPointXY, QgsPointXY > > paths = QList< QPair< QgsPointXY, QgsPointXY > >()
+      << qMakePair( QgsPointXY( 0, 0 ), QgsPointXY( 10, 10 ) )
+      << qMakePair( QgsPointXY( 0, 10 ), QgsPointXY( 10, 0 ) )
+      << qMakePair( QgsPointXY( 0, 0 ), QgsPointXY( 10, 0 ) )
+      << qMakePair( QgsPointXY( 3, 0 ), QgsPointXY( 7, 10 ) )
+      << qMakePair( QgsPointXY( 2.5, 0 ), QgsPointXY( 7.5, 10 ) )
+      << qMakePair( QgsPointXY( 5, 2.5 ), QgsPointXY( 5, 7.5 ) );
+
+  auto checkPaths = [&tracer, vl, &paths]()
+  {
+    // the changes are applied to the graph when it is used next
+    QVERIFY( tracer.isInitialized() );
+
+    QgsTracer fresh;
+    fresh.setLayers( QList<QgsVectorLayer *>() << vl );
+
+    for ( const QPair< QgsPointXY, QgsPointXY > &path : paths )
+    {
+      QgsTracer::PathError error = QgsTracer::ErrNone;
+      QgsTracer::PathError freshError = QgsTracer::ErrNone;
+      const QgsPolylineXY points = tracer.findShortestPath( path.first, path.second, &error );
+      const QgsPolylineXY freshPoints = fresh.findShortestPath( path.first, path.second, &freshError );
+      QCOMPARE( error, freshError );
+      QCOMPARE( points.count() > 0, freshPoints.count() > 0 );
+      QGSCOMPARENEAR( path_length( points ), path_length( freshPoints ), 1e-9 );
+    }
+
+    // the graph was updated, not thrown away
+    QVERIFY( tracer.isInitialized() );
+  };
+
+  QCOMPARE( path_length( tracer.findShortestPath( QgsPointXY( 0, 0 ), QgsPointXY( 10, 10 ) ) ), 20.0 );
+
+  vl->startEditing();
+
+  // add a diagonal shortcut, crossing the grid
+  QgsFeature f( make_feature( QStringLiteral( "LINESTRING(0 0, 10 10)" ) ) );
+  vl->addFeature( f );
+  checkPaths();
+  QGSCOMPARENEAR( path_length( tracer.findShortestPath( QgsPointXY( 0, 0 ), QgsPointXY( 10, 10 ) ) ), 10 * std::sqrt( 2 ), 1e-9 );
+
+  // move it to the other diagonal
+  QVERIFY( vl->changeGeometry( f.id(), QgsGeometry::fromWkt( QStringLiteral( "LINESTRING(0 10, 10 0)" ) ) ) );
+  checkPaths();
+  QCOMPARE( path_length( tracer.findShortestPath( QgsPointXY( 0, 0 ), QgsPointXY( 10, 10 ) ) ), 20.0 );
+  QGSCOMPARENEAR( path_length( tracer.findShortestPath( QgsPointXY( 0, 10 ), QgsPointXY( 10, 0 ) ) ), 10 * std::sqrt( 2 ), 1e-9 );
+
+  // break the middle vertical line into a shorter one
+  QVERIFY( vl->changeGeometry( 12, QgsGeometry::fromWkt( QStringLiteral( "LINESTRING(5 0, 5 3)" ) ) ) );
+  checkPaths();
+
+  // and delete a grid line overlapping with the border
+  QVERIFY( vl->deleteFeature( 1 ) );
+  checkPaths();
+
+  // delete the diagonal again
+  QVERIFY( vl->deleteFeature( f.id() ) );
+  checkPaths();
+
+  // attribute changes can't change the graph of a layer which is not filtered by its renderer
+  QVERIFY( vl->addAttribute( QgsField( QStringLiteral( "name" ), QVariant::String ) ) );
+  QVERIFY( tracer.isInitialized() );
+  QVERIFY( vl->changeAttributeValue( 12, 0, QStringLiteral( "changed" ) ) );
+  QVERIFY( tracer.isInitialized() );
+  checkPaths();
+
+  // large batches of edits are not applied to the graph, it is built from scratch
+  for ( int i = 0; i <= 100; ++i )
+  {
+    QgsFeature small( make_feature( QStringLiteral( "LINESTRING(%1 20, %1 21)" ).arg( i ) ) );
+    QVERIFY( vl->addFeature( small ) );
+  }
+  QVERIFY( !tracer.isInitialized() );
+  QVERIFY( tracer.init() );
+  QCOMPARE( path_length( tracer.findShortestPath( QgsPointXY( 0, 0 ), QgsPointXY( 10, 10 ) ) ), 20.0 );
+
+  vl->rollBack();
+
+  delete vl;
+}
+
 void TestQgsTracer::testExtent()
 {
   // check whether the tracer correctly handles the extent limitation
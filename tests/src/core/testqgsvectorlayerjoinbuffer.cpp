@@ -20,6 +20,7 @@
 //qgis includes...
 #include <qgsvectorlayer.h>
 #include "qgsfeatureiterator.h"
+#include "qgsfeaturebatch.h"
 #include "qgslayertreegroup.h"
 #include "qgsreadwritecontext.h"
 #include <qgsvectordataprovider.h>
@@ -28,6 +29,80 @@
 #include <qgslayerdefinition.h>
 #include <qgsproject.h>
 #include "qgslayertree.h"
+#include "qgsproviderregistry.h"
+#include "qgsprovidermetadata.h"
+
+/**
+ * Feature source counting the feature requests
+ */
+class TestCountingFeatureSource : public QgsAbstractFeatureSource
+{
+  public:
+    TestCountingFeatureSource( QgsAbstractFeatureSource *source, int &requests )
+      : mSource( source )
+      , mRequests( requests )
+    {}
+
+    QgsFeatureIterator getFeatures( const QgsFeatureRequest &request ) override
+    {
+      mRequests++;
+      return mSource->getFeatures( request );
+    }
+
+  private:
+    std::unique_ptr< QgsAbstractFeatureSource > mSource;
+    int &mRequests;
+};
+
+/**
+ * Vector data provider serving the features of a memory layer, which counts the feature requests
+ */
+class TestCountingProvider : public QgsVectorDataProvider
+{
+  public:
+    TestCountingProvider( const QString &uri, const QgsDataProvider::ProviderOptions &options )
+      : QgsVectorDataProvider( uri, options )
+      , mLayer( uri, QStringLiteral( "counted" ), QStringLiteral( "memory" ) )
+    {}
+
+    //! Returns the number of feature requests since the last call
+    int takeRequests()
+    {
+      const int requests = mRequests;
+      mRequests = 0;
+      return requests;
+    }
+
+    QgsAbstractFeatureSource *featureSource() const override { return new TestCountingFeatureSource( mLayer.dataProvider()->featureSource(), mRequests ); }
+    QgsFeatureIterator getFeatures( const QgsFeatureRequest &request ) const override { return mLayer.dataProvider()->getFeatures( request ); }
+    QgsWkbTypes::Type wkbType() const override { return mLayer.dataProvider()->wkbType(); }
+    long featureCount() const override { return mLayer.dataProvider()->featureCount(); }
+    QgsFields fields() const override { return mLayer.dataProvider()->fields(); }
+    QgsCoordinateReferenceSystem crs() const override { return mLayer.dataProvider()->crs(); }
+    QgsRectangle extent() const override { return mLayer.dataProvider()->extent(); }
+    bool isValid() const override { return mLayer.isValid(); }
+    QString name() const override { return QStringLiteral( "counting" ); }
+    QString description() const override { return QStringLiteral( "Counting provider" ); }
+    bool addFeatures( QgsFeatureList &flist, QgsFeatureSink::Flags flags = QgsFeatureSink::Flags() ) override { return mLayer.dataProvider()->addFeatures( flist, flags ); }
+
+  private:
+    QgsVectorLayer mLayer;
+    mutable int mRequests = 0;
+};
+
+class TestCountingProviderMetadata : public QgsProviderMetadata
+{
+  public:
+    TestCountingProviderMetadata()
+      : QgsProviderMetadata( QStringLiteral( "counting" ), QStringLiteral( "Counting provider" ) )
+    {}
+
+    QgsDataProvider *createProvider( const QString &uri, const QgsDataProvider::ProviderOptions &options, QgsDataProvider::ReadFlags flags = QgsDataProvider::ReadFlags() ) override
+    {
+      Q_UNUSED( flags )
+      return new TestCountingProvider( uri, options );
+    }
+};
 
 /**
  * @ingroup UnitTests
@@ -60,6 +135,7 @@ class TestVectorLayerJoinBuffer : public QObject
     void testJoinSubset();
     void testJoinTwoTimes_data();
     void testJoinTwoTimes();
+    void testJoinBatched();
     void testJoinLayerDefinitionFile();
     void testCacheUpdate_data();
     void testCacheUpdate();
@@ -85,6 +161,8 @@ void TestVectorLayerJoinBuffer::initTestCase()
   QCoreApplication::setOrganizationDomain( QStringLiteral( "qgis.org" ) );
   QCoreApplication::setApplicationName( QStringLiteral( "QGIS-TEST" ) );
 
+  QgsProviderRegistry::instance()->registerProvider( new TestCountingProviderMetadata() );
+
   mProviders = QList<QString>() << QStringLiteral( "memory" );
 
   // Create memory layers
@@ -477,6 +555,243 @@ void TestVectorLayerJoinBuffer::testJoinTwoTimes()
   QCOMPARE( vlA->vectorJoins().count(), 0 );
 }
 
+void TestVectorLayerJoinBuffer::testJoinBatched()
+{
+  // joins without memory cache fetch the joined attributes for batches of features,
+  // results must match a join using the memory cache
+  QgsVectorLayer *vlT = new QgsVectorLayer( QStringLiteral( "None?field=key:integer" ), QStringLiteral( "T" ), QStringLiteral( "memory" ) );
+  QgsVectorLayer *vlJ = new QgsVectorLayer( QStringLiteral( "None?field=id:integer&field=value:string&field=other:integer" ), QStringLiteral( "J" ), QStringLiteral( "counting" ) );
+  QVERIFY( vlT->isValid() );
+  QVERIFY( vlJ->isValid() );
+  TestCountingProvider *joinProvider = dynamic_cast< TestCountingProvider * >( vlJ->dataProvider() );
+  QVERIFY( joinProvider );
+
+  QgsFeatureList features;
+  for ( int i = 0; i < 2500; ++i )
+  {
+    QgsFeature f( vlT->fields() );
+    // one feature without key
+    f.setAttributes( QgsAttributes() << ( i == 1234 ? QVariant() : QVariant( i ) ) );
+    features << f;
+  }
+  QVERIFY( vlT->dataProvider()->addFeatures( features ) );
+
+  features.clear();
+  // only even keys have a joined feature
+  for ( int i = 0; i < 2500; i += 2 )
+  {
+    QgsFeature f( vlJ->fields() );
+    f.setAttributes( QgsAttributes() << i << QStringLiteral( "value %1" ).arg( i ) << i * 10 );
+    features << f;
+  }
+  QVERIFY( vlJ->dataProvider()->addFeatures( features ) );
+
+  QgsProject project;
+  project.addMapLayers( QList<QgsMapLayer *>() << vlT << vlJ );
+
+  auto joinedValues = [vlT, vlJ]( bool memoryCache, bool subset, const QgsFeatureRequest & request ) -> QMap< QgsFeatureId, QgsAttributes >
+  {
+    QgsVectorLayerJoinInfo joinInfo;
+    joinInfo.setTargetFieldName( QStringLiteral( "key" ) );
+    joinInfo.setJoinLayer( vlJ );
+    joinInfo.setJoinFieldName( QStringLiteral( "id" ) );
+    joinInfo.setUsingMemoryCache( memoryCache );
+    joinInfo.setPrefix( QStringLiteral( "J_" ) );
+    if ( subset )
+      joinInfo.setJoinFieldNamesSubset( new QStringList( QStringList() << QStringLiteral( "other" ) ) );
+    vlT->addJoin( joinInfo );
+
+    QMap< QgsFeatureId, QgsAttributes > values;
+    QgsFeatureIterator fi = vlT->getFeatures( request );
+    QgsFeature f;
+    while ( fi.nextFeature( f ) )
+      values.insert( f.id(), f.attributes() );
+
+    vlT->removeJoin( vlJ->id() );
+    return values;
+  };
+
+  for ( bool subset : { false, true } )
+  {
+    const QMap< QgsFeatureId, QgsAttributes > cached = joinedValues( true, subset, QgsFeatureRequest() );
+    joinProvider->takeRequests();
+    const QMap< QgsFeatureId, QgsAttributes > batched = joinedValues( false, subset, QgsFeatureRequest() );
+    QCOMPARE( batched.count(), 2500 );
+    QCOMPARE( batched, cached );
+    // one request per batch of 1000 features, instead of one per feature
+    QCOMPARE( joinProvider->takeRequests(), 3 );
+  }
+
+  // key 10 has two joined features now
+  QgsFeature duplicate( vlJ->fields() );
+  duplicate.setAttributes( QgsAttributes() << 10 << QStringLiteral( "duplicate" ) << -1 );
+  QVERIFY( vlJ->dataProvider()->addFeature( duplicate ) );
+
+  QMap< QgsFeatureId, QgsAttributes > batched = joinedValues( false, false, QgsFeatureRequest() );
+  QgsFeatureId fid10 = -1;
+  QgsFeatureId fid11 = -1;
+  for ( auto it = batched.constBegin(); it != batched.constEnd(); ++it )
+  {
+    if ( it->at( 0 ).toInt() == 10 )
+      fid10 = it.key();
+    else if ( it->at( 0 ).toInt() == 11 )
+      fid11 = it.key();
+  }
+  QVERIFY( fid10 >= 0 );
+  QVERIFY( fid11 >= 0 );
+  // first matching joined feature wins
+  QCOMPARE( batched.value( fid10 ), QgsAttributes() << 10 << QStringLiteral( "value 10" ) << 100 );
+  // no joined feature
+  QCOMPARE( batched.value( fid11 ), QgsAttributes() << 11 << QVariant() << QVariant() );
+
+  // request with limit and filter expression
+  QgsFeatureRequest request;
+  request.setFilterExpression( QStringLiteral( "key >= 2000" ) );
+  request.setLimit( 5 );
+  batched = joinedValues( false, false, request );
+  QCOMPARE( batched.count(), 5 );
+  for ( const QgsAttributes &attributes : qgis::as_const( batched ) )
+  {
+    const int key = attributes.at( 0 ).toInt();
+    QVERIFY( key >= 2000 );
+    if ( key % 2 == 0 )
+      QCOMPARE( attributes.at( 1 ).toString(), QStringLiteral( "value %1" ).arg( key ) );
+    else
+      QVERIFY( attributes.at( 1 ).isNull() );
+  }
+
+  // filter on a joined field, evaluated after the joins: the batches are not limited to the requested number of features
+  request.setFilterExpression( QStringLiteral( "J_value IS NULL" ) );
+  joinProvider->takeRequests();
+  batched = joinedValues( false, false, request );
+  QCOMPARE( batched.count(), 5 );
+  for ( const QgsAttributes &attributes : qgis::as_const( batched ) )
+    QVERIFY( attributes.at( 1 ).isNull() );
+  QCOMPARE( joinProvider->takeRequests(), 1 );
+
+  // mixing nextFeature() and nextBatch() neither drops nor duplicates features, including
+  // the ones read ahead for the joins and the ones added in the edit buffer
+  auto mixedFetch = [vlT, vlJ]( int & fetched ) -> QMap< QgsFeatureId, QgsAttributes >
+  {
+    QgsVectorLayerJoinInfo joinInfo;
+    joinInfo.setTargetFieldName( QStringLiteral( "key" ) );
+    joinInfo.setJoinLayer( vlJ );
+    joinInfo.setJoinFieldName( QStringLiteral( "id" ) );
+    joinInfo.setUsingMemoryCache( false );
+    joinInfo.setPrefix( QStringLiteral( "J_" ) );
+    vlT->addJoin( joinInfo );
+
+    QMap< QgsFeatureId, QgsAttributes > values;
+    QgsFeatureIterator fi = vlT->getFeatures();
+    QgsFeatureBatch batch( vlT->fields(), false );
+    QgsFeature f;
+    bool useBatch = false;
+    fetched = 0;
+    while ( true )
+    {
+      if ( useBatch )
+      {
+        const int rows = fi.nextBatch( batch, 700 );
+        if ( rows == 0 )
+          break;
+        for ( int row = 0; row < rows; ++row )
+        {
+          f = batch.feature( row );
+          values.insert( f.id(), f.attributes() );
+          fetched++;
+        }
+      }
+      else
+      {
+        if ( !fi.nextFeature( f ) )
+          break;
+        values.insert( f.id(), f.attributes() );
+        fetched++;
+      }
+      useBatch = !useBatch;
+    }
+
+    vlT->removeJoin( vlJ->id() );
+    return values;
+  };
+
+  int fetched = 0;
+  QMap< QgsFeatureId, QgsAttributes > mixed = mixedFetch( fetched );
+  QCOMPARE( fetched, 2500 );
+  QCOMPARE( mixed, joinedValues( true, false, QgsFeatureRequest() ) );
+
+  vlT->startEditing();
+  QgsFeature added( vlT->fields() );
+  added.setAttributes( QgsAttributes() << 20 );
+  QVERIFY( vlT->addFeature( added ) );
+  mixed = mixedFetch( fetched );
+  QCOMPARE( fetched, 2501 );
+  QCOMPARE( mixed.count(), 2501 );
+  QCOMPARE( mixed, joinedValues( true, false, QgsFeatureRequest() ) );
+  vlT->rollBack();
+
+  // edited join values are taken into account
+  vlT->startEditing();
+  QVERIFY( vlT->changeAttributeValue( fid11, 0, 12 ) );
+  batched = joinedValues( false, false, QgsFeatureRequest() );
+  QCOMPARE( batched.count(), 2500 );
+  QCOMPARE( batched.value( fid11 ), QgsAttributes() << 12 << QStringLiteral( "value 12" ) << 120 );
+  vlT->rollBack();
+
+  // a filter the provider can't handle, but which does not depend on joined fields, is evaluated
+  // before fetching the joined attributes
+  vlT->startEditing();
+  QVERIFY( vlT->addAttribute( QgsField( QStringLiteral( "flag" ), QVariant::Int ) ) );
+  request = QgsFeatureRequest();
+  request.setFilterExpression( QStringLiteral( "flag IS NULL AND key >= 2490" ) );
+  joinProvider->takeRequests();
+  batched = joinedValues( false, false, request );
+  QCOMPARE( batched.count(), 10 );
+  for ( const QgsAttributes &attributes : qgis::as_const( batched ) )
+  {
+    const int key = attributes.at( 0 ).toInt();
+    QVERIFY( key >= 2490 );
+    if ( key % 2 == 0 )
+      QCOMPARE( attributes.at( 2 ).toString(), QStringLiteral( "value %1" ).arg( key ) );
+    else
+      QVERIFY( attributes.at( 2 ).isNull() );
+  }
+  QCOMPARE( joinProvider->takeRequests(), 1 );
+  vlT->rollBack();
+
+  // join values are compared converted to the type of the join field
+  QgsVectorLayer *vlS = new QgsVectorLayer( QStringLiteral( "None?field=key:string" ), QStringLiteral( "S" ), QStringLiteral( "memory" ) );
+  QVERIFY( vlS->isValid() );
+  features.clear();
+  for ( const QString &key : { QStringLiteral( "010" ), QStringLiteral( "10" ), QStringLiteral( "12.0" ), QStringLiteral( "x" ) } )
+  {
+    QgsFeature f( vlS->fields() );
+    f.setAttributes( QgsAttributes() << key );
+    features << f;
+  }
+  QVERIFY( vlS->dataProvider()->addFeatures( features ) );
+  project.addMapLayer( vlS );
+
+  QgsVectorLayerJoinInfo joinInfo;
+  joinInfo.setTargetFieldName( QStringLiteral( "key" ) );
+  joinInfo.setJoinLayer( vlJ );
+  joinInfo.setJoinFieldName( QStringLiteral( "id" ) );
+  joinInfo.setUsingMemoryCache( false );
+  joinInfo.setPrefix( QStringLiteral( "J_" ) );
+  QVERIFY( vlS->addJoin( joinInfo ) );
+
+  QMap< QString, QVariant > joinedByKey;
+  QgsFeatureIterator fi = vlS->getFeatures();
+  QgsFeature f;
+  while ( fi.nextFeature( f ) )
+    joinedByKey.insert( f.attribute( 0 ).toString(), f.attribute( 2 ) );
+  QCOMPARE( joinedByKey.count(), 4 );
+  QCOMPARE( joinedByKey.value( QStringLiteral( "010" ) ).toInt(), 100 );
+  QCOMPARE( joinedByKey.value( QStringLiteral( "10" ) ).toInt(), 100 );
+  QCOMPARE( joinedByKey.value( QStringLiteral( "12.0" ) ).toInt(), 120 );
+  QVERIFY( joinedByKey.value( QStringLiteral( "x" ) ).isNull() );
+}
+
 void TestVectorLayerJoinBuffer::testJoinLayerDefinitionFile()
 {
   bool r;
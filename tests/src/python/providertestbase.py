@@ -19,6 +19,7 @@ from qgis.core import (
     QgsRectangle,
     QgsFeatureRequest,
     QgsFeature,
+    QgsFeatureBatch,
     QgsGeometry,
     QgsAbstractFeatureIterator,
     QgsExpressionContextScope,
@@ -593,6 +594,59 @@ class ProviderTestCase(FeatureSourceTestCase):
             self.assertFalse(f.hasGeometry(), 'Expected no geometry, got one')
             self.assertTrue(f.isValid())
 
+    def testGetFeaturesBatch(self):
+        """ Test that fetching features in batches returns the same features as nextFeature"""
+
+        def batch_features(request, batch_size):
+            batch = QgsFeatureBatch(self.source.fields(), not request.flags() & QgsFeatureRequest.NoGeometry)
+            it = self.source.getFeatures(request)
+            features = []
+            while True:
+                rows = it.nextBatch(batch, batch_size)
+                self.assertEqual(rows, batch.rowCount())
+                if rows == 0:
+                    break
+                self.assertLessEqual(rows, batch_size)
+                features.extend([batch.feature(row) for row in range(rows)])
+            return features
+
+        fields = self.source.fields()
+        requests = [QgsFeatureRequest(),
+                    QgsFeatureRequest().setFlags(QgsFeatureRequest.NoGeometry),
+                    QgsFeatureRequest().setSubsetOfAttributes(['pk', 'cnt', 'name'], fields),
+                    QgsFeatureRequest().setLimit(3),
+                    QgsFeatureRequest().setFilterExpression('"cnt" > 200')]
+        for request in requests:
+            expected = {f.id(): f for f in self.source.getFeatures(request)}
+            if request.flags() & QgsFeatureRequest.SubsetOfAttributes:
+                attributes = request.subsetOfAttributes()
+            else:
+                attributes = fields.allAttributesList()
+
+            for batch_size in [1, 2, 1000]:
+                features = batch_features(request, batch_size)
+                self.assertEqual(len(features), len(expected))
+                for f in features:
+                    self.assertIn(f.id(), expected)
+                    e = expected[f.id()]
+                    for idx in attributes:
+                        self.assertEqual(f[idx], e[idx], 'Attribute {} of feature {} differs'.format(fields.at(idx).name(), f.id()))
+                    self.assertEqual(f.hasGeometry(), e.hasGeometry())
+                    if e.hasGeometry():
+                        self.assertEqual(f.geometry().asWkt(), e.geometry().asWkt())
+
+        # typed column access
+        batch = QgsFeatureBatch(fields, [fields.lookupField('cnt')], False)
+        it = self.source.getFeatures(QgsFeatureRequest().setFlags(QgsFeatureRequest.NoGeometry))
+        self.assertEqual(it.nextBatch(batch), 5)
+        if batch.columnType(0) == QgsFeatureBatch.Int64Column:
+            values = [batch.int64Value(0, row) for row in range(batch.rowCount())]
+        else:
+            values = [batch.doubleValue(0, row) for row in range(batch.rowCount())]
+        self.assertEqual(sorted(values), [-200, 100, 200, 300, 400])
+        self.assertEqual(it.nextBatch(batch), 0)
+        self.assertEqual(batch.rowCount(), 0)
+
     def testAddFeature(self):
         if not getattr(self, 'getEditableLayer', None):
             return
@@ -642,6 +642,52 @@ class PyQgsOGRProvider(unittest.TestCase):
         self.assertEqual(vl.featureCount(), 1)
         gdal.Unlink(filename)
 
+    def testReadAhead(self):
+        """ Test reading features on a background thread """
+
+        tmpdir = tempfile.mkdtemp()
+        self.dirs_to_cleanup.append(tmpdir)
+        filename = os.path.join(tmpdir, 'read_ahead.shp')
+        ds = ogr.GetDriverByName('ESRI Shapefile').CreateDataSource(filename)
+        lyr = ds.CreateLayer('read_ahead', geom_type=ogr.wkbPoint)
+        lyr.CreateField(ogr.FieldDefn('value', ogr.OFTInteger))
+        for i in range(1000):
+            f = ogr.Feature(lyr.GetLayerDefn())
+            f['value'] = i
+            f.SetGeometry(ogr.CreateGeometryFromWkt('POINT(%d %d)' % (i, i)))
+            lyr.CreateFeature(f)
+        ds = None
+
+        vl = QgsVectorLayer(filename, 'test', 'ogr')
+        self.assertTrue(vl.isValid())
+
+        def features(request):
+            return [(f.id(), f['value'], f.geometry().asWkt()) for f in vl.getFeatures(request)]
+
+        for request in [QgsFeatureRequest(),
+                        QgsFeatureRequest().setFilterExpression('"value" % 3 = 0'),
+                        QgsFeatureRequest().setFilterRect(QgsRectangle(100, 100, 599.5, 599.5)),
+                        QgsFeatureRequest().setLimit(10),
+                        QgsFeatureRequest().setFilterFids([5, 500, 800])]:
+            expected = features(request)
+            self.assertTrue(expected)
+            request.setFlags(request.flags() | QgsFeatureRequest.ReadAhead)
+            self.assertEqual(features(request), expected)
+
+        # rewind while the thread is reading
+        it = vl.getFeatures(QgsFeatureRequest().setFlags(QgsFeatureRequest.ReadAhead))
+        f = QgsFeature()
+        self.assertTrue(it.nextFeature(f))
+        self.assertTrue(it.nextFeature(f))
+        self.assertEqual(f['value'], 1)
+        self.assertTrue(it.rewind())
+        self.assertEqual([f['value'] for f in it], list(range(1000)))
+
+        # closing an iterator which has not been consumed
+        it = vl.getFeatures(QgsFeatureRequest().setFlags(QgsFeatureRequest.ReadAhead))
+        self.assertTrue(it.nextFeature(f))
+        self.assertTrue(it.close())
+
     def testSpatialiteDefaultValues(self):
         """Test whether in spatialite table with default values like CURRENT_TIMESTAMP or
         (datetime('now','localtime')) they are respected. See GH #33383"""
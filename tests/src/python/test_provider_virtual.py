@@ -25,13 +25,16 @@ from qgis.core import (QgsVectorLayer,
                        QgsProject,
                        QgsVectorLayerJoinInfo,
                        QgsVectorFileWriter,
-                       QgsVirtualLayerDefinitionUtils
+                       QgsVirtualLayerDefinitionUtils,
+                       QgsProviderRegistry,
+                       QgsProviderMetadata
                        )
 
 from qgis.testing import start_app, unittest
 from utilities import unitTestDataPath
 
 from providertestbase import ProviderTestCase
+from provider_python import PyProvider, PyFeatureSource
 from qgis.PyQt.QtCore import QUrl, QVariant, QTemporaryDir
 
 from qgis.utils import spatialite_connect
@@ -405,6 +408,74 @@ class TestQgsVirtualLayerProvider(unittest.TestCase, ProviderTestCase):
         a = [fit.attributes()[4] for fit in l2.getFeatures()]
         self.assertEqual(a, ["Basse-Normandie"])
 
+    def test_filter_spatial_predicate(self):
+        source = toPercent(os.path.join(self.testDataDir, "france_parts.shp"))
+
+        for predicate in ("ST_Intersects", "Intersects", "MbrIntersects"):
+            query = toPercent("select * from vtab where %s(geometry, BuildMbr(-2.10,49.38,-1.3,49.99,4326))" % predicate)
+            l2 = QgsVectorLayer("?layer=ogr:%s:vtab&query=%s&uid=objectid" % (source, query), "vtab2", "virtual",
+                                QgsVectorLayer.LayerOptions(False))
+            self.assertEqual(l2.isValid(), True)
+            a = [fit.attributes()[4] for fit in l2.getFeatures()]
+            self.assertEqual(a, ["Basse-Normandie"])
+
+        # projection of a subset of the columns
+        query = toPercent("select objectid, name_1 from vtab where MbrIntersects(geometry, BuildMbr(-2.10,49.38,-1.3,49.99,4326))")
+        l2 = QgsVectorLayer("?layer=ogr:%s:vtab&query=%s&uid=objectid&nogeometry" % (source, query), "vtab2", "virtual",
+                            QgsVectorLayer.LayerOptions(False))
+        self.assertEqual(l2.isValid(), True)
+        a = [fit.attributes()[1] for fit in l2.getFeatures()]
+        self.assertEqual(a, ["Basse-Normandie"])
+
+    def test_filter_spatial_predicate_pushdown(self):
+        """Test that the bounding box of a spatial predicate is passed to the provider"""
+        registry = QgsProviderRegistry.instance()
+        if registry.providerMetadata(PyProvider.providerKey()) is None:
+            registry.registerProvider(QgsProviderMetadata(PyProvider.providerKey(), PyProvider.description(), PyProvider.createProvider))
+
+        l1 = QgsVectorLayer('Polygon?crs=epsg:4326&field=name:string', 'squares', PyProvider.providerKey())
+        self.assertTrue(l1.isValid())
+        features = []
+        for name, wkt in (('a', 'Polygon ((0 0, 1 0, 1 1, 0 1, 0 0))'),
+                          ('b', 'Polygon ((5 5, 6 5, 6 6, 5 6, 5 5))'),
+                          ('c', 'Polygon ((10 0, 14 0, 14 4, 10 4, 10 0))')):
+            f = QgsFeature(l1.fields())
+            f.setAttributes([name])
+            f.setGeometry(QgsGeometry.fromWkt(wkt))
+            features.append(f)
+        self.assertTrue(l1.dataProvider().addFeatures(features)[0])
+        QgsProject.instance().addMapLayer(l1)
+
+        filter_rects = []
+        get_features = PyFeatureSource.getFeatures
+
+        def record_request(source, request):
+            filter_rects.append(request.filterRect())
+            return get_features(source, request)
+
+        PyFeatureSource.getFeatures = record_request
+        try:
+            for condition, expected_names, expected_rect in (
+                ('Intersects(geometry, BuildMbr(4.5, 4.5, 5.5, 5.5, 4326))', ['b'], QgsRectangle(4.5, 4.5, 5.5, 5.5)),
+                ('Contains(geometry, MakePoint(12, 1, 4326))', ['c'], QgsRectangle(12, 1, 12, 1)),
+                ('Within(geometry, BuildMbr(-1, -1, 7, 7, 4326))', ['a', 'b'], QgsRectangle(-1, -1, 7, 7)),
+                # another CRS, the bounding box can't be used as a filter rectangle
+                ('Intersects(geometry, BuildMbr(4.5, 4.5, 5.5, 5.5, 3857))', ['b'], None)):
+                query = toPercent('select * from vtab where %s' % condition)
+                l2 = QgsVectorLayer('?layer_ref=%s:vtab&query=%s&uid=name' % (l1.id(), query), 'vtab2', 'virtual',
+                                    QgsVectorLayer.LayerOptions(False))
+                self.assertTrue(l2.isValid(), condition)
+                filter_rects.clear()
+                self.assertEqual(sorted(f['name'] for f in l2.getFeatures()), expected_names, condition)
+                if expected_rect is not None:
+                    self.assertIn(expected_rect, filter_rects, condition)
+                else:
+                    self.assertTrue(filter_rects, condition)
+                    self.assertTrue(all(r.isNull() for r in filter_rects), condition)
+        finally:
+            PyFeatureSource.getFeatures = get_features
+            QgsProject.instance().removeMapLayer(l1)
+
     def test_recursiveLayer(self):
         source = toPercent(os.path.join(self.testDataDir, "france_parts.shp"))
         l = QgsVectorLayer("?layer=ogr:%s" % source, "vtab", "virtual", QgsVectorLayer.LayerOptions(False))
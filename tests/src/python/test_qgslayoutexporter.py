@@ -40,7 +40,11 @@ from qgis.core import (QgsMultiRenderChecker,
                        QgsPrintLayout,
                        QgsSingleSymbolRenderer,
                        QgsRenderContext,
-                       QgsReport)
+                       QgsReport,
+                       QgsLayoutItemLegend,
+                       QgsLayoutItemAttributeTable,
+                       QgsLayoutItemLabel,
+                       QgsLayoutFrame)
 from qgis.PyQt.QtCore import QSize, QSizeF, QDir, QRectF, Qt, QDateTime, QDate, QTime, QTimeZone
 from qgis.PyQt.QtGui import QImage, QPainter
 from qgis.PyQt.QtPrintSupport import QPrinter
@@ -944,6 +948,92 @@ class TestQgsLayoutExporter(unittest.TestCase):
         page4_path = os.path.join(self.basetestpath, 'test_exportiteratortoimage_Pays de la Loire.png')
         self.assertTrue(os.path.exists(page4_path))
 
+    def testIteratorToImagesConcurrently(self):
+        project, layout = self.prepareIteratorLayout()
+        atlas = layout.atlas()
+        atlas.setFilenameExpression("'test_exportiteratortoimageconcurrent_' || \"NAME_1\"")
+
+        # setup settings
+        settings = QgsLayoutExporter.ImageExportSettings()
+        settings.dpi = 80
+        settings.maxThreads = 2
+
+        result, error = QgsLayoutExporter.exportToImage(atlas, self.basetestpath + '/', 'png', settings)
+        self.assertEqual(result, QgsLayoutExporter.Success, error)
+
+        page1_path = os.path.join(self.basetestpath, 'test_exportiteratortoimageconcurrent_Basse-Normandie.png')
+        self.assertTrue(self.checkImage('iteratortoimageconcurrent1', 'iteratortoimage1', page1_path))
+        page2_path = os.path.join(self.basetestpath, 'test_exportiteratortoimageconcurrent_Bretagne.png')
+        self.assertTrue(self.checkImage('iteratortoimageconcurrent2', 'iteratortoimage2', page2_path))
+        page3_path = os.path.join(self.basetestpath, 'test_exportiteratortoimageconcurrent_Centre.png')
+        self.assertTrue(os.path.exists(page3_path))
+        page4_path = os.path.join(self.basetestpath, 'test_exportiteratortoimageconcurrent_Pays de la Loire.png')
+        self.assertTrue(os.path.exists(page4_path))
+
+        # the atlas of the exported layout itself is left untouched
+        self.assertEqual(atlas.currentFeatureNumber(), -1)
+
+    def testIteratorToImagesConcurrentlyWithUnsafeItems(self):
+        """
+        Legends, attribute tables and HTML labels can't be rendered outside of the main thread, atlases
+        using them must be exported one feature at a time
+        """
+        project, layout = self.prepareIteratorLayout()
+        legend = QgsLayoutItemLegend(layout)
+        legend.attemptSetSceneRect(QRectF(160, 20, 50, 50))
+        layout.addLayoutItem(legend)
+        atlas = layout.atlas()
+        atlas.setFilenameExpression("'test_exportiteratortoimagelegend_' || \"NAME_1\"")
+
+        settings = QgsLayoutExporter.ImageExportSettings()
+        settings.dpi = 80
+        settings.maxThreads = 2
+
+        result, error = QgsLayoutExporter.exportToImage(atlas, self.basetestpath + '/', 'png', settings)
+        self.assertEqual(result, QgsLayoutExporter.Success, error)
+        for name in ['Basse-Normandie', 'Bretagne', 'Centre', 'Pays de la Loire']:
+            self.assertTrue(os.path.exists(os.path.join(self.basetestpath, 'test_exportiteratortoimagelegend_{}.png'.format(name))))
+        # exported sequentially through the layout's own atlas
+        self.assertEqual(atlas.currentFeatureNumber(), 3)
+
+        project, layout = self.prepareIteratorLayout()
+        table = QgsLayoutItemAttributeTable.create(layout)
+        table.setVectorLayer(layout.atlas().coverageLayer())
+        frame = QgsLayoutFrame(layout, table)
+        frame.attemptSetSceneRect(QRectF(160, 20, 50, 50))
+        table.addFrame(frame)
+        layout.addMultiFrame(table)
+        atlas = layout.atlas()
+        atlas.setFilenameExpression("'test_exportiteratortopdftable_' || \"NAME_1\"")
+
+        settings = QgsLayoutExporter.PdfExportSettings()
+        settings.maxThreads = 2
+
+        result, error = QgsLayoutExporter.exportToPdfs(atlas, self.basetestpath + '/', settings)
+        self.assertEqual(result, QgsLayoutExporter.Success, error)
+        for name in ['Basse-Normandie', 'Bretagne', 'Centre', 'Pays de la Loire']:
+            self.assertTrue(os.path.exists(os.path.join(self.basetestpath, 'test_exportiteratortopdftable_{}.pdf'.format(name))))
+        self.assertEqual(atlas.currentFeatureNumber(), 3)
+
+        project, layout = self.prepareIteratorLayout()
+        label = QgsLayoutItemLabel(layout)
+        label.setMode(QgsLayoutItemLabel.ModeHtml)
+        label.setText('<b>[% "NAME_1" %]</b>')
+        label.attemptSetSceneRect(QRectF(160, 20, 50, 20))
+        layout.addLayoutItem(label)
+        atlas = layout.atlas()
+        atlas.setFilenameExpression("'test_exportiteratortoimagehtmllabel_' || \"NAME_1\"")
+
+        settings = QgsLayoutExporter.ImageExportSettings()
+        settings.dpi = 80
+        settings.maxThreads = 2
+
+        result, error = QgsLayoutExporter.exportToImage(atlas, self.basetestpath + '/', 'png', settings)
+        self.assertEqual(result, QgsLayoutExporter.Success, error)
+        for name in ['Basse-Normandie', 'Bretagne', 'Centre', 'Pays de la Loire']:
+            self.assertTrue(os.path.exists(os.path.join(self.basetestpath, 'test_exportiteratortoimagehtmllabel_{}.png'.format(name))))
+        self.assertEqual(atlas.currentFeatureNumber(), 3)
+
     def testIteratorToSvgs(self):
         project, layout = self.prepareIteratorLayout()
         atlas = layout.atlas()
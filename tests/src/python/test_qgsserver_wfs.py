@@ -28,8 +28,14 @@ from qgis.server import QgsServerRequest
 
 from qgis.testing import unittest
 from qgis.PyQt.QtCore import QSize
+from qgis.PyQt.QtXml import QDomDocument
 from qgis.core import (
     QgsVectorLayer,
+    QgsFeature,
+    QgsJsonExporter,
+    QgsOgcUtils,
+    QgsProject,
+    NULL,
     QgsFeatureRequest,
     QgsExpression,
     QgsCoordinateReferenceSystem,
@@ -702,6 +708,86 @@ class TestQgsServerWFS(QgsServerTestBase):
         geom = feature.geometry()
         self.assertEqual(geom.asWkt(0), geom_4326.asWkt(0))
 
+    def test_getFeature_serialization(self):
+        """Test GetFeature writes features as the DOM and json serializers do"""
+
+        project = QgsProject()
+        layers = []
+        geometries = {
+            'lines': ('LineString', ['LineString (0 0, 1.5 2.25, 3 4)', 'LineString (-10 20.123456789, 30 40)']),
+            'polygons': ('Polygon', ['Polygon ((0 0, 10 0, 10 10, 0 10, 0 0),(2 2, 2 3, 3 3, 3 2, 2 2))']),
+            'multipoints': ('MultiPoint', ['MultiPoint ((1 2),(3 4))']),
+            'multilines': ('MultiLineString', ['MultiLineString ((0 0, 1 1),(2 2, 3 3, 4 5))']),
+            'multipolygons': ('MultiPolygon', ['MultiPolygon (((0 0, 1 0, 1 1, 0 0)),((5 5, 6 5, 6 6, 5 5),(5.2 5.1, 5.8 5.1, 5.8 5.7, 5.2 5.1)))']),
+            'points3d': ('PointZ', ['PointZ (1 2 3)']),
+            'lines3d': ('LineStringZ', ['LineStringZ (0 0 1, 1 1 2.5, 2 0 -3)']),
+            'polygons3d': ('PolygonZ', ['PolygonZ ((0 0 1, 10 0 2, 10 10 3, 0 10 4, 0 0 1))']),
+        }
+        for name, (geometry_type, wkts) in geometries.items():
+            layer = QgsVectorLayer('{}?crs=epsg:3857&field=name:string&field=value:integer'.format(geometry_type), name, 'memory')
+            self.assertTrue(layer.isValid())
+            features = []
+            for i, wkt in enumerate(wkts):
+                feature = QgsFeature(layer.fields())
+                # carriage returns are escaped in text too, ]]> only in text
+                feature.setAttributes(['line {}\r\nnext\t"quoted" ]]> end'.format(i), None if i else 5])
+                feature.setGeometry(QgsGeometry.fromWkt(wkt))
+                features.append(feature)
+            self.assertTrue(layer.dataProvider().addFeatures(features)[0])
+            layers.append(layer)
+        project.addMapLayers(layers)
+        project.writeEntry('WFSLayers', '/', [layer.id() for layer in layers])
+
+        for layer in layers:
+            for output_format in ('GML2', 'GML3'):
+                query_string = '?SERVICE=WFS&REQUEST=GetFeature&VERSION=1.1.0&TYPENAME={}&OUTPUTFORMAT={}'.format(layer.name(), output_format)
+                header, body = self._execute_request_project(query_string, project)
+                members = re.findall(br'<gml:featureMember>\n.*?</gml:featureMember>\n', body, re.DOTALL)
+                features = list(layer.getFeatures())
+                self.assertEqual(len(members), len(features), body)
+                for feature, member in zip(features, members):
+                    # same elements as created by the former QDomDocument based serializer
+                    doc = QDomDocument()
+                    feature_element = doc.createElement('gml:featureMember')
+                    type_name_element = doc.createElement('qgs:' + layer.name())
+                    type_name_element.setAttribute('gml:id' if output_format == 'GML3' else 'fid', '{}.{}'.format(layer.name(), feature.id()))
+                    feature_element.appendChild(type_name_element)
+                    box = feature.geometry().boundingBox()
+                    if output_format == 'GML3':
+                        gml_element = feature.geometry().constGet().asGml3(doc, 6, 'http://www.opengis.net/gml')
+                        box_element = QgsOgcUtils.rectangleToGMLEnvelope(box, doc, 6)
+                    else:
+                        gml_element = feature.geometry().constGet().asGml2(doc, 6, 'http://www.opengis.net/gml')
+                        box_element = QgsOgcUtils.rectangleToGMLBox(box, doc, 6)
+                    box_element.setAttribute('srsName', 'EPSG:3857')
+                    gml_element.setAttribute('srsName', 'EPSG:3857')
+                    bounded_by_element = doc.createElement('gml:boundedBy')
+                    bounded_by_element.appendChild(box_element)
+                    type_name_element.appendChild(bounded_by_element)
+                    geometry_element = doc.createElement('qgs:geometry')
+                    geometry_element.appendChild(gml_element)
+                    type_name_element.appendChild(geometry_element)
+                    for field, value in zip(layer.fields(), feature.attributes()):
+                        field_element = doc.createElement('qgs:' + field.name())
+                        if value == NULL:
+                            field_element.setAttribute('xsi:nil', 'true')
+                        field_element.appendChild(doc.createTextNode('' if value == NULL else str(value)))
+                        type_name_element.appendChild(field_element)
+                    doc.appendChild(feature_element)
+                    self.assertEqual(member, bytes(doc.toByteArray()), '{} {}'.format(layer.name(), output_format))
+
+            query_string = '?SERVICE=WFS&REQUEST=GetFeature&VERSION=1.1.0&TYPENAME={}&OUTPUTFORMAT=GeoJSON'.format(layer.name())
+            header, body = self._execute_request_project(query_string, project)
+            json_features = [line[2:] for line in body.split(b'\n') if line.startswith(b'  {') or line.startswith(b' ,{')]
+            features = list(layer.getFeatures())
+            self.assertEqual(len(json_features), len(features), body)
+            exporter = QgsJsonExporter()
+            exporter.setSourceCrs(layer.crs())
+            exporter.setAttributes(layer.attributeList())
+            for feature, json_feature in zip(features, json_features):
+                expected = exporter.exportFeature(feature, {}, '{}.{}'.format(layer.name(), feature.id()))
+                self.assertEqual(json_feature.decode('utf8'), expected, layer.name())
+
 
 if __name__ == '__main__':
     unittest.main()